@@ -13,6 +13,9 @@ extern "C" {
 #endif
 
 typedef enum mqtt_error {
+    MQTT_WOULD_BLOCK_ERROR                                  = -0x001F,      /* not finished yet, wait for the socket and call again */
+    MQTT_SN_REJECTED_ERROR                                  = -0x001E,      /* mqtt-sn gateway rejected the request */
+    MQTT_RPC_TIMEOUT_ERROR                                  = -0x001D,      /* mqtt rpc request, but no response */
     MQTT_SSL_CERT_ERROR                                     = -0x001C,      /* cetr parse failed */
     MQTT_SOCKET_FAILED_ERROR                                = -0x001B,      /* socket fd failed */
     MQTT_SOCKET_UNKNOWN_HOST_ERROR                          = -0x001A,      /* socket unknown host ip or domain */ 
@@ -0,0 +1,139 @@
+/*
+ * @Date: 2026-10-19
+ * @Description: fixed-size block pool, O(1) alloc and free on caller-provided storage.
+ */
+#include "mqtt_pool.h"
+
+/**
+ * @brief 初始化内存池，空闲块利用块首的指针串成单链表。
+ *
+ * @param p 内存池。
+ * @param storage 存储空间，至少 MQTT_POOL_BLOCK_SIZE(block_size) * block_num 字节，按指针对齐。
+ * @param block_size 块大小。
+ * @param block_num 块数量。
+ * @return int 成功返回0，参数错误返回-1。
+ */
+int mqtt_pool_init(mqtt_pool_t *p, void *storage, uint32_t block_size, uint32_t block_num)
+{
+    uint32_t i;
+    uint8_t *block;
+
+    if ((NULL == p) || ((NULL == storage) && (0 != block_num)))
+        return -1;
+
+    p->block_size = MQTT_POOL_BLOCK_SIZE(block_size);
+    p->block_num = block_num;
+    p->used = 0;
+    p->high_water = 0;
+    p->miss = 0;
+    p->start = (uint8_t *)storage;
+    p->end = p->start + p->block_size * block_num;
+    p->free_list = NULL;
+
+    /* 倒序链接，使分配从存储空间的起始位置开始 */
+    for (i = block_num; i > 0; i--) {
+        block = p->start + p->block_size * (i - 1);
+        *(void **)block = p->free_list;
+        p->free_list = block;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief 从内存池中分配一个块。
+ *
+ * @param p 内存池。
+ * @return void* 分配的块，内存池耗尽时返回NULL。
+ */
+void *mqtt_pool_alloc(mqtt_pool_t *p)
+{
+    void *block;
+
+    if (NULL == p)
+        return NULL;
+
+    if (NULL == p->free_list) {
+        p->miss++;
+        return NULL;
+    }
+
+    block = p->free_list;
+    p->free_list = *(void **)block;
+    if (++p->used > p->high_water)
+        p->high_water = p->used;
+
+    return block;
+}
+
+/**
+ * @brief 从内存池中分配一个块，并检查块大小是否满足需求。
+ *
+ * @param p 内存池。
+ * @param size 需要的字节数。
+ * @return void* 分配的块，超过块大小或内存池耗尽时返回NULL。
+ */
+void *mqtt_pool_alloc_size(mqtt_pool_t *p, uint32_t size)
+{
+    if (NULL == p)
+        return NULL;
+
+    if (size > p->block_size) {
+        p->miss++;
+        return NULL;
+    }
+
+    return mqtt_pool_alloc(p);
+}
+
+/**
+ * @brief 将块归还给内存池。
+ *
+ * @param p 内存池。
+ * @param block 要归还的块。
+ * @return int 成功返回0，块不属于该内存池返回-1。
+ */
+int mqtt_pool_free(mqtt_pool_t *p, void *block)
+{
+    if (!mqtt_pool_is_member(p, block))
+        return -1;
+
+    *(void **)block = p->free_list;
+    p->free_list = block;
+    p->used--;
+
+    return 0;
+}
+
+/**
+ * @brief 判断块是否属于内存池。
+ *
+ * @param p 内存池。
+ * @param block 块地址。
+ * @return int 属于返回1，否则返回0。
+ */
+int mqtt_pool_is_member(mqtt_pool_t *p, void *block)
+{
+    if ((NULL == p) || (NULL == block))
+        return 0;
+
+    return (((uint8_t *)block >= p->start) && ((uint8_t *)block < p->end)) ? 1 : 0;
+}
+
+/**
+ * @brief 获取内存池的使用统计，用于根据高水位调整内存池大小。
+ *
+ * @param p 内存池。
+ * @param stats 统计信息输出。
+ */
+void mqtt_pool_get_stats(mqtt_pool_t *p, mqtt_pool_stats_t *stats)
+{
+    if ((NULL == p) || (NULL == stats))
+        return;
+
+    stats->block_size = p->block_size;
+    stats->block_num = p->block_num;
+    stats->used = p->used;
+    stats->high_water = p->high_water;
+    stats->miss = p->miss;
+}
@@ -0,0 +1,52 @@
+/*
+ * @Date: 2026-10-19
+ * @Description: fixed-size block pool, O(1) alloc and free on caller-provided storage.
+ */
+#ifndef _MQTT_POOL_H_
+#define _MQTT_POOL_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MQTT_POOL_BLOCK_SIZE(size) \
+    (((size) + sizeof(void *) - 1) / sizeof(void *) * sizeof(void *))
+
+/* 存储空间以 void* 为单位声明，保证块的对齐 */
+#define MQTT_POOL_STORAGE_LEN(size, num) \
+    (MQTT_POOL_BLOCK_SIZE(size) / sizeof(void *) * (num))
+
+typedef struct mqtt_pool {
+    void                        *free_list;
+    uint8_t                     *start;
+    uint8_t                     *end;
+    uint32_t                    block_size;
+    uint32_t                    block_num;
+    uint32_t                    used;
+    uint32_t                    high_water;
+    uint32_t                    miss;
+} mqtt_pool_t;
+
+typedef struct mqtt_pool_stats {
+    uint32_t                    block_size;
+    uint32_t                    block_num;
+    uint32_t                    used;
+    uint32_t                    high_water;     /* 历史最大同时使用块数 */
+    uint32_t                    miss;           /* 内存池无法满足的分配次数 */
+} mqtt_pool_stats_t;
+
+int mqtt_pool_init(mqtt_pool_t *p, void *storage, uint32_t block_size, uint32_t block_num);
+void *mqtt_pool_alloc(mqtt_pool_t *p);
+void *mqtt_pool_alloc_size(mqtt_pool_t *p, uint32_t size);
+int mqtt_pool_free(mqtt_pool_t *p, void *block);
+int mqtt_pool_is_member(mqtt_pool_t *p, void *block);
+void mqtt_pool_get_stats(mqtt_pool_t *p, mqtt_pool_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _MQTT_POOL_H_ */
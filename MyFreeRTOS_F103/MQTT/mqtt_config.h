@@ -39,8 +39,12 @@
 #define     MQTT_THREAD_STACK_SIZE              2048
 #define     MQTT_THREAD_PRIO                    5
 #define     MQTT_THREAD_TICK                    50
+#define     MQTT_QOS2_BITMAP_BITS               256         // windowed inbound qos2 bitmap, 32 bytes
 
+// #define     MQTT_STATIC_ALLOCATION
+// #define     MQTT_STATIC_THREAD_STACK_SIZE       (MQTT_THREAD_STACK_SIZE * 4)    // unit: byte, MQTT_THREAD_STACK_SIZE counts words on FreeRTOS
 
 // #define     MQTT_NETWORK_TYPE_NO_TLS
+// #define     MQTT_NETWORK_TYPE_TLS
 
 #endif /* _MQTT_CONFIG_H_ */
@@ -0,0 +1,415 @@
+/*
+ * @Date: 2026-10-19
+ * @Description: time-windowed telemetry batching on top of mqtt_publish.
+ */
+#include "mqtt_batch.h"
+
+#define MQTT_BATCH_VARINT_LEN_MAX   4
+#define MQTT_BATCH_DELTA_MAX        268435455   // 4 字节 varint 能表示的最大值
+
+/**
+ * @brief 断开连接前的回调，将所有缓存的样本发送出去，再调用应用原先注册的回调
+ *
+ * @param client MQTT 客户端实例
+ * @param data 批量发布器实例
+ */
+static void mqtt_batch_disconnect_handler(void *client, void *data)
+{
+    mqtt_batch_t *b = (mqtt_batch_t *)data;
+
+    mqtt_batch_flush_all(b);
+
+    if (NULL != b->prev_disconnect_handler)
+        b->prev_disconnect_handler(client, b->prev_disconnect_data);
+}
+
+/**
+ * @brief 根据主题查找批次
+ *
+ * @param b 批量发布器实例
+ * @param topic 主题名
+ * @return mqtt_batch_topic_t* 找到的批次，未找到返回 NULL
+ */
+static mqtt_batch_topic_t *mqtt_batch_topic_find(mqtt_batch_t *b, const char *topic)
+{
+    mqtt_list_t *curr, *next;
+    mqtt_batch_topic_t *t;
+
+    LIST_FOR_EACH_SAFE(curr, next, &b->topic_list)
+    {
+        t = LIST_ENTRY(curr, mqtt_batch_topic_t, list);
+        if ((t->topic == topic) || (0 == strcmp(t->topic, topic)))
+            return t;
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief 创建一个主题批次，批次结构体与缓冲区在同一块内存中，受内存预算限制。
+ *        预算用完或内存不足时回收一个没有待发送样本的批次，内存只在释放批量发布器时归还
+ *
+ * @param b 批量发布器实例
+ * @param topic 主题名，调用者需保证其在批量发布器释放前有效
+ * @param qos 发布的 QoS 等级
+ * @param retained 发布的保留标志
+ * @return mqtt_batch_topic_t* 创建的批次，超出预算或内存不足且没有空闲批次时返回 NULL
+ */
+static mqtt_batch_topic_t *mqtt_batch_topic_create(mqtt_batch_t *b, const char *topic, mqtt_qos_t qos, uint8_t retained)
+{
+    uint32_t size = sizeof(mqtt_batch_topic_t) + b->max_bytes;
+    mqtt_list_t *curr, *next;
+    mqtt_batch_topic_t *t = NULL, *idle;
+
+    if (b->memory_used + size <= b->memory_budget)
+    {
+        t = (mqtt_batch_topic_t *)platform_memory_alloc(size);
+        if (NULL != t)
+            b->memory_used += size;
+    }
+
+    if (NULL == t)
+    {
+        /* 列表按创建先后排列，回收最早的空闲批次 */
+        LIST_FOR_EACH_SAFE(curr, next, &b->topic_list)
+        {
+            idle = LIST_ENTRY(curr, mqtt_batch_topic_t, list);
+            if (0 == idle->count)
+            {
+                mqtt_list_del(&idle->list);
+                t = idle;
+                break;
+            }
+        }
+        if (NULL == t)
+            return NULL;
+    }
+
+    memset(t, 0, sizeof(mqtt_batch_topic_t));
+    mqtt_list_init(&t->list);
+    t->topic = topic;
+    t->qos = qos;
+    t->retained = retained;
+    t->len = MQTT_BATCH_HEADER_LEN;
+    t->buf = (uint8_t *)t + sizeof(mqtt_batch_topic_t);
+
+    mqtt_list_add_tail(&t->list, &b->topic_list);
+
+    return t;
+}
+
+/**
+ * @brief 将一个批次打包为一个 PUBLISH 报文发送
+ *
+ * @param b 批量发布器实例
+ * @param t 主题批次
+ * @return int 返回状态码，MQTT_SUCCESS_ERROR 表示成功；未连接时保留数据并返回 MQTT_NOT_CONNECT_ERROR
+ */
+static int mqtt_batch_topic_flush(mqtt_batch_t *b, mqtt_batch_topic_t *t)
+{
+    int rc;
+    uint8_t *ptr;
+    mqtt_message_t msg;
+
+    if (0 == t->count)
+        RETURN_ERROR(MQTT_SUCCESS_ERROR);
+
+    ptr = t->buf + MQTT_BATCH_HEADER_LEN - 2;
+    writeInt(&ptr, t->count); /* 样本数量在发送时才确定 */
+
+    memset(&msg, 0, sizeof(msg));
+    msg.qos = t->qos;
+    msg.retained = t->retained;
+    msg.payload = t->buf;
+    msg.payloadlen = t->len;
+
+    rc = mqtt_publish_copy(b->client, t->topic, &msg);
+
+    /* 未连接时保留数据，等待重新连接后由下一次 poll 或 add 发送 */
+    if (MQTT_NOT_CONNECT_ERROR == rc)
+        RETURN_ERROR(rc);
+
+    if (MQTT_SUCCESS_ERROR != rc)
+        MQTT_LOG_W("%s:%d %s()... topic %s drop %d samples, rc is -0x%04x", __FILE__, __LINE__, __FUNCTION__, t->topic, t->count, -rc);
+
+    t->count = 0;
+    t->len = MQTT_BATCH_HEADER_LEN;
+
+    RETURN_ERROR(rc);
+}
+
+/**
+ * @brief 初始化批量发布器，并注册断开连接前的发送回调，应用已注册的断开回调会在发送后被调用
+ *
+ * @param b 批量发布器实例，由调用者提供存储空间
+ * @param c MQTT 客户端实例
+ * @return int 返回状态码，MQTT_SUCCESS_ERROR 表示成功
+ */
+int mqtt_batch_init(mqtt_batch_t *b, mqtt_client_t *c)
+{
+    if ((NULL == b) || (NULL == c))
+        RETURN_ERROR(MQTT_NULL_VALUE_ERROR);
+
+    memset(b, 0, sizeof(mqtt_batch_t));
+
+    b->client = c;
+    b->max_bytes = MQTT_BATCH_MAX_BYTES;
+    b->max_samples = MQTT_BATCH_MAX_SAMPLES;
+    b->max_latency = MQTT_BATCH_MAX_LATENCY;
+    b->memory_budget = MQTT_BATCH_MEMORY_BUDGET;
+
+    mqtt_list_init(&b->topic_list);
+    platform_mutex_init(&b->lock);
+
+    b->prev_disconnect_handler = mqtt_get_disconnect_handler(c);
+    b->prev_disconnect_data = mqtt_get_disconnect_data(c);
+
+    mqtt_set_disconnect_data(c, b);
+    mqtt_set_disconnect_handler(c, mqtt_batch_disconnect_handler);
+
+    RETURN_ERROR(MQTT_SUCCESS_ERROR);
+}
+
+/**
+ * @brief 设置批次的发送条件，只能在添加第一个样本之前调用
+ *
+ * @param b 批量发布器实例
+ * @param max_bytes 单个批次负载的最大字节数，不能超过客户端写缓冲区大小
+ * @param max_samples 单个批次的最大样本数量
+ * @param max_latency 第一个样本进入批次后的最大等待时间，单位毫秒
+ * @return int 返回状态码，MQTT_SUCCESS_ERROR 表示成功
+ */
+int mqtt_batch_set_limits(mqtt_batch_t *b, uint32_t max_bytes, uint32_t max_samples, uint32_t max_latency)
+{
+    if (NULL == b)
+        RETURN_ERROR(MQTT_NULL_VALUE_ERROR);
+
+    /* 批次缓冲区已经按原有大小分配 */
+    if (!mqtt_list_is_empty(&b->topic_list))
+        RETURN_ERROR(MQTT_FAILED_ERROR);
+
+    if ((max_bytes <= MQTT_BATCH_HEADER_LEN) || (0 == max_samples) || (max_samples > 0xFFFF))
+        RETURN_ERROR(MQTT_FAILED_ERROR);
+
+    b->max_bytes = max_bytes;
+    b->max_samples = max_samples;
+    b->max_latency = max_latency;
+
+    RETURN_ERROR(MQTT_SUCCESS_ERROR);
+}
+
+/**
+ * @brief 向主题批次追加一个样本，满足数量、大小或延迟条件时发送
+ *
+ * @param b 批量发布器实例
+ * @param topic 主题名，调用者需保证其在批量发布器释放前有效
+ * @param qos 发布的 QoS 等级，以该主题第一次添加时为准
+ * @param retained 发布的保留标志，以该主题第一次添加时为准
+ * @param sample 样本数据
+ * @param len 样本长度
+ * @return int 返回状态码，MQTT_SUCCESS_ERROR 表示成功
+ */
+int mqtt_batch_add(mqtt_batch_t *b, const char *topic, mqtt_qos_t qos, uint8_t retained, const void *sample, uint32_t len)
+{
+    int rc = MQTT_SUCCESS_ERROR;
+    uint8_t *ptr;
+    uint32_t now, delta;
+    mqtt_batch_topic_t *t;
+
+    if ((NULL == b) || (NULL == topic) || ((NULL == sample) && (0 != len)))
+        RETURN_ERROR(MQTT_NULL_VALUE_ERROR);
+
+    if (MQTT_BATCH_HEADER_LEN + 2 * MQTT_BATCH_VARINT_LEN_MAX + len > b->max_bytes)
+        RETURN_ERROR(MQTT_BUFFER_TOO_SHORT_ERROR);
+
+    platform_mutex_lock(&b->lock);
+
+    t = mqtt_batch_topic_find(b, topic);
+    if (NULL == t)
+    {
+        t = mqtt_batch_topic_create(b, topic, qos, retained);
+        if (NULL == t)
+        {
+            rc = MQTT_MEM_NOT_ENOUGH_ERROR;
+            goto exit;
+        }
+    }
+
+    /* 剩余空间不足时先发送已有的样本，发送失败则丢弃当前样本，保证内存有界 */
+    if (t->len + 2 * MQTT_BATCH_VARINT_LEN_MAX + len > b->max_bytes)
+    {
+        if (MQTT_SUCCESS_ERROR != mqtt_batch_topic_flush(b, t))
+        {
+            rc = MQTT_BUFFER_OVERFLOW_ERROR;
+            goto exit;
+        }
+    }
+
+    now = (uint32_t)platform_timer_now();
+
+    if (0 == t->count)
+    {
+        ptr = t->buf;
+        writeChar(&ptr, MQTT_BATCH_FORMAT_VERSION);
+        writeChar(&ptr, (char)(now >> 24));
+        writeChar(&ptr, (char)(now >> 16));
+        writeChar(&ptr, (char)(now >> 8));
+        writeChar(&ptr, (char)now);
+        t->last_time = now;
+        platform_timer_cutdown(&t->deadline, b->max_latency);
+    }
+
+    delta = now - t->last_time;
+    if (delta > MQTT_BATCH_DELTA_MAX)
+        delta = MQTT_BATCH_DELTA_MAX;
+    t->last_time = now;
+
+    ptr = t->buf + t->len;
+    ptr += MQTTPacket_encode(ptr, (int)delta);
+    ptr += MQTTPacket_encode(ptr, (int)len);
+    if (len > 0)
+        memcpy(ptr, sample, len);
+
+    t->len = (uint32_t)(ptr - t->buf) + len;
+    t->count++;
+
+    if ((t->count >= b->max_samples) || platform_timer_is_expired(&t->deadline))
+        rc = mqtt_batch_topic_flush(b, t);
+
+    /* 数据仍在批次中，稍后会被发送 */
+    if (MQTT_NOT_CONNECT_ERROR == rc)
+        rc = MQTT_SUCCESS_ERROR;
+
+exit:
+    platform_mutex_unlock(&b->lock);
+
+    RETURN_ERROR(rc);
+}
+
+/**
+ * @brief 发送所有已超过最大延迟的批次，需要周期性调用，周期不大于最大延迟
+ *
+ * @param b 批量发布器实例
+ * @return int 返回状态码，MQTT_SUCCESS_ERROR 表示成功
+ */
+int mqtt_batch_poll(mqtt_batch_t *b)
+{
+    int rc = MQTT_SUCCESS_ERROR, err;
+    mqtt_list_t *curr, *next;
+    mqtt_batch_topic_t *t;
+
+    if (NULL == b)
+        RETURN_ERROR(MQTT_NULL_VALUE_ERROR);
+
+    platform_mutex_lock(&b->lock);
+
+    LIST_FOR_EACH_SAFE(curr, next, &b->topic_list)
+    {
+        t = LIST_ENTRY(curr, mqtt_batch_topic_t, list);
+        if ((0 == t->count) || (!platform_timer_is_expired(&t->deadline)))
+            continue;
+
+        if (MQTT_SUCCESS_ERROR != (err = mqtt_batch_topic_flush(b, t)))
+            rc = err;
+    }
+
+    platform_mutex_unlock(&b->lock);
+
+    RETURN_ERROR(rc);
+}
+
+/**
+ * @brief 立即发送指定主题的批次
+ *
+ * @param b 批量发布器实例
+ * @param topic 主题名
+ * @return int 返回状态码，MQTT_SUCCESS_ERROR 表示成功
+ */
+int mqtt_batch_flush(mqtt_batch_t *b, const char *topic)
+{
+    int rc = MQTT_SUCCESS_ERROR;
+    mqtt_batch_topic_t *t;
+
+    if ((NULL == b) || (NULL == topic))
+        RETURN_ERROR(MQTT_NULL_VALUE_ERROR);
+
+    platform_mutex_lock(&b->lock);
+
+    t = mqtt_batch_topic_find(b, topic);
+    if (NULL != t)
+        rc = mqtt_batch_topic_flush(b, t);
+
+    platform_mutex_unlock(&b->lock);
+
+    RETURN_ERROR(rc);
+}
+
+/**
+ * @brief 立即发送所有批次，断开连接或关机前调用
+ *
+ * @param b 批量发布器实例
+ * @return int 返回状态码，MQTT_SUCCESS_ERROR 表示成功
+ */
+int mqtt_batch_flush_all(mqtt_batch_t *b)
+{
+    int rc = MQTT_SUCCESS_ERROR, err;
+    mqtt_list_t *curr, *next;
+    mqtt_batch_topic_t *t;
+
+    if (NULL == b)
+        RETURN_ERROR(MQTT_NULL_VALUE_ERROR);
+
+    platform_mutex_lock(&b->lock);
+
+    LIST_FOR_EACH_SAFE(curr, next, &b->topic_list)
+    {
+        t = LIST_ENTRY(curr, mqtt_batch_topic_t, list);
+        if (MQTT_SUCCESS_ERROR != (err = mqtt_batch_topic_flush(b, t)))
+            rc = err;
+    }
+
+    platform_mutex_unlock(&b->lock);
+
+    RETURN_ERROR(rc);
+}
+
+/**
+ * @brief 发送剩余的样本并释放批量发布器的所有内存
+ *
+ * @param b 批量发布器实例
+ * @return int 返回最后一次发送的状态码
+ */
+int mqtt_batch_release(mqtt_batch_t *b)
+{
+    int rc;
+    mqtt_list_t *curr, *next;
+    mqtt_batch_topic_t *t;
+
+    if (NULL == b)
+        RETURN_ERROR(MQTT_NULL_VALUE_ERROR);
+
+    rc = mqtt_batch_flush_all(b);
+
+    platform_mutex_lock(&b->lock);
+
+    LIST_FOR_EACH_SAFE(curr, next, &b->topic_list)
+    {
+        t = LIST_ENTRY(curr, mqtt_batch_topic_t, list);
+        mqtt_list_del(&t->list);
+        platform_memory_free(t);
+    }
+    b->memory_used = 0;
+
+    platform_mutex_unlock(&b->lock);
+
+    /* 之后注册的回调可能已经链接到本实例，此时只能由应用自行恢复 */
+    if ((mqtt_batch_disconnect_handler == mqtt_get_disconnect_handler(b->client)) &&
+        (b == mqtt_get_disconnect_data(b->client)))
+    {
+        mqtt_set_disconnect_handler(b->client, b->prev_disconnect_handler);
+        mqtt_set_disconnect_data(b->client, b->prev_disconnect_data);
+    }
+    platform_mutex_destroy(&b->lock);
+
+    RETURN_ERROR(rc);
+}
@@ -0,0 +1,60 @@
+/*
+ * @Date: 2026-10-19
+ * @Description: time-windowed telemetry batching on top of mqtt_publish.
+ */
+#ifndef _MQTT_BATCH_H_
+#define _MQTT_BATCH_H_
+
+#include "mqttclient.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * 批量负载格式（大端）：
+ *   [version:1][base_time_ms:4][count:2]
+ *   { [delta_ms:varint][len:varint][data:len] } * count
+ * varint 使用 MQTT 剩余长度的编码方式，delta_ms 为相对于上一条样本的时间差。
+ */
+#define     MQTT_BATCH_FORMAT_VERSION           1
+#define     MQTT_BATCH_HEADER_LEN               7
+
+typedef struct mqtt_batch_topic {
+    mqtt_list_t                 list;
+    const char                  *topic;
+    mqtt_qos_t                  qos;
+    uint8_t                     retained;
+    uint16_t                    count;
+    uint32_t                    len;
+    uint32_t                    last_time;
+    platform_timer_t            deadline;
+    uint8_t                     *buf;
+} mqtt_batch_topic_t;
+
+typedef struct mqtt_batch {
+    mqtt_client_t               *client;
+    mqtt_list_t                 topic_list;
+    platform_mutex_t            lock;
+    uint32_t                    max_bytes;
+    uint32_t                    max_samples;
+    uint32_t                    max_latency;
+    uint32_t                    memory_budget;
+    uint32_t                    memory_used;
+    disconnect_handler_t        prev_disconnect_handler;
+    void                        *prev_disconnect_data;
+} mqtt_batch_t;
+
+int mqtt_batch_init(mqtt_batch_t *b, mqtt_client_t *c);
+int mqtt_batch_set_limits(mqtt_batch_t *b, uint32_t max_bytes, uint32_t max_samples, uint32_t max_latency);
+int mqtt_batch_add(mqtt_batch_t *b, const char *topic, mqtt_qos_t qos, uint8_t retained, const void *sample, uint32_t len);
+int mqtt_batch_poll(mqtt_batch_t *b);
+int mqtt_batch_flush(mqtt_batch_t *b, const char *topic);
+int mqtt_batch_flush_all(mqtt_batch_t *b);
+int mqtt_batch_release(mqtt_batch_t *b);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _MQTT_BATCH_H_ */
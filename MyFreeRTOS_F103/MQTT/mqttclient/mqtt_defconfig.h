@@ -23,6 +23,14 @@
     #define     MQTT_TOPIC_LEN_MAX                  64
 #endif // !MQTT_TOPIC_LEN_MAX
 
+#ifndef MQTT_TOPIC_TABLE_SIZE
+    #define     MQTT_TOPIC_TABLE_SIZE               8       // interned inbound topics, topic id 1 ~ MQTT_TOPIC_TABLE_SIZE, ids are never reused, later topics get none
+#endif // !MQTT_TOPIC_TABLE_SIZE
+
+#ifndef MQTT_SUBSCRIBE_BATCH_MAX
+    #define     MQTT_SUBSCRIBE_BATCH_MAX            16      // topic filters per SUBSCRIBE/UNSUBSCRIBE packet
+#endif // !MQTT_SUBSCRIBE_BATCH_MAX
+
 #ifndef MQTT_ACK_HANDLER_NUM_MAX
     #define     MQTT_ACK_HANDLER_NUM_MAX            64
 #endif // !MQTT_ACK_HANDLER_NUM_MAX
@@ -55,6 +63,26 @@
     #define     MQTT_RECONNECT_DEFAULT_DURATION     1000
 #endif // !MQTT_RECONNECT_DEFAULT_DURATION
 
+#ifndef MQTT_ENDPOINT_NUM_MAX
+    #define     MQTT_ENDPOINT_NUM_MAX               4       // must not exceed 32
+#endif // !MQTT_ENDPOINT_NUM_MAX
+
+#ifndef MQTT_ENDPOINT_BACKOFF_MIN
+    #define     MQTT_ENDPOINT_BACKOFF_MIN           1000    // unit: millisecond, doubled on every failure
+#endif // !MQTT_ENDPOINT_BACKOFF_MIN
+
+#ifndef MQTT_ENDPOINT_BACKOFF_MAX
+    #define     MQTT_ENDPOINT_BACKOFF_MAX           60000   // unit: millisecond
+#endif // !MQTT_ENDPOINT_BACKOFF_MAX
+
+#ifndef MQTT_ENDPOINT_STANDBY_REFRESH
+    #define     MQTT_ENDPOINT_STANDBY_REFRESH       10000   // unit: millisecond, check the standby link and reopen it if the broker dropped it
+#endif // !MQTT_ENDPOINT_STANDBY_REFRESH
+
+#ifndef MQTT_ENDPOINT_STANDBY_STEP
+    #define     MQTT_ENDPOINT_STANDBY_STEP          10      // unit: millisecond, longest yield wait while the standby link is connecting
+#endif // !MQTT_ENDPOINT_STANDBY_STEP
+
 #ifndef MQTT_THREAD_STACK_SIZE
     #define     MQTT_THREAD_STACK_SIZE              4096
 #endif // !MQTT_THREAD_STACK_SIZE
@@ -67,21 +95,252 @@
     #define     MQTT_THREAD_TICK                    50
 #endif // !MQTT_THREAD_TICK
 
-#define MQTT_NETWORK_TYPE_NO_TLS 1
+#ifndef MQTT_QOS2_BITMAP_BITS
+    #define     MQTT_QOS2_BITMAP_BITS               65536   // inbound qos2 packet id bitmap (8 KB), a smaller power of 2 tracks a sliding window
+#endif // !MQTT_QOS2_BITMAP_BITS
+
+#ifndef MQTT_QOS2_RELEASE_QUEUE_NUM
+    #define     MQTT_QOS2_RELEASE_QUEUE_NUM         16      // PUBREL received, PUBCOMP not yet sent
+#endif // !MQTT_QOS2_RELEASE_QUEUE_NUM
+
+#ifndef MQTT_HANDLER_POOL_NUM
+    #define     MQTT_HANDLER_POOL_NUM               4       // pooled handlers per client, the rest come from the heap
+#endif // !MQTT_HANDLER_POOL_NUM
+
+#ifndef MQTT_ACK_HANDLER_POOL_NUM
+    #define     MQTT_ACK_HANDLER_POOL_NUM           MQTT_HANDLER_POOL_NUM
+#endif // !MQTT_ACK_HANDLER_POOL_NUM
+
+#ifndef MQTT_MSG_HANDLER_POOL_NUM
+    #define     MQTT_MSG_HANDLER_POOL_NUM           MQTT_HANDLER_POOL_NUM   // resubscribe needs twice the number of topics
+#endif // !MQTT_MSG_HANDLER_POOL_NUM
+
+/* MQTT_STATIC_ALLOCATION: 客户端的所有内存由 mqtt_client_static_t 提供，运行时不使用堆 */
+#ifdef MQTT_STATIC_ALLOCATION
+
+#ifndef MQTT_STATIC_READ_BUF_SIZE
+    #define     MQTT_STATIC_READ_BUF_SIZE           MQTT_DEFAULT_BUF_SIZE
+#endif // !MQTT_STATIC_READ_BUF_SIZE
+
+#ifndef MQTT_STATIC_WRITE_BUF_SIZE
+    #define     MQTT_STATIC_WRITE_BUF_SIZE          MQTT_DEFAULT_BUF_SIZE
+#endif // !MQTT_STATIC_WRITE_BUF_SIZE
+
+/* 单位为字节，与 platform_thread_init_static 一致。MQTT_THREAD_STACK_SIZE 原样传给各平台的线程接口，
+ * 在 FreeRTOS 上按字（StackType_t）计数，使用 FreeRTOS 时需按字节单独设置 */
+#ifndef MQTT_STATIC_THREAD_STACK_SIZE
+    #define     MQTT_STATIC_THREAD_STACK_SIZE       MQTT_THREAD_STACK_SIZE      // unit: byte
+#endif // !MQTT_STATIC_THREAD_STACK_SIZE
+
+#ifndef MQTT_STATIC_ACK_HANDLER_NUM
+    #define     MQTT_STATIC_ACK_HANDLER_NUM         4       // in-flight qos1/qos2 packets, each block holds a full write buffer
+#endif // !MQTT_STATIC_ACK_HANDLER_NUM
+
+/* ack 处理器的块需要容纳完整的待重发报文，且不允许溢出到堆 */
+#undef      MQTT_ACK_HANDLER_POOL_NUM
+#define     MQTT_ACK_HANDLER_POOL_NUM               MQTT_STATIC_ACK_HANDLER_NUM
+#undef      MQTT_ACK_HANDLER_POOL_PAYLOAD_SIZE
+#define     MQTT_ACK_HANDLER_POOL_PAYLOAD_SIZE      MQTT_STATIC_WRITE_BUF_SIZE
+#undef      MQTT_HANDLER_POOL_OVERFLOW
+#define     MQTT_HANDLER_POOL_OVERFLOW              0
+
+#endif /* MQTT_STATIC_ALLOCATION */
+
+#ifndef MQTT_ACK_HANDLER_POOL_PAYLOAD_SIZE
+    #define     MQTT_ACK_HANDLER_POOL_PAYLOAD_SIZE  64      // unit: byte, larger packets overflow to the heap
+#endif // !MQTT_ACK_HANDLER_POOL_PAYLOAD_SIZE
+
+#ifndef MQTT_HANDLER_POOL_OVERFLOW
+    #define     MQTT_HANDLER_POOL_OVERFLOW          1       // allocate from the heap when the handler pool is exhausted
+#endif // !MQTT_HANDLER_POOL_OVERFLOW
+
+#ifndef MQTT_BATCH_MEMORY_BUDGET
+    #define     MQTT_BATCH_MEMORY_BUDGET            2048    // unit: byte, all topic batches of a batcher
+#endif // !MQTT_BATCH_MEMORY_BUDGET
+
+#ifndef MQTT_BATCH_MAX_BYTES
+    #define     MQTT_BATCH_MAX_BYTES                512     // unit: byte, payload of one batch
+#endif // !MQTT_BATCH_MAX_BYTES
+
+#ifndef MQTT_BATCH_MAX_SAMPLES
+    #define     MQTT_BATCH_MAX_SAMPLES              32
+#endif // !MQTT_BATCH_MAX_SAMPLES
+
+#ifndef MQTT_BATCH_MAX_LATENCY
+    #define     MQTT_BATCH_MAX_LATENCY              1000    // unit: millisecond
+#endif // !MQTT_BATCH_MAX_LATENCY
+
+#ifndef MQTT_RPC_PENDING_NUM
+    #define     MQTT_RPC_PENDING_NUM                16      // requests in flight per rpc instance, power of 2, at most 256
+#endif // !MQTT_RPC_PENDING_NUM
+
+#ifndef MQTT_RPC_TIMEOUT
+    #define     MQTT_RPC_TIMEOUT                    5000    // unit: millisecond
+#endif // !MQTT_RPC_TIMEOUT
+
+#ifndef MQTT_RPC_TOPIC_LEN_MAX
+    #define     MQTT_RPC_TOPIC_LEN_MAX              64      // request/response topic, including the correlation id
+#endif // !MQTT_RPC_TOPIC_LEN_MAX
+
+#ifndef MQTT_RPC_CLIENT_NUM_MAX
+    #define     MQTT_RPC_CLIENT_NUM_MAX             2       // rpc instances that can be registered at the same time
+#endif // !MQTT_RPC_CLIENT_NUM_MAX
+
+#ifndef MQTT_SHADOW_FIELD_NUM_MAX
+    #define     MQTT_SHADOW_FIELD_NUM_MAX           32      // fields of one shadow, one dirty bit each
+#endif // !MQTT_SHADOW_FIELD_NUM_MAX
+
+#ifndef MQTT_SHADOW_DOC_SIZE
+    #define     MQTT_SHADOW_DOC_SIZE                256     // unit: byte, reported delta document, fields that do not fit go into the next one
+#endif // !MQTT_SHADOW_DOC_SIZE
+
+#ifndef MQTT_SHADOW_WINDOW
+    #define     MQTT_SHADOW_WINDOW                  200     // unit: millisecond, changes within the window are reported together
+#endif // !MQTT_SHADOW_WINDOW
+
+#ifndef MQTT_SHADOW_FLOAT_DIGITS
+    #define     MQTT_SHADOW_FLOAT_DIGITS            2       // fraction digits of reported float fields
+#endif // !MQTT_SHADOW_FLOAT_DIGITS
+
+#ifndef MQTT_SHADOW_CLIENT_NUM_MAX
+    #define     MQTT_SHADOW_CLIENT_NUM_MAX          1       // shadow instances that can be registered at the same time
+#endif // !MQTT_SHADOW_CLIENT_NUM_MAX
+
+#ifndef MQTT_SN_TOPIC_NUM_MAX
+    #define     MQTT_SN_TOPIC_NUM_MAX               8       // registered, predefined and subscribed topics of one mqtt-sn client
+#endif // !MQTT_SN_TOPIC_NUM_MAX
+
+#ifndef MQTT_SN_TOPIC_LEN_MAX
+    #define     MQTT_SN_TOPIC_LEN_MAX               MQTT_TOPIC_LEN_MAX
+#endif // !MQTT_SN_TOPIC_LEN_MAX
+
+#ifndef MQTT_SN_BUF_SIZE
+    #define     MQTT_SN_BUF_SIZE                    256     // unit: byte, one datagram in each direction
+#endif // !MQTT_SN_BUF_SIZE
+
+#ifndef MQTT_SN_KEEP_ALIVE
+    #define     MQTT_SN_KEEP_ALIVE                  60      // unit: second
+#endif // !MQTT_SN_KEEP_ALIVE
+
+#ifndef MQTT_SN_RETRY_INTERVAL
+    #define     MQTT_SN_RETRY_INTERVAL              5000    // unit: millisecond, Tretry of the mqtt-sn spec
+#endif // !MQTT_SN_RETRY_INTERVAL
+
+#ifndef MQTT_SN_RETRY_MAX
+    #define     MQTT_SN_RETRY_MAX                   3       // Nretry of the mqtt-sn spec
+#endif // !MQTT_SN_RETRY_MAX
+
+#ifndef MQTT_NETWORK_TCP_NODELAY
+    #define     MQTT_NETWORK_TCP_NODELAY            1       // disable nagle, mqtt packets are small and latency bound
+#endif // !MQTT_NETWORK_TCP_NODELAY
+
+#ifndef MQTT_NETWORK_ZEROCOPY_MIN
+    #define     MQTT_NETWORK_ZEROCOPY_MIN           0       // unit: byte, send qos0 payloads of at least this much with MSG_ZEROCOPY where supported, 0 to disable; keep the payload unchanged until mqtt_get_zerocopy_pending() is 0, mqtt_publish_copy() (used by batch, shadow and rpc) never uses zerocopy
+#endif // !MQTT_NETWORK_ZEROCOPY_MIN
+
+#ifndef MQTT_NETWORK_SHM_RING_SIZE
+    #define     MQTT_NETWORK_SHM_RING_SIZE          (64 * 1024)     // unit: byte, each direction of a shared-memory channel, power of two
+#endif // !MQTT_NETWORK_SHM_RING_SIZE
+
+#ifndef MQTT_NETWORK_SHM_SPIN
+    #define     MQTT_NETWORK_SHM_SPIN               1000    // polls of an empty or full ring before sleeping on the futex, multi-core only
+#endif // !MQTT_NETWORK_SHM_SPIN
+
+#ifndef MQTT_NETWORK_SHM_NUM_MAX
+    #define     MQTT_NETWORK_SHM_NUM_MAX            4       // shared-memory channels mapped at the same time
+#endif // !MQTT_NETWORK_SHM_NUM_MAX
+
+#if !defined(MQTT_NETWORK_TYPE_NO_TLS) && !defined(MQTT_NETWORK_TYPE_TLS)
+    #define MQTT_NETWORK_TYPE_NO_TLS 1          // this board has no TLS, define MQTT_NETWORK_TYPE_TLS in mqtt_config.h or on the command line to build the TLS transport
+#endif // !MQTT_NETWORK_TYPE_NO_TLS && !MQTT_NETWORK_TYPE_TLS
 
 #ifndef MQTT_NETWORK_TYPE_NO_TLS
 
 #ifndef MQTT_TLS_HANDSHAKE_TIMEOUT
     #define MQTT_TLS_HANDSHAKE_TIMEOUT  (5 * 1000)
 #endif // !MQTT_TLS_HANDSHAKE_TIMEOUT
+
+#ifndef MQTT_TLS_SESSION_RESUMPTION
+    #define MQTT_TLS_SESSION_RESUMPTION 1       // resume the previous session (ticket or session id) on reconnect, 0 to always do a full handshake
+#endif // !MQTT_TLS_SESSION_RESUMPTION
+
+#ifndef MQTT_TLS_PSK_CIPHERSUITE
+    #define MQTT_TLS_PSK_CIPHERSUITE    MBEDTLS_TLS_PSK_WITH_AES_128_CCM_8     // the only suite offered in psk mode
+#endif // !MQTT_TLS_PSK_CIPHERSUITE
+
+#ifndef MQTT_TLS_ECP_MAX_OPS
+    #define MQTT_TLS_ECP_MAX_OPS        0       // MCU opt-in: ECC work per handshake slice, needs MBEDTLS_ECP_RESTARTABLE (a P-256 multiplication is about 3300, 500 keeps a slice under 1 ms on a desktop), 0 runs each operation in one go
+#endif // !MQTT_TLS_ECP_MAX_OPS
+
+#ifndef MQTT_TLS_ECP_YIELD_MS
+    #define MQTT_TLS_ECP_YIELD_MS       1       // unit: millisecond, sleep between ECC slices so lower priority tasks also run, 0 only yields to tasks of the same priority
+#endif // !MQTT_TLS_ECP_YIELD_MS
+
+#ifndef MQTT_TLS_ECDHE_POOL_SIZE
+    #define MQTT_TLS_ECDHE_POOL_SIZE    0       // opt-in: secp256r1 ECDHE key pairs kept ready by network_tls_ecdhe_pool_start(), also needs MBEDTLS_ECDH_PRECOMPUTED, 0 leaves the pool out
+#endif // !MQTT_TLS_ECDHE_POOL_SIZE
+
+#ifndef MQTT_TLS_ECDHE_POOL_IDLE_MS
+    #define MQTT_TLS_ECDHE_POOL_IDLE_MS 100     // unit: millisecond, how often a full pool looks for a used key pair
+#endif // !MQTT_TLS_ECDHE_POOL_IDLE_MS
+
+#ifndef MQTT_TLS_ECDHE_POOL_STACK_SIZE
+    #define MQTT_TLS_ECDHE_POOL_STACK_SIZE  2048
+#endif // !MQTT_TLS_ECDHE_POOL_STACK_SIZE
+
+#ifndef MQTT_TLS_ECDHE_POOL_PRIO
+    #define MQTT_TLS_ECDHE_POOL_PRIO    1       // keep it below every other task so the key pairs are computed in idle time (on RT-Thread and TencentOS-tiny larger numbers are less urgent)
+#endif // !MQTT_TLS_ECDHE_POOL_PRIO
+
+#ifndef MQTT_TLS_PINNING
+    #define MQTT_TLS_PINNING            0       // pin the server public key for contexts built from mqtt_set_ca(), after the first fully verified handshake the chain is only verified again when the key changes
+#endif // !MQTT_TLS_PINNING
+
+#ifndef MQTT_TLS_KTLS
+    #define MQTT_TLS_KTLS               0       // linux: after the handshake hand the AES-GCM/AES-CCM/ChaCha20-Poly1305 record layer to the kernel (TCP_ULP "tls"), mbedtls keeps it when the kernel or the suite does not support it
+#endif // !MQTT_TLS_KTLS
     
+#if !defined(MBEDTLS_CONFIG_FILE)
     #include "mbedtls/config.h"
+#else
+    #include MBEDTLS_CONFIG_FILE
+#endif
     #include "mbedtls/ssl.h"
     #include "mbedtls/entropy.h"
     #include "mbedtls/net_sockets.h"
     #include "mbedtls/ctr_drbg.h"
     #include "mbedtls/error.h"
     #include "mbedtls/debug.h"
+
+#ifndef MQTT_TLS_MAX_FRAG_LEN       // max_fragment_length requested from the broker, follows the input record buffer
+    #if MBEDTLS_SSL_IN_CONTENT_LEN <= 512
+        #define MQTT_TLS_MAX_FRAG_LEN   MBEDTLS_SSL_MAX_FRAG_LEN_512
+    #elif MBEDTLS_SSL_IN_CONTENT_LEN <= 1024
+        #define MQTT_TLS_MAX_FRAG_LEN   MBEDTLS_SSL_MAX_FRAG_LEN_1024
+    #elif MBEDTLS_SSL_IN_CONTENT_LEN <= 2048
+        #define MQTT_TLS_MAX_FRAG_LEN   MBEDTLS_SSL_MAX_FRAG_LEN_2048
+    #elif MBEDTLS_SSL_IN_CONTENT_LEN <= 4096
+        #define MQTT_TLS_MAX_FRAG_LEN   MBEDTLS_SSL_MAX_FRAG_LEN_4096
+    #else
+        #define MQTT_TLS_MAX_FRAG_LEN   MBEDTLS_SSL_MAX_FRAG_LEN_NONE
+    #endif
+#endif // !MQTT_TLS_MAX_FRAG_LEN
+
+#ifndef MQTT_TLS_ARENA_CONNECTIONS
+    #define MQTT_TLS_ARENA_CONNECTIONS  1       // tls connections open at the same time, a client with a standby endpoint counts twice
+#endif // !MQTT_TLS_ARENA_CONNECTIONS
+
+#ifndef MQTT_TLS_ARENA_CONNECTION_OVERHEAD
+    #define MQTT_TLS_ARENA_CONNECTION_OVERHEAD  (24 * 1024)     // unit: byte, context, certificates, ECDHE handshake state and allocator headers per connection on top of the record buffers
+#endif // !MQTT_TLS_ARENA_CONNECTION_OVERHEAD
+
+#ifndef MQTT_TLS_ARENA_SIZE
+    #if defined(MBEDTLS_MEMORY_BUFFER_ALLOC_C)
+        #define MQTT_TLS_ARENA_SIZE     (MQTT_TLS_ARENA_CONNECTIONS * (MBEDTLS_SSL_IN_CONTENT_LEN + MBEDTLS_SSL_OUT_CONTENT_LEN + MQTT_TLS_ARENA_CONNECTION_OVERHEAD))
+    #else
+        #define MQTT_TLS_ARENA_SIZE     0       // mbedtls allocates from platform_memory
+    #endif
+#endif // !MQTT_TLS_ARENA_SIZE
 #endif /* MQTT_NETWORK_TYPE_NO_TLS */
 
 #endif /* _DEFCONFIG_H_ */
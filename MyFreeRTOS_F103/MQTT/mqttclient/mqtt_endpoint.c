@@ -0,0 +1,148 @@
+/*
+ * @Date: 2026-10-19
+ * @Description: broker endpoint list with health scoring, used for failover.
+ */
+#include <string.h>
+#include "mqtt_endpoint.h"
+#include "mqtt_error.h"
+
+/**
+ * @brief 计算端点的排序权值，分数与权重的乘积
+ *
+ * @param ep 端点
+ * @return uint32_t 权值
+ */
+static uint32_t mqtt_endpoint_rank(mqtt_endpoint_t *ep)
+{
+    return (uint32_t)ep->score * (ep->weight ? ep->weight : 1);
+}
+
+/**
+ * @brief 初始化端点列表
+ *
+ * @param l 端点列表
+ */
+void mqtt_endpoint_list_init(mqtt_endpoint_list_t *l)
+{
+    if (NULL == l)
+        return;
+
+    memset(l, 0, sizeof(mqtt_endpoint_list_t));
+    l->curr = -1;
+}
+
+/**
+ * @brief 添加一个服务器端点，添加顺序决定同权值端点的优先级
+ *
+ * @param l 端点列表
+ * @param host 服务器地址
+ * @param port 服务器端口
+ * @param ca CA 证书，不使用 TLS 时为 NULL
+ * @param weight 权重，0 按 1 处理
+ * @return int 成功返回端点索引，失败返回错误码
+ */
+int mqtt_endpoint_list_add(mqtt_endpoint_list_t *l, const char *host, const char *port, const char *ca, uint8_t weight)
+{
+    mqtt_endpoint_t *ep;
+
+    if ((NULL == l) || (NULL == host) || (NULL == port))
+        RETURN_ERROR(MQTT_NULL_VALUE_ERROR);
+
+    if (l->num >= MQTT_ENDPOINT_NUM_MAX)
+        RETURN_ERROR(MQTT_MEM_NOT_ENOUGH_ERROR);
+
+    ep = &l->endpoint[l->num];
+    ep->host = host;
+    ep->port = port;
+    ep->ca = ca;
+    ep->weight = weight;
+    ep->score = MQTT_ENDPOINT_SCORE_MAX;
+    ep->fail_count = 0;
+    platform_timer_init(&ep->backoff);
+
+    return l->num++;
+}
+
+/**
+ * @brief 选择下一个要连接的端点，优先选择不在退避期间且权值最高的端点。
+ *        所有候选端点都在退避期间时，若本轮尚未尝试任何端点，则返回其中权值最高的端点，保证每轮至少尝试一次
+ *
+ * @param l 端点列表
+ * @param skip_mask 本轮已经尝试过的端点，bit n 对应索引 n
+ * @return int 端点索引，没有可用端点时返回 -1
+ */
+int mqtt_endpoint_list_select(mqtt_endpoint_list_t *l, uint32_t skip_mask)
+{
+    int i, best = -1, fallback = -1;
+    mqtt_endpoint_t *ep;
+
+    if (NULL == l)
+        return -1;
+
+    for (i = 0; i < l->num; i++) {
+        if (skip_mask & (1u << i))
+            continue;
+
+        ep = &l->endpoint[i];
+        if (platform_timer_is_expired(&ep->backoff)) {
+            if ((best < 0) || (mqtt_endpoint_rank(ep) > mqtt_endpoint_rank(&l->endpoint[best])))
+                best = i;
+        } else {
+            if ((fallback < 0) || (mqtt_endpoint_rank(ep) > mqtt_endpoint_rank(&l->endpoint[fallback])))
+                fallback = i;
+        }
+    }
+
+    if ((best < 0) && (0 == skip_mask))
+        best = fallback;
+
+    return best;
+}
+
+/**
+ * @brief 报告端点的连接结果，更新健康分数与退避时间
+ *
+ * @param l 端点列表
+ * @param index 端点索引
+ * @param success 非 0 表示连接成功
+ */
+void mqtt_endpoint_list_report(mqtt_endpoint_list_t *l, int index, int success)
+{
+    uint32_t backoff;
+    mqtt_endpoint_t *ep = mqtt_endpoint_list_get(l, index);
+
+    if (NULL == ep)
+        return;
+
+    if (success) {
+        ep->score = MQTT_ENDPOINT_SCORE_MAX;
+        ep->fail_count = 0;
+        platform_timer_init(&ep->backoff);
+        return;
+    }
+
+    ep->score -= ep->score / 2;
+    if (ep->fail_count < 16)
+        ep->fail_count++;
+
+    /* 指数退避 */
+    backoff = (uint32_t)MQTT_ENDPOINT_BACKOFF_MIN << (ep->fail_count - 1);
+    if (backoff > MQTT_ENDPOINT_BACKOFF_MAX)
+        backoff = MQTT_ENDPOINT_BACKOFF_MAX;
+    platform_timer_cutdown(&ep->backoff, backoff);
+}
+
+/**
+ * @brief 获取端点
+ *
+ * @param l 端点列表
+ * @param index 端点索引
+ * @return mqtt_endpoint_t* 端点，索引无效时返回 NULL
+ */
+mqtt_endpoint_t *mqtt_endpoint_list_get(mqtt_endpoint_list_t *l, int index)
+{
+    if ((NULL == l) || (index < 0) || (index >= l->num))
+        return NULL;
+
+    return &l->endpoint[index];
+}
@@ -0,0 +1,44 @@
+/*
+ * @Date: 2026-10-19
+ * @Description: broker endpoint list with health scoring, used for failover.
+ */
+#ifndef _MQTT_ENDPOINT_H_
+#define _MQTT_ENDPOINT_H_
+
+#include <stdint.h>
+#include "mqtt_defconfig.h"
+#include "platform_timer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define     MQTT_ENDPOINT_SCORE_MAX     100
+
+typedef struct mqtt_endpoint {
+    const char                  *host;
+    const char                  *port;
+    const char                  *ca;
+    uint8_t                     weight;
+    uint8_t                     score;          /* 健康分数，连接成功恢复为满分，失败减半 */
+    uint8_t                     fail_count;     /* 连续失败次数，决定退避时间 */
+    platform_timer_t            backoff;        /* 退避期间该端点视为不健康 */
+} mqtt_endpoint_t;
+
+typedef struct mqtt_endpoint_list {
+    mqtt_endpoint_t             endpoint[MQTT_ENDPOINT_NUM_MAX];
+    uint8_t                     num;
+    int8_t                      curr;
+} mqtt_endpoint_list_t;
+
+void mqtt_endpoint_list_init(mqtt_endpoint_list_t *l);
+int mqtt_endpoint_list_add(mqtt_endpoint_list_t *l, const char *host, const char *port, const char *ca, uint8_t weight);
+int mqtt_endpoint_list_select(mqtt_endpoint_list_t *l, uint32_t skip_mask);
+void mqtt_endpoint_list_report(mqtt_endpoint_list_t *l, int index, int success);
+mqtt_endpoint_t *mqtt_endpoint_list_get(mqtt_endpoint_list_t *l, int index);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _MQTT_ENDPOINT_H_ */
@@ -0,0 +1,148 @@
+/*
+ * @Date: 2026-10-19
+ * @Description: inbound qos2 state, packet id bitmap and release queue.
+ */
+#include <string.h>
+#include "mqtt_qos2.h"
+
+#if (MQTT_QOS2_BITMAP_BITS < 8) || (MQTT_QOS2_BITMAP_BITS > 65536) || (MQTT_QOS2_BITMAP_BITS & (MQTT_QOS2_BITMAP_BITS - 1))
+    #error "MQTT_QOS2_BITMAP_BITS must be a power of 2 between 8 and 65536"
+#endif
+
+#define MQTT_QOS2_BIT(id)       ((uint32_t)(id) & (MQTT_QOS2_BITMAP_BITS - 1))
+
+/**
+ * @brief 初始化入站 QoS2 状态
+ *
+ * @param q 入站 QoS2 状态
+ */
+void mqtt_qos2_init(mqtt_qos2_t *q)
+{
+    memset(q, 0, sizeof(mqtt_qos2_t));
+}
+
+/**
+ * @brief 将窗口向前滑动，使 packet_id 成为窗口中最大的报文标识符，并清除新进入窗口的位
+ *
+ * @param q 入站 QoS2 状态
+ * @param packet_id 报文标识符
+ */
+static void mqtt_qos2_slide(mqtt_qos2_t *q, uint16_t packet_id)
+{
+    uint16_t id, new_base = (uint16_t)(packet_id - (MQTT_QOS2_BITMAP_BITS - 1));
+    uint16_t shift = (uint16_t)(new_base - q->base);
+
+    if (shift >= MQTT_QOS2_BITMAP_BITS) {
+        memset(q->bitmap, 0, sizeof(q->bitmap));
+    } else {
+        for (id = (uint16_t)(q->base + MQTT_QOS2_BITMAP_BITS); id != (uint16_t)(packet_id + 1); id++)
+            q->bitmap[MQTT_QOS2_BIT(id) >> 3] &= ~(1u << (MQTT_QOS2_BIT(id) & 7));
+    }
+
+    q->base = new_base;
+}
+
+/**
+ * @brief 记录收到的 QoS2 报文
+ *
+ * @param q 入站 QoS2 状态
+ * @param packet_id 报文标识符
+ * @return int 首次收到返回 1，重复报文返回 0
+ */
+int mqtt_qos2_mark(mqtt_qos2_t *q, uint16_t packet_id)
+{
+    uint32_t bit;
+    uint16_t offset = (uint16_t)(packet_id - q->base);
+
+    if (offset >= MQTT_QOS2_BITMAP_BITS) {
+        /* 落在窗口之后的报文已无法判断是否重复，按新报文处理 */
+        if (offset >= 0x8000)
+            return 1;
+        mqtt_qos2_slide(q, packet_id);
+    }
+
+    bit = MQTT_QOS2_BIT(packet_id);
+    if (q->bitmap[bit >> 3] & (1u << (bit & 7)))
+        return 0;
+
+    q->bitmap[bit >> 3] |= (1u << (bit & 7));
+
+    return 1;
+}
+
+/**
+ * @brief 收到 PUBREL 后清除记录，该报文标识符可被服务器再次使用
+ *
+ * @param q 入站 QoS2 状态
+ * @param packet_id 报文标识符
+ */
+void mqtt_qos2_clear(mqtt_qos2_t *q, uint16_t packet_id)
+{
+    uint32_t bit;
+
+    if ((uint16_t)(packet_id - q->base) >= MQTT_QOS2_BITMAP_BITS)
+        return;
+
+    bit = MQTT_QOS2_BIT(packet_id);
+    q->bitmap[bit >> 3] &= ~(1u << (bit & 7));
+}
+
+/**
+ * @brief 将待回复 PUBCOMP 的报文标识符加入释放队列
+ *
+ * @param q 入站 QoS2 状态
+ * @param packet_id 报文标识符
+ * @return int 成功返回 0，队列已满返回 -1
+ */
+int mqtt_qos2_release_push(mqtt_qos2_t *q, uint16_t packet_id)
+{
+    if (q->release_count >= MQTT_QOS2_RELEASE_QUEUE_NUM)
+        return -1;
+
+    q->release_queue[(q->release_head + q->release_count) % MQTT_QOS2_RELEASE_QUEUE_NUM] = packet_id;
+    q->release_count++;
+
+    return 0;
+}
+
+/**
+ * @brief 获取释放队列中最早的报文标识符
+ *
+ * @param q 入站 QoS2 状态
+ * @param packet_id 报文标识符输出
+ * @return int 队列非空返回 1，否则返回 0
+ */
+int mqtt_qos2_release_peek(mqtt_qos2_t *q, uint16_t *packet_id)
+{
+    if (0 == q->release_count)
+        return 0;
+
+    *packet_id = q->release_queue[q->release_head];
+
+    return 1;
+}
+
+/**
+ * @brief 移除释放队列中最早的报文标识符
+ *
+ * @param q 入站 QoS2 状态
+ */
+void mqtt_qos2_release_pop(mqtt_qos2_t *q)
+{
+    if (0 == q->release_count)
+        return;
+
+    q->release_head = (q->release_head + 1) % MQTT_QOS2_RELEASE_QUEUE_NUM;
+    q->release_count--;
+}
+
+/**
+ * @brief 清空释放队列，重新连接后服务器会重发 PUBREL
+ *
+ * @param q 入站 QoS2 状态
+ */
+void mqtt_qos2_release_reset(mqtt_qos2_t *q)
+{
+    q->release_head = 0;
+    q->release_count = 0;
+}
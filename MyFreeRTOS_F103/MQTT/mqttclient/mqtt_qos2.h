@@ -0,0 +1,43 @@
+/*
+ * @Date: 2026-10-19
+ * @Description: inbound qos2 state, packet id bitmap and release queue.
+ */
+#ifndef _MQTT_QOS2_H_
+#define _MQTT_QOS2_H_
+
+#include <stdint.h>
+#include "mqtt_defconfig.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * 每个报文标识符占一位，置位表示已收到 PUBLISH 但尚未收到 PUBREL。
+ * MQTT_QOS2_BITMAP_BITS 为 65536 时覆盖全部报文标识符；
+ * 较小时（必须是 2 的幂）只跟踪最近的一段窗口，窗口随新的报文标识符向前滑动，
+ * 落在窗口之后的报文按新报文处理。
+ */
+#define     MQTT_QOS2_BITMAP_BYTES      (MQTT_QOS2_BITMAP_BITS / 8)
+
+typedef struct mqtt_qos2 {
+    uint16_t                    base;           /* 窗口中最小的报文标识符 */
+    uint16_t                    release_head;
+    uint16_t                    release_count;
+    uint16_t                    release_queue[MQTT_QOS2_RELEASE_QUEUE_NUM];
+    uint8_t                     bitmap[MQTT_QOS2_BITMAP_BYTES];
+} mqtt_qos2_t;
+
+void mqtt_qos2_init(mqtt_qos2_t *q);
+int mqtt_qos2_mark(mqtt_qos2_t *q, uint16_t packet_id);
+void mqtt_qos2_clear(mqtt_qos2_t *q, uint16_t packet_id);
+int mqtt_qos2_release_push(mqtt_qos2_t *q, uint16_t packet_id);
+int mqtt_qos2_release_peek(mqtt_qos2_t *q, uint16_t *packet_id);
+void mqtt_qos2_release_pop(mqtt_qos2_t *q);
+void mqtt_qos2_release_reset(mqtt_qos2_t *q);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _MQTT_QOS2_H_ */
@@ -0,0 +1,636 @@
+/*
+ * @Date: 2026-10-19
+ * @Description: request/response rpc on top of mqtt_publish with correlation ids.
+ */
+#include "mqtt_rpc.h"
+
+#if (MQTT_RPC_PENDING_NUM < 1) || (MQTT_RPC_PENDING_NUM > 256) || (MQTT_RPC_PENDING_NUM & (MQTT_RPC_PENDING_NUM - 1))
+    #error "MQTT_RPC_PENDING_NUM must be a power of 2 between 1 and 256"
+#endif
+
+#define MQTT_RPC_SLOT_BITS      8
+#define MQTT_RPC_SLOT_MASK      (MQTT_RPC_PENDING_NUM - 1)
+
+/* 消息处理函数只能拿到客户端实例，通过该表找到客户端对应的 rpc 实例。
+ * 该表由 mqtt 线程读取，修改时需持有 mqtt_rpc_registry_lock，锁在第一次 mqtt_rpc_init 时初始化，
+ * 多个 rpc 实例应在启动阶段依次初始化 */
+static mqtt_rpc_t *mqtt_rpc_registry[MQTT_RPC_CLIENT_NUM_MAX];
+static platform_mutex_t mqtt_rpc_registry_lock;
+static int mqtt_rpc_registry_ready = 0;
+
+/**
+ * @brief 根据客户端实例查找 rpc 实例
+ *
+ * @param client MQTT 客户端实例，调用者需持有 mqtt_rpc_registry_lock
+ * @return mqtt_rpc_t* 找到的 rpc 实例，未找到返回 NULL
+ */
+static mqtt_rpc_t *mqtt_rpc_lookup(void *client)
+{
+    int i;
+
+    for (i = 0; i < MQTT_RPC_CLIENT_NUM_MAX; i++) {
+        if ((NULL != mqtt_rpc_registry[i]) && (mqtt_rpc_registry[i]->client == client))
+            return mqtt_rpc_registry[i];
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief 将关联 ID 追加到主题末尾，格式为 <topic>/<8 位十六进制>
+ *
+ * @param buf 输出缓冲区，长度为 MQTT_RPC_TOPIC_LEN_MAX
+ * @param topic 主题前缀
+ * @param id 关联 ID
+ * @return int 返回状态码，主题过长时返回 MQTT_BUFFER_TOO_SHORT_ERROR
+ */
+static int mqtt_rpc_topic_build(char *buf, const char *topic, uint32_t id)
+{
+    static const char hex[] = "0123456789abcdef";
+    size_t len = strlen(topic);
+    int i;
+
+    if (len + 1 + MQTT_RPC_ID_LEN + 1 > MQTT_RPC_TOPIC_LEN_MAX)
+        RETURN_ERROR(MQTT_BUFFER_TOO_SHORT_ERROR);
+
+    memcpy(buf, topic, len);
+    buf[len++] = '/';
+    for (i = MQTT_RPC_ID_LEN - 1; i >= 0; i--) {
+        buf[len + i] = hex[id & 0x0f];
+        id >>= 4;
+    }
+    buf[len + MQTT_RPC_ID_LEN] = '\0';
+
+    RETURN_ERROR(MQTT_SUCCESS_ERROR);
+}
+
+/**
+ * @brief 从响应主题的最后一级解析关联 ID
+ *
+ * @param topic 主题名，不要求以 '\0' 结尾
+ * @param len 主题长度
+ * @param id 输出关联 ID
+ * @return int 返回状态码，格式错误时返回 MQTT_FAILED_ERROR
+ */
+static int mqtt_rpc_topic_parse(const char *topic, uint16_t len, uint32_t *id)
+{
+    uint32_t v = 0;
+    char ch;
+    int i;
+
+    if ((len < MQTT_RPC_ID_LEN + 1) || (topic[len - MQTT_RPC_ID_LEN - 1] != '/'))
+        RETURN_ERROR(MQTT_FAILED_ERROR);
+
+    for (i = len - MQTT_RPC_ID_LEN; i < len; i++) {
+        ch = topic[i];
+        if ((ch >= '0') && (ch <= '9'))
+            v = (v << 4) | (ch - '0');
+        else if ((ch >= 'a') && (ch <= 'f'))
+            v = (v << 4) | (ch - 'a' + 10);
+        else
+            RETURN_ERROR(MQTT_FAILED_ERROR);
+    }
+
+    *id = v;
+    RETURN_ERROR(MQTT_SUCCESS_ERROR);
+}
+
+/**
+ * @brief 分配一个等待表项，关联 ID 由表项下标和递增的序号组成，迟到的旧响应不会匹配到新请求
+ *
+ * @param r rpc 实例，调用者需持有锁
+ * @param timeout 超时时间，单位毫秒
+ * @return mqtt_rpc_call_t* 分配的表项，等待表已满返回 NULL
+ */
+static mqtt_rpc_call_t *mqtt_rpc_call_alloc(mqtt_rpc_t *r, uint32_t timeout)
+{
+    mqtt_rpc_call_t *call;
+    uint8_t slot;
+
+    if (0 == r->free_num)
+        return NULL;
+
+    slot = r->free_slot[--r->free_num];
+    call = &r->calls[slot];
+
+    memset(call, 0, sizeof(mqtt_rpc_call_t));
+    call->id = ((uint32_t)(++r->seq) << MQTT_RPC_SLOT_BITS) | slot;
+    call->state = MQTT_RPC_STATE_PENDING;
+    platform_timer_cutdown(&call->deadline, timeout);
+
+    return call;
+}
+
+/**
+ * @brief 释放等待表项
+ *
+ * @param r rpc 实例，调用者需持有锁
+ * @param call 等待表项
+ */
+static void mqtt_rpc_call_free(mqtt_rpc_t *r, mqtt_rpc_call_t *call)
+{
+    call->state = MQTT_RPC_STATE_FREE;
+    call->id = 0;
+    r->free_slot[r->free_num++] = (uint8_t)(call - r->calls);
+}
+
+/**
+ * @brief 根据句柄查找等待表项
+ *
+ * @param r rpc 实例，调用者需持有锁
+ * @param id 关联 ID
+ * @return mqtt_rpc_call_t* 找到的表项，ID 不匹配或已释放返回 NULL
+ */
+static mqtt_rpc_call_t *mqtt_rpc_call_find(mqtt_rpc_t *r, uint32_t id)
+{
+    mqtt_rpc_call_t *call = &r->calls[id & MQTT_RPC_SLOT_MASK];
+
+    if ((MQTT_RPC_STATE_FREE == call->state) || (call->id != id))
+        return NULL;
+
+    return call;
+}
+
+/**
+ * @brief 进入 rpc 接口，记录调用者数量，mqtt_rpc_release 开始后不再接受新的调用
+ *
+ * @param r rpc 实例
+ * @return int 返回状态码，实例正在释放时返回 MQTT_FAILED_ERROR
+ */
+static int mqtt_rpc_enter(mqtt_rpc_t *r)
+{
+    int rc = MQTT_SUCCESS_ERROR;
+
+    platform_mutex_lock(&r->lock);
+    if (r->closing)
+        rc = MQTT_FAILED_ERROR;
+    else
+        r->users++;
+    platform_mutex_unlock(&r->lock);
+
+    RETURN_ERROR(rc);
+}
+
+/**
+ * @brief 离开 rpc 接口，之后调用者不再访问该实例
+ *
+ * @param r rpc 实例
+ */
+static void mqtt_rpc_leave(mqtt_rpc_t *r)
+{
+    platform_mutex_lock(&r->lock);
+    r->users--;
+    platform_mutex_unlock(&r->lock);
+}
+
+/**
+ * @brief 响应主题的消息处理函数，按关联 ID 直接定位等待表项
+ *
+ * @param client MQTT 客户端实例
+ * @param msg 收到的响应消息
+ */
+static void mqtt_rpc_response_handler(void *client, message_data_t *msg)
+{
+    mqtt_rpc_t *r;
+    mqtt_rpc_call_t *call;
+    mqtt_rpc_callback_t callback = NULL;
+    void *arg = NULL;
+    uint32_t id, len;
+
+    if (MQTT_SUCCESS_ERROR != mqtt_rpc_topic_parse(msg->topic_name, msg->topic_len, &id))
+        return;
+
+    len = (uint32_t)msg->message->payloadlen;
+
+    /* 处理期间一直持有注册表锁，mqtt_rpc_release 在移除表项后不会再有处理函数访问该实例 */
+    platform_mutex_lock(&mqtt_rpc_registry_lock);
+    if (NULL == (r = mqtt_rpc_lookup(client))) {
+        platform_mutex_unlock(&mqtt_rpc_registry_lock);
+        return;
+    }
+
+    platform_mutex_lock(&r->lock);
+
+    call = mqtt_rpc_call_find(r, id);
+    if ((NULL == call) || (MQTT_RPC_STATE_PENDING != call->state)) {
+        platform_mutex_unlock(&r->lock);
+        platform_mutex_unlock(&mqtt_rpc_registry_lock);
+        MQTT_LOG_D("%s:%d %s()... drop late rpc response %08x", __FILE__, __LINE__, __FUNCTION__, (unsigned int)id);
+        return;
+    }
+
+    if (NULL != call->callback) {
+        /* 回调在锁外执行，回调中可以再次发起请求 */
+        callback = call->callback;
+        arg = call->arg;
+        mqtt_rpc_call_free(r, call);
+    } else {
+        /* 响应数据在读缓冲区中，返回后即被覆盖，复制到调用者提供的缓冲区 */
+        call->resp_len = len;
+        call->rc = MQTT_SUCCESS_ERROR;
+        if (len > call->resp_size) {
+            len = call->resp_size;
+            call->rc = MQTT_BUFFER_TOO_SHORT_ERROR;
+        }
+        if (len > 0)
+            memcpy(call->resp_buf, msg->message->payload, len);
+        call->state = MQTT_RPC_STATE_DONE;
+        platform_sem_post(&r->done[call - r->calls]);
+    }
+
+    platform_mutex_unlock(&r->lock);
+    platform_mutex_unlock(&mqtt_rpc_registry_lock);
+
+    if (NULL != callback)
+        callback(arg, MQTT_SUCCESS_ERROR, msg->message->payload, len);
+}
+
+/**
+ * @brief 发布请求报文，失败时释放等待表项
+ *
+ * @param r rpc 实例
+ * @param call 已分配的等待表项
+ * @param request_topic 请求主题前缀
+ * @param payload 请求数据
+ * @param len 请求数据长度
+ * @return int 成功返回句柄（关联 ID），失败返回错误码
+ */
+static int mqtt_rpc_send(mqtt_rpc_t *r, mqtt_rpc_call_t *call, const char *request_topic, const void *payload, uint32_t len)
+{
+    int rc;
+    uint32_t id = call->id;
+    char topic[MQTT_RPC_TOPIC_LEN_MAX];
+    mqtt_message_t msg;
+
+    rc = mqtt_rpc_topic_build(topic, request_topic, id);
+    if (MQTT_SUCCESS_ERROR == rc) {
+        memset(&msg, 0, sizeof(msg));
+        msg.qos = r->qos;
+        msg.payload = (void *)payload;
+        msg.payloadlen = len;
+
+        /* 发布时不持有 rpc 锁，响应可能在发布返回前就已到达 */
+        rc = mqtt_publish_copy(r->client, topic, &msg);
+    }
+
+    if (MQTT_SUCCESS_ERROR != rc) {
+        platform_mutex_lock(&r->lock);
+        if (call == mqtt_rpc_call_find(r, id))
+            mqtt_rpc_call_free(r, call);
+        platform_mutex_unlock(&r->lock);
+        RETURN_ERROR(rc);
+    }
+
+    return (int)id;
+}
+
+/**
+ * @brief 初始化 rpc 实例，订阅共用的响应主题 <response_prefix>/+
+ *
+ * @param r rpc 实例，由调用者提供存储空间
+ * @param c MQTT 客户端实例，需已连接
+ * @param response_prefix 响应主题前缀
+ * @param qos 请求与响应订阅使用的 QoS 等级
+ * @return int 返回状态码，MQTT_SUCCESS_ERROR 表示成功
+ */
+int mqtt_rpc_init(mqtt_rpc_t *r, mqtt_client_t *c, const char *response_prefix, mqtt_qos_t qos)
+{
+    int i, rc;
+    size_t len;
+
+    if ((NULL == r) || (NULL == c) || (NULL == response_prefix))
+        RETURN_ERROR(MQTT_NULL_VALUE_ERROR);
+
+    len = strlen(response_prefix);
+    if (len + 1 + MQTT_RPC_ID_LEN + 1 > MQTT_RPC_TOPIC_LEN_MAX)
+        RETURN_ERROR(MQTT_BUFFER_TOO_SHORT_ERROR);
+
+    memset(r, 0, sizeof(mqtt_rpc_t));
+
+    r->client = c;
+    r->qos = qos;
+    memcpy(r->response_filter, response_prefix, len);
+    memcpy(r->response_filter + len, "/+", 3);
+
+    for (i = 0; i < MQTT_RPC_PENDING_NUM; i++)
+        r->free_slot[i] = (uint8_t)(MQTT_RPC_PENDING_NUM - 1 - i);
+    r->free_num = MQTT_RPC_PENDING_NUM;
+
+    for (i = 0; i < MQTT_RPC_PENDING_NUM; i++) {
+        if (0 != platform_sem_init(&r->done[i])) {
+            while (i-- > 0)
+                platform_sem_destroy(&r->done[i]);
+            RETURN_ERROR(MQTT_MEM_NOT_ENOUGH_ERROR);
+        }
+    }
+
+    if (!mqtt_rpc_registry_ready) {
+        platform_mutex_init(&mqtt_rpc_registry_lock);
+        mqtt_rpc_registry_ready = 1;
+    }
+
+    platform_mutex_init(&r->lock);
+
+    platform_mutex_lock(&mqtt_rpc_registry_lock);
+    for (i = 0; i < MQTT_RPC_CLIENT_NUM_MAX; i++) {
+        if (NULL == mqtt_rpc_registry[i]) {
+            mqtt_rpc_registry[i] = r;
+            break;
+        }
+    }
+    platform_mutex_unlock(&mqtt_rpc_registry_lock);
+
+    if (i == MQTT_RPC_CLIENT_NUM_MAX) {
+        rc = MQTT_MEM_NOT_ENOUGH_ERROR;
+        goto exit;
+    }
+
+    rc = mqtt_subscribe(c, r->response_filter, qos, mqtt_rpc_response_handler);
+    if (MQTT_SUCCESS_ERROR != rc) {
+        platform_mutex_lock(&mqtt_rpc_registry_lock);
+        mqtt_rpc_registry[i] = NULL;
+        platform_mutex_unlock(&mqtt_rpc_registry_lock);
+        goto exit;
+    }
+
+    RETURN_ERROR(MQTT_SUCCESS_ERROR);
+
+exit:
+    platform_mutex_destroy(&r->lock);
+    for (i = 0; i < MQTT_RPC_PENDING_NUM; i++)
+        platform_sem_destroy(&r->done[i]);
+
+    RETURN_ERROR(rc);
+}
+
+/**
+ * @brief 发起一个请求并立即返回，之后通过 mqtt_rpc_wait 获取响应。可以同时发起多个请求
+ *
+ * @param r rpc 实例
+ * @param request_topic 请求主题前缀
+ * @param payload 请求数据
+ * @param len 请求数据长度
+ * @param timeout 超时时间，单位毫秒，0 表示使用 MQTT_RPC_TIMEOUT
+ * @param resp_buf 响应数据缓冲区，需在 mqtt_rpc_wait 返回前保持有效
+ * @param resp_size 响应数据缓冲区大小
+ * @return int 成功返回请求句柄（非负），失败返回错误码
+ */
+int mqtt_rpc_request(mqtt_rpc_t *r, const char *request_topic, const void *payload, uint32_t len,
+                     uint32_t timeout, void *resp_buf, uint32_t resp_size)
+{
+    int rc;
+    mqtt_rpc_call_t *call;
+
+    if ((NULL == r) || (NULL == request_topic) || ((NULL == resp_buf) && (resp_size > 0)))
+        RETURN_ERROR(MQTT_NULL_VALUE_ERROR);
+
+    if (MQTT_SUCCESS_ERROR != (rc = mqtt_rpc_enter(r)))
+        RETURN_ERROR(rc);
+
+    platform_mutex_lock(&r->lock);
+    call = mqtt_rpc_call_alloc(r, (0 != timeout) ? timeout : MQTT_RPC_TIMEOUT);
+    if (NULL != call) {
+        call->resp_buf = resp_buf;
+        call->resp_size = resp_size;
+    }
+    platform_mutex_unlock(&r->lock);
+
+    rc = (NULL != call) ? mqtt_rpc_send(r, call, request_topic, payload, len) : MQTT_MEM_NOT_ENOUGH_ERROR;
+    mqtt_rpc_leave(r);
+
+    return rc;
+}
+
+/**
+ * @brief 等待 mqtt_rpc_request 发起的请求完成，返回后句柄失效
+ *
+ * @param r rpc 实例
+ * @param handle 请求句柄
+ * @param resp_len 输出响应数据的实际长度，可以为 NULL
+ * @return int 返回状态码，超时返回 MQTT_RPC_TIMEOUT_ERROR，响应被截断返回 MQTT_BUFFER_TOO_SHORT_ERROR
+ */
+int mqtt_rpc_wait(mqtt_rpc_t *r, int handle, uint32_t *resp_len)
+{
+    int rc, remain;
+    mqtt_rpc_call_t *call;
+
+    if ((NULL == r) || (handle < 0))
+        RETURN_ERROR(MQTT_NULL_VALUE_ERROR);
+
+    /* 释放过程中仍允许进入，mqtt_rpc_release 已将未完成的请求标记为失败 */
+    platform_mutex_lock(&r->lock);
+    r->users++;
+
+    for (;;) {
+        call = mqtt_rpc_call_find(r, (uint32_t)handle);
+        if ((NULL == call) || (NULL != call->callback)) {
+            rc = MQTT_FAILED_ERROR;
+            break;
+        }
+
+        if ((MQTT_RPC_STATE_DONE == call->state) || platform_timer_is_expired(&call->deadline)) {
+            rc = (MQTT_RPC_STATE_DONE == call->state) ? call->rc : MQTT_RPC_TIMEOUT_ERROR;
+            if (NULL != resp_len)
+                *resp_len = call->resp_len;
+            mqtt_rpc_call_free(r, call);
+            break;
+        }
+
+        /* 信号量可能残留上一个使用该表项的请求的信号，被唤醒后重新检查状态 */
+        remain = platform_timer_remain(&call->deadline);
+        platform_mutex_unlock(&r->lock);
+        platform_sem_wait(&r->done[call - r->calls], remain);
+        platform_mutex_lock(&r->lock);
+    }
+
+    r->users--;
+    platform_mutex_unlock(&r->lock);
+
+    RETURN_ERROR(rc);
+}
+
+/**
+ * @brief 发起一个请求并阻塞等待响应，超时时间为 MQTT_RPC_TIMEOUT
+ *
+ * @param r rpc 实例
+ * @param request_topic 请求主题前缀
+ * @param payload 请求数据
+ * @param len 请求数据长度
+ * @param resp_buf 响应数据缓冲区
+ * @param resp_size 响应数据缓冲区大小
+ * @param resp_len 输出响应数据的实际长度，可以为 NULL
+ * @return int 返回状态码，MQTT_SUCCESS_ERROR 表示成功
+ */
+int mqtt_rpc_call(mqtt_rpc_t *r, const char *request_topic, const void *payload, uint32_t len,
+                  void *resp_buf, uint32_t resp_size, uint32_t *resp_len)
+{
+    int rc, handle;
+
+    if (NULL == r)
+        RETURN_ERROR(MQTT_NULL_VALUE_ERROR);
+
+    /* 请求与等待之间不离开接口，mqtt_rpc_release 会等待本次调用返回 */
+    if (MQTT_SUCCESS_ERROR != (rc = mqtt_rpc_enter(r)))
+        RETURN_ERROR(rc);
+
+    handle = mqtt_rpc_request(r, request_topic, payload, len, 0, resp_buf, resp_size);
+    rc = (handle < 0) ? handle : mqtt_rpc_wait(r, handle, resp_len);
+
+    mqtt_rpc_leave(r);
+
+    RETURN_ERROR(rc);
+}
+
+/**
+ * @brief 发起一个请求，响应到达或超时后调用回调函数。回调在 mqtt 线程（响应）或
+ *        mqtt_rpc_poll 的调用者（超时）中执行，超时时 payload 为 NULL
+ *
+ * @param r rpc 实例
+ * @param request_topic 请求主题前缀
+ * @param payload 请求数据
+ * @param len 请求数据长度
+ * @param timeout 超时时间，单位毫秒，0 表示使用 MQTT_RPC_TIMEOUT
+ * @param callback 回调函数
+ * @param arg 回调函数参数
+ * @return int 成功返回请求句柄（非负），失败返回错误码，失败时不会调用回调
+ */
+int mqtt_rpc_call_async(mqtt_rpc_t *r, const char *request_topic, const void *payload, uint32_t len,
+                        uint32_t timeout, mqtt_rpc_callback_t callback, void *arg)
+{
+    int rc;
+    mqtt_rpc_call_t *call;
+
+    if ((NULL == r) || (NULL == request_topic) || (NULL == callback))
+        RETURN_ERROR(MQTT_NULL_VALUE_ERROR);
+
+    if (MQTT_SUCCESS_ERROR != (rc = mqtt_rpc_enter(r)))
+        RETURN_ERROR(rc);
+
+    platform_mutex_lock(&r->lock);
+    call = mqtt_rpc_call_alloc(r, (0 != timeout) ? timeout : MQTT_RPC_TIMEOUT);
+    if (NULL != call) {
+        call->callback = callback;
+        call->arg = arg;
+    }
+    platform_mutex_unlock(&r->lock);
+
+    rc = (NULL != call) ? mqtt_rpc_send(r, call, request_topic, payload, len) : MQTT_MEM_NOT_ENOUGH_ERROR;
+    mqtt_rpc_leave(r);
+
+    return rc;
+}
+
+/**
+ * @brief 处理超时的异步请求，需要周期性调用
+ *
+ * @param r rpc 实例
+ * @return int 返回本次超时的请求数量，失败返回错误码
+ */
+int mqtt_rpc_poll(mqtt_rpc_t *r)
+{
+    int i, num = 0;
+    mqtt_rpc_call_t *call;
+    mqtt_rpc_callback_t callback;
+    void *arg;
+
+    if (NULL == r)
+        RETURN_ERROR(MQTT_NULL_VALUE_ERROR);
+
+    if (MQTT_SUCCESS_ERROR != mqtt_rpc_enter(r))
+        return 0;
+
+    for (i = 0; i < MQTT_RPC_PENDING_NUM; i++) {
+        call = &r->calls[i];
+
+        platform_mutex_lock(&r->lock);
+        if ((MQTT_RPC_STATE_PENDING != call->state) || (NULL == call->callback) ||
+            (!platform_timer_is_expired(&call->deadline))) {
+            platform_mutex_unlock(&r->lock);
+            continue;
+        }
+
+        callback = call->callback;
+        arg = call->arg;
+        mqtt_rpc_call_free(r, call);
+        platform_mutex_unlock(&r->lock);
+
+        callback(arg, MQTT_RPC_TIMEOUT_ERROR, NULL, 0);
+        num++;
+    }
+
+    mqtt_rpc_leave(r);
+
+    return num;
+}
+
+/**
+ * @brief 释放 rpc 实例，取消响应主题订阅。未完成的异步请求以 MQTT_FAILED_ERROR 回调结束，
+ *        阻塞在 mqtt_rpc_wait / mqtt_rpc_call 中的请求被唤醒并返回 MQTT_FAILED_ERROR，
+ *        等所有调用者离开后才销毁锁和信号量。返回后不能再以任何方式使用该实例
+ *
+ * @param r rpc 实例
+ * @return int 返回状态码，MQTT_SUCCESS_ERROR 表示成功
+ */
+int mqtt_rpc_release(mqtt_rpc_t *r)
+{
+    int i;
+    mqtt_rpc_call_t *call;
+    mqtt_rpc_callback_t callback;
+    void *arg;
+
+    if (NULL == r)
+        RETURN_ERROR(MQTT_NULL_VALUE_ERROR);
+
+    platform_mutex_lock(&r->lock);
+    r->closing = 1;
+    platform_mutex_unlock(&r->lock);
+
+    mqtt_unsubscribe(r->client, r->response_filter);
+
+    /* 移除后响应处理函数不会再访问该实例，它在处理期间一直持有注册表锁 */
+    platform_mutex_lock(&mqtt_rpc_registry_lock);
+    for (i = 0; i < MQTT_RPC_CLIENT_NUM_MAX; i++) {
+        if (mqtt_rpc_registry[i] == r)
+            mqtt_rpc_registry[i] = NULL;
+    }
+    platform_mutex_unlock(&mqtt_rpc_registry_lock);
+
+    for (i = 0; i < MQTT_RPC_PENDING_NUM; i++) {
+        call = &r->calls[i];
+        callback = NULL;
+
+        platform_mutex_lock(&r->lock);
+        if (MQTT_RPC_STATE_PENDING == call->state) {
+            if (NULL != call->callback) {
+                callback = call->callback;
+                arg = call->arg;
+                mqtt_rpc_call_free(r, call);
+            } else {
+                /* 同步请求由等待者释放表项 */
+                call->rc = MQTT_FAILED_ERROR;
+                call->resp_len = 0;
+                call->state = MQTT_RPC_STATE_DONE;
+                platform_sem_post(&r->done[i]);
+            }
+        }
+        platform_mutex_unlock(&r->lock);
+
+        if (NULL != callback)
+            callback(arg, MQTT_FAILED_ERROR, NULL, 0);
+    }
+
+    /* 等待仍在接口中的调用者（阻塞的等待者、正在发布的请求）离开 */
+    platform_mutex_lock(&r->lock);
+    while (0 != r->users) {
+        platform_mutex_unlock(&r->lock);
+        platform_timer_usleep(1000);
+        platform_mutex_lock(&r->lock);
+    }
+    platform_mutex_unlock(&r->lock);
+
+    platform_mutex_destroy(&r->lock);
+    for (i = 0; i < MQTT_RPC_PENDING_NUM; i++)
+        platform_sem_destroy(&r->done[i]);
+
+    RETURN_ERROR(MQTT_SUCCESS_ERROR);
+}
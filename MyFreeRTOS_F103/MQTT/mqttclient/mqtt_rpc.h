@@ -0,0 +1,73 @@
+/*
+ * @Date: 2026-10-19
+ * @Description: request/response rpc on top of mqtt_publish with correlation ids.
+ */
+#ifndef _MQTT_RPC_H_
+#define _MQTT_RPC_H_
+
+#include "mqttclient.h"
+#include "platform_sem.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * 主题约定：
+ *   请求发布到   <request_topic>/<id>
+ *   响应发布到   <response_prefix>/<id>
+ * id 为 8 位十六进制的关联 ID，响应方原样带回。所有响应共用一个 <response_prefix>/+ 订阅，
+ * 关联 ID 的低位即等待表下标，分发响应时不需要遍历。
+ */
+#define     MQTT_RPC_ID_LEN                     8
+
+typedef void (*mqtt_rpc_callback_t)(void *arg, int rc, const void *payload, uint32_t len);
+
+typedef enum mqtt_rpc_state {
+    MQTT_RPC_STATE_FREE = 0,
+    MQTT_RPC_STATE_PENDING,
+    MQTT_RPC_STATE_DONE,
+} mqtt_rpc_state_t;
+
+typedef struct mqtt_rpc_call {
+    uint32_t                    id;
+    mqtt_rpc_state_t            state;
+    int                         rc;
+    platform_timer_t            deadline;
+    mqtt_rpc_callback_t         callback;
+    void                        *arg;
+    void                        *resp_buf;
+    uint32_t                    resp_size;
+    uint32_t                    resp_len;
+} mqtt_rpc_call_t;
+
+typedef struct mqtt_rpc {
+    mqtt_client_t               *client;
+    platform_mutex_t            lock;
+    mqtt_qos_t                  qos;
+    uint16_t                    seq;
+    uint16_t                    free_num;
+    uint16_t                    users;                          /* 正在 rpc 接口中的调用者数量，mqtt_rpc_release 等其归零后再销毁锁 */
+    uint8_t                     closing;
+    uint8_t                     free_slot[MQTT_RPC_PENDING_NUM];
+    mqtt_rpc_call_t             calls[MQTT_RPC_PENDING_NUM];
+    platform_sem_t              done[MQTT_RPC_PENDING_NUM];     /* 按下标对应 calls，响应到达时唤醒 mqtt_rpc_wait */
+    char                        response_filter[MQTT_RPC_TOPIC_LEN_MAX];
+} mqtt_rpc_t;
+
+int mqtt_rpc_init(mqtt_rpc_t *r, mqtt_client_t *c, const char *response_prefix, mqtt_qos_t qos);
+int mqtt_rpc_request(mqtt_rpc_t *r, const char *request_topic, const void *payload, uint32_t len,
+                     uint32_t timeout, void *resp_buf, uint32_t resp_size);
+int mqtt_rpc_wait(mqtt_rpc_t *r, int handle, uint32_t *resp_len);
+int mqtt_rpc_call(mqtt_rpc_t *r, const char *request_topic, const void *payload, uint32_t len,
+                  void *resp_buf, uint32_t resp_size, uint32_t *resp_len);
+int mqtt_rpc_call_async(mqtt_rpc_t *r, const char *request_topic, const void *payload, uint32_t len,
+                        uint32_t timeout, mqtt_rpc_callback_t callback, void *arg);
+int mqtt_rpc_poll(mqtt_rpc_t *r);
+int mqtt_rpc_release(mqtt_rpc_t *r);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _MQTT_RPC_H_ */
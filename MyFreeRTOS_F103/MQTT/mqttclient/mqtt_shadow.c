@@ -0,0 +1,1018 @@
+/*
+ * @Date: 2026-10-19
+ * @Description: device shadow that reports only the changed fields.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include "mqtt_shadow.h"
+
+#define MQTT_SHADOW_HEAD            "{\"state\":{\"reported\":{"
+#define MQTT_SHADOW_TAIL_MAX        sizeof("}},\"version\":4294967295}")
+#define MQTT_SHADOW_NUMBER_LEN_MAX  32
+
+/* 期望状态增量的消息处理函数只能拿到客户端实例，通过该表找到客户端对应的影子实例。
+ * 该表由 mqtt 线程读取，修改时需持有 mqtt_shadow_registry_lock，锁在第一次 mqtt_shadow_init 时初始化，
+ * 多个影子实例应在启动阶段依次初始化 */
+static mqtt_shadow_t *mqtt_shadow_registry[MQTT_SHADOW_CLIENT_NUM_MAX];
+static platform_mutex_t mqtt_shadow_registry_lock;
+static int mqtt_shadow_registry_ready = 0;
+
+/**
+ * @brief 标记字段已变化，第一个变化的字段开始计算合并窗口
+ *
+ * @param s 影子实例，调用者需持有锁
+ * @param index 字段下标
+ */
+static void mqtt_shadow_dirty(mqtt_shadow_t *s, int index)
+{
+    s->dirty[index / 32] |= 1u << (index % 32);
+
+    if (!s->window_armed) {
+        s->window_armed = 1;
+        platform_timer_cutdown(&s->window_timer, s->window);
+    }
+}
+
+/**
+ * @brief 标记需要重新同步，下一个增量不做版本检查
+ *
+ * @param s 影子实例
+ */
+static void mqtt_shadow_resync(mqtt_shadow_t *s)
+{
+    platform_mutex_lock(&s->lock);
+    s->resync = 1;
+    platform_mutex_unlock(&s->lock);
+}
+
+/**
+ * @brief 自动重连的回调，在每次重连尝试之前调用，然后调用之前设置的回调
+ *
+ * @param client MQTT 客户端实例
+ * @param data 影子实例
+ */
+static void mqtt_shadow_reconnect_handler(void *client, void *data)
+{
+    mqtt_shadow_t *s = (mqtt_shadow_t *)data;
+
+    mqtt_shadow_resync(s);
+
+    if (NULL != s->prev_reconnect_handler)
+        s->prev_reconnect_handler(client, s->prev_reconnect_data);
+}
+
+/**
+ * @brief 调用 mqtt_disconnect 时的回调，应用之后重新连接同样需要重新同步，然后调用之前设置的回调
+ *
+ * @param client MQTT 客户端实例
+ * @param data 影子实例
+ */
+static void mqtt_shadow_disconnect_handler(void *client, void *data)
+{
+    mqtt_shadow_t *s = (mqtt_shadow_t *)data;
+
+    mqtt_shadow_resync(s);
+
+    if (NULL != s->prev_disconnect_handler)
+        s->prev_disconnect_handler(client, s->prev_disconnect_data);
+}
+
+/**
+ * @brief 检查参数并返回字段描述
+ *
+ * @param s 影子实例
+ * @param index 字段下标
+ * @param type 期望的字段类型
+ * @return const mqtt_shadow_field_t* 字段描述，参数错误返回 NULL
+ */
+static const mqtt_shadow_field_t *mqtt_shadow_field(mqtt_shadow_t *s, int index, mqtt_shadow_type_t type)
+{
+    if ((NULL == s) || (index < 0) || (index >= s->field_num) || (s->fields[index].type != type))
+        return NULL;
+
+    return &s->fields[index];
+}
+
+/**
+ * @brief 向文档追加数据
+ *
+ * @param doc 文档缓冲区
+ * @param len 当前长度，追加成功后更新
+ * @param limit 可写入的最大长度
+ * @param str 追加的数据
+ * @param n 追加的长度
+ * @return int 成功返回 0，空间不足返回 -1
+ */
+static int mqtt_shadow_put(char *doc, uint32_t *len, uint32_t limit, const char *str, uint32_t n)
+{
+    if (*len + n > limit)
+        return -1;
+
+    memcpy(doc + *len, str, n);
+    *len += n;
+    return 0;
+}
+
+/**
+ * @brief 以 JSON 字符串的形式追加数据，转义引号、反斜杠与控制字符
+ *
+ * @param doc 文档缓冲区
+ * @param len 当前长度，追加成功后更新
+ * @param limit 可写入的最大长度
+ * @param str 以 '\0' 结尾的字符串
+ * @return int 成功返回 0，空间不足返回 -1
+ */
+static int mqtt_shadow_put_string(char *doc, uint32_t *len, uint32_t limit, const char *str)
+{
+    char esc[8];
+    int rc = mqtt_shadow_put(doc, len, limit, "\"", 1);
+
+    for (; (0 == rc) && ('\0' != *str); str++) {
+        if (('"' == *str) || ('\\' == *str)) {
+            esc[0] = '\\';
+            esc[1] = *str;
+            rc = mqtt_shadow_put(doc, len, limit, esc, 2);
+        } else if ((unsigned char)*str < 0x20) {
+            snprintf(esc, sizeof(esc), "\\u%04x", (unsigned char)*str);
+            rc = mqtt_shadow_put(doc, len, limit, esc, 6);
+        } else {
+            rc = mqtt_shadow_put(doc, len, limit, str, 1);
+        }
+    }
+
+    if (0 == rc)
+        rc = mqtt_shadow_put(doc, len, limit, "\"", 1);
+
+    return rc;
+}
+
+/**
+ * @brief 格式化浮点数，保留 MQTT_SHADOW_FLOAT_DIGITS 位小数，不依赖 printf 的浮点支持
+ *
+ * @param buf 输出缓冲区，长度为 MQTT_SHADOW_NUMBER_LEN_MAX
+ * @param v 浮点数
+ * @return int 输出的长度
+ */
+static int mqtt_shadow_format_float(char *buf, float v)
+{
+    uint32_t scale = 1, ip, fp;
+    double x = v;
+    int i;
+
+    if ((x != x) || (x > 4.0e9) || (x < -4.0e9))
+        return snprintf(buf, MQTT_SHADOW_NUMBER_LEN_MAX, "null");
+
+    for (i = 0; i < MQTT_SHADOW_FLOAT_DIGITS; i++)
+        scale *= 10;
+
+    x = ((x < 0) ? -x : x) * scale + 0.5;
+    ip = (uint32_t)(x / scale);
+    fp = (uint32_t)(x - (double)ip * scale);
+
+    if (1 == scale)
+        return snprintf(buf, MQTT_SHADOW_NUMBER_LEN_MAX, "%s%lu", ((v < 0) && (ip | fp)) ? "-" : "", (unsigned long)ip);
+
+    return snprintf(buf, MQTT_SHADOW_NUMBER_LEN_MAX, "%s%lu.%0*lu", ((v < 0) && (ip | fp)) ? "-" : "",
+                    (unsigned long)ip, MQTT_SHADOW_FLOAT_DIGITS, (unsigned long)fp);
+}
+
+/**
+ * @brief 追加一个字段 ,"name":value ，空间不足时文档保持不变
+ *
+ * @param f 字段描述
+ * @param first 是否为文档中的第一个字段
+ * @param doc 文档缓冲区
+ * @param len 当前长度，追加成功后更新
+ * @param limit 可写入的最大长度
+ * @return int 成功返回 0，空间不足返回 -1
+ */
+static int mqtt_shadow_put_field(const mqtt_shadow_field_t *f, int first, char *doc, uint32_t *len, uint32_t limit)
+{
+    char num[MQTT_SHADOW_NUMBER_LEN_MAX];
+    uint32_t start = *len;
+    int rc = 0, n = 0;
+
+    if (!first)
+        rc = mqtt_shadow_put(doc, len, limit, ",", 1);
+    if (0 == rc)
+        rc = mqtt_shadow_put_string(doc, len, limit, f->name);
+    if (0 == rc)
+        rc = mqtt_shadow_put(doc, len, limit, ":", 1);
+
+    if (0 == rc) {
+        switch (f->type) {
+            case MQTT_SHADOW_TYPE_BOOL:
+                n = snprintf(num, sizeof(num), "%s", (*(uint8_t *)f->value) ? "true" : "false");
+                break;
+            case MQTT_SHADOW_TYPE_INT:
+                n = snprintf(num, sizeof(num), "%ld", (long)*(int32_t *)f->value);
+                break;
+            case MQTT_SHADOW_TYPE_FLOAT:
+                n = mqtt_shadow_format_float(num, *(float *)f->value);
+                break;
+            default:
+                rc = mqtt_shadow_put_string(doc, len, limit, (const char *)f->value);
+                break;
+        }
+
+        if ((0 == rc) && (n > 0))
+            rc = mqtt_shadow_put(doc, len, limit, num, n);
+    }
+
+    if (0 != rc)
+        *len = start;
+
+    return rc;
+}
+
+/**
+ * @brief 将变化的字段写入上报文档，放不下的字段留给下一个文档
+ *
+ * @param s 影子实例，调用者需持有锁
+ * @param sent 输出写入文档的字段
+ * @return int 文档长度，没有可写入的字段返回 0
+ */
+static int mqtt_shadow_build(mqtt_shadow_t *s, uint32_t *sent)
+{
+    uint32_t len = 0, limit = MQTT_SHADOW_DOC_SIZE - MQTT_SHADOW_TAIL_MAX;
+    int i, num = 0;
+
+    memset(sent, 0, sizeof(s->dirty));
+    mqtt_shadow_put(s->doc, &len, limit, MQTT_SHADOW_HEAD, sizeof(MQTT_SHADOW_HEAD) - 1);
+
+    for (i = 0; i < s->field_num; i++) {
+        if (!(s->dirty[i / 32] & (1u << (i % 32))))
+            continue;
+
+        if (0 != mqtt_shadow_put_field(&s->fields[i], (0 == num), s->doc, &len, limit)) {
+            if (num > 0)
+                continue;
+
+            /* 单个字段就超出了文档大小，无法上报 */
+            MQTT_LOG_W("%s:%d %s()... field %s is too long to report", __FILE__, __LINE__, __FUNCTION__, s->fields[i].name);
+            s->dirty[i / 32] &= ~(1u << (i % 32));
+            continue;
+        }
+
+        sent[i / 32] |= 1u << (i % 32);
+        num++;
+    }
+
+    if (0 == num)
+        return 0;
+
+    /* 发布成功后才递增版本号，发布失败的文档重新生成时使用同一个版本号 */
+    len += snprintf(s->doc + len, MQTT_SHADOW_DOC_SIZE - len, "}},\"version\":%lu}", (unsigned long)(s->version + 1));
+
+    return (int)len;
+}
+
+/**
+ * @brief 跳过空白字符
+ */
+static const char *mqtt_shadow_skip_ws(const char *p, const char *end)
+{
+    while ((p < end) && ((' ' == *p) || ('\t' == *p) || ('\r' == *p) || ('\n' == *p)))
+        p++;
+    return p;
+}
+
+/**
+ * @brief 跳过一个字符串，p 指向起始的引号
+ *
+ * @return const char* 结束引号之后的位置，格式错误返回 NULL
+ */
+static const char *mqtt_shadow_skip_string(const char *p, const char *end)
+{
+    for (p++; p < end; p++) {
+        if ('\\' == *p)
+            p++;
+        else if ('"' == *p)
+            return p + 1;
+    }
+    return NULL;
+}
+
+/**
+ * @brief 跳过任意一个值，对象与数组整体跳过
+ *
+ * @return const char* 值之后的位置，格式错误返回 NULL
+ */
+static const char *mqtt_shadow_skip_value(const char *p, const char *end)
+{
+    int depth = 0;
+
+    if (p >= end)
+        return NULL;
+
+    if ('"' == *p)
+        return mqtt_shadow_skip_string(p, end);
+
+    if (('{' != *p) && ('[' != *p)) {
+        while ((p < end) && (',' != *p) && ('}' != *p) && (']' != *p) && (' ' != *p) &&
+               ('\t' != *p) && ('\r' != *p) && ('\n' != *p))
+            p++;
+        return p;
+    }
+
+    while (p < end) {
+        if ('"' == *p) {
+            if (NULL == (p = mqtt_shadow_skip_string(p, end)))
+                return NULL;
+            continue;
+        }
+        if (('{' == *p) || ('[' == *p))
+            depth++;
+        else if ((('}' == *p) || (']' == *p)) && (0 == --depth))
+            return p + 1;
+        p++;
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief 读取对象的下一个成员，*p 初始指向 '{' 之后
+ *
+ * @return int 读到成员返回 1，对象结束返回 0，格式错误返回 -1
+ */
+static int mqtt_shadow_next_member(const char **p, const char *end, const char **key, uint32_t *key_len,
+                                   const char **val, const char **val_end)
+{
+    const char *q = mqtt_shadow_skip_ws(*p, end);
+
+    if ((q < end) && (',' == *q))
+        q = mqtt_shadow_skip_ws(q + 1, end);
+
+    if (q >= end)
+        return -1;
+
+    if ('}' == *q) {
+        *p = q + 1;
+        return 0;
+    }
+
+    if ('"' != *q)
+        return -1;
+
+    *key = q + 1;
+    if (NULL == (q = mqtt_shadow_skip_string(q, end)))
+        return -1;
+    *key_len = (uint32_t)(q - 1 - *key);
+
+    q = mqtt_shadow_skip_ws(q, end);
+    if ((q >= end) || (':' != *q))
+        return -1;
+
+    *val = mqtt_shadow_skip_ws(q + 1, end);
+    if (NULL == (*val_end = mqtt_shadow_skip_value(*val, end)))
+        return -1;
+
+    *p = *val_end;
+    return 1;
+}
+
+/**
+ * @brief 将数值复制为以 '\0' 结尾的字符串
+ *
+ * @return int 成功返回 0，过长返回 -1
+ */
+static int mqtt_shadow_number(char *buf, const char *val, const char *val_end)
+{
+    uint32_t n = (uint32_t)(val_end - val);
+
+    if ((0 == n) || (n >= MQTT_SHADOW_NUMBER_LEN_MAX))
+        return -1;
+
+    memcpy(buf, val, n);
+    buf[n] = '\0';
+    return 0;
+}
+
+/**
+ * @brief 读取字符串中的一个字符并处理转义
+ *
+ * @param val 字符串，从引号开始
+ * @param end 结束引号的位置
+ * @param i 当前位置，读取后更新
+ * @return char 读到的字符
+ */
+static char mqtt_shadow_unescape(const char *val, uint32_t end, uint32_t *i)
+{
+    char ch = val[(*i)++];
+
+    if (('\\' != ch) || (*i >= end))
+        return ch;
+
+    ch = val[(*i)++];
+    if ('n' == ch)
+        return '\n';
+    if ('t' == ch)
+        return '\t';
+    if ('r' == ch)
+        return '\r';
+    return ch;
+}
+
+/**
+ * @brief 将期望状态中的一个值原地写入字段
+ *
+ * @param f 字段描述
+ * @param val 值的起始位置
+ * @param val_end 值的结束位置
+ * @return int 值发生变化返回 1，未变化返回 0，类型不匹配返回 -1
+ */
+static int mqtt_shadow_apply_value(const mqtt_shadow_field_t *f, const char *val, const char *val_end)
+{
+    char num[MQTT_SHADOW_NUMBER_LEN_MAX], *num_end;
+    uint32_t n = (uint32_t)(val_end - val);
+    uint32_t i, j;
+    int32_t iv;
+    float fv;
+    char *str;
+
+    if ((4 == n) && (0 == memcmp(val, "null", 4)))
+        return 0;
+
+    switch (f->type) {
+        case MQTT_SHADOW_TYPE_BOOL:
+            if ((4 == n) && (0 == memcmp(val, "true", 4)))
+                iv = 1;
+            else if ((5 == n) && (0 == memcmp(val, "false", 5)))
+                iv = 0;
+            else if (0 == mqtt_shadow_number(num, val, val_end))
+                iv = (0 != strtol(num, NULL, 10));
+            else
+                return -1;
+            if (*(uint8_t *)f->value == (uint8_t)iv)
+                return 0;
+            *(uint8_t *)f->value = (uint8_t)iv;
+            return 1;
+
+        case MQTT_SHADOW_TYPE_INT:
+            if (0 != mqtt_shadow_number(num, val, val_end))
+                return -1;
+            iv = (int32_t)strtol(num, &num_end, 10);
+            if ('\0' != *num_end)
+                return -1;
+            if (*(int32_t *)f->value == iv)
+                return 0;
+            *(int32_t *)f->value = iv;
+            return 1;
+
+        case MQTT_SHADOW_TYPE_FLOAT:
+            if (0 != mqtt_shadow_number(num, val, val_end))
+                return -1;
+            fv = (float)strtod(num, &num_end);
+            if ('\0' != *num_end)
+                return -1;
+            if (*(float *)f->value == fv)
+                return 0;
+            *(float *)f->value = fv;
+            return 1;
+
+        default:
+            if ((n < 2) || ('"' != *val))
+                return -1;
+
+            /* 先确认去转义后的长度放得下，再与当前值比较 */
+            for (i = 1, j = 0; i < n - 1; j++)
+                mqtt_shadow_unescape(val, n - 1, &i);
+            if (j >= f->size)
+                return -1;
+
+            str = (char *)f->value;
+            for (i = 1, j = 0; (i < n - 1) && (str[j] == mqtt_shadow_unescape(val, n - 1, &i)); j++)
+                ;
+            if ((i >= n - 1) && ('\0' == str[j]))
+                return 0;
+
+            for (i = 1, j = 0; i < n - 1; j++)
+                str[j] = mqtt_shadow_unescape(val, n - 1, &i);
+            str[j] = '\0';
+            return 1;
+    }
+}
+
+/**
+ * @brief 期望状态增量主题的消息处理函数
+ *
+ * @param client MQTT 客户端实例
+ * @param msg 收到的增量文档
+ */
+static void mqtt_shadow_delta_message_handler(void *client, message_data_t *msg)
+{
+    int i;
+    mqtt_shadow_t *s;
+
+    /* 持有注册表锁处理消息，mqtt_shadow_release 移除实例之后不会再有处理函数访问它 */
+    platform_mutex_lock(&mqtt_shadow_registry_lock);
+    for (i = 0; i < MQTT_SHADOW_CLIENT_NUM_MAX; i++) {
+        s = mqtt_shadow_registry[i];
+        if ((NULL == s) || (s->client != client))
+            continue;
+
+        if ((strlen(s->delta_topic) != msg->topic_len) || (0 != memcmp(s->delta_topic, msg->topic_name, msg->topic_len)))
+            continue;
+
+        mqtt_shadow_apply_delta(s, (const char *)msg->message->payload, (uint32_t)msg->message->payloadlen);
+    }
+    platform_mutex_unlock(&mqtt_shadow_registry_lock);
+}
+
+/**
+ * @brief 初始化影子实例，订阅期望状态增量主题。初始化后所有字段都被标记为已变化，第一次上报为完整状态
+ *
+ * @param s 影子实例，由调用者提供存储空间
+ * @param c MQTT 客户端实例
+ * @param fields 字段表，需在影子释放前有效
+ * @param field_num 字段数量，最多 MQTT_SHADOW_FIELD_NUM_MAX 个
+ * @param report_topic 上报主题，需在影子释放前有效
+ * @param delta_topic 期望状态增量主题，需在影子释放前有效，为 NULL 时不订阅
+ * @param qos 上报与订阅使用的 QoS 等级
+ * @return int 返回状态码，MQTT_SUCCESS_ERROR 表示成功
+ */
+int mqtt_shadow_init(mqtt_shadow_t *s, mqtt_client_t *c, const mqtt_shadow_field_t *fields, int field_num,
+                     const char *report_topic, const char *delta_topic, mqtt_qos_t qos)
+{
+    int i, slot = -1, rc = MQTT_SUCCESS_ERROR;
+
+    if ((NULL == s) || (NULL == c) || (NULL == fields) || (NULL == report_topic) ||
+        (field_num <= 0) || (field_num > MQTT_SHADOW_FIELD_NUM_MAX))
+        RETURN_ERROR(MQTT_NULL_VALUE_ERROR);
+
+    memset(s, 0, sizeof(mqtt_shadow_t));
+
+    s->client = c;
+    s->fields = fields;
+    s->field_num = (uint16_t)field_num;
+    s->qos = qos;
+    s->report_topic = report_topic;
+    s->delta_topic = delta_topic;
+    s->window = MQTT_SHADOW_WINDOW;
+
+    platform_mutex_init(&s->lock);
+
+    for (i = 0; i < field_num; i++)
+        mqtt_shadow_dirty(s, i);
+
+    s->prev_reconnect_handler = mqtt_get_reconnect_handler(c);
+    s->prev_reconnect_data = mqtt_get_reconnect_data(c);
+    mqtt_set_reconnect_data(c, s);
+    mqtt_set_reconnect_handler(c, mqtt_shadow_reconnect_handler);
+
+    s->prev_disconnect_handler = mqtt_get_disconnect_handler(c);
+    s->prev_disconnect_data = mqtt_get_disconnect_data(c);
+    mqtt_set_disconnect_data(c, s);
+    mqtt_set_disconnect_handler(c, mqtt_shadow_disconnect_handler);
+
+    if (NULL == delta_topic)
+        RETURN_ERROR(MQTT_SUCCESS_ERROR);
+
+    if (!mqtt_shadow_registry_ready) {
+        platform_mutex_init(&mqtt_shadow_registry_lock);
+        mqtt_shadow_registry_ready = 1;
+    }
+
+    platform_mutex_lock(&mqtt_shadow_registry_lock);
+    for (i = 0; i < MQTT_SHADOW_CLIENT_NUM_MAX; i++) {
+        if (NULL == mqtt_shadow_registry[i]) {
+            mqtt_shadow_registry[i] = s;
+            slot = i;
+            break;
+        }
+    }
+    platform_mutex_unlock(&mqtt_shadow_registry_lock);
+
+    if (slot < 0) {
+        rc = MQTT_MEM_NOT_ENOUGH_ERROR;
+    } else {
+        rc = mqtt_subscribe(c, delta_topic, qos, mqtt_shadow_delta_message_handler);
+        if (MQTT_SUCCESS_ERROR != rc) {
+            platform_mutex_lock(&mqtt_shadow_registry_lock);
+            mqtt_shadow_registry[slot] = NULL;
+            platform_mutex_unlock(&mqtt_shadow_registry_lock);
+        }
+    }
+
+    if (MQTT_SUCCESS_ERROR != rc) {
+        mqtt_set_disconnect_handler(c, s->prev_disconnect_handler);
+        mqtt_set_disconnect_data(c, s->prev_disconnect_data);
+        mqtt_set_reconnect_handler(c, s->prev_reconnect_handler);
+        mqtt_set_reconnect_data(c, s->prev_reconnect_data);
+        platform_mutex_destroy(&s->lock);
+    }
+
+    RETURN_ERROR(rc);
+}
+
+/**
+ * @brief 设置合并窗口，窗口内的多次变化合并为一次上报，0 表示每次 poll 都上报
+ *
+ * @param s 影子实例
+ * @param window 合并窗口，单位毫秒
+ * @return int 返回状态码，MQTT_SUCCESS_ERROR 表示成功
+ */
+int mqtt_shadow_set_window(mqtt_shadow_t *s, uint32_t window)
+{
+    if (NULL == s)
+        RETURN_ERROR(MQTT_NULL_VALUE_ERROR);
+
+    platform_mutex_lock(&s->lock);
+    s->window = window;
+    platform_mutex_unlock(&s->lock);
+
+    RETURN_ERROR(MQTT_SUCCESS_ERROR);
+}
+
+/**
+ * @brief 设置期望状态的回调，字段被增量修改后以字段下标调用
+ *
+ * @param s 影子实例
+ * @param handler 回调函数
+ * @param arg 回调函数参数
+ * @return int 返回状态码，MQTT_SUCCESS_ERROR 表示成功
+ */
+int mqtt_shadow_set_delta_handler(mqtt_shadow_t *s, mqtt_shadow_delta_handler_t handler, void *arg)
+{
+    if (NULL == s)
+        RETURN_ERROR(MQTT_NULL_VALUE_ERROR);
+
+    platform_mutex_lock(&s->lock);
+    s->delta_handler = handler;
+    s->delta_arg = arg;
+    platform_mutex_unlock(&s->lock);
+
+    RETURN_ERROR(MQTT_SUCCESS_ERROR);
+}
+
+/**
+ * @brief 设置布尔字段，值变化时标记字段
+ *
+ * @param s 影子实例
+ * @param index 字段下标
+ * @param value 新的值
+ * @return int 返回状态码，MQTT_SUCCESS_ERROR 表示成功
+ */
+int mqtt_shadow_set_bool(mqtt_shadow_t *s, int index, uint8_t value)
+{
+    const mqtt_shadow_field_t *f = mqtt_shadow_field(s, index, MQTT_SHADOW_TYPE_BOOL);
+
+    if (NULL == f)
+        RETURN_ERROR(MQTT_NULL_VALUE_ERROR);
+
+    value = (0 != value);
+
+    platform_mutex_lock(&s->lock);
+    if (*(uint8_t *)f->value != value) {
+        *(uint8_t *)f->value = value;
+        mqtt_shadow_dirty(s, index);
+    }
+    platform_mutex_unlock(&s->lock);
+
+    RETURN_ERROR(MQTT_SUCCESS_ERROR);
+}
+
+/**
+ * @brief 设置整数字段，值变化时标记字段
+ *
+ * @param s 影子实例
+ * @param index 字段下标
+ * @param value 新的值
+ * @return int 返回状态码，MQTT_SUCCESS_ERROR 表示成功
+ */
+int mqtt_shadow_set_int(mqtt_shadow_t *s, int index, int32_t value)
+{
+    const mqtt_shadow_field_t *f = mqtt_shadow_field(s, index, MQTT_SHADOW_TYPE_INT);
+
+    if (NULL == f)
+        RETURN_ERROR(MQTT_NULL_VALUE_ERROR);
+
+    platform_mutex_lock(&s->lock);
+    if (*(int32_t *)f->value != value) {
+        *(int32_t *)f->value = value;
+        mqtt_shadow_dirty(s, index);
+    }
+    platform_mutex_unlock(&s->lock);
+
+    RETURN_ERROR(MQTT_SUCCESS_ERROR);
+}
+
+/**
+ * @brief 设置浮点字段，值变化时标记字段
+ *
+ * @param s 影子实例
+ * @param index 字段下标
+ * @param value 新的值
+ * @return int 返回状态码，MQTT_SUCCESS_ERROR 表示成功
+ */
+int mqtt_shadow_set_float(mqtt_shadow_t *s, int index, float value)
+{
+    const mqtt_shadow_field_t *f = mqtt_shadow_field(s, index, MQTT_SHADOW_TYPE_FLOAT);
+
+    if (NULL == f)
+        RETURN_ERROR(MQTT_NULL_VALUE_ERROR);
+
+    platform_mutex_lock(&s->lock);
+    if (*(float *)f->value != value) {
+        *(float *)f->value = value;
+        mqtt_shadow_dirty(s, index);
+    }
+    platform_mutex_unlock(&s->lock);
+
+    RETURN_ERROR(MQTT_SUCCESS_ERROR);
+}
+
+/**
+ * @brief 设置字符串字段，值变化时标记字段
+ *
+ * @param s 影子实例
+ * @param index 字段下标
+ * @param value 新的值
+ * @return int 返回状态码，字符串超出字段大小返回 MQTT_BUFFER_TOO_SHORT_ERROR
+ */
+int mqtt_shadow_set_string(mqtt_shadow_t *s, int index, const char *value)
+{
+    const mqtt_shadow_field_t *f = mqtt_shadow_field(s, index, MQTT_SHADOW_TYPE_STRING);
+    size_t len;
+
+    if ((NULL == f) || (NULL == value))
+        RETURN_ERROR(MQTT_NULL_VALUE_ERROR);
+
+    len = strlen(value);
+    if (len >= f->size)
+        RETURN_ERROR(MQTT_BUFFER_TOO_SHORT_ERROR);
+
+    platform_mutex_lock(&s->lock);
+    if (0 != strcmp((const char *)f->value, value)) {
+        memcpy(f->value, value, len + 1);
+        mqtt_shadow_dirty(s, index);
+    }
+    platform_mutex_unlock(&s->lock);
+
+    RETURN_ERROR(MQTT_SUCCESS_ERROR);
+}
+
+/**
+ * @brief 标记字段已变化，用于调用者直接修改了字段变量的情况
+ *
+ * @param s 影子实例
+ * @param index 字段下标
+ * @return int 返回状态码，MQTT_SUCCESS_ERROR 表示成功
+ */
+int mqtt_shadow_mark_dirty(mqtt_shadow_t *s, int index)
+{
+    if ((NULL == s) || (index < 0) || (index >= s->field_num))
+        RETURN_ERROR(MQTT_NULL_VALUE_ERROR);
+
+    platform_mutex_lock(&s->lock);
+    mqtt_shadow_dirty(s, index);
+    platform_mutex_unlock(&s->lock);
+
+    RETURN_ERROR(MQTT_SUCCESS_ERROR);
+}
+
+/**
+ * @brief 原地应用期望状态，被修改的字段会在下一次上报中确认
+ *
+ * @param s 影子实例
+ * @param doc 增量文档或完整文档
+ * @param len 文档长度
+ * @param full 非 0 时为完整文档，使用 state.desired（没有时使用 state），不做版本检查
+ * @return int 成功返回被修改的字段数量，过期的增量返回 0，格式错误返回错误码
+ */
+static int mqtt_shadow_apply(mqtt_shadow_t *s, const char *doc, uint32_t len, int full)
+{
+    const char *p, *end, *key, *val, *val_end, *state = NULL;
+    uint32_t changed[MQTT_SHADOW_DIRTY_WORDS] = {0};
+    uint32_t key_len, version = 0;
+    char num[MQTT_SHADOW_NUMBER_LEN_MAX];
+    mqtt_shadow_delta_handler_t handler;
+    void *arg;
+    int i, rc, num_changed = 0;
+
+    if ((NULL == s) || (NULL == doc))
+        RETURN_ERROR(MQTT_NULL_VALUE_ERROR);
+
+    end = doc + len;
+    p = mqtt_shadow_skip_ws(doc, end);
+    if ((p >= end) || ('{' != *p))
+        RETURN_ERROR(MQTT_FAILED_ERROR);
+    p++;
+
+    /* 先找出 state 对象与版本号 */
+    while (1 == (rc = mqtt_shadow_next_member(&p, end, &key, &key_len, &val, &val_end))) {
+        if ((5 == key_len) && (0 == memcmp(key, "state", 5)) && ('{' == *val))
+            state = val + 1;
+        else if ((7 == key_len) && (0 == memcmp(key, "version", 7)) && (0 == mqtt_shadow_number(num, val, val_end)))
+            version = (uint32_t)strtoul(num, NULL, 10);
+    }
+    if (rc < 0)
+        RETURN_ERROR(MQTT_FAILED_ERROR);
+
+    /* 完整文档的期望状态在 state.desired 中 */
+    if (full && (NULL != (p = state))) {
+        while (1 == (rc = mqtt_shadow_next_member(&p, end, &key, &key_len, &val, &val_end))) {
+            if ((7 == key_len) && (0 == memcmp(key, "desired", 7)) && ('{' == *val)) {
+                state = val + 1;
+                break;
+            }
+        }
+        if (rc < 0)
+            RETURN_ERROR(MQTT_FAILED_ERROR);
+    }
+
+    platform_mutex_lock(&s->lock);
+
+    /* 重新连接或完整文档之后以新的版本号为准，云端可能已经重置了版本号 */
+    if ((0 != version) && (version <= s->desired_version) && (!s->resync) && (!full)) {
+        platform_mutex_unlock(&s->lock);
+        MQTT_LOG_D("%s:%d %s()... drop stale delta version %lu", __FILE__, __LINE__, __FUNCTION__, (unsigned long)version);
+        return 0;
+    }
+
+    p = (NULL != state) ? state : mqtt_shadow_skip_ws(doc, end) + 1;
+    while (1 == (rc = mqtt_shadow_next_member(&p, end, &key, &key_len, &val, &val_end))) {
+        for (i = 0; i < s->field_num; i++) {
+            if ((0 == strncmp(s->fields[i].name, key, key_len)) && ('\0' == s->fields[i].name[key_len]))
+                break;
+        }
+
+        if ((i == s->field_num) || (!s->fields[i].writable))
+            continue;
+
+        switch (mqtt_shadow_apply_value(&s->fields[i], val, val_end)) {
+            case 1:
+                changed[i / 32] |= 1u << (i % 32);
+                mqtt_shadow_dirty(s, i);
+                num_changed++;
+                break;
+            case -1:
+                MQTT_LOG_W("%s:%d %s()... delta value of %s is invalid", __FILE__, __LINE__, __FUNCTION__, s->fields[i].name);
+                break;
+            default:
+                break;
+        }
+    }
+
+    if (0 != version) {
+        s->desired_version = version;
+        s->resync = 0;
+    }
+
+    handler = s->delta_handler;
+    arg = s->delta_arg;
+
+    platform_mutex_unlock(&s->lock);
+
+    if (rc < 0)
+        MQTT_LOG_W("%s:%d %s()... delta document is truncated", __FILE__, __LINE__, __FUNCTION__);
+
+    /* 回调在锁外执行，回调中可以再次设置字段 */
+    for (i = 0; (NULL != handler) && (i < s->field_num); i++) {
+        if (changed[i / 32] & (1u << (i % 32)))
+            handler(arg, i);
+    }
+
+    return num_changed;
+}
+
+/**
+ * @brief 原地应用期望状态增量，被修改的字段会在下一次上报中确认
+ *
+ * @param s 影子实例
+ * @param doc 增量文档
+ * @param len 文档长度
+ * @return int 成功返回被修改的字段数量，过期的增量返回 0，格式错误返回错误码
+ */
+int mqtt_shadow_apply_delta(mqtt_shadow_t *s, const char *doc, uint32_t len)
+{
+    return mqtt_shadow_apply(s, doc, len, 0);
+}
+
+/**
+ * @brief 应用完整的影子文档（例如 GET 的响应），不做版本检查，之后以文档中的版本号为准
+ *
+ * @param s 影子实例
+ * @param doc 完整文档，期望状态在 state.desired 中，没有 desired 时使用 state
+ * @param len 文档长度
+ * @return int 成功返回被修改的字段数量，格式错误返回错误码
+ */
+int mqtt_shadow_apply_document(mqtt_shadow_t *s, const char *doc, uint32_t len)
+{
+    return mqtt_shadow_apply(s, doc, len, 1);
+}
+
+/**
+ * @brief 合并窗口到期后上报变化的字段，需要周期性调用
+ *
+ * @param s 影子实例
+ * @return int 返回状态码，MQTT_SUCCESS_ERROR 表示成功
+ */
+int mqtt_shadow_poll(mqtt_shadow_t *s)
+{
+    int expired;
+
+    if (NULL == s)
+        RETURN_ERROR(MQTT_NULL_VALUE_ERROR);
+
+    platform_mutex_lock(&s->lock);
+    expired = s->window_armed && platform_timer_is_expired(&s->window_timer);
+    platform_mutex_unlock(&s->lock);
+
+    if (!expired)
+        RETURN_ERROR(MQTT_SUCCESS_ERROR);
+
+    return mqtt_shadow_flush(s);
+}
+
+/**
+ * @brief 立即上报所有变化的字段，一个文档放不下时分多次发送。发送失败的字段保持标记，等待下一个窗口
+ *
+ * @param s 影子实例
+ * @return int 返回状态码，MQTT_SUCCESS_ERROR 表示成功
+ */
+int mqtt_shadow_flush(mqtt_shadow_t *s)
+{
+    int i, len, rc = MQTT_SUCCESS_ERROR;
+    uint32_t sent[MQTT_SHADOW_DIRTY_WORDS];
+    mqtt_message_t msg;
+
+    if (NULL == s)
+        RETURN_ERROR(MQTT_NULL_VALUE_ERROR);
+
+    platform_mutex_lock(&s->lock);
+
+    while ((len = mqtt_shadow_build(s, sent)) > 0) {
+        memset(&msg, 0, sizeof(msg));
+        msg.qos = s->qos;
+        msg.payload = s->doc;
+        msg.payloadlen = len;
+
+        /* mqtt_publish 不会等待 mqtt 线程，持有影子锁发布不会死锁 */
+        rc = mqtt_publish_copy(s->client, s->report_topic, &msg);
+        if (MQTT_SUCCESS_ERROR != rc)
+            break;
+
+        s->version++;
+
+        for (i = 0; i < MQTT_SHADOW_DIRTY_WORDS; i++)
+            s->dirty[i] &= ~sent[i];
+    }
+
+    s->window_armed = 0;
+    if (MQTT_SUCCESS_ERROR != rc) {
+        MQTT_LOG_W("%s:%d %s()... shadow report failed -0x%04x", __FILE__, __LINE__, __FUNCTION__, -rc);
+        s->window_armed = 1;
+        platform_timer_cutdown(&s->window_timer, s->window);
+    }
+
+    platform_mutex_unlock(&s->lock);
+
+    RETURN_ERROR(rc);
+}
+
+/**
+ * @brief 释放影子实例，取消期望状态增量主题的订阅，未上报的变化被丢弃
+ *
+ * @param s 影子实例
+ * @return int 返回状态码，MQTT_SUCCESS_ERROR 表示成功
+ */
+int mqtt_shadow_release(mqtt_shadow_t *s)
+{
+    int i;
+
+    if (NULL == s)
+        RETURN_ERROR(MQTT_NULL_VALUE_ERROR);
+
+    if (NULL != s->delta_topic)
+        mqtt_unsubscribe(s->client, s->delta_topic);
+
+    if (mqtt_shadow_registry_ready) {
+        platform_mutex_lock(&mqtt_shadow_registry_lock);
+        for (i = 0; i < MQTT_SHADOW_CLIENT_NUM_MAX; i++) {
+            if (mqtt_shadow_registry[i] == s)
+                mqtt_shadow_registry[i] = NULL;
+        }
+        platform_mutex_unlock(&mqtt_shadow_registry_lock);
+    }
+
+    /* 之后注册的回调可能已经链接到本实例，此时只能由应用自行恢复 */
+    if ((mqtt_shadow_disconnect_handler == mqtt_get_disconnect_handler(s->client)) &&
+        (s == mqtt_get_disconnect_data(s->client)))
+    {
+        mqtt_set_disconnect_handler(s->client, s->prev_disconnect_handler);
+        mqtt_set_disconnect_data(s->client, s->prev_disconnect_data);
+    }
+
+    if ((mqtt_shadow_reconnect_handler == mqtt_get_reconnect_handler(s->client)) &&
+        (s == mqtt_get_reconnect_data(s->client)))
+    {
+        mqtt_set_reconnect_handler(s->client, s->prev_reconnect_handler);
+        mqtt_set_reconnect_data(s->client, s->prev_reconnect_data);
+    }
+
+    platform_mutex_destroy(&s->lock);
+
+    RETURN_ERROR(MQTT_SUCCESS_ERROR);
+}
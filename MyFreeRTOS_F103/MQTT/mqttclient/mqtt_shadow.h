@@ -0,0 +1,87 @@
+/*
+ * @Date: 2026-10-19
+ * @Description: device shadow that reports only the changed fields.
+ */
+#ifndef _MQTT_SHADOW_H_
+#define _MQTT_SHADOW_H_
+
+#include "mqttclient.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * 上报文档（只包含变化的字段）：
+ *   {"state":{"reported":{"<name>":<value>,...}},"version":<n>}
+ * 下发的期望状态增量：
+ *   {"state":{"<name>":<value>,...},"version":<n>}，没有 "state" 时直接使用顶层对象
+ * 版本号不大于上次已处理版本的增量被丢弃，未知字段与只读字段被忽略。
+ * 增量只应用到 delta_topic 与消息主题相同的影子，delta_topic 不能包含通配符。
+ * 自动重连或调用 mqtt_disconnect 之后的第一个增量与 mqtt_shadow_apply_document 应用的完整文档（例如 GET 的响应）不做版本检查，
+ * 云端重置版本号后影子以新的版本号为准。
+ */
+#define     MQTT_SHADOW_DIRTY_WORDS             ((MQTT_SHADOW_FIELD_NUM_MAX + 31) / 32)
+
+typedef enum mqtt_shadow_type {
+    MQTT_SHADOW_TYPE_BOOL = 0,      /* value 指向 uint8_t */
+    MQTT_SHADOW_TYPE_INT,           /* value 指向 int32_t */
+    MQTT_SHADOW_TYPE_FLOAT,         /* value 指向 float */
+    MQTT_SHADOW_TYPE_STRING,        /* value 指向 char[size] */
+} mqtt_shadow_type_t;
+
+/* 字段表由调用者提供，可以是 const 数组，字段值保存在调用者的变量中 */
+typedef struct mqtt_shadow_field {
+    const char                  *name;
+    void                        *value;
+    uint16_t                    size;
+    uint8_t                     type;
+    uint8_t                     writable;
+} mqtt_shadow_field_t;
+
+typedef void (*mqtt_shadow_delta_handler_t)(void *arg, int index);
+
+typedef struct mqtt_shadow {
+    mqtt_client_t               *client;
+    const mqtt_shadow_field_t   *fields;
+    uint16_t                    field_num;
+    mqtt_qos_t                  qos;
+    const char                  *report_topic;
+    const char                  *delta_topic;
+    mqtt_shadow_delta_handler_t delta_handler;
+    void                        *delta_arg;
+    platform_mutex_t            lock;
+    uint32_t                    dirty[MQTT_SHADOW_DIRTY_WORDS];
+    uint32_t                    version;
+    uint32_t                    desired_version;
+    uint8_t                     resync;
+    uint32_t                    window;
+    uint8_t                     window_armed;
+    platform_timer_t            window_timer;
+    reconnect_handler_t         prev_reconnect_handler;
+    void                        *prev_reconnect_data;
+    disconnect_handler_t        prev_disconnect_handler;
+    void                        *prev_disconnect_data;
+    char                        doc[MQTT_SHADOW_DOC_SIZE];
+} mqtt_shadow_t;
+
+int mqtt_shadow_init(mqtt_shadow_t *s, mqtt_client_t *c, const mqtt_shadow_field_t *fields, int field_num,
+                     const char *report_topic, const char *delta_topic, mqtt_qos_t qos);
+int mqtt_shadow_set_window(mqtt_shadow_t *s, uint32_t window);
+int mqtt_shadow_set_delta_handler(mqtt_shadow_t *s, mqtt_shadow_delta_handler_t handler, void *arg);
+int mqtt_shadow_set_bool(mqtt_shadow_t *s, int index, uint8_t value);
+int mqtt_shadow_set_int(mqtt_shadow_t *s, int index, int32_t value);
+int mqtt_shadow_set_float(mqtt_shadow_t *s, int index, float value);
+int mqtt_shadow_set_string(mqtt_shadow_t *s, int index, const char *value);
+int mqtt_shadow_mark_dirty(mqtt_shadow_t *s, int index);
+int mqtt_shadow_apply_delta(mqtt_shadow_t *s, const char *doc, uint32_t len);
+int mqtt_shadow_apply_document(mqtt_shadow_t *s, const char *doc, uint32_t len);
+int mqtt_shadow_poll(mqtt_shadow_t *s);
+int mqtt_shadow_flush(mqtt_shadow_t *s);
+int mqtt_shadow_release(mqtt_shadow_t *s);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _MQTT_SHADOW_H_ */
@@ -0,0 +1,1012 @@
+/*
+ * @Date: 2026-10-19
+ * @Description: mqtt-sn 1.2 client over udp for sleepy sensor nodes.
+ */
+#include "mqtt_sn.h"
+
+#define MQTT_SN_ADVERTISE       0x00
+#define MQTT_SN_CONNECT         0x04
+#define MQTT_SN_CONNACK         0x05
+#define MQTT_SN_REGISTER        0x0A
+#define MQTT_SN_REGACK          0x0B
+#define MQTT_SN_PUBLISH         0x0C
+#define MQTT_SN_PUBACK          0x0D
+#define MQTT_SN_SUBSCRIBE       0x12
+#define MQTT_SN_SUBACK          0x13
+#define MQTT_SN_UNSUBSCRIBE     0x14
+#define MQTT_SN_UNSUBACK        0x15
+#define MQTT_SN_PINGREQ         0x16
+#define MQTT_SN_PINGRESP        0x17
+#define MQTT_SN_DISCONNECT      0x18
+
+#define MQTT_SN_FLAG_DUP        0x80
+#define MQTT_SN_FLAG_RETAIN     0x10
+#define MQTT_SN_FLAG_CLEAN      0x04
+#define MQTT_SN_FLAG_QOS_SHIFT  5
+#define MQTT_SN_FLAG_TYPE_MASK  0x03
+
+#define MQTT_SN_PROTOCOL_ID     0x01
+#define MQTT_SN_RC_ACCEPTED     0x00
+#define MQTT_SN_RC_INVALID_ID   0x02
+
+/* 报文体写在 tx + MQTT_SN_HEADER_MAX 处，发送时再在前面补上 2 或 4 字节的长度和类型 */
+#define MQTT_SN_HEADER_MAX      4
+#define MQTT_SN_BODY_MAX        (MQTT_SN_BUF_SIZE - MQTT_SN_HEADER_MAX)
+#define MQTT_SN_NO_MSG_ID       (-1)
+
+static uint16_t mqtt_sn_get16(const unsigned char *p)
+{
+    return (uint16_t)((p[0] << 8) | p[1]);
+}
+
+static void mqtt_sn_put16(unsigned char *p, uint16_t v)
+{
+    p[0] = (unsigned char)(v >> 8);
+    p[1] = (unsigned char)(v & 0xff);
+}
+
+static unsigned char *mqtt_sn_body(mqtt_sn_client_t *c)
+{
+    return c->tx + MQTT_SN_HEADER_MAX;
+}
+
+static uint16_t mqtt_sn_next_msg_id(mqtt_sn_client_t *c)
+{
+    if (++c->msg_id == 0)
+        c->msg_id = 1;
+    return c->msg_id;
+}
+
+/**
+ * @brief 主题过滤器匹配，支持 '+' 和 '#' 通配符
+ *
+ * @param filter 主题过滤器
+ * @param topic 主题名
+ * @param topic_len 主题名长度
+ * @return int 匹配返回 1，否则返回 0
+ */
+static int mqtt_sn_topic_match(const char *filter, const char *topic, int topic_len)
+{
+    const char *end = topic + topic_len;
+
+    while (*filter && (topic < end)) {
+        if ('#' == *filter)
+            return 1;
+        if ('+' == *filter) {
+            while ((topic < end) && ('/' != *topic))
+                topic++;
+            filter++;
+            continue;
+        }
+        if (*filter != *topic)
+            return 0;
+        filter++;
+        topic++;
+    }
+
+    /* 主题已结束时 '+' 匹配空层级，"a/+" 也匹配 "a/" */
+    if ((topic == end) && ('+' == *filter))
+        filter++;
+
+    /* "a/#" 也匹配 "a" */
+    if ((topic == end) && ('/' == filter[0]) && ('#' == filter[1]) && ('\0' == filter[2]))
+        return 1;
+
+    return (topic == end) && (('\0' == *filter) || (('#' == *filter) && ('\0' == filter[1])));
+}
+
+static mqtt_sn_topic_t *mqtt_sn_topic_find(mqtt_sn_client_t *c, const char *name)
+{
+    int i;
+
+    for (i = 0; i < MQTT_SN_TOPIC_NUM_MAX; i++) {
+        if (('\0' != c->topics[i].name[0]) && (0 == strcmp(c->topics[i].name, name)))
+            return &c->topics[i];
+    }
+    return NULL;
+}
+
+static mqtt_sn_topic_t *mqtt_sn_topic_find_id(mqtt_sn_client_t *c, uint16_t id, uint8_t type)
+{
+    int i;
+
+    for (i = 0; i < MQTT_SN_TOPIC_NUM_MAX; i++) {
+        if (('\0' != c->topics[i].name[0]) && (c->topics[i].id == id) && (c->topics[i].type == type))
+            return &c->topics[i];
+    }
+    return NULL;
+}
+
+static mqtt_sn_topic_t *mqtt_sn_topic_add(mqtt_sn_client_t *c, const char *name, int name_len)
+{
+    int i;
+    mqtt_sn_topic_t *t;
+
+    if (name_len >= MQTT_SN_TOPIC_LEN_MAX)
+        return NULL;
+
+    for (i = 0; i < MQTT_SN_TOPIC_NUM_MAX; i++) {
+        t = &c->topics[i];
+        if ('\0' != t->name[0])
+            continue;
+
+        memset(t, 0, sizeof(mqtt_sn_topic_t));
+        memcpy(t->name, name, name_len);
+        t->name[name_len] = '\0';
+        return t;
+    }
+    return NULL;
+}
+
+/**
+ * @brief 按订阅过滤器查找主题的处理函数，精确匹配的订阅优先
+ *
+ * @param c MQTT-SN 客户端实例
+ * @param name 主题名
+ * @param name_len 主题名长度
+ * @return message_handler_t 处理函数，没有匹配的订阅时返回默认处理函数
+ */
+static message_handler_t mqtt_sn_topic_handler(mqtt_sn_client_t *c, const char *name, int name_len)
+{
+    int i;
+    message_handler_t handler = NULL;
+
+    for (i = 0; i < MQTT_SN_TOPIC_NUM_MAX; i++) {
+        if ((!c->topics[i].subscribed) || (!mqtt_sn_topic_match(c->topics[i].name, name, name_len)))
+            continue;
+        if (((int)strlen(c->topics[i].name) == name_len) && (0 == memcmp(c->topics[i].name, name, name_len)))
+            return c->topics[i].handler;
+        if (NULL == handler)
+            handler = c->topics[i].handler;
+    }
+
+    return (NULL != handler) ? handler : c->default_handler;
+}
+
+/**
+ * @brief 主题名是否还被某个订阅过滤器匹配
+ *
+ * @param c MQTT-SN 客户端实例
+ * @param name 主题名
+ * @return int 有匹配的订阅返回 1，否则返回 0
+ */
+static int mqtt_sn_topic_covered(mqtt_sn_client_t *c, const char *name)
+{
+    int i, len = strlen(name);
+
+    for (i = 0; i < MQTT_SN_TOPIC_NUM_MAX; i++) {
+        if ((c->topics[i].subscribed) && (mqtt_sn_topic_match(c->topics[i].name, name, len)))
+            return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief 打开到网关的 UDP 套接字
+ *
+ * @param c MQTT-SN 客户端实例
+ * @return int 返回状态码，MQTT_SUCCESS_ERROR 表示成功
+ */
+static int mqtt_sn_open(mqtt_sn_client_t *c)
+{
+    if (c->fd >= 0)
+        RETURN_ERROR(MQTT_SUCCESS_ERROR);
+
+    c->fd = platform_net_socket_connect(c->host, c->port, PLATFORM_NET_PROTO_UDP);
+    if (c->fd < 0)
+        RETURN_ERROR(c->fd);
+
+    RETURN_ERROR(MQTT_SUCCESS_ERROR);
+}
+
+static int mqtt_sn_write(mqtt_sn_client_t *c, unsigned char *buf, int len)
+{
+    if (platform_net_socket_write(c->fd, buf, len) != len)
+        RETURN_ERROR(MQTT_SEND_PACKET_ERROR);
+
+    c->tx_bytes += len;
+    c->tx_packets++;
+    platform_timer_cutdown(&c->ping_timer, (unsigned int)c->keep_alive * 1000);
+
+    RETURN_ERROR(MQTT_SUCCESS_ERROR);
+}
+
+/**
+ * @brief 给 tx 中已写好的报文体加上长度和类型并发送，报文保留在 tx 中用于重发
+ *
+ * @param c MQTT-SN 客户端实例
+ * @param type 报文类型
+ * @param body_len 报文体长度
+ * @return int 返回状态码，MQTT_SUCCESS_ERROR 表示成功
+ */
+static int mqtt_sn_send(mqtt_sn_client_t *c, uint8_t type, int body_len)
+{
+    unsigned char *p;
+
+    if (body_len + 2 <= 255) {
+        p = c->tx + MQTT_SN_HEADER_MAX - 2;
+        p[0] = (unsigned char)(body_len + 2);
+        p[1] = type;
+        c->tx_len = body_len + 2;
+    } else {
+        p = c->tx;
+        p[0] = 0x01;
+        mqtt_sn_put16(p + 1, (uint16_t)(body_len + 4));
+        p[3] = type;
+        c->tx_len = body_len + 4;
+    }
+
+    return mqtt_sn_write(c, p, c->tx_len);
+}
+
+static int mqtt_sn_resend(mqtt_sn_client_t *c)
+{
+    return mqtt_sn_write(c, mqtt_sn_body(c) - ((c->tx_len > 255) ? 4 : 2), c->tx_len);
+}
+
+/* 应答直接在栈上组包，不覆盖 tx 中等待重发的请求 */
+static void mqtt_sn_send_ack(mqtt_sn_client_t *c, uint8_t type, uint16_t topic_id, uint16_t msg_id, uint8_t rc)
+{
+    unsigned char ack[7];
+
+    ack[0] = sizeof(ack);
+    ack[1] = type;
+    mqtt_sn_put16(ack + 2, topic_id);
+    mqtt_sn_put16(ack + 4, msg_id);
+    ack[6] = rc;
+    mqtt_sn_write(c, ack, sizeof(ack));
+}
+
+/**
+ * @brief 读取一个数据报并解析报文头
+ *
+ * @param c MQTT-SN 客户端实例
+ * @param timeout 超时时间，单位毫秒
+ * @param type 输出报文类型
+ * @param body 输出报文体
+ * @param body_len 输出报文体长度
+ * @return int 返回状态码，超时或收到无效报文时返回 MQTT_NOTHING_TO_READ_ERROR
+ */
+static int mqtt_sn_read_packet(mqtt_sn_client_t *c, int timeout, uint8_t *type, unsigned char **body, int *body_len)
+{
+    int len, hdr, pkt_len;
+
+    if (platform_net_socket_wait(c->fd, PLATFORM_NET_WAIT_READ, timeout) <= 0)
+        RETURN_ERROR(MQTT_NOTHING_TO_READ_ERROR);
+
+    len = platform_net_socket_recv(c->fd, c->rx, sizeof(c->rx), 0);
+    if (len < 2)
+        RETURN_ERROR(MQTT_NOTHING_TO_READ_ERROR);
+
+    if (0x01 == c->rx[0]) {
+        if (len < 4)
+            RETURN_ERROR(MQTT_NOTHING_TO_READ_ERROR);
+        hdr = 3;
+        pkt_len = mqtt_sn_get16(c->rx + 1);
+    } else {
+        hdr = 1;
+        pkt_len = c->rx[0];
+    }
+
+    if ((pkt_len > len) || (pkt_len < hdr + 1))
+        RETURN_ERROR(MQTT_NOTHING_TO_READ_ERROR);
+
+    c->rx_bytes += len;
+    c->rx_packets++;
+
+    *type = c->rx[hdr];
+    *body = c->rx + hdr + 1;
+    *body_len = pkt_len - hdr - 1;
+
+    RETURN_ERROR(MQTT_SUCCESS_ERROR);
+}
+
+/**
+ * @brief 处理网关下发的 PUBLISH，QoS1 的消息回复 PUBACK
+ */
+static void mqtt_sn_publish_handle(mqtt_sn_client_t *c, unsigned char *body, int body_len)
+{
+    uint8_t flags, type;
+    uint16_t topic_id, msg_id;
+    char short_name[3];
+    mqtt_sn_topic_t *t = NULL;
+    message_handler_t handler;
+    mqtt_message_t msg;
+    message_data_t md;
+
+    if (body_len < 5)
+        return;
+
+    flags = body[0];
+    type = flags & MQTT_SN_FLAG_TYPE_MASK;
+    topic_id = mqtt_sn_get16(body + 1);
+    msg_id = mqtt_sn_get16(body + 3);
+
+    memset(&msg, 0, sizeof(msg));
+    msg.qos = (mqtt_qos_t)((flags >> MQTT_SN_FLAG_QOS_SHIFT) & 0x03);
+    msg.retained = (flags & MQTT_SN_FLAG_RETAIN) ? 1 : 0;
+    msg.dup = (flags & MQTT_SN_FLAG_DUP) ? 1 : 0;
+    msg.id = msg_id;
+    msg.payload = body + 5;
+    msg.payloadlen = body_len - 5;
+
+    md.message = &msg;
+    md.topic_id = topic_id;
+
+    if (MQTT_SN_TOPIC_TYPE_SHORT == type) {
+        short_name[0] = (char)body[1];
+        short_name[1] = (char)body[2];
+        short_name[2] = '\0';
+        md.topic_name = short_name;
+        md.topic_len = 2;
+    } else {
+        t = mqtt_sn_topic_find_id(c, topic_id, type);
+        if (NULL == t) {
+            /* 未知的主题 ID，通知网关不要再发 */
+            mqtt_sn_send_ack(c, MQTT_SN_PUBACK, topic_id, msg_id, MQTT_SN_RC_INVALID_ID);
+            return;
+        }
+        md.topic_name = t->name;
+        md.topic_len = (uint16_t)strlen(t->name);
+    }
+
+    handler = (NULL != t) && (NULL != t->handler) ? t->handler : mqtt_sn_topic_handler(c, md.topic_name, md.topic_len);
+    if (NULL != handler)
+        handler(c, &md);
+
+    if (QOS1 == msg.qos)
+        mqtt_sn_send_ack(c, MQTT_SN_PUBACK, topic_id, msg_id, MQTT_SN_RC_ACCEPTED);
+}
+
+/**
+ * @brief 处理网关为通配符订阅下发的 REGISTER，记录主题名与 ID 的对应关系
+ */
+static void mqtt_sn_register_handle(mqtt_sn_client_t *c, unsigned char *body, int body_len)
+{
+    uint16_t topic_id, msg_id;
+    mqtt_sn_topic_t *t;
+
+    if (body_len < 5)
+        return;
+
+    topic_id = mqtt_sn_get16(body);
+    msg_id = mqtt_sn_get16(body + 2);
+
+    t = mqtt_sn_topic_find_id(c, topic_id, MQTT_SN_TOPIC_TYPE_NORMAL);
+    if (NULL == t) {
+        t = mqtt_sn_topic_add(c, (const char *)body + 4, body_len - 4);
+        if (NULL == t) {
+            mqtt_sn_send_ack(c, MQTT_SN_REGACK, topic_id, msg_id, 0x01);  /* congestion */
+            return;
+        }
+        t->id = topic_id;
+        t->type = MQTT_SN_TOPIC_TYPE_NORMAL;
+        t->gateway = 1;
+        t->handler = mqtt_sn_topic_handler(c, t->name, body_len - 4);
+    }
+
+    mqtt_sn_send_ack(c, MQTT_SN_REGACK, topic_id, msg_id, MQTT_SN_RC_ACCEPTED);
+}
+
+static void mqtt_sn_packet_handle(mqtt_sn_client_t *c, uint8_t type, unsigned char *body, int body_len)
+{
+    switch (type) {
+        case MQTT_SN_PUBLISH:
+            mqtt_sn_publish_handle(c, body, body_len);
+            break;
+
+        case MQTT_SN_REGISTER:
+            mqtt_sn_register_handle(c, body, body_len);
+            break;
+
+        case MQTT_SN_PINGREQ: {
+            unsigned char resp[2] = { 2, MQTT_SN_PINGRESP };
+            mqtt_sn_write(c, resp, sizeof(resp));
+            break;
+        }
+
+        case MQTT_SN_DISCONNECT:
+            /* 网关主动断开，或者睡眠请求的应答，由调用者决定状态 */
+            break;
+
+        default:
+            break;
+    }
+}
+
+/**
+ * @brief 发送 tx 中的请求并等待应答，期间收到的消息照常分发，超时后重发，DUP 标志按需置位
+ *
+ * @param c MQTT-SN 客户端实例
+ * @param type 请求报文类型
+ * @param body_len 请求报文体长度
+ * @param ack_type 期望的应答类型
+ * @param msg_id 期望的报文 ID
+ * @param msg_id_off 报文 ID 在应答报文体中的偏移，MQTT_SN_NO_MSG_ID 表示应答中没有报文 ID
+ * @return int 返回状态码，收到应答时返回 MQTT_SUCCESS_ERROR，应答报文体保存在 c->ack
+ */
+static int mqtt_sn_request(mqtt_sn_client_t *c, uint8_t type, int body_len,
+                           uint8_t ack_type, uint16_t msg_id, int msg_id_off)
+{
+    int rc, retry, rx_len;
+    uint8_t rx_type;
+    unsigned char *rx_body;
+    platform_timer_t timer;
+
+    rc = mqtt_sn_send(c, type, body_len);
+
+    for (retry = 0; (MQTT_SUCCESS_ERROR == rc) && (retry <= MQTT_SN_RETRY_MAX); retry++) {
+        if (retry > 0) {
+            if (MQTT_SN_PUBLISH == type)
+                mqtt_sn_body(c)[0] |= MQTT_SN_FLAG_DUP;
+            if ((rc = mqtt_sn_resend(c)) != MQTT_SUCCESS_ERROR)
+                break;
+        }
+
+        platform_timer_cutdown(&timer, MQTT_SN_RETRY_INTERVAL);
+        while (!platform_timer_is_expired(&timer)) {
+            if (mqtt_sn_read_packet(c, platform_timer_remain(&timer), &rx_type, &rx_body, &rx_len) != MQTT_SUCCESS_ERROR)
+                continue;
+
+            if ((MQTT_SN_DISCONNECT == rx_type) && (MQTT_SN_DISCONNECT != ack_type)) {
+                c->state = MQTT_SN_STATE_DISCONNECTED;
+                RETURN_ERROR(MQTT_NOT_CONNECT_ERROR);
+            }
+
+            mqtt_sn_packet_handle(c, rx_type, rx_body, rx_len);
+
+            if (rx_type != ack_type)
+                continue;
+            if ((MQTT_SN_NO_MSG_ID != msg_id_off) &&
+                ((rx_len < msg_id_off + 2) || (mqtt_sn_get16(rx_body + msg_id_off) != msg_id)))
+                continue;
+
+            c->ack = rx_body;
+            c->ack_len = rx_len;
+            RETURN_ERROR(MQTT_SUCCESS_ERROR);
+        }
+    }
+
+    if (MQTT_SUCCESS_ERROR == rc) {
+        /* 重试次数用完，认为与网关的连接已经断开 */
+        c->state = MQTT_SN_STATE_DISCONNECTED;
+        rc = MQTT_NOT_CONNECT_ERROR;
+    }
+
+    RETURN_ERROR(rc);
+}
+
+/**
+ * @brief 初始化 MQTT-SN 客户端
+ *
+ * @param c MQTT-SN 客户端实例
+ * @param host 网关地址
+ * @param port 网关 UDP 端口
+ * @param client_id 客户端 ID，1 ~ 23 个字符
+ * @return int 返回状态码，MQTT_SUCCESS_ERROR 表示成功
+ */
+int mqtt_sn_init(mqtt_sn_client_t *c, const char *host, const char *port, const char *client_id)
+{
+    if ((NULL == c) || (NULL == host) || (NULL == port) || (NULL == client_id))
+        RETURN_ERROR(MQTT_NULL_VALUE_ERROR);
+
+    memset(c, 0, sizeof(mqtt_sn_client_t));
+    c->fd = -1;
+    c->host = host;
+    c->port = port;
+    c->client_id = client_id;
+    c->state = MQTT_SN_STATE_DISCONNECTED;
+    c->clean_session = 1;
+    c->keep_alive = MQTT_SN_KEEP_ALIVE;
+    platform_timer_init(&c->ping_timer);
+
+    RETURN_ERROR(MQTT_SUCCESS_ERROR);
+}
+
+int mqtt_sn_set_keep_alive(mqtt_sn_client_t *c, uint16_t keep_alive)
+{
+    if (NULL == c)
+        RETURN_ERROR(MQTT_NULL_VALUE_ERROR);
+
+    c->keep_alive = keep_alive;
+    RETURN_ERROR(MQTT_SUCCESS_ERROR);
+}
+
+int mqtt_sn_set_clean_session(mqtt_sn_client_t *c, uint8_t clean_session)
+{
+    if (NULL == c)
+        RETURN_ERROR(MQTT_NULL_VALUE_ERROR);
+
+    c->clean_session = clean_session;
+    RETURN_ERROR(MQTT_SUCCESS_ERROR);
+}
+
+/**
+ * @brief 设置默认处理函数，没有匹配订阅的消息（例如网关预先配置的订阅）交给它处理
+ */
+int mqtt_sn_set_default_handler(mqtt_sn_client_t *c, message_handler_t handler)
+{
+    if (NULL == c)
+        RETURN_ERROR(MQTT_NULL_VALUE_ERROR);
+
+    c->default_handler = handler;
+    RETURN_ERROR(MQTT_SUCCESS_ERROR);
+}
+
+/**
+ * @brief 添加与网关约定的预定义主题，之后按主题名发布或订阅时直接使用该 ID，不需要注册
+ *
+ * @param c MQTT-SN 客户端实例
+ * @param topic 主题名
+ * @param topic_id 预定义的主题 ID
+ * @return int 返回状态码，MQTT_SUCCESS_ERROR 表示成功
+ */
+int mqtt_sn_add_predefined(mqtt_sn_client_t *c, const char *topic, uint16_t topic_id)
+{
+    mqtt_sn_topic_t *t;
+
+    if ((NULL == c) || (NULL == topic))
+        RETURN_ERROR(MQTT_NULL_VALUE_ERROR);
+
+    t = mqtt_sn_topic_find(c, topic);
+    if (NULL == t)
+        t = mqtt_sn_topic_add(c, topic, strlen(topic));
+    if (NULL == t)
+        RETURN_ERROR(MQTT_MEM_NOT_ENOUGH_ERROR);
+
+    t->id = topic_id;
+    t->type = MQTT_SN_TOPIC_TYPE_PREDEFINED;
+
+    RETURN_ERROR(MQTT_SUCCESS_ERROR);
+}
+
+/**
+ * @brief 连接网关，也用于从睡眠状态回到活动状态
+ *
+ * @param c MQTT-SN 客户端实例
+ * @return int 返回状态码，MQTT_SUCCESS_ERROR 表示成功
+ */
+int mqtt_sn_connect(mqtt_sn_client_t *c)
+{
+    int i, rc, len;
+    unsigned char *body;
+
+    if (NULL == c)
+        RETURN_ERROR(MQTT_NULL_VALUE_ERROR);
+
+    if ((rc = mqtt_sn_open(c)) != MQTT_SUCCESS_ERROR)
+        RETURN_ERROR(rc);
+
+    len = strlen(c->client_id);
+    if ((len < 1) || (len > 23))
+        RETURN_ERROR(MQTT_CONNECT_FAILED_ERROR);
+
+    body = mqtt_sn_body(c);
+    body[0] = c->clean_session ? MQTT_SN_FLAG_CLEAN : 0;
+    body[1] = MQTT_SN_PROTOCOL_ID;
+    mqtt_sn_put16(body + 2, c->keep_alive);
+    memcpy(body + 4, c->client_id, len);
+
+    rc = mqtt_sn_request(c, MQTT_SN_CONNECT, 4 + len, MQTT_SN_CONNACK, 0, MQTT_SN_NO_MSG_ID);
+    if (MQTT_SUCCESS_ERROR != rc)
+        RETURN_ERROR(MQTT_CONNECT_FAILED_ERROR);
+
+    if ((c->ack_len < 1) || (MQTT_SN_RC_ACCEPTED != c->ack[0]))
+        RETURN_ERROR(MQTT_SN_REJECTED_ERROR);
+
+    /* 新会话中网关分配的主题 ID 全部失效，订阅需要重新发起，其余非预定义主题直接释放 */
+    if (c->clean_session) {
+        for (i = 0; i < MQTT_SN_TOPIC_NUM_MAX; i++) {
+            if (MQTT_SN_TOPIC_TYPE_PREDEFINED == c->topics[i].type)
+                continue;
+            if (!c->topics[i].subscribed)
+                memset(&c->topics[i], 0, sizeof(mqtt_sn_topic_t));
+            else if (MQTT_SN_TOPIC_TYPE_NORMAL == c->topics[i].type)
+                c->topics[i].id = 0;
+        }
+    }
+
+    c->state = MQTT_SN_STATE_ACTIVE;
+    MQTT_LOG_D("%s:%d %s()... mqtt-sn connect success...", __FILE__, __LINE__, __FUNCTION__);
+
+    RETURN_ERROR(MQTT_SUCCESS_ERROR);
+}
+
+/**
+ * @brief 注册普通主题，获得网关分配的主题 ID
+ *
+ * @param c MQTT-SN 客户端实例
+ * @param topic 主题名
+ * @param topic_id 输出主题 ID，可以为 NULL
+ * @return int 返回状态码，MQTT_SUCCESS_ERROR 表示成功
+ */
+int mqtt_sn_register(mqtt_sn_client_t *c, const char *topic, uint16_t *topic_id)
+{
+    int rc, len;
+    uint16_t msg_id;
+    unsigned char *body;
+    mqtt_sn_topic_t *t;
+
+    if ((NULL == c) || (NULL == topic))
+        RETURN_ERROR(MQTT_NULL_VALUE_ERROR);
+
+    if (MQTT_SN_STATE_ACTIVE != c->state)
+        RETURN_ERROR(MQTT_NOT_CONNECT_ERROR);
+
+    t = mqtt_sn_topic_find(c, topic);
+    if ((NULL != t) && (0 != t->id)) {
+        if (NULL != topic_id)
+            *topic_id = t->id;
+        RETURN_ERROR(MQTT_SUCCESS_ERROR);
+    }
+
+    len = strlen(topic);
+    if (len + 4 > MQTT_SN_BODY_MAX)
+        RETURN_ERROR(MQTT_BUFFER_TOO_SHORT_ERROR);
+
+    if ((NULL == t) && (NULL == (t = mqtt_sn_topic_add(c, topic, len))))
+        RETURN_ERROR(MQTT_MEM_NOT_ENOUGH_ERROR);
+
+    msg_id = mqtt_sn_next_msg_id(c);
+    body = mqtt_sn_body(c);
+    mqtt_sn_put16(body, 0);
+    mqtt_sn_put16(body + 2, msg_id);
+    memcpy(body + 4, topic, len);
+
+    rc = mqtt_sn_request(c, MQTT_SN_REGISTER, 4 + len, MQTT_SN_REGACK, msg_id, 2);
+    if (MQTT_SUCCESS_ERROR != rc)
+        RETURN_ERROR(rc);
+
+    if ((c->ack_len < 5) || (MQTT_SN_RC_ACCEPTED != c->ack[4]))
+        RETURN_ERROR(MQTT_SN_REJECTED_ERROR);
+
+    t->id = mqtt_sn_get16(c->ack);
+    t->type = MQTT_SN_TOPIC_TYPE_NORMAL;
+    if (NULL != topic_id)
+        *topic_id = t->id;
+
+    RETURN_ERROR(MQTT_SUCCESS_ERROR);
+}
+
+/**
+ * @brief 发布消息。两个字符的主题按短主题发送，预定义主题直接使用其 ID，其他主题按需注册。
+ *        QoS -1（MQTT_SN_QOS_NEG1）不需要连接网关，只能用于短主题和预定义主题
+ *
+ * @param c MQTT-SN 客户端实例
+ * @param topic 主题名
+ * @param msg 消息，qos 可以为 MQTT_SN_QOS_NEG1、QOS0 或 QOS1
+ * @return int 返回状态码，MQTT_SUCCESS_ERROR 表示成功
+ */
+int mqtt_sn_publish(mqtt_sn_client_t *c, const char *topic, mqtt_message_t *msg)
+{
+    int rc;
+    uint8_t type;
+    uint16_t topic_id, msg_id = 0;
+    unsigned char *body;
+    mqtt_sn_topic_t *t;
+
+    if ((NULL == c) || (NULL == topic) || (NULL == msg))
+        RETURN_ERROR(MQTT_NULL_VALUE_ERROR);
+
+    if ((QOS2 == msg->qos) || (msg->payloadlen + 5 > MQTT_SN_BODY_MAX))
+        RETURN_ERROR((QOS2 == msg->qos) ? MQTT_PUBLISH_PACKET_ERROR : MQTT_BUFFER_TOO_SHORT_ERROR);
+
+    if ((MQTT_SN_QOS_NEG1 != msg->qos) && (MQTT_SN_STATE_ACTIVE != c->state))
+        RETURN_ERROR(MQTT_NOT_CONNECT_ERROR);
+
+    if ((rc = mqtt_sn_open(c)) != MQTT_SUCCESS_ERROR)
+        RETURN_ERROR(rc);
+
+    t = mqtt_sn_topic_find(c, topic);
+    if ((NULL != t) && (MQTT_SN_TOPIC_TYPE_PREDEFINED == t->type)) {
+        type = MQTT_SN_TOPIC_TYPE_PREDEFINED;
+        topic_id = t->id;
+    } else if (2 == strlen(topic)) {
+        type = MQTT_SN_TOPIC_TYPE_SHORT;
+        topic_id = (uint16_t)(((uint8_t)topic[0] << 8) | (uint8_t)topic[1]);
+    } else if (MQTT_SN_QOS_NEG1 == msg->qos) {
+        RETURN_ERROR(MQTT_PUBLISH_PACKET_ERROR);
+    } else {
+        type = MQTT_SN_TOPIC_TYPE_NORMAL;
+        if ((rc = mqtt_sn_register(c, topic, &topic_id)) != MQTT_SUCCESS_ERROR)
+            RETURN_ERROR(rc);
+    }
+
+    if (QOS1 == msg->qos)
+        msg->id = msg_id = mqtt_sn_next_msg_id(c);
+
+    body = mqtt_sn_body(c);
+    body[0] = (uint8_t)((msg->qos & 0x03) << MQTT_SN_FLAG_QOS_SHIFT) | (msg->retained ? MQTT_SN_FLAG_RETAIN : 0) | type;
+    mqtt_sn_put16(body + 1, topic_id);
+    mqtt_sn_put16(body + 3, msg_id);
+    if (msg->payloadlen > 0)
+        memcpy(body + 5, msg->payload, msg->payloadlen);
+
+    if (QOS1 != msg->qos)
+        RETURN_ERROR(mqtt_sn_send(c, MQTT_SN_PUBLISH, 5 + (int)msg->payloadlen));
+
+    rc = mqtt_sn_request(c, MQTT_SN_PUBLISH, 5 + (int)msg->payloadlen, MQTT_SN_PUBACK, msg_id, 2);
+    if (MQTT_SUCCESS_ERROR != rc)
+        RETURN_ERROR(rc);
+
+    if ((c->ack_len >= 5) && (MQTT_SN_RC_ACCEPTED != c->ack[4])) {
+        /* 网关已不认识这个主题 ID，下次发布时重新注册 */
+        if ((MQTT_SN_RC_INVALID_ID == c->ack[4]) && (NULL != (t = mqtt_sn_topic_find(c, topic))) &&
+            (MQTT_SN_TOPIC_TYPE_NORMAL == t->type))
+            t->id = 0;
+        RETURN_ERROR(MQTT_SN_REJECTED_ERROR);
+    }
+
+    RETURN_ERROR(MQTT_SUCCESS_ERROR);
+}
+
+/**
+ * @brief 订阅主题，支持通配符，通配符匹配到的主题由网关通过 REGISTER 告知
+ *
+ * @param c MQTT-SN 客户端实例
+ * @param topic_filter 主题过滤器，预定义主题和短主题不需要注册
+ * @param qos 最大 QoS，QOS0 或 QOS1
+ * @param handler 消息处理函数
+ * @return int 返回状态码，MQTT_SUCCESS_ERROR 表示成功
+ */
+int mqtt_sn_subscribe(mqtt_sn_client_t *c, const char *topic_filter, mqtt_qos_t qos, message_handler_t handler)
+{
+    int rc, len, body_len;
+    uint16_t msg_id;
+    unsigned char *body;
+    mqtt_sn_topic_t *t;
+
+    if ((NULL == c) || (NULL == topic_filter))
+        RETURN_ERROR(MQTT_NULL_VALUE_ERROR);
+
+    if ((QOS0 != qos) && (QOS1 != qos))
+        RETURN_ERROR(MQTT_SUBSCRIBE_QOS_ERROR);
+
+    if (MQTT_SN_STATE_ACTIVE != c->state)
+        RETURN_ERROR(MQTT_NOT_CONNECT_ERROR);
+
+    len = strlen(topic_filter);
+    if (len + 3 > MQTT_SN_BODY_MAX)
+        RETURN_ERROR(MQTT_BUFFER_TOO_SHORT_ERROR);
+
+    t = mqtt_sn_topic_find(c, topic_filter);
+    if ((NULL == t) && (NULL == (t = mqtt_sn_topic_add(c, topic_filter, len))))
+        RETURN_ERROR(MQTT_MEM_NOT_ENOUGH_ERROR);
+
+    msg_id = mqtt_sn_next_msg_id(c);
+    body = mqtt_sn_body(c);
+    mqtt_sn_put16(body + 1, msg_id);
+
+    if (MQTT_SN_TOPIC_TYPE_PREDEFINED == t->type) {
+        body[0] = (uint8_t)(qos << MQTT_SN_FLAG_QOS_SHIFT) | MQTT_SN_TOPIC_TYPE_PREDEFINED;
+        mqtt_sn_put16(body + 3, t->id);
+        body_len = 5;
+    } else if (2 == len) {
+        t->type = MQTT_SN_TOPIC_TYPE_SHORT;
+        t->id = (uint16_t)(((uint8_t)topic_filter[0] << 8) | (uint8_t)topic_filter[1]);
+        body[0] = (uint8_t)(qos << MQTT_SN_FLAG_QOS_SHIFT) | MQTT_SN_TOPIC_TYPE_SHORT;
+        mqtt_sn_put16(body + 3, t->id);
+        body_len = 5;
+    } else {
+        body[0] = (uint8_t)(qos << MQTT_SN_FLAG_QOS_SHIFT) | MQTT_SN_TOPIC_TYPE_NORMAL;
+        memcpy(body + 3, topic_filter, len);
+        body_len = 3 + len;
+    }
+
+    rc = mqtt_sn_request(c, MQTT_SN_SUBSCRIBE, body_len, MQTT_SN_SUBACK, msg_id, 3);
+    if (MQTT_SUCCESS_ERROR != rc)
+        RETURN_ERROR(rc);
+
+    if ((c->ack_len < 6) || (MQTT_SN_RC_ACCEPTED != c->ack[5]))
+        RETURN_ERROR(MQTT_SN_REJECTED_ERROR);
+
+    /* 通配符订阅返回的 ID 为 0 */
+    if (MQTT_SN_TOPIC_TYPE_NORMAL == t->type)
+        t->id = mqtt_sn_get16(c->ack + 1);
+    t->subscribed = 1;
+    t->handler = handler;
+
+    RETURN_ERROR(MQTT_SUCCESS_ERROR);
+}
+
+/**
+ * @brief 取消订阅
+ *
+ * @param c MQTT-SN 客户端实例
+ * @param topic_filter 订阅时使用的主题过滤器
+ * @return int 返回状态码，MQTT_SUCCESS_ERROR 表示成功
+ */
+int mqtt_sn_unsubscribe(mqtt_sn_client_t *c, const char *topic_filter)
+{
+    int i, rc, len, body_len;
+    uint16_t msg_id;
+    unsigned char *body;
+    mqtt_sn_topic_t *t;
+
+    if ((NULL == c) || (NULL == topic_filter))
+        RETURN_ERROR(MQTT_NULL_VALUE_ERROR);
+
+    if (MQTT_SN_STATE_ACTIVE != c->state)
+        RETURN_ERROR(MQTT_NOT_CONNECT_ERROR);
+
+    t = mqtt_sn_topic_find(c, topic_filter);
+    if ((NULL == t) || (!t->subscribed))
+        RETURN_ERROR(MQTT_SUCCESS_ERROR);
+
+    len = strlen(topic_filter);
+    msg_id = mqtt_sn_next_msg_id(c);
+    body = mqtt_sn_body(c);
+    body[0] = t->type;
+    mqtt_sn_put16(body + 1, msg_id);
+    if (MQTT_SN_TOPIC_TYPE_NORMAL == t->type) {
+        memcpy(body + 3, topic_filter, len);
+        body_len = 3 + len;
+    } else {
+        mqtt_sn_put16(body + 3, t->id);
+        body_len = 5;
+    }
+
+    rc = mqtt_sn_request(c, MQTT_SN_UNSUBSCRIBE, body_len, MQTT_SN_UNSUBACK, msg_id, 0);
+    if (MQTT_SUCCESS_ERROR != rc)
+        RETURN_ERROR(rc);
+
+    /* 预定义主题保留 ID 映射，其余过滤器直接释放 */
+    if (MQTT_SN_TOPIC_TYPE_PREDEFINED == t->type) {
+        t->subscribed = 0;
+        t->handler = NULL;
+    } else {
+        memset(t, 0, sizeof(mqtt_sn_topic_t));
+    }
+
+    /* 网关为这个过滤器下发的主题不再有人订阅时释放，否则重新查找处理函数 */
+    for (i = 0; i < MQTT_SN_TOPIC_NUM_MAX; i++) {
+        t = &c->topics[i];
+        if ((!t->gateway) || (!mqtt_sn_topic_match(topic_filter, t->name, strlen(t->name))))
+            continue;
+        if (mqtt_sn_topic_covered(c, t->name))
+            t->handler = mqtt_sn_topic_handler(c, t->name, strlen(t->name));
+        else
+            memset(t, 0, sizeof(mqtt_sn_topic_t));
+    }
+
+    RETURN_ERROR(MQTT_SUCCESS_ERROR);
+}
+
+/**
+ * @brief 接收并分发网关下发的消息，到达保活时间时发送 PINGREQ
+ *
+ * @param c MQTT-SN 客户端实例
+ * @param timeout_ms 等待时间，单位毫秒
+ * @return int 返回状态码，与网关失去联系时返回 MQTT_NOT_CONNECT_ERROR
+ */
+int mqtt_sn_yield(mqtt_sn_client_t *c, int timeout_ms)
+{
+    int rc, rx_len;
+    uint8_t rx_type;
+    unsigned char *rx_body;
+    platform_timer_t timer;
+
+    if (NULL == c)
+        RETURN_ERROR(MQTT_NULL_VALUE_ERROR);
+
+    if (MQTT_SN_STATE_ACTIVE != c->state)
+        RETURN_ERROR(MQTT_NOT_CONNECT_ERROR);
+
+    platform_timer_cutdown(&timer, timeout_ms);
+
+    do {
+        if ((c->keep_alive > 0) && platform_timer_is_expired(&c->ping_timer)) {
+            rc = mqtt_sn_request(c, MQTT_SN_PINGREQ, 0, MQTT_SN_PINGRESP, 0, MQTT_SN_NO_MSG_ID);
+            if (MQTT_SUCCESS_ERROR != rc)
+                RETURN_ERROR(rc);
+        }
+
+        if (mqtt_sn_read_packet(c, platform_timer_remain(&timer), &rx_type, &rx_body, &rx_len) != MQTT_SUCCESS_ERROR)
+            continue;
+
+        if (MQTT_SN_DISCONNECT == rx_type) {
+            c->state = MQTT_SN_STATE_DISCONNECTED;
+            RETURN_ERROR(MQTT_NOT_CONNECT_ERROR);
+        }
+
+        mqtt_sn_packet_handle(c, rx_type, rx_body, rx_len);
+    } while (!platform_timer_is_expired(&timer));
+
+    RETURN_ERROR(MQTT_SUCCESS_ERROR);
+}
+
+/**
+ * @brief 进入睡眠状态，网关在 duration 秒内为客户端缓存消息，客户端应在此之前调用 mqtt_sn_wake()
+ *
+ * @param c MQTT-SN 客户端实例
+ * @param duration 睡眠时长，单位秒
+ * @return int 返回状态码，MQTT_SUCCESS_ERROR 表示成功
+ */
+int mqtt_sn_sleep(mqtt_sn_client_t *c, uint16_t duration)
+{
+    int rc;
+
+    if ((NULL == c) || (0 == duration))
+        RETURN_ERROR(MQTT_NULL_VALUE_ERROR);
+
+    if ((MQTT_SN_STATE_ACTIVE != c->state) && (MQTT_SN_STATE_ASLEEP != c->state))
+        RETURN_ERROR(MQTT_NOT_CONNECT_ERROR);
+
+    mqtt_sn_put16(mqtt_sn_body(c), duration);
+    rc = mqtt_sn_request(c, MQTT_SN_DISCONNECT, 2, MQTT_SN_DISCONNECT, 0, MQTT_SN_NO_MSG_ID);
+    if (MQTT_SUCCESS_ERROR != rc)
+        RETURN_ERROR(rc);
+
+    c->state = MQTT_SN_STATE_ASLEEP;
+    RETURN_ERROR(MQTT_SUCCESS_ERROR);
+}
+
+/**
+ * @brief 睡眠期间短暂唤醒，取回网关缓存的消息并分发，完成后回到睡眠状态
+ *
+ * @param c MQTT-SN 客户端实例
+ * @return int 返回状态码，MQTT_SUCCESS_ERROR 表示成功
+ */
+int mqtt_sn_wake(mqtt_sn_client_t *c)
+{
+    int rc, len;
+
+    if (NULL == c)
+        RETURN_ERROR(MQTT_NULL_VALUE_ERROR);
+
+    if (MQTT_SN_STATE_ASLEEP != c->state)
+        RETURN_ERROR(MQTT_NOT_CONNECT_ERROR);
+
+    /* 带客户端 ID 的 PINGREQ 让网关把缓存的消息发完后再回复 PINGRESP */
+    len = strlen(c->client_id);
+    memcpy(mqtt_sn_body(c), c->client_id, len);
+
+    c->state = MQTT_SN_STATE_AWAKE;
+    rc = mqtt_sn_request(c, MQTT_SN_PINGREQ, len, MQTT_SN_PINGRESP, 0, MQTT_SN_NO_MSG_ID);
+    if (MQTT_SUCCESS_ERROR != rc)
+        RETURN_ERROR(rc);
+
+    c->state = MQTT_SN_STATE_ASLEEP;
+    RETURN_ERROR(MQTT_SUCCESS_ERROR);
+}
+
+/**
+ * @brief 断开与网关的连接
+ *
+ * @param c MQTT-SN 客户端实例
+ * @return int 返回状态码，MQTT_SUCCESS_ERROR 表示成功
+ */
+int mqtt_sn_disconnect(mqtt_sn_client_t *c)
+{
+    int rc = MQTT_SUCCESS_ERROR;
+
+    if (NULL == c)
+        RETURN_ERROR(MQTT_NULL_VALUE_ERROR);
+
+    if (MQTT_SN_STATE_DISCONNECTED != c->state)
+        rc = mqtt_sn_request(c, MQTT_SN_DISCONNECT, 0, MQTT_SN_DISCONNECT, 0, MQTT_SN_NO_MSG_ID);
+
+    c->state = MQTT_SN_STATE_DISCONNECTED;
+    RETURN_ERROR(rc);
+}
+
+/**
+ * @brief 关闭套接字并清空主题表
+ *
+ * @param c MQTT-SN 客户端实例
+ * @return int 返回状态码，MQTT_SUCCESS_ERROR 表示成功
+ */
+int mqtt_sn_release(mqtt_sn_client_t *c)
+{
+    if (NULL == c)
+        RETURN_ERROR(MQTT_NULL_VALUE_ERROR);
+
+    if (c->fd >= 0)
+        platform_net_socket_close(c->fd);
+
+    memset(c->topics, 0, sizeof(c->topics));
+    c->fd = -1;
+    c->state = MQTT_SN_STATE_DISCONNECTED;
+
+    RETURN_ERROR(MQTT_SUCCESS_ERROR);
+}
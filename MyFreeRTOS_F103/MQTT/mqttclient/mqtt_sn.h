@@ -0,0 +1,89 @@
+/*
+ * @Date: 2026-10-19
+ * @Description: mqtt-sn 1.2 client over udp for sleepy sensor nodes.
+ */
+#ifndef _MQTT_SN_H_
+#define _MQTT_SN_H_
+
+#include "mqttclient.h"
+#include "platform_net_socket.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * MQTT-SN 客户端，与网关之间使用 UDP，主题以 2 字节 ID 表示：
+ *   普通主题先 REGISTER 换取 ID，2 个字符的短主题和预定义主题不需要注册
+ *   QoS -1 的发布不需要连接，只能使用短主题或预定义主题
+ *   mqtt_sn_sleep() 之后网关缓存下发消息，mqtt_sn_wake() 取回缓存的消息后继续睡眠
+ * 客户端没有后台线程，所有接口都是同步的，下发的消息在 mqtt_sn_yield() 或等待应答时分发给处理函数，
+ * 处理函数与 mqttclient 相同，client 参数为 mqtt_sn_client_t 实例。接口不可在多个线程中同时调用。
+ */
+#define     MQTT_SN_QOS_NEG1                    ((mqtt_qos_t)3)
+
+#define     MQTT_SN_TOPIC_TYPE_NORMAL           0x00
+#define     MQTT_SN_TOPIC_TYPE_PREDEFINED       0x01
+#define     MQTT_SN_TOPIC_TYPE_SHORT            0x02
+
+typedef enum mqtt_sn_state {
+    MQTT_SN_STATE_DISCONNECTED = 0,
+    MQTT_SN_STATE_ACTIVE,
+    MQTT_SN_STATE_ASLEEP,
+    MQTT_SN_STATE_AWAKE,
+} mqtt_sn_state_t;
+
+typedef struct mqtt_sn_topic {
+    uint16_t                    id;             /* 0 表示尚未获得 ID（未注册或通配符订阅） */
+    uint8_t                     type;           /* MQTT_SN_TOPIC_TYPE_* */
+    uint8_t                     subscribed;     /* name 为订阅的主题过滤器 */
+    uint8_t                     gateway;        /* 由网关为通配符订阅 REGISTER，取消订阅时释放 */
+    message_handler_t           handler;
+    char                        name[MQTT_SN_TOPIC_LEN_MAX];
+} mqtt_sn_topic_t;
+
+typedef struct mqtt_sn_client {
+    int                         fd;
+    const char                  *host;
+    const char                  *port;
+    const char                  *client_id;
+    mqtt_sn_state_t             state;
+    uint8_t                     clean_session;
+    uint16_t                    keep_alive;     /* unit: second */
+    uint16_t                    msg_id;
+    platform_timer_t            ping_timer;
+    message_handler_t           default_handler;
+    mqtt_sn_topic_t             topics[MQTT_SN_TOPIC_NUM_MAX];
+    /* 收发统计，包含 MQTT-SN 报文头，不含 UDP/IP 头 */
+    uint32_t                    tx_bytes;
+    uint32_t                    rx_bytes;
+    uint32_t                    tx_packets;
+    uint32_t                    rx_packets;
+    unsigned char               *ack;           /* 最近一次应答的报文体，指向 rx */
+    int                         ack_len;
+    int                         tx_len;
+    unsigned char               tx[MQTT_SN_BUF_SIZE];
+    unsigned char               rx[MQTT_SN_BUF_SIZE];
+} mqtt_sn_client_t;
+
+int mqtt_sn_init(mqtt_sn_client_t *c, const char *host, const char *port, const char *client_id);
+int mqtt_sn_set_keep_alive(mqtt_sn_client_t *c, uint16_t keep_alive);
+int mqtt_sn_set_clean_session(mqtt_sn_client_t *c, uint8_t clean_session);
+int mqtt_sn_set_default_handler(mqtt_sn_client_t *c, message_handler_t handler);
+int mqtt_sn_add_predefined(mqtt_sn_client_t *c, const char *topic, uint16_t topic_id);
+int mqtt_sn_connect(mqtt_sn_client_t *c);
+int mqtt_sn_register(mqtt_sn_client_t *c, const char *topic, uint16_t *topic_id);
+int mqtt_sn_publish(mqtt_sn_client_t *c, const char *topic, mqtt_message_t *msg);
+int mqtt_sn_subscribe(mqtt_sn_client_t *c, const char *topic_filter, mqtt_qos_t qos, message_handler_t handler);
+int mqtt_sn_unsubscribe(mqtt_sn_client_t *c, const char *topic_filter);
+int mqtt_sn_yield(mqtt_sn_client_t *c, int timeout_ms);
+int mqtt_sn_sleep(mqtt_sn_client_t *c, uint16_t duration);
+int mqtt_sn_wake(mqtt_sn_client_t *c);
+int mqtt_sn_disconnect(mqtt_sn_client_t *c);
+int mqtt_sn_release(mqtt_sn_client_t *c);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _MQTT_SN_H_ */
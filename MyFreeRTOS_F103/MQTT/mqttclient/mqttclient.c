@@ -12,6 +12,10 @@
 #define MQTT_MIN_PAYLOAD_SIZE 2
 #define MQTT_MAX_PAYLOAD_SIZE 268435455 // MQTT imposes a maximum payload size of 268435455 bytes.
 
+#define MQTT_CONNECT_PHASE_IDLE     0   // no non-blocking connect in progress
+#define MQTT_CONNECT_PHASE_NETWORK  1   // tcp connect or tls handshake
+#define MQTT_CONNECT_PHASE_CONNACK  2   // CONNECT sent, waiting for CONNACK
+
 static void default_msg_handler(void *client, message_data_t *msg)
 {
     MQTT_LOG_I("%s:%d %s()...\ntopic: %s, qos: %d, \nmessage:%s", __FILE__, __LINE__, __FUNCTION__,
@@ -99,7 +103,12 @@ static int mqtt_set_publish_dup(mqtt_client_t *c, uint8_t dup)
  */
 static int mqtt_ack_handler_is_maximum(mqtt_client_t *c)
 {
+#ifdef MQTT_STATIC_ALLOCATION
+    /* 静态分配时 ACK 处理器只能来自内存池 */
+    return (c->mqtt_ack_handler_number >= MQTT_STATIC_ACK_HANDLER_NUM) ? 1 : 0;
+#else
     return (c->mqtt_ack_handler_number >= MQTT_ACK_HANDLER_NUM_MAX) ? 1 : 0;
+#endif
 }
 
 /**
@@ -156,11 +165,12 @@ static uint16_t mqtt_get_next_packet_id(mqtt_client_t *c)
  * @param c MQTT 客户端结构体指针。
  * @param value 解码后的数值。
  * @param timeout 超时时间。
- * @return int 解码的字节数。
+ * @return int 解码的字节数，数据错误或未读完时返回 MQTTPACKET_READ_ERROR。
  */
 static int mqtt_decode_packet(mqtt_client_t *c, int *value, int timeout)
 {
     uint8_t i;
+    int rc = MQTTPACKET_READ_ERROR;
     int multiplier = 1;
     int len = 0;
     const int MAX_NO_OF_REMAINING_LENGTH_BYTES = 4;
@@ -168,8 +178,6 @@ static int mqtt_decode_packet(mqtt_client_t *c, int *value, int timeout)
     *value = 0;
     do
     {
-        int rc = MQTTPACKET_READ_ERROR;
-
         if (++len > MAX_NO_OF_REMAINING_LENGTH_BYTES)
         {
             rc = MQTTPACKET_READ_ERROR; /* bad data */
@@ -182,7 +190,7 @@ static int mqtt_decode_packet(mqtt_client_t *c, int *value, int timeout)
         multiplier *= 128;
     } while ((i & 128) != 0);
 exit:
-    return len;
+    return (1 == rc) ? len : MQTTPACKET_READ_ERROR;
 }
 
 /**
@@ -222,6 +230,21 @@ static void mqtt_packet_drain(mqtt_client_t *c, platform_timer_t *timer, int pac
         }
     } while ((total_bytes_read < packet_len) && (0 != read_len)); /* read and discard all corrupted data */
 }
+/**
+ * @brief 对端关闭连接或读取出错，关闭连接并等待 mqtt 线程重新连接
+ *
+ * @param c MQTT 客户端实例
+ */
+static void mqtt_connection_lost(mqtt_client_t *c)
+{
+    MQTT_LOG_W("%s:%d %s()... connection lost", __FILE__, __LINE__, __FUNCTION__);
+
+    network_disconnect(c->mqtt_network);
+
+    if (CLIENT_STATE_CONNECTED == mqtt_get_client_state(c))
+        mqtt_set_client_state(c, CLIENT_STATE_DISCONNECTED);
+}
+
 /**
  * @brief 从网络读取 MQTT 数据包
  *
@@ -233,7 +256,7 @@ static void mqtt_packet_drain(mqtt_client_t *c, platform_timer_t *timer, int pac
 static int mqtt_read_packet(mqtt_client_t *c, int *packet_type, platform_timer_t *timer)
 {
     MQTTHeader header = {0};
-    int rc;
+    int rc, wait;
     int len = 1;
     int remain_len = 0;
 
@@ -242,13 +265,27 @@ static int mqtt_read_packet(mqtt_client_t *c, int *packet_type, platform_timer_t
 
     platform_timer_cutdown(timer, c->mqtt_cmd_timeout);
 
+    /* 等待数据可读，空闲时不再阻塞在带超时的读取上；备用连接建立期间分段等待，由 mqtt_yield 推进备用连接 */
+    wait = platform_timer_remain(timer);
+    if (c->mqtt_standby_connecting && (wait > MQTT_ENDPOINT_STANDBY_STEP))
+        wait = MQTT_ENDPOINT_STANDBY_STEP;
+    rc = network_wait(c->mqtt_network, wait);
+    if (rc == 0)
+        RETURN_ERROR(MQTT_NOTHING_TO_READ_ERROR);
+
     /* 1. 读取头部字节，其中包含数据包类型 */
-    rc = network_read(c->mqtt_network, c->mqtt_read_buf, len, platform_timer_remain(timer));
+    if (rc > 0)
+        rc = network_read(c->mqtt_network, c->mqtt_read_buf, len, platform_timer_remain(timer));
+    if (rc < 0) {
+        mqtt_connection_lost(c);
+        RETURN_ERROR(MQTT_NOT_CONNECT_ERROR);
+    }
     if (rc != len)
         RETURN_ERROR(MQTT_NOTHING_TO_READ_ERROR);
 
     /* 2. 读取剩余长度字段，这个字段本身是可变的 */
-    mqtt_decode_packet(c, &remain_len, platform_timer_remain(timer));
+    if (mqtt_decode_packet(c, &remain_len, platform_timer_remain(timer)) < 0)
+        RETURN_ERROR(MQTT_NOTHING_TO_READ_ERROR);
 
     /* 将原始的剩余长度字段放回缓冲区 */
     len += MQTTPacket_encode(c->mqtt_read_buf + len, remain_len);
@@ -263,8 +300,13 @@ static int mqtt_read_packet(mqtt_client_t *c, int *packet_type, platform_timer_t
     }
 
     /* 3. 使用回调读取网络中剩余的数据 */
-    if ((remain_len > 0) && ((rc = network_read(c->mqtt_network, c->mqtt_read_buf + len, remain_len, platform_timer_remain(timer))) != remain_len))
+    if ((remain_len > 0) && ((rc = network_read(c->mqtt_network, c->mqtt_read_buf + len, remain_len, platform_timer_remain(timer))) != remain_len)) {
+        if (rc < 0) {
+            mqtt_connection_lost(c);
+            RETURN_ERROR(MQTT_NOT_CONNECT_ERROR);
+        }
         RETURN_ERROR(MQTT_NOTHING_TO_READ_ERROR);
+    }
 
     header.byte = c->mqtt_read_buf[0];
     *packet_type = header.bits.type;
@@ -293,10 +335,61 @@ static int mqtt_send_packet(mqtt_client_t *c, int length, platform_timer_t *time
     /* 在阻塞模式下发送 MQTT 数据包，或在定时器超时时退出 */
     while ((sent < length) && (!platform_timer_is_expired(timer)))
     {
-        len = network_write(c->mqtt_network, &c->mqtt_write_buf[sent], length, platform_timer_remain(timer));
+        len = network_write(c->mqtt_network, &c->mqtt_write_buf[sent], length - sent, platform_timer_remain(timer));
+        if (len <= 0) // 发送数据出错
+            break;
+        sent += len;
+    }
+
+    if (sent == length)
+    {
+        /* 更新最后发送时间，用于保活检测 */
+        platform_timer_cutdown(&c->mqtt_last_sent, (c->mqtt_keep_alive_interval * 1000));
+        RETURN_ERROR(MQTT_SUCCESS_ERROR);
+    }
+
+    RETURN_ERROR(MQTT_SEND_PACKET_ERROR);
+}
+
+/**
+ * @brief 发送由多段数据组成的 MQTT 数据包，各段数据不需要先复制到写缓冲区
+ *
+ * @param c MQTT 客户端实例
+ * @param iov 数据段，发送过程中会被修改
+ * @param iovcnt 数据段数量
+ * @param flags network_writev() 的标志，NETWORK_WRITE_ZEROCOPY 表示第一段之后的数据可以零拷贝发送
+ * @param timer 计时器实例
+ * @return int 返回状态码，MQTT_SUCCESS_ERROR 表示成功
+ */
+static int mqtt_send_packet_iov(mqtt_client_t *c, network_iovec_t *iov, int iovcnt, int flags, platform_timer_t *timer)
+{
+    int i, len = 0;
+    size_t sent = 0, length = 0;
+
+    platform_timer_cutdown(timer, c->mqtt_cmd_timeout);
+
+    for (i = 0; i < iovcnt; i++)
+        length += iov[i].iov_len;
+
+    while ((sent < length) && (!platform_timer_is_expired(timer)))
+    {
+        len = network_writev(c->mqtt_network, iov, iovcnt, flags, platform_timer_remain(timer));
         if (len <= 0) // 发送数据出错
             break;
         sent += len;
+
+        /* 跳过已发送的数据段 */
+        while ((iovcnt > 0) && ((size_t)len >= iov->iov_len))
+        {
+            len -= iov->iov_len;
+            iov++;
+            iovcnt--;
+        }
+        if (iovcnt > 0)
+        {
+            iov->iov_base = (uint8_t *)iov->iov_base + len;
+            iov->iov_len -= len;
+        }
     }
 
     if (sent == length)
@@ -371,19 +464,117 @@ static char mqtt_topic_is_matched(char *topic_filter, MQTTString *topic_name)
     return (curn == curn_end) && (*curf == '\0');
 }
 /**
- * @brief 创建一个新的消息数据结构
+ * @brief 计算主题名的哈希值（FNV-1a）
+ *
+ * @param name 主题名
+ * @param len 主题名长度
+ * @return uint32_t 哈希值
+ */
+static uint32_t mqtt_topic_hash(const char *name, int len)
+{
+    uint32_t hash = 2166136261u;
+
+    while (len-- > 0)
+        hash = (hash ^ (uint8_t)*name++) * 16777619u;
+
+    return hash;
+}
+
+/**
+ * @brief 在主题表中查找主题，未找到时收录该主题，表满时淘汰最久未使用且未固定的条目。
+ *        编号交给过应用的条目都是固定的，一个编号在客户端释放前只对应一个主题。
+ *        调用者需持有 mqtt_global_lock
+ *
+ * @param c MQTT 客户端实例
+ * @param name 主题名，不要求以 '\0' 结尾
+ * @param len 主题名长度
+ * @return mqtt_topic_entry_t* 返回主题表条目，主题过长或表中条目均被固定时返回 NULL
+ */
+static mqtt_topic_entry_t *mqtt_topic_table_get(mqtt_client_t *c, const char *name, int len)
+{
+    int i;
+    uint32_t hash;
+    mqtt_topic_entry_t *entry, *victim = NULL;
+
+    if ((len <= 0) || (len >= MQTT_TOPIC_LEN_MAX))
+        return NULL;
+
+    hash = mqtt_topic_hash(name, len);
+
+    for (i = 0; i < MQTT_TOPIC_TABLE_SIZE; i++) {
+        entry = &c->mqtt_topic_table[i];
+
+        if ((entry->len == len) && (entry->hash == hash) && (0 == memcmp(entry->name, name, len))) {
+            entry->last_used = ++c->mqtt_topic_clock;
+            return entry;
+        }
+
+        /* 空条目优先，其次为最久未使用的条目 */
+        if (entry->pinned)
+            continue;
+        if ((NULL == victim) || ((0 != victim->len) && ((0 == entry->len) || (entry->last_used < victim->last_used))))
+            victim = entry;
+    }
+
+    if (NULL == victim)
+        return NULL;
+
+    memcpy(victim->name, name, len);
+    victim->name[len] = '\0';
+    victim->len = len;
+    victim->hash = hash;
+    victim->pinned = 0;
+    victim->handler = NULL;
+    victim->handler_gen = c->mqtt_handler_gen - 1;      /* 使缓存的处理器失效 */
+    victim->last_used = ++c->mqtt_topic_clock;
+
+    return victim;
+}
+
+/**
+ * @brief 使主题表中缓存的消息处理器全部失效，在消息处理器列表变化时调用
+ *
+ * @param c MQTT 客户端实例
+ */
+static void mqtt_topic_table_invalidate(mqtt_client_t *c)
+{
+    platform_mutex_lock(&c->mqtt_global_lock);
+    c->mqtt_handler_gen++;
+    platform_mutex_unlock(&c->mqtt_global_lock);
+}
+
+/**
+ * @brief 创建一个新的消息数据结构。已收录的主题直接引用主题表中的主题名，编号交给应用后
+ *        条目被固定，回调期间及之后都不会被淘汰或改写。调用者需持有 mqtt_global_lock
  *
+ * @param c MQTT 客户端实例
  * @param md 消息数据结构指针
+ * @param entry 主题表条目，为 NULL 时将报文中的主题名拷贝到 buf 中，且没有主题编号
+ * @param buf 长度为 MQTT_TOPIC_LEN_MAX 的缓冲区，仅在 entry 为 NULL 时使用
  * @param topic_name MQTT 主题名
  * @param message MQTT 消息结构指针
  */
-static void mqtt_new_message_data(message_data_t *md, MQTTString *topic_name, mqtt_message_t *message)
+static void mqtt_new_message_data(mqtt_client_t *c, message_data_t *md, mqtt_topic_entry_t *entry, char *buf,
+                                  MQTTString *topic_name, mqtt_message_t *message)
 {
     int len;
-    len = (topic_name->lenstring.len < MQTT_TOPIC_LEN_MAX - 1) ? topic_name->lenstring.len : MQTT_TOPIC_LEN_MAX - 1;
-    memcpy(md->topic_name, topic_name->lenstring.data, len);
-    md->topic_name[len] = '\0'; /* 主题名太长，将被截断 */
+
     md->message = message;
+
+    if (NULL != entry) {
+        entry->pinned = 1;
+        md->topic_name = entry->name;
+        md->topic_len = entry->len;
+        md->topic_id = (uint16_t)(entry - c->mqtt_topic_table) + 1;
+        return;
+    }
+
+    len = (topic_name->lenstring.len < MQTT_TOPIC_LEN_MAX - 1) ? topic_name->lenstring.len : MQTT_TOPIC_LEN_MAX - 1;
+    memcpy(buf, topic_name->lenstring.data, len);
+    buf[len] = '\0'; /* 主题名太长，将被截断 */
+    md->topic_name = buf;
+    md->topic_len = len;
+    md->topic_id = MQTT_TOPIC_ID_NONE;
 }
 
 /**
@@ -425,22 +616,39 @@ static int mqtt_deliver_message(mqtt_client_t *c, MQTTString *topic_name, mqtt_m
 {
     int rc = MQTT_FAILED_ERROR;
     message_handlers_t *msg_handler;
+    message_handler_t handler = NULL;
+    mqtt_topic_entry_t *entry;
+    message_data_t md;
+    char buf[MQTT_TOPIC_LEN_MAX];
 
-    /* 获取匹配的消息处理器 */
-    msg_handler = mqtt_get_msg_handler(c, topic_name);
+    /* 查找或收录主题，命中时直接使用缓存的消息处理器。未固定的条目可能被其他线程淘汰或改写，
+       回调函数、主题名和主题编号都在持锁期间取出 */
+    platform_mutex_lock(&c->mqtt_global_lock);
+    entry = mqtt_topic_table_get(c, topic_name->lenstring.data, topic_name->lenstring.len);
 
-    if (NULL != msg_handler)
-    {
-        message_data_t md;
-        mqtt_new_message_data(&md, topic_name, message); /* 创建消息数据 */
-        msg_handler->handler(c, &md);                    /* 传递消息 */
-        rc = MQTT_SUCCESS_ERROR;
+    if ((NULL != entry) && (entry->handler_gen == c->mqtt_handler_gen)) {
+        msg_handler = entry->handler;
+    } else {
+        /* 获取匹配的消息处理器 */
+        msg_handler = mqtt_get_msg_handler(c, topic_name);
+        if (NULL != entry) {
+            entry->handler = msg_handler;
+            entry->handler_gen = c->mqtt_handler_gen;
+        }
     }
-    else if (NULL != c->mqtt_interceptor_handler)
+
+    if (NULL != msg_handler)
+        handler = msg_handler->handler;
+    else
+        handler = c->mqtt_interceptor_handler;
+
+    if (NULL != handler)
+        mqtt_new_message_data(c, &md, entry, buf, topic_name, message); /* 创建消息数据 */
+    platform_mutex_unlock(&c->mqtt_global_lock);
+
+    if (NULL != handler)
     {
-        message_data_t md;
-        mqtt_new_message_data(&md, topic_name, message); /* 创建消息数据 */
-        c->mqtt_interceptor_handler(c, &md);
+        handler(c, &md); /* 传递消息 */
         rc = MQTT_SUCCESS_ERROR;
     }
 
@@ -450,6 +658,131 @@ static int mqtt_deliver_message(mqtt_client_t *c, MQTTString *topic_name, mqtt_m
     RETURN_ERROR(rc);
 }
 
+/**
+ * @brief 分配 ACK 处理器的内存，优先从客户端的 ACK 处理器内存池中分配，
+ *        内存池耗尽或报文超过块大小时，允许溢出则改从堆中分配
+ *
+ * @param c MQTT 客户端实例
+ * @param payload_len 需要保存的报文长度
+ * @return ack_handlers_t* 返回分配的内存，失败时返回 NULL
+ */
+static ack_handlers_t *mqtt_ack_handler_alloc(mqtt_client_t *c, uint16_t payload_len)
+{
+    ack_handlers_t *ack_handler;
+
+    platform_mutex_lock(&c->mqtt_global_lock);
+    ack_handler = (ack_handlers_t *)mqtt_pool_alloc_size(&c->mqtt_ack_handler_pool, sizeof(ack_handlers_t) + payload_len);
+    platform_mutex_unlock(&c->mqtt_global_lock);
+
+#if MQTT_HANDLER_POOL_OVERFLOW
+    if (NULL == ack_handler)
+        ack_handler = (ack_handlers_t *)platform_memory_alloc(sizeof(ack_handlers_t) + payload_len);
+#endif
+
+    return ack_handler;
+}
+
+/**
+ * @brief 释放 ACK 处理器的内存，不属于内存池的块归还给堆
+ *
+ * @param c MQTT 客户端实例
+ * @param ack_handler ACK 处理器实例指针
+ */
+static void mqtt_ack_handler_free(mqtt_client_t *c, ack_handlers_t *ack_handler)
+{
+    int rc;
+
+    platform_mutex_lock(&c->mqtt_global_lock);
+    rc = mqtt_pool_free(&c->mqtt_ack_handler_pool, ack_handler);
+    platform_mutex_unlock(&c->mqtt_global_lock);
+
+    if (0 != rc)
+        platform_memory_free(ack_handler);
+}
+
+/**
+ * @brief 分配消息处理器的内存，优先从客户端的消息处理器内存池中分配
+ *
+ * @param c MQTT 客户端实例
+ * @return message_handlers_t* 返回分配的内存，失败时返回 NULL
+ */
+static message_handlers_t *mqtt_msg_handler_alloc(mqtt_client_t *c)
+{
+    message_handlers_t *msg_handler;
+
+    platform_mutex_lock(&c->mqtt_global_lock);
+    msg_handler = (message_handlers_t *)mqtt_pool_alloc(&c->mqtt_msg_handler_pool);
+    platform_mutex_unlock(&c->mqtt_global_lock);
+
+#if MQTT_HANDLER_POOL_OVERFLOW
+    if (NULL == msg_handler)
+        msg_handler = (message_handlers_t *)platform_memory_alloc(sizeof(message_handlers_t));
+#endif
+
+    return msg_handler;
+}
+
+/**
+ * @brief 释放消息处理器的内存，不属于内存池的块归还给堆
+ *
+ * @param c MQTT 客户端实例
+ * @param msg_handler 消息处理器实例指针
+ */
+static void mqtt_msg_handler_free(mqtt_client_t *c, message_handlers_t *msg_handler)
+{
+    int rc;
+
+    platform_mutex_lock(&c->mqtt_global_lock);
+    rc = mqtt_pool_free(&c->mqtt_msg_handler_pool, msg_handler);
+    platform_mutex_unlock(&c->mqtt_global_lock);
+
+    if (0 != rc)
+        platform_memory_free(msg_handler);
+}
+
+/**
+ * @brief 初始化客户端的 ACK 处理器与消息处理器内存池，非静态分配模式下两个内存池共用一次堆分配，
+ *        分配失败且允许溢出时以空内存池运行
+ *
+ * @param c MQTT 客户端实例
+ * @return int 返回处理结果，成功或内存不足
+ */
+static int mqtt_handler_pool_init(mqtt_client_t *c)
+{
+#ifdef MQTT_STATIC_ALLOCATION
+    mqtt_client_static_t *s = (mqtt_client_static_t *)c;
+
+    mqtt_pool_init(&c->mqtt_msg_handler_pool, s->msg_handler_storage, sizeof(message_handlers_t), MQTT_MSG_HANDLER_POOL_NUM);
+    mqtt_pool_init(&c->mqtt_ack_handler_pool, s->ack_handler_storage, MQTT_ACK_HANDLER_POOL_BLOCK_SIZE, MQTT_ACK_HANDLER_POOL_NUM);
+#else
+    uint32_t msg_pool_len = MQTT_POOL_BLOCK_SIZE(sizeof(message_handlers_t)) * MQTT_MSG_HANDLER_POOL_NUM;
+    uint32_t ack_pool_len = MQTT_POOL_BLOCK_SIZE(MQTT_ACK_HANDLER_POOL_BLOCK_SIZE) * MQTT_ACK_HANDLER_POOL_NUM;
+
+    c->mqtt_handler_pool_storage = NULL;
+    if (0 != msg_pool_len + ack_pool_len) {
+        c->mqtt_handler_pool_storage = platform_memory_alloc(msg_pool_len + ack_pool_len);
+        if (NULL == c->mqtt_handler_pool_storage) {
+#if MQTT_HANDLER_POOL_OVERFLOW
+            /* 没有内存池时所有处理器都从堆中分配，客户端仍然可用 */
+            MQTT_LOG_W("%s:%d %s()... malloc handler pool failed, handlers come from the heap...", __FILE__, __LINE__, __FUNCTION__);
+            mqtt_pool_init(&c->mqtt_msg_handler_pool, NULL, sizeof(message_handlers_t), 0);
+            mqtt_pool_init(&c->mqtt_ack_handler_pool, NULL, MQTT_ACK_HANDLER_POOL_BLOCK_SIZE, 0);
+            RETURN_ERROR(MQTT_SUCCESS_ERROR);
+#else
+            MQTT_LOG_E("%s:%d %s()... malloc handler pool failed...", __FILE__, __LINE__, __FUNCTION__);
+            RETURN_ERROR(MQTT_MEM_NOT_ENOUGH_ERROR);
+#endif
+        }
+    }
+
+    mqtt_pool_init(&c->mqtt_msg_handler_pool, c->mqtt_handler_pool_storage, sizeof(message_handlers_t), MQTT_MSG_HANDLER_POOL_NUM);
+    mqtt_pool_init(&c->mqtt_ack_handler_pool, (uint8_t *)c->mqtt_handler_pool_storage + msg_pool_len,
+                   MQTT_ACK_HANDLER_POOL_BLOCK_SIZE, MQTT_ACK_HANDLER_POOL_NUM);
+#endif
+
+    RETURN_ERROR(MQTT_SUCCESS_ERROR);
+}
+
 /**
  * @brief 创建一个 ACK 处理器
  *
@@ -464,7 +797,7 @@ static ack_handlers_t *mqtt_ack_handler_create(mqtt_client_t *c, int type, uint1
 {
     ack_handlers_t *ack_handler = NULL;
 
-    ack_handler = (ack_handlers_t *)platform_memory_alloc(sizeof(ack_handlers_t) + payload_len);
+    ack_handler = mqtt_ack_handler_alloc(c, payload_len);
     if (NULL == ack_handler)
         return NULL;
 
@@ -474,6 +807,7 @@ static ack_handlers_t *mqtt_ack_handler_create(mqtt_client_t *c, int type, uint1
 
     ack_handler->type = type;
     ack_handler->packet_id = packet_id;
+    ack_handler->handler = handler;
     ack_handler->payload_len = payload_len;
     ack_handler->payload = (uint8_t *)ack_handler + sizeof(ack_handlers_t);
     memcpy(ack_handler->payload, c->mqtt_write_buf, payload_len); /* 将数据保存在 ACK 处理器中 */
@@ -484,14 +818,15 @@ static ack_handlers_t *mqtt_ack_handler_create(mqtt_client_t *c, int type, uint1
 /**
  * @brief 销毁 ACK 处理器
  *
+ * @param c MQTT 客户端实例
  * @param ack_handler ACK 处理器实例指针
  */
-static void mqtt_ack_handler_destroy(ack_handlers_t *ack_handler)
+static void mqtt_ack_handler_destroy(mqtt_client_t *c, ack_handlers_t *ack_handler)
 {
     if (NULL != &ack_handler->list)
     {
         mqtt_list_del(&ack_handler->list);
-        platform_memory_free(ack_handler); /* 从列表中删除 ACK 处理器，并释放内存 */
+        mqtt_ack_handler_free(c, ack_handler); /* 从列表中删除 ACK 处理器，并释放内存 */
     }
 }
 
@@ -602,7 +937,7 @@ static int mqtt_ack_list_unrecord(mqtt_client_t *c, int type, uint16_t packet_id
             *handler = ack_handler->handler;
 
         /* 销毁一个 ACK 处理器节点 */
-        mqtt_ack_handler_destroy(ack_handler);
+        mqtt_ack_handler_destroy(c, ack_handler);
         mqtt_subtract_ack_handler_num(c);
     }
     RETURN_ERROR(MQTT_SUCCESS_ERROR);
@@ -611,16 +946,17 @@ static int mqtt_ack_list_unrecord(mqtt_client_t *c, int type, uint16_t packet_id
 /**
  * @brief 创建一个消息处理器实例
  *
+ * @param c MQTT 客户端实例
  * @param topic_filter MQTT 主题过滤器
  * @param qos MQTT QoS 等级
  * @param handler 消息处理器回调函数
  * @return message_handlers_t* 返回创建的消息处理器实例，如果内存分配失败则返回 NULL
  */
-static message_handlers_t *mqtt_msg_handler_create(const char *topic_filter, mqtt_qos_t qos, message_handler_t handler)
+static message_handlers_t *mqtt_msg_handler_create(mqtt_client_t *c, const char *topic_filter, mqtt_qos_t qos, message_handler_t handler)
 {
     message_handlers_t *msg_handler = NULL;
 
-    msg_handler = (message_handlers_t *)platform_memory_alloc(sizeof(message_handlers_t));
+    msg_handler = mqtt_msg_handler_alloc(c);
     if (NULL == msg_handler)
         return NULL;
 
@@ -636,17 +972,53 @@ static message_handlers_t *mqtt_msg_handler_create(const char *topic_filter, mqt
 /**
  * @brief 销毁消息处理器实例
  *
+ * @param c MQTT 客户端实例
  * @param msg_handler 消息处理器实例指针
  */
-static void mqtt_msg_handler_destory(message_handlers_t *msg_handler)
+static void mqtt_msg_handler_destory(mqtt_client_t *c, message_handlers_t *msg_handler)
 {
     if (NULL != &msg_handler->list)
     {
         mqtt_list_del(&msg_handler->list);
-        platform_memory_free(msg_handler);
+        mqtt_topic_table_invalidate(c);
+        mqtt_msg_handler_free(c, msg_handler);
     }
 }
 
+/**
+ * @brief 从消息处理器环中取出一个处理器。同一个 SUBSCRIBE/UNSUBSCRIBE 报文的消息处理器通过 list 节点串成环，
+ *        由 ACK 处理器持有其中任意一个
+ *
+ * @param ring 消息处理器环，取出后指向下一个处理器，取完后为 NULL
+ * @return message_handlers_t* 取出的处理器，环为空时返回 NULL
+ */
+static message_handlers_t *mqtt_msg_handler_ring_take(message_handlers_t **ring)
+{
+    message_handlers_t *msg_handler = *ring;
+
+    if (NULL == msg_handler)
+        return NULL;
+
+    *ring = (msg_handler->list.next == &msg_handler->list) ? NULL : LIST_ENTRY(msg_handler->list.next, message_handlers_t, list);
+    mqtt_list_del_init(&msg_handler->list);
+
+    return msg_handler;
+}
+
+/**
+ * @brief 销毁消息处理器环中的所有处理器
+ *
+ * @param c MQTT 客户端实例
+ * @param ring 消息处理器环
+ */
+static void mqtt_msg_handler_ring_destroy(mqtt_client_t *c, message_handlers_t *ring)
+{
+    message_handlers_t *msg_handler;
+
+    while (NULL != (msg_handler = mqtt_msg_handler_ring_take(&ring)))
+        mqtt_msg_handler_destory(c, msg_handler);
+}
+
 /**
  * @brief 检查消息处理器列表中是否已存在指定的消息处理器
  *
@@ -692,12 +1064,13 @@ static int mqtt_msg_handlers_install(mqtt_client_t *c, message_handlers_t *handl
 
     if (mqtt_msg_handler_is_exist(c, handler))
     {
-        mqtt_msg_handler_destory(handler);
+        mqtt_msg_handler_destory(c, handler);
         RETURN_ERROR(MQTT_SUCCESS_ERROR);
     }
 
     /* 安装到消息处理器列表 */
     mqtt_list_add_tail(&handler->list, &c->mqtt_msg_handler_list);
+    mqtt_topic_table_invalidate(c);
 
     RETURN_ERROR(MQTT_SUCCESS_ERROR);
 }
@@ -722,10 +1095,10 @@ static void mqtt_clean_session(mqtt_client_t *c)
             //@lchnu, 2020-10-08, 避免在等待 suback/unsuback 时断开连接...
             if (NULL != ack_handler->handler)
             {
-                mqtt_msg_handler_destory(ack_handler->handler);
+                mqtt_msg_handler_ring_destroy(c, ack_handler->handler);
                 ack_handler->handler = NULL;
             }
-            platform_memory_free(ack_handler);
+            mqtt_ack_handler_free(c, ack_handler);
         }
         mqtt_list_del_init(&c->mqtt_ack_handler_list);
     }
@@ -740,58 +1113,249 @@ static void mqtt_clean_session(mqtt_client_t *c)
             msg_handler = LIST_ENTRY(curr, message_handlers_t, list);
             mqtt_list_del(&msg_handler->list);
             msg_handler->topic_filter = NULL;
-            platform_memory_free(msg_handler);
+            mqtt_msg_handler_free(c, msg_handler);
         }
         mqtt_list_del_init(&c->mqtt_msg_handler_list);
     }
+    mqtt_topic_table_invalidate(c);
 
     mqtt_set_client_state(c, CLIENT_STATE_INVALID);
 }
 
 /**
- * @brief 扫描 ACK 处理器列表，处理等待服务器响应的消息
+ * @brief 发布消息的确认报文处理函数
  *
- * @param c MQTT 客户端实例
- * @param flag 标志位，0 表示不需要等待超时立即处理，1 表示需要等待超时后处理
+ * @param c MQTT 客户端结构体指针
+ * @param packet_id 报文标识符
+ * @param packet_type 报文类型（PUBREC 或 PUBREL）
+ * @return int 返回处理结果，可能是成功或失败的状态码
  */
-static void mqtt_ack_list_scan(mqtt_client_t *c, uint8_t flag)
+static int mqtt_publish_ack_packet(mqtt_client_t *c, uint16_t packet_id, int packet_type)
 {
-    mqtt_list_t *curr, *next;
-    ack_handlers_t *ack_handler;
+    int len = 0;
+    int rc = MQTT_SUCCESS_ERROR;
+    platform_timer_t timer;
 
-    if ((mqtt_list_is_empty(&c->mqtt_ack_handler_list)) || (CLIENT_STATE_CONNECTED != mqtt_get_client_state(c)))
-        return;
+    platform_timer_cutdown(&timer, c->mqtt_cmd_timeout);
 
-    LIST_FOR_EACH_SAFE(curr, next, &c->mqtt_ack_handler_list)
+    platform_mutex_lock(&c->mqtt_write_lock);
+
+    switch (packet_type)
     {
-        ack_handler = LIST_ENTRY(curr, ack_handlers_t, list);
+    case PUBREC:
+        len = MQTTSerialize_ack(c->mqtt_write_buf, c->mqtt_write_buf_size, PUBREL, 0, packet_id); /* 构造 PUBREL 确认报文 */
+        rc = mqtt_ack_list_record(c, PUBCOMP, packet_id, len, NULL);                              /* 记录确认报文，期望接收 PUBCOMP */
+        if (MQTT_SUCCESS_ERROR != rc)
+            goto exit;
+        break;
 
-        if ((!platform_timer_is_expired(&ack_handler->timer)) && (flag == 1))
-            continue;
+    case PUBREL:
+        len = MQTTSerialize_ack(c->mqtt_write_buf, c->mqtt_write_buf_size, PUBCOMP, 0, packet_id); /* 构造 PUBCOMP 确认报文 */
+        break;
 
-        if ((ack_handler->type == PUBACK) || (ack_handler->type == PUBREC) || (ack_handler->type == PUBREL) || (ack_handler->type == PUBCOMP))
-        {
+    default:
+        rc = MQTT_PUBLISH_ACK_TYPE_ERROR;
+        goto exit;
+    }
 
-            /* 已发生超时，对于 QoS1 和 QoS2 的数据包，需要重新发送 */
-            mqtt_ack_handler_resend(c, ack_handler);
-            continue;
+    if (len <= 0)
+    {
+        rc = MQTT_PUBLISH_ACK_PACKET_ERROR;
+        goto exit;
+    }
+
+    rc = mqtt_send_packet(c, len, &timer); // 发送确认报文
+
+exit:
+    platform_mutex_unlock(&c->mqtt_write_lock);
+
+    RETURN_ERROR(rc); // 返回处理结果
+}
+
+/**
+ * @brief 发送释放队列中的 PUBCOMP 报文，发送成功后清除报文标识符的记录，发送失败的报文留在队列中等待下次发送
+ *
+ * @param c MQTT 客户端实例
+ * @return int 返回状态码，MQTT_SUCCESS_ERROR 表示成功
+ */
+static int mqtt_qos2_release_drain(mqtt_client_t *c)
+{
+    int rc = MQTT_SUCCESS_ERROR;
+    uint16_t packet_id;
+
+    while (mqtt_qos2_release_peek(&c->mqtt_qos2, &packet_id)) {
+        rc = mqtt_publish_ack_packet(c, packet_id, PUBREL);
+        if (MQTT_SUCCESS_ERROR != rc)
+            break;
+
+        mqtt_qos2_clear(&c->mqtt_qos2, packet_id);
+        mqtt_qos2_release_pop(&c->mqtt_qos2);
+    }
+
+    RETURN_ERROR(rc);
+}
+
+/**
+ * @brief 扫描 ACK 处理器列表，处理等待服务器响应的消息
+ *
+ * @param c MQTT 客户端实例
+ * @param flag 标志位，0 表示不需要等待超时立即处理，1 表示需要等待超时后处理
+ */
+static void mqtt_ack_list_scan(mqtt_client_t *c, uint8_t flag)
+{
+    mqtt_list_t *curr, *next;
+    ack_handlers_t *ack_handler;
+
+    if (CLIENT_STATE_CONNECTED != mqtt_get_client_state(c))
+        return;
+
+    /* 重新发送释放队列中发送失败的 PUBCOMP 报文 */
+    mqtt_qos2_release_drain(c);
+
+    if (mqtt_list_is_empty(&c->mqtt_ack_handler_list))
+        return;
+
+    LIST_FOR_EACH_SAFE(curr, next, &c->mqtt_ack_handler_list)
+    {
+        ack_handler = LIST_ENTRY(curr, ack_handlers_t, list);
+
+        if ((!platform_timer_is_expired(&ack_handler->timer)) && (flag == 1))
+            continue;
+
+        if ((ack_handler->type == PUBACK) || (ack_handler->type == PUBREC) || (ack_handler->type == PUBREL) || (ack_handler->type == PUBCOMP))
+        {
+
+            /* 已发生超时，对于 QoS1 和 QoS2 的数据包，需要重新发送 */
+            mqtt_ack_handler_resend(c, ack_handler);
+            continue;
         }
         else if ((ack_handler->type == SUBACK) || (ack_handler->type == UNSUBACK))
         {
 
+            /* 重连后仍未确认的订阅/取消订阅报文重新发送，收到 ACK 后再处理消息处理器 */
+            if (flag == 0)
+            {
+                mqtt_ack_handler_resend(c, ack_handler);
+                continue;
+            }
+
             /*@lchnu, 2020-10-08, 如果 suback/unsuback 已过期，则释放处理器内存 */
             if (NULL != ack_handler->handler)
             {
-                mqtt_msg_handler_destory(ack_handler->handler);
+                mqtt_msg_handler_ring_destroy(c, ack_handler->handler);
                 ack_handler->handler = NULL;
             }
         }
         /* 如果不是 QoS1 或 QoS2 消息，则在每次处理中销毁 */
-        mqtt_ack_handler_destroy(ack_handler);
+        mqtt_ack_handler_destroy(c, ack_handler);
         mqtt_subtract_ack_handler_num(c); /*@lchnu, 2020-10-08 */
     }
 }
 
+/**
+ * @brief 发送一个 SUBSCRIBE 报文，报文超出写缓冲区时减少主题数量，剩余主题由调用者再次发送
+ *
+ * @param c MQTT 客户端实例
+ * @param topics 要订阅的主题
+ * @param count 主题数量
+ * @param install 非 0 时为每个主题创建消息处理器，收到 SUBACK 后安装；重新订阅时为 0
+ * @return int 成功返回本报文包含的主题数量，失败返回错误码
+ */
+static int mqtt_subscribe_packet(mqtt_client_t *c, const mqtt_subscribe_topic_t *topics, int count, int install)
+{
+    int i, len = 0;
+    int rc = MQTT_SUBSCRIBE_ERROR;
+    uint16_t packet_id;
+    platform_timer_t timer;
+    int qos[MQTT_SUBSCRIBE_BATCH_MAX];
+    MQTTString filters[MQTT_SUBSCRIBE_BATCH_MAX];
+    message_handlers_t *ring = NULL, *msg_handler;
+
+    if (count > MQTT_SUBSCRIBE_BATCH_MAX)
+        count = MQTT_SUBSCRIBE_BATCH_MAX;
+
+    for (i = 0; i < count; i++) {
+        filters[i].cstring = (char *)topics[i].topic_filter;
+        filters[i].lenstring.len = 0;
+        filters[i].lenstring.data = NULL;
+        qos[i] = topics[i].qos;
+    }
+
+    // 获取下一个报文 ID
+    packet_id = mqtt_get_next_packet_id(c);
+
+    platform_timer_cutdown(&timer, c->mqtt_cmd_timeout);
+
+    platform_mutex_lock(&c->mqtt_write_lock);
+
+    /* 序列化订阅报文，写缓冲区放不下时减少主题数量 */
+    while ((len = MQTTSerialize_subscribe(c->mqtt_write_buf, c->mqtt_write_buf_size, 0, packet_id, count, filters, qos)) <= 0) {
+        if (--count <= 0)
+            goto exit;
+    }
+
+    /* 创建消息处理程序，如果 handler 为 NULL，则使用默认的消息处理函数 */
+    for (i = 0; (i < count) && install; i++) {
+        msg_handler = mqtt_msg_handler_create(c, topics[i].topic_filter, topics[i].qos,
+                                              (NULL != topics[i].handler) ? topics[i].handler : default_msg_handler);
+        if (NULL == msg_handler) {
+            rc = MQTT_MEM_NOT_ENOUGH_ERROR;
+            goto exit;
+        }
+
+        if (NULL == ring)
+            ring = msg_handler;
+        else
+            mqtt_list_add_tail(&msg_handler->list, &ring->list);
+    }
+
+    /* 先记录 SUBACK 再发送，否则 SUBACK 可能在记录之前被接收线程处理，消息处理程序环由 ACK 处理器持有 */
+    if ((rc = mqtt_ack_list_record(c, SUBACK, packet_id, len, ring)) != MQTT_SUCCESS_ERROR)
+        goto exit;
+    ring = NULL;
+
+    /* 发送失败时取回消息处理程序环并销毁 */
+    if ((rc = mqtt_send_packet(c, len, &timer)) != MQTT_SUCCESS_ERROR)
+        mqtt_ack_list_unrecord(c, SUBACK, packet_id, &ring);
+
+exit:
+    mqtt_msg_handler_ring_destroy(c, ring);
+
+    platform_mutex_unlock(&c->mqtt_write_lock);
+
+    if (MQTT_SUCCESS_ERROR != rc)
+        RETURN_ERROR(rc);
+
+    return count;
+}
+
+/**
+ * @brief 发送重新订阅的主题，发送后清空缓存
+ *
+ * @param c MQTT 客户端实例
+ * @param topics 缓存的主题
+ * @param num 缓存的主题数量，发送后置 0
+ * @return int 返回状态码，MQTT_SUCCESS_ERROR 表示成功
+ */
+static int mqtt_resubscribe_flush(mqtt_client_t *c, mqtt_subscribe_topic_t *topics, int *num)
+{
+    int sent;
+
+    while (*num > 0) {
+        sent = mqtt_subscribe_packet(c, topics, *num, 0);
+        if (sent < 0) {
+            MQTT_LOG_W("%s:%d %s()... mqtt resubscribe failed -0x%04x", __FILE__, __LINE__, __FUNCTION__, -sent);
+            *num = 0;
+            RETURN_ERROR(sent);
+        }
+
+        *num -= sent;
+        memmove(topics, topics + sent, *num * sizeof(mqtt_subscribe_topic_t));
+    }
+
+    RETURN_ERROR(MQTT_SUCCESS_ERROR);
+}
+
 /**
  * @brief 尝试重新订阅 MQTT 客户端中断前的所有主题
  *
@@ -800,24 +1364,33 @@ static void mqtt_ack_list_scan(mqtt_client_t *c, uint8_t flag)
  */
 static int mqtt_try_resubscribe(mqtt_client_t *c)
 {
-    int rc = MQTT_RESUBSCRIBE_ERROR;
+    int rc = MQTT_SUCCESS_ERROR;
+    int num = 0;
     mqtt_list_t *curr, *next;
     message_handlers_t *msg_handler;
+    mqtt_subscribe_topic_t topics[MQTT_SUBSCRIBE_BATCH_MAX];
 
     MQTT_LOG_W("%s:%d %s()... mqtt try resubscribe ...", __FILE__, __LINE__, __FUNCTION__);
 
     if (mqtt_list_is_empty(&c->mqtt_msg_handler_list))
         RETURN_ERROR(MQTT_SUCCESS_ERROR);
 
+    /* 将已安装的主题打包到尽可能少的 SUBSCRIBE 报文中，已安装的消息处理器保持不变 */
     LIST_FOR_EACH_SAFE(curr, next, &c->mqtt_msg_handler_list)
     {
         msg_handler = LIST_ENTRY(curr, message_handlers_t, list);
 
-        /* 重新订阅主题 */
-        if ((rc = mqtt_subscribe(c, msg_handler->topic_filter, msg_handler->qos, msg_handler->handler)) == MQTT_ACK_HANDLER_NUM_TOO_MUCH_ERROR)
-            MQTT_LOG_W("%s:%d %s()... mqtt ack handler num too much ...", __FILE__, __LINE__, __FUNCTION__);
+        topics[num].topic_filter = msg_handler->topic_filter;
+        topics[num].qos = msg_handler->qos;
+        topics[num].handler = msg_handler->handler;
+
+        if (++num == MQTT_SUBSCRIBE_BATCH_MAX)
+            rc = mqtt_resubscribe_flush(c, topics, &num);
     }
 
+    if (num > 0)
+        rc = mqtt_resubscribe_flush(c, topics, &num);
+
     RETURN_ERROR(rc);
 }
 
@@ -836,9 +1409,12 @@ static int mqtt_try_do_reconnect(mqtt_client_t *c)
 
     if (MQTT_SUCCESS_ERROR == rc)
     {
-        rc = mqtt_try_resubscribe(c); /* 重新订阅 */
-        /* 在重新连接后立即处理这些 ACK 消息 */
+        /* 在重新连接后立即重发未确认的报文 */
         mqtt_ack_list_scan(c, 0);
+
+        /* 服务器保留了会话时订阅仍然有效，无需重新订阅 */
+        if (!c->mqtt_session_present)
+            rc = mqtt_try_resubscribe(c); /* 重新订阅 */
     }
 
     MQTT_LOG_D("%s:%d %s()... mqtt try connect result is -0x%04x", __FILE__, __LINE__, __FUNCTION__, -rc);
@@ -874,54 +1450,6 @@ static int mqtt_try_reconnect(mqtt_client_t *c)
     RETURN_ERROR(rc);
 }
 
-/**
- * @brief 发布消息的确认报文处理函数
- *
- * @param c MQTT 客户端结构体指针
- * @param packet_id 报文标识符
- * @param packet_type 报文类型（PUBREC 或 PUBREL）
- * @return int 返回处理结果，可能是成功或失败的状态码
- */
-static int mqtt_publish_ack_packet(mqtt_client_t *c, uint16_t packet_id, int packet_type)
-{
-    int len = 0;
-    int rc = MQTT_SUCCESS_ERROR;
-    platform_timer_t timer;
-
-    platform_mutex_lock(&c->mqtt_write_lock);
-
-    switch (packet_type)
-    {
-    case PUBREC:
-        len = MQTTSerialize_ack(c->mqtt_write_buf, c->mqtt_write_buf_size, PUBREL, 0, packet_id); /* 构造 PUBREL 确认报文 */
-        rc = mqtt_ack_list_record(c, PUBCOMP, packet_id, len, NULL);                              /* 记录确认报文，期望接收 PUBCOMP */
-        if (MQTT_SUCCESS_ERROR != rc)
-            goto exit;
-        break;
-
-    case PUBREL:
-        len = MQTTSerialize_ack(c->mqtt_write_buf, c->mqtt_write_buf_size, PUBCOMP, 0, packet_id); /* 构造 PUBCOMP 确认报文 */
-        break;
-
-    default:
-        rc = MQTT_PUBLISH_ACK_TYPE_ERROR;
-        goto exit;
-    }
-
-    if (len <= 0)
-    {
-        rc = MQTT_PUBLISH_ACK_PACKET_ERROR;
-        goto exit;
-    }
-
-    rc = mqtt_send_packet(c, len, &timer); // 发送确认报文
-
-exit:
-    platform_mutex_unlock(&c->mqtt_write_lock);
-
-    RETURN_ERROR(rc); // 返回处理结果
-}
-
 /**
  * @brief 处理 PUBACK 和 PUBCOMP 报文的函数
  *
@@ -958,35 +1486,46 @@ static int mqtt_puback_and_pubcomp_packet_handle(mqtt_client_t *c, platform_time
 static int mqtt_suback_packet_handle(mqtt_client_t *c, platform_timer_t *timer)
 {
     int rc = MQTT_FAILED_ERROR;
-    int count = 0;
-    int granted_qos = 0;
+    int i, count = 0;
+    int granted_qos[MQTT_SUBSCRIBE_BATCH_MAX];
     uint16_t packet_id;
-    int is_nack = 0;
-    message_handlers_t *msg_handler = NULL;
+    message_handlers_t *ring = NULL, *msg_handler;
 
     rc = mqtt_is_connected(c); // 检查 MQTT 连接状态
     if (MQTT_SUCCESS_ERROR != rc)
         RETURN_ERROR(rc);
 
-    /* 反序列化 SUBACK 报文 */
-    if (MQTTDeserialize_suback(&packet_id, 1, &count, (int *)&granted_qos, c->mqtt_read_buf, c->mqtt_read_buf_size) != 1)
+    /* 反序列化 SUBACK 报文，每个主题过滤器对应一个授予的 QoS */
+    if (MQTTDeserialize_suback(&packet_id, MQTT_SUBSCRIBE_BATCH_MAX, &count, granted_qos, c->mqtt_read_buf, c->mqtt_read_buf_size) != 1)
         RETURN_ERROR(MQTT_SUBSCRIBE_ACK_PACKET_ERROR);
 
-    is_nack = (granted_qos == SUBFAIL);
-
-    rc = mqtt_ack_list_unrecord(c, SUBACK, packet_id, &msg_handler); /* 取消记录确认处理程序 */
+    rc = mqtt_ack_list_unrecord(c, SUBACK, packet_id, &ring); /* 取消记录确认处理程序 */
 
-    if (!msg_handler)
-        RETURN_ERROR(MQTT_MEM_NOT_ENOUGH_ERROR);
+    /* 重新订阅的报文没有新的消息处理程序，已安装的处理程序保持不变 */
+    if (NULL == ring) {
+        for (i = 0; i < count; i++) {
+            if (SUBFAIL == granted_qos[i])
+                MQTT_LOG_W("%s:%d %s()... resubscribe topic %d of packet %d failed", __FILE__, __LINE__, __FUNCTION__, i, packet_id);
+        }
+        RETURN_ERROR(rc);
+    }
 
-    if (is_nack)
+    /* 按顺序处理每个主题，订阅失败的主题销毁消息处理程序，其余安装 */
+    for (i = 0; NULL != (msg_handler = mqtt_msg_handler_ring_take(&ring)); i++)
     {
-        mqtt_msg_handler_destory(msg_handler); /* 订阅主题失败，销毁消息处理程序 */
-        MQTT_LOG_D("订阅主题失败...");
-        RETURN_ERROR(MQTT_SUBSCRIBE_NOT_ACK_ERROR);
-    }
+        if ((i >= count) || (SUBFAIL == granted_qos[i]))
+        {
+            MQTT_LOG_D("订阅主题失败... %s", msg_handler->topic_filter);
+            mqtt_msg_handler_destory(c, msg_handler); /* 订阅主题失败，销毁消息处理程序 */
+            rc = MQTT_SUBSCRIBE_NOT_ACK_ERROR;
+            continue;
+        }
+
+        if (granted_qos[i] < msg_handler->qos)
+            MQTT_LOG_W("%s:%d %s()... topic %s granted qos%d", __FILE__, __LINE__, __FUNCTION__, msg_handler->topic_filter, granted_qos[i]);
 
-    rc = mqtt_msg_handlers_install(c, msg_handler); // 安装消息处理程序
+        mqtt_msg_handlers_install(c, msg_handler); // 安装消息处理程序
+    }
 
     RETURN_ERROR(rc); // 返回处理结果
 }
@@ -1001,7 +1540,7 @@ static int mqtt_suback_packet_handle(mqtt_client_t *c, platform_timer_t *timer)
 static int mqtt_unsuback_packet_handle(mqtt_client_t *c, platform_timer_t *timer)
 {
     int rc = MQTT_FAILED_ERROR;
-    message_handlers_t *msg_handler;
+    message_handlers_t *msg_handler = NULL;
     uint16_t packet_id = 0;
 
     rc = mqtt_is_connected(c); // 检查 MQTT 连接状态
@@ -1016,7 +1555,7 @@ static int mqtt_unsuback_packet_handle(mqtt_client_t *c, platform_timer_t *timer
     if (!msg_handler)
         RETURN_ERROR(MQTT_MEM_NOT_ENOUGH_ERROR);
 
-    mqtt_msg_handler_destory(msg_handler); /* 销毁消息处理程序 */
+    mqtt_msg_handler_ring_destroy(c, msg_handler); /* 销毁报文中所有主题的消息处理程序 */
 
     RETURN_ERROR(rc); // 返回处理结果
 }
@@ -1062,8 +1601,9 @@ static int mqtt_publish_packet_handle(mqtt_client_t *c, platform_timer_t *timer)
     if (msg.qos != QOS2)
         mqtt_deliver_message(c, &topic_name, &msg);
     else {
-        /* record the received of a qos2 message and only processes it when the qos2 message is received for the first time */
-        if ((rc = mqtt_ack_list_record(c, PUBREL, msg.id, len, NULL)) != MQTT_ACK_NODE_IS_EXIST_ERROR)
+        /* record the received of a qos2 message in the packet id bitmap and only processes it when it is received for the first time,
+           a duplicate only needs the PUBREC above, the sender resends PUBLISH until it gets one */
+        if (mqtt_qos2_mark(&c->mqtt_qos2, msg.id))
             mqtt_deliver_message(c, &topic_name, &msg);
     }
     
@@ -1085,6 +1625,20 @@ static int mqtt_pubrec_and_pubrel_packet_handle(mqtt_client_t *c, platform_timer
         RETURN_ERROR(MQTT_PUBREC_PACKET_ERROR);
 
     (void) dup;
+
+    if (PUBREL == packet_type) {
+        /* inbound qos2 is tracked by the bitmap, queue the PUBCOMP and release the packet id once it is sent */
+        if (0 != mqtt_qos2_release_push(&c->mqtt_qos2, packet_id)) {
+            mqtt_qos2_release_drain(c);
+            if (0 != mqtt_qos2_release_push(&c->mqtt_qos2, packet_id)) {
+                /* 释放队列仍然已满，丢弃该 PUBREL，重新连接后服务器会重发 */
+                MQTT_LOG_E("%s:%d %s()... release queue is full, drop PUBREL %d", __FILE__, __LINE__, __FUNCTION__, packet_id);
+                RETURN_ERROR(MQTT_ACK_HANDLER_NUM_TOO_MUCH_ERROR);
+            }
+        }
+        RETURN_ERROR(mqtt_qos2_release_drain(c));
+    }
+
     rc = mqtt_publish_ack_packet(c, packet_id, packet_type);    /* make a ack packet and send it */
     rc = mqtt_ack_list_unrecord(c, packet_type, packet_id, NULL);
 
@@ -1161,6 +1715,109 @@ static int mqtt_wait_packet(mqtt_client_t* c, int packet_type, platform_timer_t*
     RETURN_ERROR(rc);
 }
 
+/**
+ * @brief 关闭备用连接，包括尚未完成的连接
+ *
+ * @param c MQTT 客户端实例
+ */
+static void mqtt_standby_close(mqtt_client_t *c)
+{
+    if (c->mqtt_standby_index >= 0) {
+        network_release(&c->mqtt_standby_network);
+        c->mqtt_standby_index = -1;
+        c->mqtt_standby_connecting = 0;
+    }
+}
+
+/**
+ * @brief 处理备用连接的异步连接结果
+ *
+ * @param c MQTT 客户端实例
+ * @param rc network_connect_start() 或 network_connect_continue() 的返回值
+ */
+static void mqtt_standby_connect_result(mqtt_client_t *c, int rc)
+{
+    mqtt_endpoint_t *ep = mqtt_endpoint_list_get(&c->mqtt_endpoint_list, c->mqtt_standby_index);
+
+    if (MQTT_WOULD_BLOCK_ERROR == rc)
+        return;
+
+    if (MQTT_SUCCESS_ERROR == rc) {
+        c->mqtt_standby_connecting = 0;
+        platform_timer_cutdown(&c->mqtt_standby_timer, MQTT_ENDPOINT_STANDBY_REFRESH);
+        MQTT_LOG_D("%s:%d %s()... standby connected to %s:%s", __FILE__, __LINE__, __FUNCTION__, ep->host, ep->port);
+        return;
+    }
+
+    mqtt_endpoint_list_report(&c->mqtt_endpoint_list, c->mqtt_standby_index, 0);
+    MQTT_LOG_W("%s:%d %s()... standby connect to %s:%s failed", __FILE__, __LINE__, __FUNCTION__, ep->host, ep->port);
+    mqtt_standby_close(c);
+}
+
+/**
+ * @brief 开始与下一个健康的端点建立备用连接，不等待连接完成
+ *
+ * @param c MQTT 客户端实例
+ */
+static void mqtt_standby_open(mqtt_client_t *c)
+{
+    int index;
+    mqtt_endpoint_t *ep;
+
+    /* 连接超时与下一次检查共用同一个定时器 */
+    platform_timer_cutdown(&c->mqtt_standby_timer, MQTT_ENDPOINT_STANDBY_REFRESH);
+
+    index = mqtt_endpoint_list_select(&c->mqtt_endpoint_list, 1u << c->mqtt_endpoint_list.curr);
+    if (NULL == (ep = mqtt_endpoint_list_get(&c->mqtt_endpoint_list, index)))
+        return;
+
+    network_init(&c->mqtt_standby_network, ep->host, ep->port, ep->ca);
+    if (NULL != c->mqtt_tls_context)
+        network_set_tls_context(&c->mqtt_standby_network, c->mqtt_tls_context);
+
+    c->mqtt_standby_index = index;
+    c->mqtt_standby_connecting = 1;
+    mqtt_standby_connect_result(c, network_connect_start(&c->mqtt_standby_network));
+}
+
+/**
+ * @brief 维护备用连接：连接成功后预先与下一个健康的端点建立传输层连接（TCP 或 TCP+TLS），
+ *        故障切换时直接在该连接上发送 CONNECT 报文。连接在接收线程中分步完成，不阻塞主连接的报文处理；
+ *        已建立的备用连接定期检查，只有被服务器关闭后才重建
+ *
+ * @param c MQTT 客户端实例
+ */
+static void mqtt_standby_maintain(mqtt_client_t *c)
+{
+    if ((!c->mqtt_standby) || (c->mqtt_endpoint_list.num < 2)) {
+        mqtt_standby_close(c);
+        return;
+    }
+
+    if (c->mqtt_standby_connecting) {
+        if (platform_timer_is_expired(&c->mqtt_standby_timer))
+            mqtt_standby_connect_result(c, MQTT_CONNECT_FAILED_ERROR);
+        else
+            mqtt_standby_connect_result(c, network_connect_continue(&c->mqtt_standby_network));
+        return;
+    }
+
+    if (!platform_timer_is_expired(&c->mqtt_standby_timer))
+        return;
+
+    /* 发送 CONNECT 之前服务器不会发来数据，备用连接可读说明已被服务器关闭 */
+    if (c->mqtt_standby_index >= 0) {
+        if ((c->mqtt_standby_index != c->mqtt_endpoint_list.curr) && (0 == network_wait(&c->mqtt_standby_network, 0))) {
+            platform_timer_cutdown(&c->mqtt_standby_timer, MQTT_ENDPOINT_STANDBY_REFRESH);
+            return;
+        }
+        MQTT_LOG_D("%s:%d %s()... standby connection is closed, reopen", __FILE__, __LINE__, __FUNCTION__);
+        mqtt_standby_close(c);
+    }
+
+    mqtt_standby_open(c);
+}
+
 static int mqtt_yield(mqtt_client_t* c, int timeout_ms)
 {
     int rc = MQTT_SUCCESS_ERROR;
@@ -1196,6 +1853,9 @@ static int mqtt_yield(mqtt_client_t* c, int timeout_ms)
             /* scan ack list, destroy ack handler that have timed out or resend them */
             mqtt_ack_list_scan(c, 1);
 
+            /* keep a pre-connected socket to the next endpoint for fast failover */
+            mqtt_standby_maintain(c);
+
         } else if (MQTT_NOT_CONNECT_ERROR == rc) {
             MQTT_LOG_E("%s:%d %s()... mqtt not connect", __FILE__, __LINE__, __FUNCTION__);
         } else {
@@ -1224,6 +1884,7 @@ static void mqtt_yield_thread(void *arg)
         if (MQTT_CLEAN_SESSION_ERROR == rc) {
             MQTT_LOG_W("%s:%d %s()..., mqtt clean session....", __FILE__, __LINE__, __FUNCTION__);
             network_disconnect(c->mqtt_network);
+            mqtt_standby_close(c);
             mqtt_clean_session(c);
             goto exit;
         } else if (MQTT_RECONNECT_TIMEOUT_ERROR == rc) {
@@ -1234,39 +1895,101 @@ static void mqtt_yield_thread(void *arg)
 exit:
     thread_to_be_destoried = c->mqtt_thread;
     c->mqtt_thread = (platform_thread_t *)0;
+#ifdef MQTT_STATIC_ALLOCATION
+    platform_thread_destroy_static(thread_to_be_destoried);
+#else
     platform_thread_destroy(thread_to_be_destoried);
+#endif
 }
 
-static int mqtt_connect_with_results(mqtt_client_t* c)
+static void mqtt_standby_takeover(mqtt_client_t *c)
 {
-    int len = 0;
-    int rc = MQTT_CONNECT_FAILED_ERROR;
-    platform_timer_t connect_timer;
-    mqtt_connack_data_t connack_data = {0};
-    MQTTPacket_connectData connect_data = MQTTPacket_connectData_initializer;
+#ifndef MQTT_NETWORK_TYPE_NO_TLS
+    network_tls_stats_t stats = c->mqtt_network->tls_stats;
+
+    network_clear_tls_session(c->mqtt_network);
+    network_set_tls_context(c->mqtt_network, NULL);
+    *c->mqtt_network = c->mqtt_standby_network;
+    c->mqtt_network->tls_stats.full += stats.full;
+    c->mqtt_network->tls_stats.resumed += stats.resumed;
+    c->mqtt_network->tls_stats.failed += stats.failed;
+#else
+    *c->mqtt_network = c->mqtt_standby_network;
+#endif
+    memset(&c->mqtt_standby_network, 0, sizeof(network_t));
+}
 
-    if (NULL == c)
-        RETURN_ERROR(MQTT_NULL_VALUE_ERROR);
+/**
+ * @brief 建立到指定端点的传输层连接，该端点存在备用连接时直接接管备用连接
+ *
+ * @param c MQTT 客户端实例
+ * @param index 端点索引，-1 表示使用 mqtt_host/mqtt_port
+ * @param standby 输出是否接管了备用连接
+ * @param async 非 0 时只开始连接，返回 MQTT_WOULD_BLOCK_ERROR 后由 network_connect_continue() 继续
+ * @return int 返回状态码，MQTT_SUCCESS_ERROR 表示成功
+ */
+static int mqtt_network_open(mqtt_client_t *c, int index, int *standby, int async)
+{
+    int rc;
+    mqtt_endpoint_t *ep = mqtt_endpoint_list_get(&c->mqtt_endpoint_list, index);
 
-    if (CLIENT_STATE_CONNECTED == mqtt_get_client_state(c))
-        RETURN_ERROR(MQTT_SUCCESS_ERROR);
+    *standby = 0;
 
+    /* 尚未完成的备用连接不能接管 */
+    if ((NULL != ep) && (index == c->mqtt_standby_index) && c->mqtt_standby_connecting)
+        mqtt_standby_close(c);
 
+    if ((NULL != ep) && (index == c->mqtt_standby_index)) {
+        /* 备用连接带有自己的会话，握手统计累加到主连接上 */
+        mqtt_standby_takeover(c);
+        c->mqtt_standby_index = -1;
+        *standby = 1;
+        RETURN_ERROR(MQTT_SUCCESS_ERROR);
+    }
 
 #ifndef MQTT_NETWORK_TYPE_NO_TLS
-    rc = network_init(c->mqtt_network, c->mqtt_host, c->mqtt_port, c->mqtt_ca);
+    if (NULL != ep)
+        rc = network_init(c->mqtt_network, ep->host, ep->port, ep->ca);
+    else
+        rc = network_init(c->mqtt_network, c->mqtt_host, c->mqtt_port, c->mqtt_ca);
+    if (MQTT_SUCCESS_ERROR != rc)
+        RETURN_ERROR(rc);
+
+    /* 共享的 TLS 上下文优先于 CA 字符串，证书不必在每次连接时重新解析 */
+    if (NULL != c->mqtt_tls_context)
+        network_set_tls_context(c->mqtt_network, c->mqtt_tls_context);
 #else
-    rc = network_init(c->mqtt_network, c->mqtt_host, c->mqtt_port, NULL);
+    if (NULL != ep)
+        rc = network_init(c->mqtt_network, ep->host, ep->port, NULL);
+    else
+        rc = network_init(c->mqtt_network, c->mqtt_host, c->mqtt_port, NULL);
+    if (MQTT_SUCCESS_ERROR != rc)
+        RETURN_ERROR(rc);
 #endif
 
-    rc = network_connect(c->mqtt_network);
-    if (MQTT_SUCCESS_ERROR != rc) {
+    rc = async ? network_connect_start(c->mqtt_network) : network_connect(c->mqtt_network);
+    if ((MQTT_SUCCESS_ERROR != rc) && (MQTT_WOULD_BLOCK_ERROR != rc)) {
         if (NULL != c->mqtt_network) {
             network_release(c->mqtt_network);
             RETURN_ERROR(rc);
         }  
     }
-    
+
+    RETURN_ERROR(rc);
+}
+
+/**
+ * @brief 在已建立的传输层连接上发送 CONNECT 报文
+ *
+ * @param c MQTT 客户端实例
+ * @param timer 计时器实例
+ * @return int 返回状态码，MQTT_SUCCESS_ERROR 表示成功
+ */
+static int mqtt_connect_send(mqtt_client_t *c, platform_timer_t *timer)
+{
+    int len = 0;
+    MQTTPacket_connectData connect_data = MQTTPacket_connectData_initializer;
+
     MQTT_LOG_I("%s:%d %s()... mqtt connect success...", __FILE__, __LINE__, __FUNCTION__);
 
     connect_data.keepAliveInterval = c->mqtt_keep_alive_interval;
@@ -1286,32 +2009,157 @@ static int mqtt_connect_with_results(mqtt_client_t* c)
     
     platform_timer_cutdown(&c->mqtt_last_received, (c->mqtt_keep_alive_interval * 1000));
 
-    platform_mutex_lock(&c->mqtt_write_lock);
-
     /* serialize connect packet */
     if ((len = MQTTSerialize_connect(c->mqtt_write_buf, c->mqtt_write_buf_size, &connect_data)) <= 0)
-        goto exit;
-        
-    platform_timer_cutdown(&connect_timer, c->mqtt_cmd_timeout);
+        RETURN_ERROR(MQTT_CONNECT_FAILED_ERROR);
 
     /* send connect packet */
-    if ((rc = mqtt_send_packet(c, len, &connect_timer)) != MQTT_SUCCESS_ERROR)
-        goto exit;
+    return mqtt_send_packet(c, len, timer);
+}
 
-    if (mqtt_wait_packet(c, CONNACK, &connect_timer) == CONNACK) {
-        if (MQTTDeserialize_connack(&connack_data.session_present, &connack_data.rc, c->mqtt_read_buf, c->mqtt_read_buf_size) == 1)
-            rc = connack_data.rc;
-        else
-            rc = MQTT_CONNECT_FAILED_ERROR;
-    } else
-        rc = MQTT_CONNECT_FAILED_ERROR;
+/**
+ * @brief 解析已读取的 CONNACK 报文，记录服务器是否保留了会话
+ *
+ * @param c MQTT 客户端实例
+ * @param packet_type 读到的报文类型，不是 CONNACK 时连接失败
+ * @return int 返回状态码，MQTT_SUCCESS_ERROR 表示服务器接受连接
+ */
+static int mqtt_connack_parse(mqtt_client_t *c, int packet_type)
+{
+    int rc = MQTT_CONNECT_FAILED_ERROR;
+    mqtt_connack_data_t connack_data = {0};
 
-exit:
+    if ((CONNACK == packet_type) &&
+        (MQTTDeserialize_connack(&connack_data.session_present, &connack_data.rc, c->mqtt_read_buf, c->mqtt_read_buf_size) == 1))
+        rc = connack_data.rc;
+
+    c->mqtt_session_present = (MQTT_SUCCESS_ERROR == rc) ? connack_data.session_present : 0;
+
+    RETURN_ERROR(rc);
+}
+
+/**
+ * @brief 非阻塞地读取 CONNACK，已读到的字节保存在 mqtt_read_buf 中，报文不完整时下次调用接着读
+ *
+ * @param c MQTT 客户端实例
+ * @param packet_type 报文完整时返回的报文类型
+ * @return int MQTT_SUCCESS_ERROR 表示已读到完整报文，MQTT_NOTHING_TO_READ_ERROR 表示还需等待，其他为错误码
+ */
+static int mqtt_connack_poll(mqtt_client_t *c, int *packet_type)
+{
+    int i, rc, need, remain_len, multiplier;
+    MQTTHeader header = {0};
+
+    while (1) {
+        /* 由已读到的字节推算还需要读多少，剩余长度字段本身也是变长的 */
+        need = 1;
+        if (c->mqtt_connack_len > 0) {
+            remain_len = 0;
+            multiplier = 1;
+            for (i = 1; i < c->mqtt_connack_len; i++) {
+                remain_len += (c->mqtt_read_buf[i] & 127) * multiplier;
+                multiplier *= 128;
+                if (0 == (c->mqtt_read_buf[i] & 128))
+                    break;
+            }
+
+            if (i > 4)
+                RETURN_ERROR(MQTT_CONNECT_FAILED_ERROR);
+
+            if (i < c->mqtt_connack_len) {
+                if ((i + 1 + remain_len) > c->mqtt_read_buf_size)
+                    RETURN_ERROR(MQTT_BUFFER_TOO_SHORT_ERROR);
+                need = i + 1 + remain_len - c->mqtt_connack_len;
+            }
+        }
+
+        if (0 == need)
+            break;
+
+        rc = network_read(c->mqtt_network, c->mqtt_read_buf + c->mqtt_connack_len, need, 0);
+        if (rc < 0)
+            RETURN_ERROR(MQTT_NOT_CONNECT_ERROR);
+        if (0 == rc)
+            RETURN_ERROR(MQTT_NOTHING_TO_READ_ERROR);
+        c->mqtt_connack_len += rc;
+    }
+
+    header.byte = c->mqtt_read_buf[0];
+    *packet_type = header.bits.type;
+    platform_timer_cutdown(&c->mqtt_last_received, (c->mqtt_keep_alive_interval * 1000));
+
+    RETURN_ERROR(MQTT_SUCCESS_ERROR);
+}
+
+/**
+ * @brief 等待并解析 CONNACK 报文
+ *
+ * @param c MQTT 客户端实例
+ * @param timer 计时器实例
+ * @return int 返回状态码，MQTT_SUCCESS_ERROR 表示服务器接受连接
+ */
+static int mqtt_connack_handle(mqtt_client_t *c, platform_timer_t *timer)
+{
+    RETURN_ERROR(mqtt_connack_parse(c, mqtt_wait_packet(c, CONNACK, timer)));
+}
+
+/**
+ * @brief 与指定端点建立 MQTT 连接，发送 CONNECT 报文并等待 CONNACK。
+ *        接管的备用连接可能已被服务器关闭，此时重新建立一次连接
+ *
+ * @param c MQTT 客户端实例
+ * @param index 端点索引，-1 表示使用 mqtt_host/mqtt_port
+ * @return int 返回状态码，MQTT_SUCCESS_ERROR 表示成功
+ */
+static int mqtt_connect_endpoint(mqtt_client_t *c, int index)
+{
+    int standby = 0;
+    int rc = MQTT_CONNECT_FAILED_ERROR;
+    platform_timer_t connect_timer;
+
+retry:
+    rc = mqtt_network_open(c, index, &standby, 0);
+    if (MQTT_SUCCESS_ERROR != rc)
+        RETURN_ERROR(rc);
+
+    platform_timer_cutdown(&connect_timer, c->mqtt_cmd_timeout);
+
+    if ((rc = mqtt_connect_send(c, &connect_timer)) == MQTT_SUCCESS_ERROR)
+        rc = mqtt_connack_handle(c, &connect_timer);
+    else
+        c->mqtt_session_present = 0;
+
+    if (rc != MQTT_SUCCESS_ERROR) {
+        network_release(c->mqtt_network);
+        if (standby) {
+            MQTT_LOG_W("%s:%d %s()... standby connection is stale, reconnect", __FILE__, __LINE__, __FUNCTION__);
+            goto retry;
+        }
+    }
+
+    RETURN_ERROR(rc);
+}
+
+/**
+ * @brief 连接结束后更新客户端状态，成功时启动 mqtt 线程。调用者持有 mqtt_write_lock
+ *
+ * @param c MQTT 客户端实例
+ * @param rc 连接结果
+ * @return int 返回状态码，MQTT_SUCCESS_ERROR 表示成功
+ */
+static int mqtt_connect_finish(mqtt_client_t *c, int rc)
+{
     if (rc == MQTT_SUCCESS_ERROR) {
         if(NULL == c->mqtt_thread) {
 
             /* connect success, and need init mqtt thread */
+#ifdef MQTT_STATIC_ALLOCATION
+            mqtt_client_static_t *s = (mqtt_client_static_t *)c;
+            c->mqtt_thread = platform_thread_init_static(&s->thread, "mqtt_yield_thread", mqtt_yield_thread, c,
+                                                         s->thread_stack, sizeof(s->thread_stack), MQTT_THREAD_PRIO, MQTT_THREAD_TICK);
+#else
             c->mqtt_thread= platform_thread_init("mqtt_yield_thread", mqtt_yield_thread, c, MQTT_THREAD_STACK_SIZE, MQTT_THREAD_PRIO, MQTT_THREAD_TICK);
+#endif
 
             if (NULL != c->mqtt_thread) {
                 mqtt_set_client_state(c, CLIENT_STATE_CONNECTED);
@@ -1329,20 +2177,249 @@ exit:
 
         c->mqtt_ping_outstanding = 0;        /* reset ping outstanding */
 
+        /* the broker resends PUBREL after reconnecting, without a stored session it drops all inbound qos2 state */
+        mqtt_qos2_release_reset(&c->mqtt_qos2);
+        if (!c->mqtt_session_present)
+            mqtt_qos2_init(&c->mqtt_qos2);
+
     } else {
-        network_release(c->mqtt_network);
         mqtt_set_client_state(c, CLIENT_STATE_INITIALIZED); /* connect failed */
     }
-    
+
+    RETURN_ERROR(rc);
+}
+
+static int mqtt_connect_with_results(mqtt_client_t* c)
+{
+    int index;
+    uint32_t tried = 0;
+    int rc = MQTT_CONNECT_FAILED_ERROR;
+
+    if (NULL == c)
+        RETURN_ERROR(MQTT_NULL_VALUE_ERROR);
+
+    if (CLIENT_STATE_CONNECTED == mqtt_get_client_state(c))
+        RETURN_ERROR(MQTT_SUCCESS_ERROR);
+
+    platform_mutex_lock(&c->mqtt_write_lock);
+
+    if (0 == c->mqtt_endpoint_list.num) {
+        rc = mqtt_connect_endpoint(c, -1);
+    } else {
+        /* 依次尝试健康的端点，失败后立即切换到下一个，而不是等待下一次重连 */
+        while ((index = mqtt_endpoint_list_select(&c->mqtt_endpoint_list, tried)) >= 0) {
+            tried |= 1u << index;
+            rc = mqtt_connect_endpoint(c, index);
+            mqtt_endpoint_list_report(&c->mqtt_endpoint_list, index, (MQTT_SUCCESS_ERROR == rc));
+            if (MQTT_SUCCESS_ERROR == rc) {
+                c->mqtt_endpoint_list.curr = index;
+                break;
+            }
+            MQTT_LOG_W("%s:%d %s()... endpoint %d connect failed, fail over", __FILE__, __LINE__, __FUNCTION__, index);
+        }
+    }
+
+    rc = mqtt_connect_finish(c, rc);
+
     platform_mutex_unlock(&c->mqtt_write_lock);
 
     RETURN_ERROR(rc);
 }
 
+/**
+ * @brief 非阻塞连接选择下一个端点并开始连接，不等待 TCP 连接和 TLS 握手
+ *
+ * @param c MQTT 客户端实例
+ * @return int MQTT_WOULD_BLOCK_ERROR 表示已开始连接，所有端点都已尝试时返回 MQTT_CONNECT_FAILED_ERROR
+ */
+static int mqtt_connect_next(mqtt_client_t *c)
+{
+    int rc, standby = 0;
+
+    do {
+        if (0 == c->mqtt_endpoint_list.num) {
+            if (0 != c->mqtt_connect_tried)
+                RETURN_ERROR(MQTT_CONNECT_FAILED_ERROR);
+            c->mqtt_connect_tried = 1;
+            c->mqtt_connect_index = -1;
+        } else {
+            c->mqtt_connect_index = mqtt_endpoint_list_select(&c->mqtt_endpoint_list, c->mqtt_connect_tried);
+            if (c->mqtt_connect_index < 0)
+                RETURN_ERROR(MQTT_CONNECT_FAILED_ERROR);
+            c->mqtt_connect_tried |= 1u << c->mqtt_connect_index;
+        }
+
+        rc = mqtt_network_open(c, c->mqtt_connect_index, &standby, 1);
+        if ((MQTT_SUCCESS_ERROR != rc) && (MQTT_WOULD_BLOCK_ERROR != rc)) {
+            mqtt_endpoint_list_report(&c->mqtt_endpoint_list, c->mqtt_connect_index, 0);
+            MQTT_LOG_W("%s:%d %s()... endpoint %d connect failed, fail over", __FILE__, __LINE__, __FUNCTION__, c->mqtt_connect_index);
+        }
+    } while ((MQTT_SUCCESS_ERROR != rc) && (MQTT_WOULD_BLOCK_ERROR != rc));
+
+    /* TLS 握手由 n->timeout_ms 限制，其他通道的连接时间由 mqtt_cmd_timeout 限制 */
+    platform_timer_cutdown(&c->mqtt_connect_timer, c->mqtt_cmd_timeout);
+    c->mqtt_connect_phase = MQTT_CONNECT_PHASE_NETWORK;
+    RETURN_ERROR(MQTT_WOULD_BLOCK_ERROR);
+}
+
+/**
+ * @brief 推进非阻塞连接，直到需要等待套接字、连接成功或所有端点都失败。调用者持有 mqtt_write_lock
+ *
+ * @param c MQTT 客户端实例
+ * @return int MQTT_SUCCESS_ERROR 表示已连接，MQTT_WOULD_BLOCK_ERROR 表示仍在进行，其他为错误码
+ */
+static int mqtt_connect_advance(mqtt_client_t *c)
+{
+    int rc, packet_type = 0;
+
+    while (1) {
+        switch (c->mqtt_connect_phase) {
+            case MQTT_CONNECT_PHASE_NETWORK:
+                rc = network_connect_continue(c->mqtt_network);
+                if (MQTT_WOULD_BLOCK_ERROR == rc) {
+                    if ((NETWORK_CHANNEL_TLS == c->mqtt_network->channel) || (!platform_timer_is_expired(&c->mqtt_connect_timer)))
+                        RETURN_ERROR(rc);
+                    rc = MQTT_CONNECT_FAILED_ERROR;
+                } else if (MQTT_SUCCESS_ERROR == rc) {
+                    platform_timer_cutdown(&c->mqtt_connect_timer, c->mqtt_cmd_timeout);
+                    rc = mqtt_connect_send(c, &c->mqtt_connect_timer);
+                    if (MQTT_SUCCESS_ERROR == rc) {
+                        c->mqtt_connect_phase = MQTT_CONNECT_PHASE_CONNACK;
+                        c->mqtt_connack_len = 0;
+                        continue;
+                    }
+                }
+                break;
+
+            case MQTT_CONNECT_PHASE_CONNACK:
+                /* 读取 CONNACK 时只轮询，还没有完整到达时保留已读部分，下次接着读 */
+                rc = mqtt_connack_poll(c, &packet_type);
+                if (MQTT_NOTHING_TO_READ_ERROR == rc) {
+                    if (!platform_timer_is_expired(&c->mqtt_connect_timer))
+                        RETURN_ERROR(MQTT_WOULD_BLOCK_ERROR);
+                    rc = MQTT_CONNECT_FAILED_ERROR;
+                } else if (MQTT_SUCCESS_ERROR == rc) {
+                    rc = mqtt_connack_parse(c, packet_type);
+                }
+
+                if (MQTT_SUCCESS_ERROR == rc) {
+                    mqtt_endpoint_list_report(&c->mqtt_endpoint_list, c->mqtt_connect_index, 1);
+                    if (c->mqtt_connect_index >= 0)
+                        c->mqtt_endpoint_list.curr = c->mqtt_connect_index;
+                    c->mqtt_connect_phase = MQTT_CONNECT_PHASE_IDLE;
+                    RETURN_ERROR(rc);
+                }
+                break;
+
+            default:
+                rc = mqtt_connect_next(c);
+                if (MQTT_WOULD_BLOCK_ERROR == rc)
+                    continue;
+                RETURN_ERROR(rc);
+        }
+
+        /* 当前端点失败，切换到下一个端点 */
+        network_release(c->mqtt_network);
+        mqtt_endpoint_list_report(&c->mqtt_endpoint_list, c->mqtt_connect_index, 0);
+        MQTT_LOG_W("%s:%d %s()... endpoint %d connect failed, fail over", __FILE__, __LINE__, __FUNCTION__, c->mqtt_connect_index);
+        c->mqtt_connect_phase = MQTT_CONNECT_PHASE_IDLE;
+    }
+}
+
+/**
+ * @brief 开始非阻塞连接，与 mqtt_connect() 一样依次尝试各个端点，但 TCP 连接、TLS 握手和等待 CONNACK 都不阻塞调用者。
+ *        返回 MQTT_WOULD_BLOCK_ERROR 时通过 mqtt_connect_want() 获取套接字和等待的事件，就绪后调用 mqtt_connect_continue()，
+ *        一个事件循环线程可以同时推进多个客户端的连接。只用于首次连接，连接成功后由 mqtt 线程负责重连
+ *
+ * @param c MQTT 客户端实例
+ * @return int MQTT_SUCCESS_ERROR 表示已连接，MQTT_WOULD_BLOCK_ERROR 表示仍在进行，其他为错误码
+ */
+int mqtt_connect_start(mqtt_client_t *c)
+{
+    int rc;
+
+    if (NULL == c)
+        RETURN_ERROR(MQTT_NULL_VALUE_ERROR);
+
+    if (CLIENT_STATE_CONNECTED == mqtt_get_client_state(c))
+        RETURN_ERROR(MQTT_SUCCESS_ERROR);
+
+    if (MQTT_CONNECT_PHASE_IDLE != c->mqtt_connect_phase)
+        RETURN_ERROR(MQTT_WOULD_BLOCK_ERROR);
+
+    /* mqtt 线程已存在时由它负责重连 */
+    if (NULL != c->mqtt_thread)
+        RETURN_ERROR(MQTT_NOT_CONNECT_ERROR);
+
+    platform_mutex_lock(&c->mqtt_write_lock);
+
+    c->mqtt_connect_tried = 0;
+    rc = mqtt_connect_advance(c);
+    if (MQTT_WOULD_BLOCK_ERROR != rc)
+        rc = mqtt_connect_finish(c, rc);
+
+    platform_mutex_unlock(&c->mqtt_write_lock);
+
+    RETURN_ERROR(rc);
+}
+
+/**
+ * @brief 在套接字就绪后继续 mqtt_connect_start() 开始的连接
+ *
+ * @param c MQTT 客户端实例
+ * @return int MQTT_SUCCESS_ERROR 表示已连接，MQTT_WOULD_BLOCK_ERROR 表示仍在进行，其他为错误码
+ */
+int mqtt_connect_continue(mqtt_client_t *c)
+{
+    int rc;
+
+    if (NULL == c)
+        RETURN_ERROR(MQTT_NULL_VALUE_ERROR);
+
+    if (MQTT_CONNECT_PHASE_IDLE == c->mqtt_connect_phase)
+        RETURN_ERROR((CLIENT_STATE_CONNECTED == mqtt_get_client_state(c)) ? MQTT_SUCCESS_ERROR : MQTT_NOT_CONNECT_ERROR);
+
+    platform_mutex_lock(&c->mqtt_write_lock);
+
+    rc = mqtt_connect_advance(c);
+    if (MQTT_WOULD_BLOCK_ERROR != rc)
+        rc = mqtt_connect_finish(c, rc);
+
+    platform_mutex_unlock(&c->mqtt_write_lock);
+
+    RETURN_ERROR(rc);
+}
+
+/**
+ * @brief 获取非阻塞连接需要等待的套接字事件
+ *
+ * @param c MQTT 客户端实例
+ * @param socket 输出正在连接的套接字
+ * @return int NETWORK_WANT_READ 和/或 NETWORK_WANT_WRITE，0 表示无需等待，让出 CPU 后即可调用 mqtt_connect_continue()
+ */
+int mqtt_connect_want(mqtt_client_t *c, int *socket)
+{
+    if ((NULL == c) || (MQTT_CONNECT_PHASE_IDLE == c->mqtt_connect_phase))
+        return 0;
+
+    if (NULL != socket)
+        *socket = c->mqtt_network->socket;
+
+    if (MQTT_CONNECT_PHASE_CONNACK == c->mqtt_connect_phase)
+        return NETWORK_WANT_READ;
+
+    return network_connect_want(c->mqtt_network);
+}
+
 static uint32_t mqtt_read_buf_malloc(mqtt_client_t* c, uint32_t size)
 {
     MQTT_ROBUSTNESS_CHECK(c, 0);
-    
+
+#ifdef MQTT_STATIC_ALLOCATION
+    /* the read buffer is static storage, it can only be shrunk */
+    c->mqtt_read_buf = ((mqtt_client_static_t *)c)->read_buf;
+    c->mqtt_read_buf_size = ((MQTT_MIN_PAYLOAD_SIZE >= size) || (MQTT_STATIC_READ_BUF_SIZE < size)) ? MQTT_STATIC_READ_BUF_SIZE : size;
+#else
     if (NULL != c->mqtt_read_buf)
         platform_memory_free(c->mqtt_read_buf);
     
@@ -1358,13 +2435,19 @@ static uint32_t mqtt_read_buf_malloc(mqtt_client_t* c, uint32_t size)
         MQTT_LOG_E("%s:%d %s()... malloc read buf failed...", __FILE__, __LINE__, __FUNCTION__);
         RETURN_ERROR(MQTT_MEM_NOT_ENOUGH_ERROR);
     }
+#endif
     return c->mqtt_read_buf_size;
 }
 
 static uint32_t mqtt_write_buf_malloc(mqtt_client_t* c, uint32_t size)
 {
     MQTT_ROBUSTNESS_CHECK(c, 0);
-    
+
+#ifdef MQTT_STATIC_ALLOCATION
+    /* the write buffer is static storage, it can only be shrunk */
+    c->mqtt_write_buf = ((mqtt_client_static_t *)c)->write_buf;
+    c->mqtt_write_buf_size = ((MQTT_MIN_PAYLOAD_SIZE >= size) || (MQTT_STATIC_WRITE_BUF_SIZE < size)) ? MQTT_STATIC_WRITE_BUF_SIZE : size;
+#else
     if (NULL != c->mqtt_write_buf)
         platform_memory_free(c->mqtt_write_buf);
     
@@ -1380,13 +2463,20 @@ static uint32_t mqtt_write_buf_malloc(mqtt_client_t* c, uint32_t size)
         MQTT_LOG_E("%s:%d %s()... malloc write buf failed...", __FILE__, __LINE__, __FUNCTION__);
         RETURN_ERROR(MQTT_MEM_NOT_ENOUGH_ERROR);
     }
+#endif
     return c->mqtt_write_buf_size;
 }
 
 static int mqtt_init(mqtt_client_t* c)
 {
     /* network init */
+#ifdef MQTT_STATIC_ALLOCATION
+    mqtt_client_static_t *s = (mqtt_client_static_t *)c;
+
+    c->mqtt_network = &s->network;
+#else
     c->mqtt_network = (network_t*) platform_memory_alloc(sizeof(network_t));
+#endif
 
     if (NULL == c->mqtt_network) {
         MQTT_LOG_E("%s:%d %s()... malloc memory failed...", __FILE__, __LINE__, __FUNCTION__);
@@ -1394,6 +2484,9 @@ static int mqtt_init(mqtt_client_t* c)
     }
     memset(c->mqtt_network, 0, sizeof(network_t));
 
+    if (MQTT_SUCCESS_ERROR != mqtt_handler_pool_init(c))
+        RETURN_ERROR(MQTT_MEM_NOT_ENOUGH_ERROR);
+
     c->mqtt_packet_id = 1;
     c->mqtt_clean_session = 0;          //no clear session by default
     c->mqtt_will_flag = 0;
@@ -1401,6 +2494,7 @@ static int mqtt_init(mqtt_client_t* c)
     c->mqtt_client_state = CLIENT_STATE_INITIALIZED;
     
     c->mqtt_ping_outstanding = 0;
+    c->mqtt_session_present = 0;
     c->mqtt_ack_handler_number = 0;
     c->mqtt_client_id_len = 0;
     c->mqtt_user_name_len = 0;
@@ -1412,7 +2506,17 @@ static int mqtt_init(mqtt_client_t* c)
     c->mqtt_will_options = NULL;
     c->mqtt_reconnect_data = NULL;
     c->mqtt_reconnect_handler = NULL;
+    c->mqtt_disconnect_data = NULL;
+    c->mqtt_disconnect_handler = NULL;
     c->mqtt_interceptor_handler = NULL;
+
+    mqtt_endpoint_list_init(&c->mqtt_endpoint_list);
+    mqtt_qos2_init(&c->mqtt_qos2);
+    c->mqtt_standby = 0;
+    c->mqtt_standby_index = -1;
+    c->mqtt_standby_connecting = 0;
+    c->mqtt_connect_phase = MQTT_CONNECT_PHASE_IDLE;
+    platform_timer_init(&c->mqtt_standby_timer);
     
     mqtt_read_buf_malloc(c, MQTT_DEFAULT_BUF_SIZE);
     mqtt_write_buf_malloc(c, MQTT_DEFAULT_BUF_SIZE);
@@ -1420,8 +2524,15 @@ static int mqtt_init(mqtt_client_t* c)
     mqtt_list_init(&c->mqtt_msg_handler_list);
     mqtt_list_init(&c->mqtt_ack_handler_list);
     
+#ifdef MQTT_STATIC_ALLOCATION
+    if ((0 != platform_mutex_init_static(&c->mqtt_write_lock)) || (0 != platform_mutex_init_static(&c->mqtt_global_lock))) {
+        MQTT_LOG_E("%s:%d %s()... static mutex init failed...", __FILE__, __LINE__, __FUNCTION__);
+        RETURN_ERROR(MQTT_FAILED_ERROR);
+    }
+#else
     platform_mutex_init(&c->mqtt_write_lock);
     platform_mutex_init(&c->mqtt_global_lock);
+#endif
 
     platform_timer_init(&c->mqtt_last_sent);
     platform_timer_init(&c->mqtt_last_received);
@@ -1444,6 +2555,7 @@ MQTT_CLIENT_SET_DEFINE(password, char *, NULL)
 MQTT_CLIENT_SET_DEFINE(host, char *, NULL)
 MQTT_CLIENT_SET_DEFINE(port, char *, NULL)
 MQTT_CLIENT_SET_DEFINE(ca, char *, NULL)
+MQTT_CLIENT_SET_DEFINE(tls_context, network_tls_context_t *, NULL)
 MQTT_CLIENT_SET_DEFINE(reconnect_data, void *, NULL)
 MQTT_CLIENT_SET_DEFINE(keep_alive_interval, uint16_t, 0)
 MQTT_CLIENT_SET_DEFINE(will_flag, uint32_t, 0)
@@ -1452,7 +2564,18 @@ MQTT_CLIENT_SET_DEFINE(version, uint32_t, 0)
 MQTT_CLIENT_SET_DEFINE(cmd_timeout, uint32_t, 0)
 MQTT_CLIENT_SET_DEFINE(reconnect_try_duration, uint32_t, 0)
 MQTT_CLIENT_SET_DEFINE(reconnect_handler, reconnect_handler_t, NULL)
+MQTT_CLIENT_SET_DEFINE(disconnect_data, void *, NULL)
+MQTT_CLIENT_SET_DEFINE(disconnect_handler, disconnect_handler_t, NULL)
 MQTT_CLIENT_SET_DEFINE(interceptor_handler, interceptor_handler_t, NULL)
+MQTT_CLIENT_SET_DEFINE(standby, uint32_t, 0)
+
+/**
+ * @brief 定义 MQTT 客户端属性的获取函数，供扩展模块在替换回调前保存原有设置
+ */
+MQTT_CLIENT_GET_DEFINE(reconnect_data, void *, NULL)
+MQTT_CLIENT_GET_DEFINE(reconnect_handler, reconnect_handler_t, NULL)
+MQTT_CLIENT_GET_DEFINE(disconnect_data, void *, NULL)
+MQTT_CLIENT_GET_DEFINE(disconnect_handler, disconnect_handler_t, NULL)
 
 /**
  * @brief 设置 MQTT 客户端读缓冲区大小
@@ -1525,6 +2648,29 @@ int mqtt_keep_alive(mqtt_client_t *c)
     RETURN_ERROR(rc);
 }
 
+#ifdef MQTT_STATIC_ALLOCATION
+/**
+ * @brief 在调用者提供的静态存储空间上初始化 MQTT 客户端，不使用堆内存
+ *
+ * @param s 客户端的静态存储空间，包括缓冲区、处理器内存池和线程栈
+ * @return mqtt_client_t* 返回 MQTT 客户端结构体指针，初始化失败时返回 NULL
+ */
+mqtt_client_t *mqtt_lease_static(mqtt_client_static_t *s)
+{
+    int rc;
+
+    if (NULL == s)
+        return NULL;
+
+    memset(s, 0, sizeof(mqtt_client_static_t));
+
+    rc = mqtt_init(&s->client);
+    if (MQTT_SUCCESS_ERROR != rc)
+        return NULL;
+
+    return &s->client;
+}
+#else
 /**
  * @brief 分配 MQTT 客户端结构体内存并初始化
  *
@@ -1547,6 +2693,7 @@ mqtt_client_t *mqtt_lease(void)
 
     return c;
 }
+#endif
 
 /**
  * @brief 释放 MQTT 客户端结构体内存
@@ -1575,6 +2722,13 @@ int mqtt_release(mqtt_client_t *c)
         }
     }
 
+    /* 释放为重连保存的 TLS 会话和 TLS 上下文引用 */
+    network_clear_tls_session(c->mqtt_network);
+    network_clear_tls_session(&c->mqtt_standby_network);
+    network_set_tls_context(c->mqtt_network, NULL);
+    network_set_tls_context(&c->mqtt_standby_network, NULL);
+
+#ifndef MQTT_STATIC_ALLOCATION
     // 释放网络结构体内存
     if (NULL != c->mqtt_network)
     {
@@ -1596,6 +2750,14 @@ int mqtt_release(mqtt_client_t *c)
         c->mqtt_write_buf = NULL;
     }
 
+    // 释放处理器内存池
+    if (NULL != c->mqtt_handler_pool_storage)
+    {
+        platform_memory_free(c->mqtt_handler_pool_storage);
+        c->mqtt_handler_pool_storage = NULL;
+    }
+#endif
+
     platform_mutex_destroy(&c->mqtt_write_lock);
     platform_mutex_destroy(&c->mqtt_global_lock);
 
@@ -1628,6 +2790,12 @@ int mqtt_disconnect(mqtt_client_t *c)
     platform_timer_t timer;
     int len = 0;
 
+    /* 在发送 DISCONNECT 之前调用断开处理器，可以用于发送缓存中尚未发布的数据 */
+    if (NULL != c->mqtt_disconnect_handler)
+    {
+        c->mqtt_disconnect_handler(c, c->mqtt_disconnect_data);
+    }
+
     // 设置定时器，用于超时控制
     platform_timer_cutdown(&timer, c->mqtt_cmd_timeout);
 
@@ -1657,49 +2825,129 @@ int mqtt_disconnect(mqtt_client_t *c)
  */
 int mqtt_subscribe(mqtt_client_t *c, const char *topic_filter, mqtt_qos_t qos, message_handler_t handler)
 {
-    int rc = MQTT_SUBSCRIBE_ERROR;
-    int len = 0;
-    uint16_t packet_id;
-    platform_timer_t timer;
-    MQTTString topic = MQTTString_initializer;
-    topic.cstring = (char *)topic_filter;
-    message_handlers_t *msg_handler = NULL;
+    mqtt_subscribe_topic_t topic;
+
+    topic.topic_filter = topic_filter;
+    topic.qos = qos;
+    topic.handler = handler;
+
+    return mqtt_subscribe_many(c, &topic, 1);
+}
+
+/**
+ * @brief 订阅多个 MQTT 主题，主题被打包到尽可能少的 SUBSCRIBE 报文中，
+ *        每个报文最多 MQTT_SUBSCRIBE_BATCH_MAX 个主题且不超过写缓冲区
+ *
+ * @param c MQTT 客户端结构体指针
+ * @param topics 要订阅的主题、QoS 及消息处理函数
+ * @param count 主题数量
+ * @return int 返回处理结果，可能是成功或失败的状态码
+ */
+int mqtt_subscribe_many(mqtt_client_t *c, const mqtt_subscribe_topic_t *topics, int count)
+{
+    int i, sent;
+
+    if ((NULL == c) || (NULL == topics) || (count <= 0))
+        RETURN_ERROR(MQTT_NULL_VALUE_ERROR);
 
     if (CLIENT_STATE_CONNECTED != mqtt_get_client_state(c))
         RETURN_ERROR(MQTT_NOT_CONNECT_ERROR);
 
+    for (i = 0; i < count; i += sent) {
+        sent = mqtt_subscribe_packet(c, &topics[i], count - i, 1);
+        if (sent < 0)
+            RETURN_ERROR(sent);
+    }
+
+    RETURN_ERROR(MQTT_SUCCESS_ERROR);
+}
+
+/**
+ * @brief 发送一个 UNSUBSCRIBE 报文，并将对应的消息处理器从列表中取出，收到 UNSUBACK 后销毁
+ *
+ * @param c MQTT 客户端结构体指针
+ * @param topic_filters 要取消订阅的主题过滤器
+ * @param count 主题数量
+ * @return int 成功返回本报文包含的主题数量，失败返回错误码
+ */
+static int mqtt_unsubscribe_packet(mqtt_client_t *c, const char **topic_filters, int count)
+{
+    int i, len = 0;
+    int rc = MQTT_FAILED_ERROR;
+    uint16_t packet_id;
+    platform_timer_t timer;
+    MQTTString filters[MQTT_SUBSCRIBE_BATCH_MAX];
+    message_handlers_t *ring = NULL, *msg_handler;
+
+    if (count > MQTT_SUBSCRIBE_BATCH_MAX)
+        count = MQTT_SUBSCRIBE_BATCH_MAX;
+
+    for (i = 0; i < count; i++) {
+        filters[i].cstring = (char *)topic_filters[i];
+        filters[i].lenstring.len = 0;
+        filters[i].lenstring.data = NULL;
+    }
+
     // 获取下一个报文 ID
     packet_id = mqtt_get_next_packet_id(c);
 
+    platform_timer_cutdown(&timer, c->mqtt_cmd_timeout);
+
     platform_mutex_lock(&c->mqtt_write_lock);
 
-    /* 序列化订阅报文并发送 */
-    len = MQTTSerialize_subscribe(c->mqtt_write_buf, c->mqtt_write_buf_size, 0, packet_id, 1, &topic, (int *)&qos);
-    if (len <= 0)
-        goto exit;
+    /* 序列化取消订阅报文，写缓冲区放不下时减少主题数量 */
+    while ((len = MQTTSerialize_unsubscribe(c->mqtt_write_buf, c->mqtt_write_buf_size, 0, packet_id, count, filters)) <= 0) {
+        if (--count <= 0)
+            goto exit;
+    }
 
-    if ((rc = mqtt_send_packet(c, len, &timer)) != MQTT_SUCCESS_ERROR)
-        goto exit;
+    /* 获取已订阅消息处理程序，从列表中取出串成环 */
+    for (i = 0; i < count; i++) {
+        msg_handler = mqtt_get_msg_handler(c, &filters[i]);
+        if (NULL == msg_handler)
+            continue;
 
-    // 如果 handler 为 NULL，则使用默认的消息处理函数
-    if (NULL == handler)
-        handler = default_msg_handler;
+        mqtt_list_del_init(&msg_handler->list);
+        if (NULL == ring)
+            ring = msg_handler;
+        else
+            mqtt_list_add_tail(&msg_handler->list, &ring->list);
+    }
 
-    /* 创建消息处理程序并记录 */
-    msg_handler = mqtt_msg_handler_create(topic_filter, qos, handler);
-    if (NULL == msg_handler)
+    /* 先记录 UNSUBACK 再发送，否则 UNSUBACK 可能在记录之前被接收线程处理 */
+    if (NULL != ring)
     {
-        rc = MQTT_MEM_NOT_ENOUGH_ERROR;
-        goto exit;
+        mqtt_topic_table_invalidate(c);
+
+        if ((rc = mqtt_ack_list_record(c, UNSUBACK, packet_id, len, ring)) != MQTT_SUCCESS_ERROR)
+            goto reinstall;
+    }
+
+    if ((rc = mqtt_send_packet(c, len, &timer)) != MQTT_SUCCESS_ERROR)
+    {
+        if (NULL != ring)
+            mqtt_ack_list_unrecord(c, UNSUBACK, packet_id, NULL);
+        goto reinstall;
     }
 
-    rc = mqtt_ack_list_record(c, SUBACK, packet_id, len, msg_handler);
+    if (NULL == ring)
+        rc = MQTT_MEM_NOT_ENOUGH_ERROR;
+
+    goto exit;
+
+reinstall:
+    /* 未能取消订阅，消息处理程序重新安装 */
+    while (NULL != (msg_handler = mqtt_msg_handler_ring_take(&ring)))
+        mqtt_msg_handlers_install(c, msg_handler);
 
 exit:
 
     platform_mutex_unlock(&c->mqtt_write_lock);
 
-    RETURN_ERROR(rc);
+    if (MQTT_SUCCESS_ERROR != rc)
+        RETURN_ERROR(rc);
+
+    return count;
 }
 
 /**
@@ -1711,43 +2959,34 @@ exit:
  */
 int mqtt_unsubscribe(mqtt_client_t *c, const char *topic_filter)
 {
-    int len = 0;
-    int rc = MQTT_FAILED_ERROR;
-    uint16_t packet_id;
-    platform_timer_t timer;
-    MQTTString topic = MQTTString_initializer;
-    topic.cstring = (char *)topic_filter;
-    message_handlers_t *msg_handler = NULL;
-
-    if (CLIENT_STATE_CONNECTED != mqtt_get_client_state(c))
-        RETURN_ERROR(MQTT_NOT_CONNECT_ERROR);
+    return mqtt_unsubscribe_many(c, &topic_filter, 1);
+}
 
-    // 获取下一个报文 ID
-    packet_id = mqtt_get_next_packet_id(c);
+/**
+ * @brief 取消订阅多个 MQTT 主题，主题被打包到尽可能少的 UNSUBSCRIBE 报文中
+ *
+ * @param c MQTT 客户端结构体指针
+ * @param topic_filters 要取消订阅的主题过滤器
+ * @param count 主题数量
+ * @return int 返回处理结果，可能是成功或失败的状态码
+ */
+int mqtt_unsubscribe_many(mqtt_client_t *c, const char **topic_filters, int count)
+{
+    int i, sent;
 
-    platform_mutex_lock(&c->mqtt_write_lock);
+    if ((NULL == c) || (NULL == topic_filters) || (count <= 0))
+        RETURN_ERROR(MQTT_NULL_VALUE_ERROR);
 
-    /* 序列化取消订阅报文并发送 */
-    if ((len = MQTTSerialize_unsubscribe(c->mqtt_write_buf, c->mqtt_write_buf_size, 0, packet_id, 1, &topic)) <= 0)
-        goto exit;
-    if ((rc = mqtt_send_packet(c, len, &timer)) != MQTT_SUCCESS_ERROR)
-        goto exit;
+    if (CLIENT_STATE_CONNECTED != mqtt_get_client_state(c))
+        RETURN_ERROR(MQTT_NOT_CONNECT_ERROR);
 
-    /* 获取已订阅消息处理程序 */
-    msg_handler = mqtt_get_msg_handler(c, &topic);
-    if (NULL == msg_handler)
-    {
-        rc = MQTT_MEM_NOT_ENOUGH_ERROR;
-        goto exit;
+    for (i = 0; i < count; i += sent) {
+        sent = mqtt_unsubscribe_packet(c, &topic_filters[i], count - i);
+        if (sent < 0)
+            RETURN_ERROR(sent);
     }
 
-    rc = mqtt_ack_list_record(c, UNSUBACK, packet_id, len, msg_handler);
-
-exit:
-
-    platform_mutex_unlock(&c->mqtt_write_lock);
-
-    RETURN_ERROR(rc);
+    RETURN_ERROR(MQTT_SUCCESS_ERROR);
 }
 
 /**
@@ -1756,28 +2995,28 @@ exit:
  * @param c MQTT 客户端结构体指针
  * @param topic_filter 发布的主题过滤器
  * @param msg MQTT 消息结构体指针，包含要发布的消息内容
+ * @param flags NETWORK_WRITE_ZEROCOPY 表示 QoS0 的负载可以零拷贝发送
  * @return int 返回处理结果，可能是成功或失败的状态码
  */
-int mqtt_publish(mqtt_client_t *c, const char *topic_filter, mqtt_message_t *msg)
+static int mqtt_publish_flags(mqtt_client_t *c, const char *topic_filter, mqtt_message_t *msg, int flags)
 {
     int len = 0;
     int rc = MQTT_FAILED_ERROR;
     platform_timer_t timer;
+    network_iovec_t iov[2];
     MQTTString topic = MQTTString_initializer;
     topic.cstring = (char *)topic_filter;
 
+    /* 此时还未持有写锁，不能跳转到 exit */
     if (CLIENT_STATE_CONNECTED != mqtt_get_client_state(c))
-    {
-        rc = MQTT_NOT_CONNECT_ERROR;
-        goto exit;
-    }
+        RETURN_ERROR(MQTT_NOT_CONNECT_ERROR);
 
     // 如果消息的 payload 存在且长度为 0，则根据字符串长度设置 payload 长度
     if ((NULL != msg->payload) && (0 == msg->payloadlen))
         msg->payloadlen = strlen((char *)msg->payload);
 
-    // 如果消息的 payload 长度大于客户端写缓冲区的大小，则报错并返回
-    if (msg->payloadlen > c->mqtt_write_buf_size)
+    // QoS1/QoS2 的报文需要完整保存用于重发，payload 长度大于客户端写缓冲区的大小时报错并返回
+    if ((QOS0 != msg->qos) && (msg->payloadlen > c->mqtt_write_buf_size))
     {
         MQTT_LOG_E("publish payload len is greater than client write buffer...");
         RETURN_ERROR(MQTT_BUFFER_TOO_SHORT_ERROR);
@@ -1796,6 +3035,23 @@ int mqtt_publish(mqtt_client_t *c, const char *topic_filter, mqtt_message_t *msg
         msg->id = mqtt_get_next_packet_id(c);
     }
 
+    /* QoS0 的报文不需要保存，只序列化报文头，payload 直接从调用者的缓冲区发送 */
+    if (QOS0 == msg->qos)
+    {
+        len = MQTTSerialize_publish_header(c->mqtt_write_buf, c->mqtt_write_buf_size, 0, QOS0, msg->retained, 0,
+                                           topic, msg->payloadlen);
+        if (len <= 0)
+            goto exit;
+
+        iov[0].iov_base = c->mqtt_write_buf;
+        iov[0].iov_len = len;
+        iov[1].iov_base = msg->payload;
+        iov[1].iov_len = msg->payloadlen;
+
+        rc = mqtt_send_packet_iov(c, iov, (msg->payloadlen > 0) ? 2 : 1, flags, &timer);
+        goto exit;
+    }
+
     /* 序列化发布报文并发送 */
     len = MQTTSerialize_publish(c->mqtt_write_buf, c->mqtt_write_buf_size, 0, msg->qos, msg->retained, msg->id,
                                 topic, (uint8_t *)msg->payload, msg->payloadlen);
@@ -1843,6 +3099,34 @@ exit:
     RETURN_ERROR(rc);
 }
 
+/**
+ * @brief 发布 MQTT 消息到指定主题。启用 MQTT_NETWORK_ZEROCOPY_MIN 后，QoS0 的负载可能零拷贝发送，
+ *        mqtt_get_zerocopy_pending() 返回 0 之前不能修改负载缓冲区
+ *
+ * @param c MQTT 客户端结构体指针
+ * @param topic_filter 发布的主题过滤器
+ * @param msg MQTT 消息结构体指针，包含要发布的消息内容
+ * @return int 返回处理结果，可能是成功或失败的状态码
+ */
+int mqtt_publish(mqtt_client_t *c, const char *topic_filter, mqtt_message_t *msg)
+{
+    return mqtt_publish_flags(c, topic_filter, msg, NETWORK_WRITE_ZEROCOPY);
+}
+
+/**
+ * @brief 发布 MQTT 消息到指定主题，负载总是复制发送，返回后即可修改负载缓冲区。
+ *        batch、shadow、rpc 等复用自己缓冲区的模块使用
+ *
+ * @param c MQTT 客户端结构体指针
+ * @param topic_filter 发布的主题过滤器
+ * @param msg MQTT 消息结构体指针，包含要发布的消息内容
+ * @return int 返回处理结果，可能是成功或失败的状态码
+ */
+int mqtt_publish_copy(mqtt_client_t *c, const char *topic_filter, mqtt_message_t *msg)
+{
+    return mqtt_publish_flags(c, topic_filter, msg, 0);
+}
+
 /**
  * @brief 列出已订阅的 MQTT 主题
  *
@@ -1874,6 +3158,146 @@ int mqtt_list_subscribe_topic(mqtt_client_t *c)
     RETURN_ERROR(MQTT_SUCCESS_ERROR);
 }
 
+/**
+ * @brief 添加一个服务器端点。添加了端点后，连接时按健康分数与权重选择端点，
+ *        连接失败立即切换到下一个健康的端点，mqtt_host/mqtt_port 不再使用
+ *
+ * @param c MQTT 客户端结构体指针
+ * @param host 服务器地址
+ * @param port 服务器端口
+ * @param ca CA 证书，不使用 TLS 时为 NULL
+ * @param weight 权重，分数相同时权重高的端点优先
+ * @return int 成功返回端点索引，失败返回错误码
+ */
+int mqtt_add_endpoint(mqtt_client_t *c, char *host, char *port, char *ca, uint8_t weight)
+{
+    int rc;
+
+    if (NULL == c)
+        RETURN_ERROR(MQTT_NULL_VALUE_ERROR);
+
+    platform_mutex_lock(&c->mqtt_write_lock);
+    rc = mqtt_endpoint_list_add(&c->mqtt_endpoint_list, host, port, ca, weight);
+    platform_mutex_unlock(&c->mqtt_write_lock);
+
+    return rc;
+}
+
+/**
+ * @brief 获取当前连接的端点索引
+ *
+ * @param c MQTT 客户端结构体指针
+ * @return int 端点索引，未使用端点列表时返回 -1
+ */
+int mqtt_get_endpoint(mqtt_client_t *c)
+{
+    if (NULL == c)
+        RETURN_ERROR(MQTT_NULL_VALUE_ERROR);
+
+    return c->mqtt_endpoint_list.curr;
+}
+
+/**
+ * @brief 将主题收录到主题表中并固定，固定的主题不会被淘汰，其编号在客户端释放前保持不变，
+ *        应用可在订阅前收录关心的主题，并在消息回调中根据 topic_id 分发
+ *
+ * @param c MQTT 客户端结构体指针
+ * @param topic 主题名，不支持通配符
+ * @return int 成功返回主题编号（1 ~ MQTT_TOPIC_TABLE_SIZE），失败返回错误码
+ */
+int mqtt_topic_intern(mqtt_client_t *c, const char *topic)
+{
+    int len;
+    mqtt_topic_entry_t *entry;
+
+    if ((NULL == c) || (NULL == topic))
+        RETURN_ERROR(MQTT_NULL_VALUE_ERROR);
+
+    len = strlen(topic);
+    if ((0 == len) || (len >= MQTT_TOPIC_LEN_MAX))
+        RETURN_ERROR(MQTT_FAILED_ERROR);
+
+    platform_mutex_lock(&c->mqtt_global_lock);
+    entry = mqtt_topic_table_get(c, topic, len);
+    if (NULL != entry)
+        entry->pinned = 1;
+    platform_mutex_unlock(&c->mqtt_global_lock);
+
+    if (NULL == entry)
+        RETURN_ERROR(MQTT_MEM_NOT_ENOUGH_ERROR);
+
+    return (int)(entry - c->mqtt_topic_table) + 1;
+}
+
+/**
+ * @brief 根据主题编号获取主题名
+ *
+ * @param c MQTT 客户端结构体指针
+ * @param topic_id 主题编号
+ * @return const char* 主题名，编号无效时返回 NULL
+ */
+const char *mqtt_topic_name(mqtt_client_t *c, uint16_t topic_id)
+{
+    if ((NULL == c) || (MQTT_TOPIC_ID_NONE == topic_id) || (topic_id > MQTT_TOPIC_TABLE_SIZE))
+        return NULL;
+
+    if (0 == c->mqtt_topic_table[topic_id - 1].len)
+        return NULL;
+
+    return c->mqtt_topic_table[topic_id - 1].name;
+}
+
+/**
+ * @brief 获取 ACK 处理器与消息处理器内存池的使用统计，高水位与未命中次数可用于调整内存池大小
+ *
+ * @param c MQTT 客户端结构体指针
+ * @param ack_stats ACK 处理器内存池统计，可为 NULL
+ * @param msg_stats 消息处理器内存池统计，可为 NULL
+ * @return int 返回处理结果，可能是成功或失败的状态码
+ */
+int mqtt_get_handler_pool_stats(mqtt_client_t *c, mqtt_pool_stats_t *ack_stats, mqtt_pool_stats_t *msg_stats)
+{
+    if (NULL == c)
+        RETURN_ERROR(MQTT_NULL_VALUE_ERROR);
+
+    platform_mutex_lock(&c->mqtt_global_lock);
+    mqtt_pool_get_stats(&c->mqtt_ack_handler_pool, ack_stats);
+    mqtt_pool_get_stats(&c->mqtt_msg_handler_pool, msg_stats);
+    platform_mutex_unlock(&c->mqtt_global_lock);
+
+    RETURN_ERROR(MQTT_SUCCESS_ERROR);
+}
+
+/**
+ * @brief 获取 TLS 握手统计，resumed 为重连时通过会话恢复完成的简化握手次数
+ *
+ * @param c MQTT 客户端结构体指针
+ * @param stats 输出握手统计
+ * @return int 返回处理结果，可能是成功或失败的状态码
+ */
+int mqtt_get_tls_stats(mqtt_client_t *c, network_tls_stats_t *stats)
+{
+    if ((NULL == c) || (NULL == c->mqtt_network))
+        RETURN_ERROR(MQTT_NULL_VALUE_ERROR);
+
+    return network_get_tls_stats(c->mqtt_network, stats);
+}
+
+/**
+ * @brief 获取内核仍在读取的零拷贝发送数量。启用 MQTT_NETWORK_ZEROCOPY_MIN 后，
+ *        QoS0 消息的负载在 mqtt_publish 返回后仍由内核直接读取，返回 0 之前不能修改负载缓冲区
+ *
+ * @param c MQTT 客户端结构体指针
+ * @return int 未完成的零拷贝发送数量，失败返回错误码
+ */
+int mqtt_get_zerocopy_pending(mqtt_client_t *c)
+{
+    if ((NULL == c) || (NULL == c->mqtt_network))
+        RETURN_ERROR(MQTT_NULL_VALUE_ERROR);
+
+    return network_zerocopy_pending(c->mqtt_network);
+}
+
 /**
  * @brief 设置 MQTT 遗嘱消息选项
  *
@@ -1891,7 +3315,11 @@ int mqtt_set_will_options(mqtt_client_t *c, char *topic, mqtt_qos_t qos, uint8_t
 
     if (NULL == c->mqtt_will_options)
     {
+#ifdef MQTT_STATIC_ALLOCATION
+        c->mqtt_will_options = &((mqtt_client_static_t *)c)->will_options;
+#else
         c->mqtt_will_options = (mqtt_will_options_t *)platform_memory_alloc(sizeof(mqtt_will_options_t));
+#endif
         MQTT_ROBUSTNESS_CHECK(c->mqtt_will_options, MQTT_MEM_NOT_ENOUGH_ERROR);
     }
 
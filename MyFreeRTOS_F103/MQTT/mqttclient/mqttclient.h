@@ -14,6 +14,9 @@
 
 #include "MQTTPacket.h"
 #include "mqtt_list.h"
+#include "mqtt_pool.h"
+#include "mqtt_endpoint.h"
+#include "mqtt_qos2.h"
 #include "platform_timer.h"
 #include "platform_memory.h"
 #include "platform_mutex.h"
@@ -66,14 +69,27 @@ typedef struct mqtt_message {
     void                *payload;
 } mqtt_message_t;
 
+/* topic_id 为主题在客户端主题表中的编号（1 ~ MQTT_TOPIC_TABLE_SIZE），0 表示主题未被收录。
+ * 编号交给应用后在客户端释放前不会再指向其他主题，主题表被占满后新出现的主题编号为 0 */
+#define     MQTT_TOPIC_ID_NONE      0
+
 typedef struct message_data {
-    char                topic_name[MQTT_TOPIC_LEN_MAX];
+    const char          *topic_name;
+    uint16_t            topic_len;
+    uint16_t            topic_id;
     mqtt_message_t      *message;
 } message_data_t;
 
 typedef void (*interceptor_handler_t)(void* client, message_data_t* msg);
 typedef void (*message_handler_t)(void* client, message_data_t* msg);
+
+typedef struct mqtt_subscribe_topic {
+    const char          *topic_filter;
+    mqtt_qos_t          qos;
+    message_handler_t   handler;
+} mqtt_subscribe_topic_t;
 typedef void (*reconnect_handler_t)(void* client, void* reconnect_date);
+typedef void (*disconnect_handler_t)(void* client, void* disconnect_data);
 
 dcl_class(mqtt_connack_data_t)
 def_class(mqtt_connack_data_t,
@@ -106,6 +122,19 @@ def_class(ack_handlers_t,
     )
 )
 
+dcl_class(mqtt_topic_entry_t)
+def_class(mqtt_topic_entry_t,
+    private_member(
+        char                name[MQTT_TOPIC_LEN_MAX];
+        uint16_t            len;
+        uint8_t             pinned;             /* 编号已交给应用，不再淘汰 */
+        uint32_t            hash;
+        uint32_t            last_used;
+        uint32_t            handler_gen;
+        message_handlers_t  *handler;
+    )
+)
+
 dcl_class(mqtt_will_options_t)
 def_class(mqtt_will_options_t,
     private_member(
@@ -125,7 +154,9 @@ def_class(mqtt_client_t,
         char                        *mqtt_host;
         char                        *mqtt_port;
         char                        *mqtt_ca;
+        network_tls_context_t       *mqtt_tls_context;
         void                        *mqtt_reconnect_data;
+        void                        *mqtt_disconnect_data;
         uint8_t                     *mqtt_read_buf;
         uint8_t                     *mqtt_write_buf;
         uint16_t                    mqtt_keep_alive_interval;
@@ -133,8 +164,9 @@ def_class(mqtt_client_t,
         uint32_t                    mqtt_will_flag          : 1;
         uint32_t                    mqtt_clean_session      : 1;
         uint32_t                    mqtt_ping_outstanding   : 2;
+        uint32_t                    mqtt_session_present    : 1;
         uint32_t                    mqtt_version            : 4;
-        uint32_t                    mqtt_ack_handler_number : 24;
+        uint32_t                    mqtt_ack_handler_number : 23;
         uint32_t                    mqtt_cmd_timeout;
         uint32_t                    mqtt_read_buf_size;
         uint32_t                    mqtt_write_buf_size;
@@ -153,10 +185,47 @@ def_class(mqtt_client_t,
         platform_timer_t            mqtt_last_sent;
         platform_timer_t            mqtt_last_received;
         reconnect_handler_t         mqtt_reconnect_handler;
+        disconnect_handler_t        mqtt_disconnect_handler;
         interceptor_handler_t       mqtt_interceptor_handler;
+        mqtt_pool_t                 mqtt_msg_handler_pool;
+        mqtt_pool_t                 mqtt_ack_handler_pool;
+        void                        *mqtt_handler_pool_storage;
+        uint32_t                    mqtt_topic_clock;
+        uint32_t                    mqtt_handler_gen;
+        mqtt_topic_entry_t          mqtt_topic_table[MQTT_TOPIC_TABLE_SIZE];
+        mqtt_endpoint_list_t        mqtt_endpoint_list;
+        uint32_t                    mqtt_standby;
+        int                         mqtt_standby_index;
+        int                         mqtt_standby_connecting;
+        network_t                   mqtt_standby_network;
+        platform_timer_t            mqtt_standby_timer;
+        mqtt_qos2_t                 mqtt_qos2;
+        int                         mqtt_connect_phase;
+        int                         mqtt_connack_len;
+        int                         mqtt_connect_index;
+        uint32_t                    mqtt_connect_tried;
+        platform_timer_t            mqtt_connect_timer;
     )
 )
 
+/* ack 处理器内存池的块大小，块内保存待重发报文 */
+#define MQTT_ACK_HANDLER_POOL_BLOCK_SIZE    (sizeof(ack_handlers_t) + MQTT_ACK_HANDLER_POOL_PAYLOAD_SIZE)
+
+#ifdef MQTT_STATIC_ALLOCATION
+
+typedef struct mqtt_client_static {
+    mqtt_client_t               client;         /* must be the first member */
+    network_t                   network;
+    mqtt_will_options_t         will_options;
+    platform_thread_static_t    thread;
+    uint32_t                    thread_stack[(MQTT_STATIC_THREAD_STACK_SIZE + 3) / 4];     /* MQTT_STATIC_THREAD_STACK_SIZE 字节，按字对齐 */
+    uint8_t                     read_buf[MQTT_STATIC_READ_BUF_SIZE];
+    uint8_t                     write_buf[MQTT_STATIC_WRITE_BUF_SIZE];
+    void                        *msg_handler_storage[MQTT_POOL_STORAGE_LEN(sizeof(message_handlers_t), MQTT_MSG_HANDLER_POOL_NUM)];
+    void                        *ack_handler_storage[MQTT_POOL_STORAGE_LEN(MQTT_ACK_HANDLER_POOL_BLOCK_SIZE, MQTT_ACK_HANDLER_POOL_NUM)];
+} mqtt_client_static_t;
+#endif
+
 
 #define MQTT_ROBUSTNESS_CHECK(item, err) if (!(item)) {                                         \
         MQTT_LOG_E("%s:%d %s()... check for error.", __FILE__, __LINE__, __FUNCTION__);         \
@@ -172,12 +241,22 @@ def_class(mqtt_client_t,
 #define MQTT_CLIENT_SET_STATEMENT(name, type)           \
     type mqtt_set_##name(mqtt_client_t *, type);
 
+#define MQTT_CLIENT_GET_DEFINE(name, type, res)         \
+    type mqtt_get_##name(mqtt_client_t *c) {            \
+        MQTT_ROBUSTNESS_CHECK((c), res);                \
+        return c->mqtt_##name;                          \
+    }
+
+#define MQTT_CLIENT_GET_STATEMENT(name, type)           \
+    type mqtt_get_##name(mqtt_client_t *);
+
 MQTT_CLIENT_SET_STATEMENT(client_id, char*)
 MQTT_CLIENT_SET_STATEMENT(user_name, char*)
 MQTT_CLIENT_SET_STATEMENT(password, char*)
 MQTT_CLIENT_SET_STATEMENT(host, char*)
 MQTT_CLIENT_SET_STATEMENT(port, char*)
 MQTT_CLIENT_SET_STATEMENT(ca, char*)
+MQTT_CLIENT_SET_STATEMENT(tls_context, network_tls_context_t*)
 MQTT_CLIENT_SET_STATEMENT(reconnect_data, void*)
 MQTT_CLIENT_SET_STATEMENT(keep_alive_interval, uint16_t)
 MQTT_CLIENT_SET_STATEMENT(will_flag, uint32_t)
@@ -188,18 +267,43 @@ MQTT_CLIENT_SET_STATEMENT(read_buf_size, uint32_t)
 MQTT_CLIENT_SET_STATEMENT(write_buf_size, uint32_t)
 MQTT_CLIENT_SET_STATEMENT(reconnect_try_duration, uint32_t)
 MQTT_CLIENT_SET_STATEMENT(reconnect_handler, reconnect_handler_t)
+MQTT_CLIENT_SET_STATEMENT(disconnect_data, void*)
+MQTT_CLIENT_SET_STATEMENT(disconnect_handler, disconnect_handler_t)
 MQTT_CLIENT_SET_STATEMENT(interceptor_handler, interceptor_handler_t)
+MQTT_CLIENT_SET_STATEMENT(standby, uint32_t)
+
+MQTT_CLIENT_GET_STATEMENT(reconnect_data, void*)
+MQTT_CLIENT_GET_STATEMENT(reconnect_handler, reconnect_handler_t)
+MQTT_CLIENT_GET_STATEMENT(disconnect_data, void*)
+MQTT_CLIENT_GET_STATEMENT(disconnect_handler, disconnect_handler_t)
 
 void mqtt_sleep_ms(int ms);
+#ifdef MQTT_STATIC_ALLOCATION
+mqtt_client_t *mqtt_lease_static(mqtt_client_static_t *s);
+#else
 mqtt_client_t *mqtt_lease(void);
+#endif
 int mqtt_release(mqtt_client_t* c);
 int mqtt_connect(mqtt_client_t* c);
+int mqtt_connect_start(mqtt_client_t* c);
+int mqtt_connect_continue(mqtt_client_t* c);
+int mqtt_connect_want(mqtt_client_t* c, int* socket);
 int mqtt_disconnect(mqtt_client_t* c);
 int mqtt_keep_alive(mqtt_client_t* c);
 int mqtt_subscribe(mqtt_client_t* c, const char* topic_filter, mqtt_qos_t qos, message_handler_t msg_handler);
 int mqtt_unsubscribe(mqtt_client_t* c, const char* topic_filter);
+int mqtt_subscribe_many(mqtt_client_t* c, const mqtt_subscribe_topic_t* topics, int count);
+int mqtt_unsubscribe_many(mqtt_client_t* c, const char** topic_filters, int count);
 int mqtt_publish(mqtt_client_t* c, const char* topic_filter, mqtt_message_t* msg);
+int mqtt_publish_copy(mqtt_client_t* c, const char* topic_filter, mqtt_message_t* msg);
 int mqtt_list_subscribe_topic(mqtt_client_t* c);
+int mqtt_add_endpoint(mqtt_client_t* c, char* host, char* port, char* ca, uint8_t weight);
+int mqtt_get_endpoint(mqtt_client_t* c);
+int mqtt_topic_intern(mqtt_client_t* c, const char* topic);
+const char *mqtt_topic_name(mqtt_client_t* c, uint16_t topic_id);
+int mqtt_get_handler_pool_stats(mqtt_client_t* c, mqtt_pool_stats_t* ack_stats, mqtt_pool_stats_t* msg_stats);
+int mqtt_get_tls_stats(mqtt_client_t* c, network_tls_stats_t* stats);
+int mqtt_get_zerocopy_pending(mqtt_client_t* c);
 int mqtt_set_will_options(mqtt_client_t* c, char *topic, mqtt_qos_t qos, uint8_t retained, char *message);
 
 #ifdef __cplusplus
@@ -0,0 +1,29 @@
+/*
+ * @Date: 2026-10-19
+ * @Description: low-memory tls profile, applied on top of the mbedtls configuration with
+ *               -DMBEDTLS_USER_CONFIG_FILE='"config-mqtt-lowmem.h"'.
+ *
+ * - records are limited with max_fragment_length, derived from MBEDTLS_SSL_IN_CONTENT_LEN by
+ *   MQTT_TLS_MAX_FRAG_LEN; the broker must honour the extension, and the server certificate
+ *   chain must fit in one input record since mbedtls does not reassemble tls handshake messages
+ * - all mbedtls allocations come from a static arena of MQTT_TLS_ARENA_SIZE bytes instead of the
+ *   general heap, MBEDTLS_MEMORY_DEBUG keeps the current and peak usage for network_get_tls_memory()
+ * - the arena is shared by every connection, so mbedtls mutexes are mapped onto platform_mutex
+ */
+#ifndef MBEDTLS_CONFIG_MQTT_LOWMEM_H
+#define MBEDTLS_CONFIG_MQTT_LOWMEM_H
+
+#define MBEDTLS_SSL_MAX_FRAGMENT_LENGTH
+
+#undef MBEDTLS_SSL_IN_CONTENT_LEN
+#undef MBEDTLS_SSL_OUT_CONTENT_LEN
+#define MBEDTLS_SSL_IN_CONTENT_LEN              4096
+#define MBEDTLS_SSL_OUT_CONTENT_LEN             2048        /* MQTT_DEFAULT_BUF_SIZE and headroom */
+
+#define MBEDTLS_MEMORY_BUFFER_ALLOC_C
+#define MBEDTLS_MEMORY_DEBUG
+
+#define MBEDTLS_THREADING_C
+#define MBEDTLS_THREADING_ALT                               /* wrapper/threading_alt.c */
+
+#endif /* MBEDTLS_CONFIG_MQTT_LOWMEM_H */
@@ -0,0 +1,57 @@
+/*
+ * @Date: 2026-10-19
+ * @Description: minimal mbedtls configuration for the mqttclient psk mode, TLS 1.2 client with
+ *               TLS-PSK-WITH-AES-128-CCM-8 only. No bignum, no PK, no X509.
+ *
+ * build with -DMBEDTLS_CONFIG_FILE='"config-mqtt-psk.h"' and set the psk with network_set_psk()
+ * or a tls context created from psk credentials.
+ */
+#ifndef MBEDTLS_CONFIG_H
+#define MBEDTLS_CONFIG_H
+
+/* System support */
+#define MBEDTLS_PLATFORM_MEMORY         /* calloc/free come from platform_memory */
+#define MBEDTLS_NO_PLATFORM_ENTROPY     /* entropy comes from random.c through nettype_tls */
+#define MBEDTLS_TIMING_ALT              /* wrapper/timing_alt.c */
+
+/* mbed TLS feature support */
+#define MBEDTLS_KEY_EXCHANGE_PSK_ENABLED
+#define MBEDTLS_SSL_PROTO_TLS1_2
+#define MBEDTLS_SSL_MAX_FRAGMENT_LENGTH
+#define MBEDTLS_SSL_SESSION_TICKETS     /* cheap with psk and saves a round trip on reconnect */
+
+/* mbed TLS modules, the socket layer is wrapper/net_sockets_alt.c so MBEDTLS_NET_C stays off */
+#define MBEDTLS_AES_C
+#define MBEDTLS_CCM_C
+#define MBEDTLS_CIPHER_C
+#define MBEDTLS_CTR_DRBG_C
+#define MBEDTLS_ENTROPY_C
+#define MBEDTLS_MD_C
+#define MBEDTLS_PLATFORM_C
+#define MBEDTLS_SHA256_C
+#define MBEDTLS_SSL_CLI_C
+#define MBEDTLS_SSL_TLS_C
+#define MBEDTLS_TIMING_C
+
+/* Save RAM at the expense of ROM */
+#define MBEDTLS_AES_ROM_TABLES
+#define MBEDTLS_AES_FEWER_TABLES
+
+/* 128-bit keys */
+#define MBEDTLS_PSK_MAX_LEN             16
+
+/* only the source added by nettype_tls */
+#define MBEDTLS_ENTROPY_MAX_SOURCES     2
+
+/* must match MQTT_TLS_PSK_CIPHERSUITE */
+#define MBEDTLS_SSL_CIPHERSUITES        MBEDTLS_TLS_PSK_WITH_AES_128_CCM_8
+
+/*
+ * Record buffers dominate the RAM of a connection. 2048 bytes covers MQTT_DEFAULT_BUF_SIZE with
+ * room to spare; the broker must accept max_fragment_length or be configured to send smaller records.
+ */
+#define MBEDTLS_SSL_MAX_CONTENT_LEN     2048
+
+#include "mbedtls/check_config.h"
+
+#endif /* MBEDTLS_CONFIG_H */
@@ -763,6 +763,21 @@
  */
 //#define MBEDTLS_ECP_RESTARTABLE
 
+/**
+ * \def MBEDTLS_ECDH_PRECOMPUTED
+ *
+ * Let mbedtls_ecdh_make_public() take an ephemeral key pair computed ahead
+ * of time instead of generating one on the spot.
+ *
+ * The key pairs come from a callback registered with
+ * mbedtls_ecdh_set_precomputed(); without a callback, or when the callback
+ * has no key pair for the group, a key pair is generated as usual. Only the
+ * side that sends its public value last (the TLS client) is affected.
+ *
+ * Uncomment this macro to enable precomputed ECDH key pairs.
+ */
+//#define MBEDTLS_ECDH_PRECOMPUTED
+
 /**
  * \def MBEDTLS_ECDSA_DETERMINISTIC
  *
@@ -433,6 +433,23 @@ int mbedtls_ecdh_calc_secret( mbedtls_ecdh_context *ctx, size_t *olen,
 void mbedtls_ecdh_enable_restart( mbedtls_ecdh_context *ctx );
 #endif /* MBEDTLS_ECP_RESTARTABLE */
 
+#if defined(MBEDTLS_ECDH_PRECOMPUTED)
+/**
+ * \brief           This function sets the source of ephemeral key pairs
+ *                  computed ahead of time, used by mbedtls_ecdh_make_public().
+ *
+ * \param f_take    The callback. It receives the group of the exchange and
+ *                  moves a fresh key pair into \p d and \p Q, returning \c 0,
+ *                  or returns non-zero to have the key pair generated as
+ *                  usual. A key pair must never be handed out twice. It may
+ *                  be called from several threads at once. Pass \c NULL to
+ *                  remove the source.
+ */
+void mbedtls_ecdh_set_precomputed( int (*f_take)( mbedtls_ecp_group_id grp_id,
+                                                  mbedtls_mpi *d,
+                                                  mbedtls_ecp_point *Q ) );
+#endif /* MBEDTLS_ECDH_PRECOMPUTED */
+
 #ifdef __cplusplus
 }
 #endif
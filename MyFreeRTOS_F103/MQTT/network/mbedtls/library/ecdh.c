@@ -49,6 +49,18 @@
 typedef mbedtls_ecdh_context mbedtls_ecdh_context_mbed;
 #endif
 
+#if defined(MBEDTLS_ECDH_PRECOMPUTED)
+static int (*ecdh_precomputed_take)( mbedtls_ecp_group_id, mbedtls_mpi *,
+                                     mbedtls_ecp_point * ) = NULL;
+
+void mbedtls_ecdh_set_precomputed( int (*f_take)( mbedtls_ecp_group_id grp_id,
+                                                  mbedtls_mpi *d,
+                                                  mbedtls_ecp_point *Q ) )
+{
+    ecdh_precomputed_take = f_take;
+}
+#endif /* MBEDTLS_ECDH_PRECOMPUTED */
+
 static mbedtls_ecp_group_id mbedtls_ecdh_grp_id(
     const mbedtls_ecdh_context *ctx )
 {
@@ -506,6 +518,19 @@ static int ecdh_make_public_internal( mbedtls_ecdh_context_mbed *ctx,
     (void) restart_enabled;
 #endif
 
+#if defined(MBEDTLS_ECDH_PRECOMPUTED)
+    /* Only at the start, a resumed multiplication already has its key */
+    if( ecdh_precomputed_take != NULL &&
+#if defined(MBEDTLS_ECP_RESTARTABLE)
+        ( rs_ctx == NULL || rs_ctx->rsm == NULL ) &&
+#endif
+        ecdh_precomputed_take( ctx->grp.id, &ctx->d, &ctx->Q ) == 0 )
+    {
+        return mbedtls_ecp_tls_write_point( &ctx->grp, &ctx->Q, point_format,
+                                            olen, buf, blen );
+    }
+#endif /* MBEDTLS_ECDH_PRECOMPUTED */
+
 #if defined(MBEDTLS_ECP_RESTARTABLE)
     if( ( ret = ecdh_gen_public_restartable( &ctx->grp, &ctx->d, &ctx->Q,
                                              f_rng, p_rng, rs_ctx ) ) != 0 )
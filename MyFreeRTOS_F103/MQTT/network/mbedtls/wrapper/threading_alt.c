@@ -0,0 +1,57 @@
+/*
+ * @Date: 2026-10-19
+ * @Description: mbedtls mutexes on top of platform_mutex, used when MBEDTLS_THREADING_ALT is enabled.
+ */
+#if !defined(MBEDTLS_CONFIG_FILE)
+#include "mbedtls/config.h"
+#else
+#include MBEDTLS_CONFIG_FILE
+#endif
+
+#if defined(MBEDTLS_THREADING_ALT)
+
+#include "mbedtls/threading.h"
+
+/* platform_mutex_lock/unlock report success differently on each platform, so only validity is checked */
+static void threading_alt_mutex_init(mbedtls_threading_mutex_t *mutex)
+{
+    if (mutex == NULL)
+        return;
+
+    mutex->is_valid = (platform_mutex_init(&mutex->mutex) == 0);
+}
+
+static void threading_alt_mutex_free(mbedtls_threading_mutex_t *mutex)
+{
+    if ((mutex == NULL) || (!mutex->is_valid))
+        return;
+
+    platform_mutex_destroy(&mutex->mutex);
+    mutex->is_valid = 0;
+}
+
+static int threading_alt_mutex_lock(mbedtls_threading_mutex_t *mutex)
+{
+    if ((mutex == NULL) || (!mutex->is_valid))
+        return MBEDTLS_ERR_THREADING_BAD_INPUT_DATA;
+
+    platform_mutex_lock(&mutex->mutex);
+    return 0;
+}
+
+static int threading_alt_mutex_unlock(mbedtls_threading_mutex_t *mutex)
+{
+    if ((mutex == NULL) || (!mutex->is_valid))
+        return MBEDTLS_ERR_THREADING_BAD_INPUT_DATA;
+
+    platform_mutex_unlock(&mutex->mutex);
+    return 0;
+}
+
+void mbedtls_threading_platform_setup(void)
+{
+    mbedtls_threading_set_alt(threading_alt_mutex_init, threading_alt_mutex_free,
+                              threading_alt_mutex_lock, threading_alt_mutex_unlock);
+}
+
+#endif /* MBEDTLS_THREADING_ALT */
@@ -0,0 +1,25 @@
+/*
+ * @Date: 2026-10-19
+ * @Description: mbedtls mutexes on top of platform_mutex, used when MBEDTLS_THREADING_ALT is enabled.
+ */
+#ifndef _THREADING_ALT_H_
+#define _THREADING_ALT_H_
+
+#include "platform_mutex.h"
+
+/**
+ * @brief   mutex structure
+ */
+typedef struct mbedtls_threading_mutex_t {
+    platform_mutex_t    mutex;
+    char                is_valid;
+} mbedtls_threading_mutex_t;
+
+/**
+ * @brief   Install the platform mutexes into mbedtls.
+ *          Must be called before any mbedtls context that owns a mutex is initialised
+ *          (entropy, ctr_drbg, memory_buffer_alloc, ...).
+ */
+void mbedtls_threading_platform_setup(void);
+
+#endif /* _THREADING_ALT_H_ */
@@ -0,0 +1,97 @@
+/*
+ * @Date: 2026-10-19
+ * @Description: shared-memory ring transport for high-rate producers on the same host.
+ */
+#include <string.h>
+#include "mqtt_log.h"
+#include "nettype_shm.h"
+
+#ifdef PLATFORM_NET_PROTO_SHM
+
+/**
+ * @brief 从共享内存环形缓冲区读取数据。
+ *
+ * @param n 指向网络对象的指针，n->socket 为共享内存通道的句柄。
+ * @param read_buf 存储读取数据的缓冲区。
+ * @param len 要读取的数据长度。
+ * @param timeout 超时时间，单位为毫秒。
+ * @return int 成功时返回读取的字节数，对端关闭时返回-1。
+ */
+int nettype_shm_read(network_t *n, unsigned char *read_buf, int len, int timeout)
+{
+    return platform_shm_ring_read(n->socket, read_buf, len, timeout);
+}
+
+/**
+ * @brief 等待共享内存环形缓冲区中有数据可读，先自旋，超过 MQTT_NETWORK_SHM_SPIN 次后才睡眠等待唤醒。
+ *
+ * @param n 指向网络对象的指针。
+ * @param timeout 超时时间，单位为毫秒。
+ * @return int 可读时返回正数，超时返回0，对端关闭时返回负数。
+ */
+int nettype_shm_wait(network_t *n, int timeout)
+{
+    return platform_shm_ring_wait(n->socket, timeout);
+}
+
+/**
+ * @brief 向共享内存环形缓冲区写入数据。
+ *
+ * @param n 指向网络对象的指针。
+ * @param write_buf 要写入的数据缓冲区。
+ * @param len 要写入的数据长度。
+ * @param timeout 超时时间，单位为毫秒。
+ * @return int 成功时返回写入的字节数，失败时返回错误码。
+ */
+int nettype_shm_write(network_t *n, unsigned char *write_buf, int len, int timeout)
+{
+    return platform_shm_ring_write(n->socket, write_buf, len, timeout);
+}
+
+/**
+ * @brief 将多段数据写入共享内存环形缓冲区，所有数据段拷贝完成后只更新一次写指针。
+ *
+ * @param n 指向网络对象的指针。
+ * @param iov 数据段数组。
+ * @param iovcnt 数据段数量。
+ * @param timeout 超时时间，单位为毫秒。
+ * @return int 成功时返回写入的字节数，失败时返回错误码。
+ */
+int nettype_shm_writev(network_t *n, const network_iovec_t *iov, int iovcnt, int timeout)
+{
+    return platform_shm_ring_writev(n->socket, iov, iovcnt, timeout);
+}
+
+/**
+ * @brief 连接到服务端创建的共享内存段，n->host 为 "shm:<name>" 或段名。
+ *
+ * @param n 指向网络对象的指针。
+ * @return int 成功时返回MQTT_SUCCESS_ERROR，失败时返回错误码。
+ */
+int nettype_shm_connect(network_t *n)
+{
+    const char *name = n->host;
+
+    if ((NULL != name) && (0 == strncmp(name, NETWORK_SHM_PREFIX, sizeof(NETWORK_SHM_PREFIX) - 1)))
+        name += sizeof(NETWORK_SHM_PREFIX) - 1;
+
+    n->socket = platform_shm_ring_connect(name);
+    if (n->socket < 0)
+        RETURN_ERROR(n->socket);
+
+    RETURN_ERROR(MQTT_SUCCESS_ERROR);
+}
+
+/**
+ * @brief 断开共享内存通道，对端随后读取时会得到连接关闭。
+ *
+ * @param n 指向网络对象的指针。
+ */
+void nettype_shm_disconnect(network_t *n)
+{
+    if (NULL != n)
+        platform_shm_ring_close(n->socket);
+    n->socket = -1;
+}
+
+#endif /* PLATFORM_NET_PROTO_SHM */
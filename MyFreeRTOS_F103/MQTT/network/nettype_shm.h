@@ -0,0 +1,36 @@
+/*
+ * @Date: 2026-10-19
+ * @Description: shared-memory ring transport for high-rate producers on the same host.
+ */
+#ifndef _NETTYPE_SHM_H_
+#define _NETTYPE_SHM_H_
+
+#include "platform_net_socket.h"
+#include "network.h"
+#include "mqtt_error.h"
+
+/* 只有提供了 PLATFORM_NET_PROTO_SHM 的平台才支持共享内存通道 */
+#ifdef PLATFORM_NET_PROTO_SHM
+#include "platform_shm_ring.h"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifdef PLATFORM_NET_PROTO_SHM
+
+int nettype_shm_read(network_t *n, unsigned char *buf, int len, int timeout);
+int nettype_shm_wait(network_t *n, int timeout);
+int nettype_shm_write(network_t *n, unsigned char *buf, int len, int timeout);
+int nettype_shm_writev(network_t *n, const network_iovec_t *iov, int iovcnt, int timeout);
+int nettype_shm_connect(network_t* n);
+void nettype_shm_disconnect(network_t* n);
+
+#endif /* PLATFORM_NET_PROTO_SHM */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -7,6 +7,7 @@
  */
 #include "mqtt_log.h"
 #include "nettype_tcp.h"
+#include "platform_timer.h"
 
 /**
  * @brief 读取TCP数据。
@@ -22,6 +23,18 @@ int nettype_tcp_read(network_t *n, unsigned char *read_buf, int len, int timeout
     return platform_net_socket_recv_timeout(n->socket, read_buf, len, timeout);
 }
 
+/**
+ * @brief 等待TCP数据可读。
+ *
+ * @param n 指向网络对象的指针。
+ * @param timeout 超时时间，单位为毫秒。
+ * @return int 可读时返回正数，超时返回0，失败时返回负数。
+ */
+int nettype_tcp_wait(network_t *n, int timeout)
+{
+    return platform_net_socket_wait(n->socket, PLATFORM_NET_WAIT_READ, timeout);
+}
+
 /**
  * @brief 写入TCP数据。
  *
@@ -36,6 +49,43 @@ int nettype_tcp_write(network_t *n, unsigned char *write_buf, int len, int timeo
     return platform_net_socket_write_timeout(n->socket, write_buf, len, timeout);
 }
 
+/**
+ * @brief 将多段数据一次写入TCP连接，调用者允许时达到 MQTT_NETWORK_ZEROCOPY_MIN 的数据使用零拷贝发送。
+ *
+ * @param n 指向网络对象的指针。
+ * @param iov 数据段数组。
+ * @param iovcnt 数据段数量。
+ * @param flags NETWORK_WRITE_ZEROCOPY 表示第一段之后的数据可以零拷贝发送。
+ * @param timeout 超时时间，单位为毫秒。
+ * @return int 成功时返回写入的字节数，失败时返回错误码。
+ */
+int nettype_tcp_writev(network_t *n, const network_iovec_t *iov, int iovcnt, int flags, int timeout)
+{
+#if MQTT_NETWORK_ZEROCOPY_MIN > 0
+    int i, len, rc;
+    size_t total = 0;
+    platform_timer_t timer;
+
+    for (i = 1; i < iovcnt; i++)
+        total += iov[i].iov_len;
+
+    /* 第一段是客户端写缓冲区中的报文头，下一个报文会覆盖它，复制发送；只有其后的数据使用零拷贝 */
+    if ((flags & NETWORK_WRITE_ZEROCOPY) && (iovcnt > 1) && (total >= MQTT_NETWORK_ZEROCOPY_MIN)) {
+        platform_timer_cutdown(&timer, timeout);
+
+        len = platform_net_socket_writev(n->socket, iov, 1, PLATFORM_NET_SEND_MORE, timeout);
+        if (len != (int)iov[0].iov_len)
+            return len;
+
+        rc = platform_net_socket_writev(n->socket, iov + 1, iovcnt - 1, PLATFORM_NET_SEND_ZEROCOPY, platform_timer_remain(&timer));
+        return (rc < 0) ? len : len + rc;
+    }
+#endif
+
+    (void)flags;
+    return platform_net_socket_writev(n->socket, iov, iovcnt, 0, timeout);
+}
+
 /**
  * @brief 连接到TCP服务器。
  *
@@ -51,6 +101,44 @@ int nettype_tcp_connect(network_t *n)
     RETURN_ERROR(MQTT_SUCCESS_ERROR);
 }
 
+/**
+ * @brief 开始连接TCP服务器，不等待连接完成。
+ *
+ * @param n 指向网络对象的指针。
+ * @return int 已连接返回MQTT_SUCCESS_ERROR，仍在进行中返回MQTT_WOULD_BLOCK_ERROR，失败时返回错误码。
+ */
+int nettype_tcp_connect_start(network_t *n)
+{
+    n->socket = platform_net_socket_connect_start(n->host, n->port, PLATFORM_NET_PROTO_TCP);
+    if (n->socket < 0)
+        RETURN_ERROR(n->socket);
+
+    n->want = NETWORK_WANT_WRITE;
+    return nettype_tcp_connect_continue(n);
+}
+
+/**
+ * @brief 检查 nettype_tcp_connect_start() 开始的连接是否完成，失败时关闭套接字。
+ *
+ * @param n 指向网络对象的指针。
+ * @return int 已连接返回MQTT_SUCCESS_ERROR，仍在进行中返回MQTT_WOULD_BLOCK_ERROR，失败时返回错误码。
+ */
+int nettype_tcp_connect_continue(network_t *n)
+{
+    int rc = platform_net_socket_connect_result(n->socket);
+
+    if (MQTT_WOULD_BLOCK_ERROR == rc)
+        RETURN_ERROR(rc);
+
+    n->want = 0;
+    if (rc < 0) {
+        nettype_tcp_disconnect(n);
+        RETURN_ERROR(rc);
+    }
+
+    RETURN_ERROR(MQTT_SUCCESS_ERROR);
+}
+
 /**
  * @brief 断开与TCP服务器的连接。
  *
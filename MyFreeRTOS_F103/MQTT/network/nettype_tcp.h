@@ -17,8 +17,12 @@ extern "C" {
 #endif
 
 int nettype_tcp_read(network_t *n, unsigned char *buf, int len, int timeout);
+int nettype_tcp_wait(network_t *n, int timeout);
 int nettype_tcp_write(network_t *n, unsigned char *buf, int len, int timeout);
+int nettype_tcp_writev(network_t *n, const network_iovec_t *iov, int iovcnt, int flags, int timeout);
 int nettype_tcp_connect(network_t* n);
+int nettype_tcp_connect_start(network_t* n);
+int nettype_tcp_connect_continue(network_t* n);
 void nettype_tcp_disconnect(network_t* n);
 
 #ifdef __cplusplus
@@ -6,15 +6,18 @@
  * @Description: the code belongs to jiejie, please keep the author information and source code according to the license.
  */
 #include "nettype_tls.h"
+#include "nettype_tcp.h"
 #include "platform_net_socket.h"
 #include "platform_memory.h"
 #include "platform_timer.h"
+#include "platform_thread.h"
 #include "random.h"
 
 #ifndef MQTT_NETWORK_TYPE_NO_TLS
 
 #include "mbedtls/platform.h"
 #include "mbedtls/ssl.h"
+#include "mbedtls/ssl_internal.h"
 #include "mbedtls/entropy.h"
 #include "mbedtls/net_sockets.h"
 #include "mbedtls/ctr_drbg.h"
@@ -22,9 +25,63 @@
 #include "mbedtls/debug.h"
 #include "mbedtls/x509_crt.h"
 #include "mbedtls/pk.h"
+#include "mbedtls/asn1.h"
+#include "mbedtls/oid.h"
+#include "mbedtls/ecdh.h"
+#include "mbedtls/sha256.h"
+#include "mbedtls/platform_util.h"
+#if defined(MBEDTLS_MEMORY_BUFFER_ALLOC_C)
+#include "mbedtls/memory_buffer_alloc.h"
+#endif
+#if defined(MBEDTLS_THREADING_ALT)
+#include "mbedtls/threading.h"
+#endif
+
+#if defined(MBEDTLS_MEMORY_BUFFER_ALLOC_C) && (MQTT_TLS_ARENA_SIZE > 0)
+#define NETTYPE_TLS_ARENA
+static unsigned char nettype_tls_arena[MQTT_TLS_ARENA_SIZE];
+#else
+/* 分配块前面记录块大小，保持与 calloc 相同的对齐 */
+#define NETTYPE_TLS_MEMORY_HEADER   (2 * sizeof(size_t))
+static platform_mutex_t nettype_tls_memory_lock;
+static size_t nettype_tls_memory_current, nettype_tls_memory_peak;
+#endif
+static int nettype_tls_memory_ready = 0;
+
+#ifdef NETTYPE_TLS_ECDHE_POOL
+/* 预计算的 ECDHE 密钥对，d/Q 的前 ready 个可用，lock 保护除 grp、gen_* 以外的成员，后者只由填充线程使用。
+ * 密钥对用 ctx 的 DRBG 生成，不再单独播种一个 DRBG，线程退出时释放 ctx 的引用 */
+static struct nettype_tls_ecdhe_pool {
+    platform_mutex_t            lock;
+    platform_thread_t           *thread;
+    int                         running;
+    unsigned int                ready;
+    unsigned int                hits;
+    unsigned int                misses;
+    mbedtls_mpi                 d[MQTT_TLS_ECDHE_POOL_SIZE];
+    mbedtls_ecp_point           Q[MQTT_TLS_ECDHE_POOL_SIZE];
+    mbedtls_ecp_group           grp;
+    nettype_tls_context_t       *ctx;
+    mbedtls_mpi                 gen_d;
+    mbedtls_ecp_point           gen_Q;
+} nettype_tls_ecdhe_pool;
+#endif
+
+#if defined(MBEDTLS_X509_CRT_PARSE_C) && defined(MBEDTLS_SHA256_C)
+#define NETTYPE_TLS_PINNING
+#endif
+
+#if defined(PLATFORM_NET_KTLS) && defined(MBEDTLS_SSL_EXPORT_KEYS)
+#define NETTYPE_TLS_KTLS
+/* 握手导出的 AEAD 记录层密钥，[0] 为客户端发送方向，[1] 为服务器发送方向 */
+typedef struct nettype_tls_ktls_keys {
+    unsigned char               key[2][32];
+    unsigned char               iv[2][12];
+} nettype_tls_ktls_keys_t;
+#endif
 
 #if defined(MBEDTLS_X509_CRT_PARSE_C)
-static int server_certificate_verify(void *hostname, mbedtls_x509_crt *crt, int depth, uint32_t *flags)
+static int server_certificate_verify(void *data, mbedtls_x509_crt *crt, int depth, uint32_t *flags)
 {
     if (0 != *flags)
         MQTT_LOG_E("%s:%d %s()... server_certificate_verify failed returned 0x%04x\n", __FILE__, __LINE__, __FUNCTION__, *flags);
@@ -48,70 +105,976 @@ static int nettype_tls_entropy_source(void *data, uint8_t *output, size_t len, s
     return 0;
 }
 
-static int nettype_tls_init(network_t* n, nettype_tls_params_t* nettype_tls_params)
+#ifndef NETTYPE_TLS_ARENA
+static void *nettype_tls_memory_calloc(size_t num, size_t size)
 {
-    int rc = MQTT_SUCCESS_ERROR;
-    
-    mbedtls_platform_set_calloc_free(platform_memory_calloc, platform_memory_free);
-    
-    mbedtls_net_init(&(nettype_tls_params->socket_fd));
-    mbedtls_ssl_init(&(nettype_tls_params->ssl));
-    mbedtls_ssl_config_init(&(nettype_tls_params->ssl_conf));
-    mbedtls_ctr_drbg_init(&(nettype_tls_params->ctr_drbg));
+    size_t *p, len = num * size;
+
+    if ((0 != size) && (len / size != num))
+        return NULL;
+
+    p = (size_t *) platform_memory_calloc(1, len + NETTYPE_TLS_MEMORY_HEADER);
+    if (NULL == p)
+        return NULL;
+
+    p[0] = len;
+    platform_mutex_lock(&nettype_tls_memory_lock);
+    nettype_tls_memory_current += len;
+    if (nettype_tls_memory_current > nettype_tls_memory_peak)
+        nettype_tls_memory_peak = nettype_tls_memory_current;
+    platform_mutex_unlock(&nettype_tls_memory_lock);
+
+    return (unsigned char *)p + NETTYPE_TLS_MEMORY_HEADER;
+}
+
+static void nettype_tls_memory_free(void *ptr)
+{
+    size_t *p;
+
+    if (NULL == ptr)
+        return;
+
+    p = (size_t *)((unsigned char *)ptr - NETTYPE_TLS_MEMORY_HEADER);
+    platform_mutex_lock(&nettype_tls_memory_lock);
+    nettype_tls_memory_current -= p[0];
+    platform_mutex_unlock(&nettype_tls_memory_lock);
+    platform_memory_free(p);
+}
+#endif
+
+/**
+ * @brief 第一次创建上下文时确定 mbedtls 的内存来源：启用 MBEDTLS_MEMORY_BUFFER_ALLOC_C 时使用静态内存池，
+ *        否则经 platform_memory 分配并统计用量。必须在任何 mbedtls 对象初始化之前调用。
+ *        这里没有加锁，多个客户端并发连接时应在启动阶段先创建共享上下文（network_tls_context_create）
+ *        启用 MBEDTLS_ECP_RESTARTABLE 时同时设置 ECC 分片的运算量，该设置对所有连接生效
+ */
+static void nettype_tls_memory_init(void)
+{
+    if (nettype_tls_memory_ready)
+        return;
+    nettype_tls_memory_ready = 1;
+
+#if defined(MBEDTLS_THREADING_ALT)
+    mbedtls_threading_platform_setup();
+#endif
+#ifdef NETTYPE_TLS_ARENA
+    mbedtls_memory_buffer_alloc_init(nettype_tls_arena, sizeof(nettype_tls_arena));
+#else
+    platform_mutex_init(&nettype_tls_memory_lock);
+    mbedtls_platform_set_calloc_free(nettype_tls_memory_calloc, nettype_tls_memory_free);
+#endif
+#if defined(MBEDTLS_ECP_RESTARTABLE)
+    mbedtls_ecp_set_max_ops(MQTT_TLS_ECP_MAX_OPS);
+#endif
+#ifdef NETTYPE_TLS_ECDHE_POOL
+    platform_mutex_init(&nettype_tls_ecdhe_pool.lock);
+#endif
+}
+
+void nettype_tls_memory_get(network_tls_memory_t *mem)
+{
+    memset(mem, 0, sizeof(network_tls_memory_t));
+
+    if (!nettype_tls_memory_ready)
+        return;
+
+#ifdef NETTYPE_TLS_ARENA
+    mem->arena = sizeof(nettype_tls_arena);
+#if defined(MBEDTLS_MEMORY_DEBUG)
+    {
+        size_t blocks;
+        mbedtls_memory_buffer_alloc_cur_get(&(mem->current), &blocks);
+        mbedtls_memory_buffer_alloc_max_get(&(mem->peak), &blocks);
+    }
+#endif
+#else
+    platform_mutex_lock(&nettype_tls_memory_lock);
+    mem->current = nettype_tls_memory_current;
+    mem->peak = nettype_tls_memory_peak;
+    platform_mutex_unlock(&nettype_tls_memory_lock);
+#endif
+}
+
+void nettype_tls_memory_reset_peak(void)
+{
+    if (!nettype_tls_memory_ready)
+        return;
+
+#ifdef NETTYPE_TLS_ARENA
+#if defined(MBEDTLS_MEMORY_DEBUG)
+    mbedtls_memory_buffer_alloc_max_reset();
+#endif
+#else
+    platform_mutex_lock(&nettype_tls_memory_lock);
+    nettype_tls_memory_peak = nettype_tls_memory_current;
+    platform_mutex_unlock(&nettype_tls_memory_lock);
+#endif
+}
+
+static int nettype_tls_context_random(void *p_rng, unsigned char *output, size_t len)
+{
+    int rc;
+    nettype_tls_context_t *ctx = (nettype_tls_context_t *) p_rng;
+
+    /* 同一个 DRBG 被多个连接和密钥池共享 */
+    platform_mutex_lock(&(ctx->lock));
+    rc = mbedtls_ctr_drbg_random(&(ctx->ctr_drbg), output, len);
+    platform_mutex_unlock(&(ctx->lock));
+
+    return rc;
+}
+
+#ifdef NETTYPE_TLS_ECDHE_POOL
+static void nettype_tls_ecdhe_point_swap(mbedtls_ecp_point *a, mbedtls_ecp_point *b)
+{
+    mbedtls_mpi_swap(&(a->X), &(b->X));
+    mbedtls_mpi_swap(&(a->Y), &(b->Y));
+    mbedtls_mpi_swap(&(a->Z), &(b->Z));
+}
+
+/**
+ * @brief 由 mbedtls_ecdh_make_public 在握手中调用，池中有 secp256r1 密钥对时交换给握手使用，每个密钥对只用一次
+ *
+ * @return int 取到返回 0，其他曲线或池为空时返回 -1，由 mbedtls 现算
+ */
+static int nettype_tls_ecdhe_pool_take(mbedtls_ecp_group_id grp_id, mbedtls_mpi *d, mbedtls_ecp_point *Q)
+{
+    int rc = -1;
+    struct nettype_tls_ecdhe_pool *pool = &nettype_tls_ecdhe_pool;
+
+    if (MBEDTLS_ECP_DP_SECP256R1 != grp_id)
+        return rc;
+
+    platform_mutex_lock(&(pool->lock));
+    if (pool->ready > 0) {
+        pool->ready--;
+        mbedtls_mpi_swap(d, &(pool->d[pool->ready]));
+        nettype_tls_ecdhe_point_swap(Q, &(pool->Q[pool->ready]));
+        pool->hits++;
+        rc = 0;
+    } else if (pool->running) {
+        pool->misses++;
+    }
+    platform_mutex_unlock(&(pool->lock));
+
+    return rc;
+}
+
+/**
+ * @brief 填充线程：池不满时生成一个密钥对放入池中，满了就每 MQTT_TLS_ECDHE_POOL_IDLE_MS 检查一次。
+ *        曲线参数常驻，基点的预计算表只在第一次生成时计算；生成不分片，线程优先级应低于所有业务线程
+ */
+static void nettype_tls_ecdhe_pool_thread(void *arg)
+{
+    int i, rc;
+    unsigned int ready;
+    platform_thread_t *thread_to_be_destoried = NULL;
+    nettype_tls_context_t *ctx;
+    struct nettype_tls_ecdhe_pool *pool = &nettype_tls_ecdhe_pool;
+
+    (void) arg;
+
+    mbedtls_ecp_group_init(&(pool->grp));
+    mbedtls_mpi_init(&(pool->gen_d));
+    mbedtls_ecp_point_init(&(pool->gen_Q));
+
+    if ((rc = mbedtls_ecp_group_load(&(pool->grp), MBEDTLS_ECP_DP_SECP256R1)) != 0) {
+        MQTT_LOG_E("%s:%d %s()... mbedtls_ecp_group_load failed returned 0x%04x", __FILE__, __LINE__, __FUNCTION__, (rc < 0 )? -rc : rc);
+        goto fail;
+    }
+
+    while (1) {
+        /* 是否退出在锁内决定，停止后立即重新启动时线程继续运行 */
+        platform_mutex_lock(&(pool->lock));
+        if (!pool->running)
+            goto exit;
+        ready = pool->ready;
+        platform_mutex_unlock(&(pool->lock));
+
+        if (ready >= MQTT_TLS_ECDHE_POOL_SIZE) {
+            platform_timer_usleep(MQTT_TLS_ECDHE_POOL_IDLE_MS * 1000);
+            continue;
+        }
+
+        rc = mbedtls_ecp_gen_keypair(&(pool->grp), &(pool->gen_d), &(pool->gen_Q), nettype_tls_context_random, pool->ctx);
+        if (0 != rc) {
+            MQTT_LOG_E("%s:%d %s()... mbedtls_ecp_gen_keypair failed returned 0x%04x", __FILE__, __LINE__, __FUNCTION__, (rc < 0 )? -rc : rc);
+            platform_timer_usleep(MQTT_TLS_ECDHE_POOL_IDLE_MS * 1000);
+            continue;
+        }
+
+        platform_mutex_lock(&(pool->lock));
+        if (pool->ready < MQTT_TLS_ECDHE_POOL_SIZE) {
+            mbedtls_mpi_swap(&(pool->gen_d), &(pool->d[pool->ready]));
+            nettype_tls_ecdhe_point_swap(&(pool->gen_Q), &(pool->Q[pool->ready]));
+            pool->ready++;
+        }
+        platform_mutex_unlock(&(pool->lock));
+    }
+
+fail:
+    platform_mutex_lock(&(pool->lock));
+exit:
+    pool->running = 0;
+    pool->ready = 0;
+    for (i = 0; i < MQTT_TLS_ECDHE_POOL_SIZE; i++) {
+        mbedtls_mpi_free(&(pool->d[i]));
+        mbedtls_ecp_point_free(&(pool->Q[i]));
+    }
+    thread_to_be_destoried = pool->thread;
+    pool->thread = NULL;
+    ctx = pool->ctx;
+    pool->ctx = NULL;
+    platform_mutex_unlock(&(pool->lock));
+
+    mbedtls_ecp_point_free(&(pool->gen_Q));
+    mbedtls_mpi_free(&(pool->gen_d));
+    mbedtls_ecp_group_free(&(pool->grp));
+    nettype_tls_context_put(ctx);
+
+    platform_thread_destroy(thread_to_be_destoried);
+}
+
+static int nettype_tls_ecdhe_pool_running(void)
+{
+    int running;
+
+    if (!nettype_tls_memory_ready)
+        return 0;
+
+    platform_mutex_lock(&nettype_tls_ecdhe_pool.lock);
+    running = nettype_tls_ecdhe_pool.running;
+    platform_mutex_unlock(&nettype_tls_ecdhe_pool.lock);
+
+    return running;
+}
+
+static const mbedtls_ecp_group_id *nettype_tls_ecdhe_curves(void)
+{
+    int i = 0;
+    const mbedtls_ecp_group_id *id;
+    static mbedtls_ecp_group_id curves[MBEDTLS_ECP_DP_MAX + 1];
+
+    if (MBEDTLS_ECP_DP_NONE != curves[0])
+        return curves;
+
+    curves[i++] = MBEDTLS_ECP_DP_SECP256R1;
+    for (id = mbedtls_ecp_grp_id_list(); MBEDTLS_ECP_DP_NONE != *id; id++) {
+        if (MBEDTLS_ECP_DP_SECP256R1 != *id)
+            curves[i++] = *id;
+    }
+    curves[i] = MBEDTLS_ECP_DP_NONE;
+
+    return curves;
+}
+#endif
+
+int nettype_tls_ecdhe_pool_start(nettype_tls_context_t *ctx)
+{
+#ifdef NETTYPE_TLS_ECDHE_POOL
+    int i, rc = MQTT_SUCCESS_ERROR;
+    struct nettype_tls_ecdhe_pool *pool = &nettype_tls_ecdhe_pool;
+
+    if (NULL == ctx)
+        RETURN_ERROR(MQTT_NULL_VALUE_ERROR);
+
+    nettype_tls_memory_init();
+
+    platform_mutex_lock(&(pool->lock));
+    if (NULL == pool->thread) {
+        /* 上一个线程已经退出，池中的密钥对都已释放 */
+        for (i = 0; i < MQTT_TLS_ECDHE_POOL_SIZE; i++) {
+            mbedtls_mpi_init(&(pool->d[i]));
+            mbedtls_ecp_point_init(&(pool->Q[i]));
+        }
+        pool->running = 1;
+        nettype_tls_context_hold(ctx);
+        pool->ctx = ctx;
+        pool->thread = platform_thread_init("ecdhe_pool_thread", nettype_tls_ecdhe_pool_thread, NULL,
+                                            MQTT_TLS_ECDHE_POOL_STACK_SIZE, MQTT_TLS_ECDHE_POOL_PRIO, MQTT_THREAD_TICK);
+        if (NULL == pool->thread) {
+            pool->running = 0;
+            pool->ctx = NULL;
+            nettype_tls_context_put(ctx);
+            rc = MQTT_FAILED_ERROR;
+        } else {
+            platform_thread_startup(pool->thread);
+            mbedtls_ecdh_set_precomputed(nettype_tls_ecdhe_pool_take);
+        }
+    } else {
+        /* 线程还没有退出，继续使用，密钥对仍由原来的上下文生成 */
+        pool->running = 1;
+    }
+    platform_mutex_unlock(&(pool->lock));
+
+    RETURN_ERROR(rc);
+#else
+    RETURN_ERROR(MQTT_FAILED_ERROR);
+#endif
+}
+
+void nettype_tls_ecdhe_pool_stop(void)
+{
+#ifdef NETTYPE_TLS_ECDHE_POOL
+    if (!nettype_tls_memory_ready)
+        return;
+
+    platform_mutex_lock(&nettype_tls_ecdhe_pool.lock);
+    nettype_tls_ecdhe_pool.running = 0;
+    platform_mutex_unlock(&nettype_tls_ecdhe_pool.lock);
+#endif
+}
+
+void nettype_tls_ecdhe_pool_get(network_tls_ecdhe_pool_t *pool)
+{
+    memset(pool, 0, sizeof(network_tls_ecdhe_pool_t));
+
+#ifdef NETTYPE_TLS_ECDHE_POOL
+    if (!nettype_tls_memory_ready)
+        return;
+
+    platform_mutex_lock(&nettype_tls_ecdhe_pool.lock);
+    pool->ready = nettype_tls_ecdhe_pool.ready;
+    pool->hits = nettype_tls_ecdhe_pool.hits;
+    pool->misses = nettype_tls_ecdhe_pool.misses;
+    platform_mutex_unlock(&nettype_tls_ecdhe_pool.lock);
+#endif
+}
+
+#if defined(MBEDTLS_KEY_EXCHANGE_PSK_ENABLED)
+static const int nettype_tls_psk_ciphersuites[] = { MQTT_TLS_PSK_CIPHERSUITE, 0 };
+#endif
+
+#if defined(MBEDTLS_X509_CRT_PARSE_C)
+/**
+ * @brief 解析证书，len 为 0 时按以 '\0' 结尾的 PEM 字符串解析，否则按 DER 解析，可以是多个 DER 证书首尾相接
+ *
+ * @param crt 证书链
+ * @param buf 证书数据
+ * @param len 证书数据长度
+ * @return int 成功返回 0，失败返回 mbedtls 错误码
+ */
+static int nettype_tls_parse_crt(mbedtls_x509_crt *crt, const unsigned char *buf, size_t len)
+{
+    int rc;
+    size_t crt_len;
+    unsigned char *p, *end;
+
+    if (0 == len)
+        return mbedtls_x509_crt_parse(crt, buf, strlen((const char *)buf) + 1);
+
+    p = (unsigned char *)buf;
+    end = p + len;
+    while (p < end) {
+        /* 每个证书是一个 SEQUENCE，跳过 PEM 解码直接按长度切分 */
+        unsigned char *start = p;
+        if (0 != (rc = mbedtls_asn1_get_tag(&p, end, &crt_len, MBEDTLS_ASN1_CONSTRUCTED | MBEDTLS_ASN1_SEQUENCE)))
+            return rc;
+        p += crt_len;
+        if (0 != (rc = mbedtls_x509_crt_parse_der(crt, start, p - start)))
+            return rc;
+    }
+
+    return 0;
+}
+#endif
+
+static uint32_t nettype_tls_peer_hash(network_t* n)
+{
+    uint32_t hash = 2166136261u;
+    const char *p;
+
+    for (p = n->host; (NULL != p) && *p; p++)
+        hash = (hash ^ (uint8_t)*p) * 16777619u;
+    hash = (hash ^ ':') * 16777619u;
+    for (p = n->port; (NULL != p) && *p; p++)
+        hash = (hash ^ (uint8_t)*p) * 16777619u;
+
+    return hash;
+}
+
+#ifdef NETTYPE_TLS_PINNING
+/**
+ * @brief 计算证书公钥 SubjectPublicKeyInfo 的 SHA-256，它在 tbsCertificate 中紧跟在 subject 之后，直接在证书原始数据上计算
+ *
+ * @param crt 证书
+ * @param hash 输出的 32 字节哈希
+ * @return int 成功返回 0，失败返回 mbedtls 错误码
+ */
+static int nettype_tls_pin_hash(const mbedtls_x509_crt *crt, unsigned char *hash)
+{
+    int rc;
+    size_t len;
+    unsigned char *start = crt->subject_raw.p + crt->subject_raw.len;
+    unsigned char *p = start;
+
+    if (0 != (rc = mbedtls_asn1_get_tag(&p, crt->tbs.p + crt->tbs.len, &len, MBEDTLS_ASN1_CONSTRUCTED | MBEDTLS_ASN1_SEQUENCE)))
+        return rc;
+
+    return mbedtls_sha256_ret(start, (p + len) - start, hash, 0);
+}
+
+/**
+ * @brief 取出服务器固定的公钥
+ *
+ * @param ctx TLS 上下文
+ * @param peer host:port 的哈希
+ * @param hash 输出的 32 字节哈希，为 NULL 时只查询是否已固定
+ * @return int 已固定返回 1，否则返回 0
+ */
+static int nettype_tls_pin_get(nettype_tls_context_t *ctx, uint32_t peer, unsigned char *hash)
+{
+    int i, found = 0;
+
+    platform_mutex_lock(&(ctx->lock));
+    for (i = 0; i < MQTT_ENDPOINT_NUM_MAX; i++) {
+        if (ctx->pins[i].set && (ctx->pins[i].peer == peer)) {
+            if (NULL != hash)
+                memcpy(hash, ctx->pins[i].hash, sizeof(ctx->pins[i].hash));
+            found = 1;
+            break;
+        }
+    }
+    platform_mutex_unlock(&(ctx->lock));
+
+    return found;
+}
+
+/**
+ * @brief 固定服务器的公钥，表满时轮流替换，被替换的服务器下次重新完整验证
+ */
+static void nettype_tls_pin_set(nettype_tls_context_t *ctx, uint32_t peer, const unsigned char *hash)
+{
+    int i, slot = -1;
+
+    platform_mutex_lock(&(ctx->lock));
+    for (i = 0; i < MQTT_ENDPOINT_NUM_MAX; i++) {
+        if (ctx->pins[i].set && (ctx->pins[i].peer == peer)) {
+            slot = i;
+            break;
+        }
+        if ((slot < 0) && !ctx->pins[i].set)
+            slot = i;
+    }
+
+    if (slot < 0) {
+        slot = ctx->pin_next;
+        ctx->pin_next = (ctx->pin_next + 1) % MQTT_ENDPOINT_NUM_MAX;
+    }
+
+    ctx->pins[slot].peer = peer;
+    ctx->pins[slot].set = 1;
+    memcpy(ctx->pins[slot].hash, hash, sizeof(ctx->pins[slot].hash));
+    platform_mutex_unlock(&(ctx->lock));
+}
+
+/**
+ * @brief 只对 ASCII 字母不区分大小写的比较，相同返回 0
+ */
+static int nettype_tls_memcasecmp(const unsigned char *a, const char *b, size_t len)
+{
+    size_t i;
+    unsigned char x, y;
+
+    for (i = 0; i < len; i++) {
+        x = a[i];
+        y = (unsigned char)b[i];
+        if ((x >= 'A') && (x <= 'Z'))
+            x += 'a' - 'A';
+        if ((y >= 'A') && (y <= 'Z'))
+            y += 'a' - 'A';
+        if (x != y)
+            return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief 比较证书中的名字与主机名，规则与 mbedtls 验证证书时相同，通配符只匹配最左一级
+ */
+static int nettype_tls_pin_name_match(const mbedtls_x509_buf *name, const char *host, size_t len)
+{
+    size_t dot;
+
+    if ((name->len == len) && (0 == nettype_tls_memcasecmp(name->p, host, len)))
+        return 1;
+
+    if ((name->len < 3) || (name->p[0] != '*') || (name->p[1] != '.'))
+        return 0;
+
+    for (dot = 0; (dot < len) && (host[dot] != '.'); dot++) ;
+
+    if ((0 == dot) || (len - dot != name->len - 1))
+        return 0;
+
+    return (0 == nettype_tls_memcasecmp(name->p + 1, host + dot, name->len - 1));
+}
+
+/**
+ * @brief 检查证书是否属于 host：有 subjectAltName 时只看其中的名字，否则看 subject 的 CN
+ *
+ * @param crt 服务器证书
+ * @param host 连接的主机名
+ * @return int 匹配返回 1，否则返回 0
+ */
+static int nettype_tls_pin_name(const mbedtls_x509_crt *crt, const char *host)
+{
+    const mbedtls_x509_sequence *cur;
+    const mbedtls_x509_name *name;
+    size_t len = strlen(host);
+
+    if (crt->ext_types & MBEDTLS_X509_EXT_SUBJECT_ALT_NAME) {
+        for (cur = &crt->subject_alt_names; NULL != cur; cur = cur->next) {
+            if (nettype_tls_pin_name_match(&cur->buf, host, len))
+                return 1;
+        }
+        return 0;
+    }
+
+    for (name = &crt->subject; NULL != name; name = name->next) {
+        if ((0 == MBEDTLS_OID_CMP(MBEDTLS_OID_AT_CN, &name->oid)) && nettype_tls_pin_name_match(&name->val, host, len))
+            return 1;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief 应用配置了公钥时，服务器公钥必须与它一致
+ */
+static int nettype_tls_pin_allowed(nettype_tls_context_t *ctx, const unsigned char *hash)
+{
+    if (ctx->pin_fixed && (0 != memcmp(hash, ctx->pin, sizeof(ctx->pin)))) {
+        MQTT_LOG_E("%s:%d %s()...server public key does not match the configured pin", __FILE__, __LINE__, __FUNCTION__);
+        return 0;
+    }
+
+    return 1;
+}
+
+/**
+ * @brief 检查固定公钥握手中的服务器证书：公钥与该服务器固定的一致时只检查主机名，不再验证证书链，
+ *        不一致时（例如服务器换了密钥）完整验证证书链和主机名，通过后固定新的公钥
+ *
+ * @param n 网络对象
+ * @param nettype_tls_params TLS 连接参数，握手已经处理完服务器证书
+ * @return int 成功返回 MQTT_SUCCESS_ERROR，验证失败返回 MQTT_SSL_CERT_ERROR
+ */
+static int nettype_tls_pin_check(network_t* n, nettype_tls_params_t* nettype_tls_params)
+{
+    int rc;
+    uint32_t flags;
+    uint32_t peer = nettype_tls_peer_hash(n);
+    unsigned char hash[32], pin[32];
+    nettype_tls_context_t *ctx = nettype_tls_params->ctx;
+    mbedtls_x509_crt *cert = nettype_tls_params->ssl.session_negotiate->peer_cert;
+
+    nettype_tls_params->pin_checked = 1;
+
+    if ((NULL == cert) || (0 != nettype_tls_pin_hash(cert, hash)))
+        RETURN_ERROR(MQTT_SSL_CERT_ERROR);
+
+    if (!nettype_tls_pin_allowed(ctx, hash))
+        RETURN_ERROR(MQTT_SSL_CERT_ERROR);
+
+    if (nettype_tls_pin_get(ctx, peer, pin) && (0 == memcmp(hash, pin, sizeof(hash)))) {
+        if (!nettype_tls_pin_name(cert, n->host)) {
+            MQTT_LOG_E("%s:%d %s()...server certificate does not match the host name %s", __FILE__, __LINE__, __FUNCTION__, n->host);
+            RETURN_ERROR(MQTT_SSL_CERT_ERROR);
+        }
+        n->tls_stats.pinned++;
+        RETURN_ERROR(MQTT_SUCCESS_ERROR);
+    }
+
+    MQTT_LOG_W("%s:%d %s()...server public key does not match the pin, verifying the certificate chain", __FILE__, __LINE__, __FUNCTION__);
+
+    rc = mbedtls_x509_crt_verify_with_profile(cert, &(ctx->ca_cert), NULL, ctx->ssl_conf.cert_profile,
+                                              n->host, &flags, NULL, NULL);
+    if (0 != rc) {
+        MQTT_LOG_E("%s:%d %s()...unable to verify the server's certificate, flags 0x%04x", __FILE__, __LINE__, __FUNCTION__, flags);
+        RETURN_ERROR(MQTT_SSL_CERT_ERROR);
+    }
+
+    nettype_tls_pin_set(ctx, peer, hash);
+    RETURN_ERROR(MQTT_SUCCESS_ERROR);
+}
+
+/**
+ * @brief 固定第一次完整验证通过的服务器公钥，之后与该服务器的握手只比较公钥和主机名
+ *
+ * @param n 网络对象
+ * @param nettype_tls_params TLS 连接参数，mbedtls 已经验证了证书链和主机名
+ * @return int 成功返回 MQTT_SUCCESS_ERROR，公钥与配置的不一致返回 MQTT_SSL_CERT_ERROR
+ */
+static int nettype_tls_pin_learn(network_t* n, nettype_tls_params_t* nettype_tls_params)
+{
+    unsigned char hash[32];
+    const mbedtls_x509_crt *cert = mbedtls_ssl_get_peer_cert(&(nettype_tls_params->ssl));
+
+    if ((NULL == cert) || (0 != nettype_tls_pin_hash(cert, hash)))
+        RETURN_ERROR(MQTT_SSL_CERT_ERROR);
+
+    if (!nettype_tls_pin_allowed(nettype_tls_params->ctx, hash))
+        RETURN_ERROR(MQTT_SSL_CERT_ERROR);
+
+    nettype_tls_pin_set(nettype_tls_params->ctx, nettype_tls_peer_hash(n), hash);
+    RETURN_ERROR(MQTT_SUCCESS_ERROR);
+}
+#endif
+
+static void nettype_tls_context_free(nettype_tls_context_t *ctx)
+{
+#if defined(MBEDTLS_X509_CRT_PARSE_C)
+    mbedtls_x509_crt_free(&(ctx->client_cert));
+    mbedtls_x509_crt_free(&(ctx->ca_cert));
+    mbedtls_pk_free(&(ctx->private_key));
+#endif
+    mbedtls_ssl_config_free(&(ctx->ssl_conf));
+    mbedtls_ctr_drbg_free(&(ctx->ctr_drbg));
+    mbedtls_entropy_free(&(ctx->entropy));
+    platform_mutex_destroy(&(ctx->lock));
+    platform_memory_free(ctx);
+}
+
+/**
+ * @brief 创建 TLS 上下文：播种 DRBG、解析 CA 证书链和客户端证书、建立 ssl_config。
+ *        上下文只读地被多个连接共享，每个连接只创建自己的 mbedtls_ssl_context
+ *
+ * @param cred 证书信息，数据在上下文销毁前必须保持有效
+ * @return nettype_tls_context_t* 成功返回上下文，引用计数为 1，失败返回 NULL
+ */
+nettype_tls_context_t *nettype_tls_context_create(const network_tls_credentials_t *cred)
+{
+    int rc;
+    nettype_tls_context_t *ctx;
+
+    if (NULL == cred)
+        return NULL;
+
+    nettype_tls_memory_init();
+
+    ctx = (nettype_tls_context_t *) platform_memory_alloc(sizeof(nettype_tls_context_t));
+    if (NULL == ctx)
+        return NULL;
+
+    memset(ctx, 0, sizeof(nettype_tls_context_t));
+    ctx->refs = 1;
+    ctx->ca_src = cred->ca;
+    platform_mutex_init(&(ctx->lock));
+
+    mbedtls_ssl_config_init(&(ctx->ssl_conf));
+    mbedtls_ctr_drbg_init(&(ctx->ctr_drbg));
 #if defined(MBEDTLS_X509_CRT_PARSE_C)
-    mbedtls_x509_crt_init(&(nettype_tls_params->ca_cert));
-    mbedtls_x509_crt_init(&(nettype_tls_params->client_cert));
-    mbedtls_pk_init(&(nettype_tls_params->private_key));
+    mbedtls_x509_crt_init(&(ctx->ca_cert));
+    mbedtls_x509_crt_init(&(ctx->client_cert));
+    mbedtls_pk_init(&(ctx->private_key));
 #endif
 
-    mbedtls_entropy_init(&(nettype_tls_params->entropy));
-    mbedtls_entropy_add_source(&(nettype_tls_params->entropy), nettype_tls_entropy_source, NULL, MBEDTLS_ENTROPY_MAX_GATHER, MBEDTLS_ENTROPY_SOURCE_STRONG);
+    mbedtls_entropy_init(&(ctx->entropy));
+    mbedtls_entropy_add_source(&(ctx->entropy), nettype_tls_entropy_source, NULL, MBEDTLS_ENTROPY_MAX_GATHER, MBEDTLS_ENTROPY_SOURCE_STRONG);
 
-    if ((rc = mbedtls_ctr_drbg_seed(&(nettype_tls_params->ctr_drbg), mbedtls_entropy_func,
-                                    &(nettype_tls_params->entropy), NULL, 0)) != 0) {
+    if ((rc = mbedtls_ctr_drbg_seed(&(ctx->ctr_drbg), mbedtls_entropy_func, &(ctx->entropy), NULL, 0)) != 0) {
         MQTT_LOG_E("mbedtls_ctr_drbg_seed failed returned 0x%04x", (rc < 0 )? -rc : rc);
-        RETURN_ERROR(rc);
+        goto exit;
     }
 
-    if ((rc = mbedtls_ssl_config_defaults(&(nettype_tls_params->ssl_conf), MBEDTLS_SSL_IS_CLIENT,
+    if ((rc = mbedtls_ssl_config_defaults(&(ctx->ssl_conf), MBEDTLS_SSL_IS_CLIENT,
                                            MBEDTLS_SSL_TRANSPORT_STREAM, MBEDTLS_SSL_PRESET_DEFAULT)) != 0) {
         MQTT_LOG_E("mbedtls_ssl_config_defaults failed returned 0x%04x", (rc < 0 )? -rc : rc);
-        RETURN_ERROR(rc);
+        goto exit;
     }
 
-    mbedtls_ssl_conf_rng(&(nettype_tls_params->ssl_conf), mbedtls_ctr_drbg_random, &(nettype_tls_params->ctr_drbg));
+    mbedtls_ssl_conf_rng(&(ctx->ssl_conf), nettype_tls_context_random, ctx);
 
-#if defined(MBEDTLS_X509_CRT_PARSE_C)
-    if (NULL != n->ca_crt) {
-        n->ca_crt_len = strlen(n->ca_crt);
+#if defined(MBEDTLS_SSL_MAX_FRAGMENT_LENGTH)
+    /* 请求服务器把记录限制在输入缓冲区以内，服务器不支持该扩展时仍按 16KB 发送 */
+    if (MBEDTLS_SSL_MAX_FRAG_LEN_NONE != MQTT_TLS_MAX_FRAG_LEN)
+        mbedtls_ssl_conf_max_frag_len(&(ctx->ssl_conf), MQTT_TLS_MAX_FRAG_LEN);
+#endif
+
+    if (NULL != cred->psk) {
+#if defined(MBEDTLS_KEY_EXCHANGE_PSK_ENABLED)
+        /* 预共享密钥模式：只协商 PSK 套件，没有证书和公钥运算 */
+        ctx->psk_src = cred->psk;
+        rc = mbedtls_ssl_conf_psk(&(ctx->ssl_conf), cred->psk, cred->psk_len,
+                                  (const unsigned char *)cred->psk_identity, strlen(cred->psk_identity));
+        if (0 != rc) {
+            MQTT_LOG_E("%s:%d %s()... mbedtls_ssl_conf_psk failed returned 0x%04x", __FILE__, __LINE__, __FUNCTION__, (rc < 0 )? -rc : rc);
+            goto exit;
+        }
+        mbedtls_ssl_conf_ciphersuites(&(ctx->ssl_conf), nettype_tls_psk_ciphersuites);
+        goto done;
+#else
+        MQTT_LOG_E("%s:%d %s()... psk key exchange is not enabled in mbedtls", __FILE__, __LINE__, __FUNCTION__);
+        goto exit;
+#endif
+    }
 
-        if (0 != (rc = (mbedtls_x509_crt_parse(&(nettype_tls_params->ca_cert), (unsigned char *)n->ca_crt,
-                                          (n->ca_crt_len + 1))))) {
+#if defined(MBEDTLS_X509_CRT_PARSE_C)
+    if (NULL != cred->ca) {
+        if (0 != (rc = nettype_tls_parse_crt(&(ctx->ca_cert), cred->ca, cred->ca_len))) {
             MQTT_LOG_E("%s:%d %s()... parse ca crt failed returned 0x%04x", __FILE__, __LINE__, __FUNCTION__, (rc < 0 )? -rc : rc);
-            RETURN_ERROR(rc);
+            goto exit;
         }
     }
 
-    mbedtls_ssl_conf_ca_chain(&(nettype_tls_params->ssl_conf), &(nettype_tls_params->ca_cert), NULL);
+    mbedtls_ssl_conf_ca_chain(&(ctx->ssl_conf), &(ctx->ca_cert), NULL);
 
-    if ((rc = mbedtls_ssl_conf_own_cert(&(nettype_tls_params->ssl_conf),
-                                         &(nettype_tls_params->client_cert), &(nettype_tls_params->private_key))) != 0) {
-        MQTT_LOG_E("%s:%d %s()... mbedtls_ssl_conf_own_cert failed returned 0x%04x", __FILE__, __LINE__, __FUNCTION__, (rc < 0 )? -rc : rc);
-        RETURN_ERROR(rc);
+    if ((NULL != cred->client_crt) && (NULL != cred->client_key)) {
+        if (0 != (rc = nettype_tls_parse_crt(&(ctx->client_cert), cred->client_crt, cred->client_crt_len))) {
+            MQTT_LOG_E("%s:%d %s()... parse client crt failed returned 0x%04x", __FILE__, __LINE__, __FUNCTION__, (rc < 0 )? -rc : rc);
+            goto exit;
+        }
+
+        rc = mbedtls_pk_parse_key(&(ctx->private_key), cred->client_key,
+                                  (0 == cred->client_key_len) ? strlen((const char *)cred->client_key) + 1 : cred->client_key_len, NULL, 0);
+        if (0 != rc) {
+            MQTT_LOG_E("%s:%d %s()... parse client key failed returned 0x%04x", __FILE__, __LINE__, __FUNCTION__, (rc < 0 )? -rc : rc);
+            goto exit;
+        }
+
+        if ((rc = mbedtls_ssl_conf_own_cert(&(ctx->ssl_conf), &(ctx->client_cert), &(ctx->private_key))) != 0) {
+            MQTT_LOG_E("%s:%d %s()... mbedtls_ssl_conf_own_cert failed returned 0x%04x", __FILE__, __LINE__, __FUNCTION__, (rc < 0 )? -rc : rc);
+            goto exit;
+        }
     }
-    
-    mbedtls_ssl_conf_verify(&(nettype_tls_params->ssl_conf), server_certificate_verify, (void *)n->host);
 
-    mbedtls_ssl_conf_authmode(&(nettype_tls_params->ssl_conf), MBEDTLS_SSL_VERIFY_REQUIRED);
+    mbedtls_ssl_conf_verify(&(ctx->ssl_conf), server_certificate_verify, NULL);
+
+    mbedtls_ssl_conf_authmode(&(ctx->ssl_conf), MBEDTLS_SSL_VERIFY_REQUIRED);
+#endif
+
+    if (cred->pinning) {
+#ifdef NETTYPE_TLS_PINNING
+        ctx->pinning = 1;
+        if (NULL != cred->pin) {
+            memcpy(ctx->pin, cred->pin, sizeof(ctx->pin));
+            ctx->pin_fixed = 1;
+        }
+#else
+        MQTT_LOG_W("%s:%d %s()... public key pinning needs MBEDTLS_X509_CRT_PARSE_C and MBEDTLS_SHA256_C", __FILE__, __LINE__, __FUNCTION__);
+#endif
+    }
+
+done:
+    mbedtls_ssl_conf_read_timeout(&(ctx->ssl_conf), MQTT_TLS_HANDSHAKE_TIMEOUT);
+
+#ifdef NETTYPE_TLS_PINNING
+    if (ctx->pinning) {
+        /* 浅拷贝，与 ssl_conf 共用证书链、客户端证书和 DRBG，只是握手中不验证证书链，不单独释放 */
+        ctx->pin_conf = ctx->ssl_conf;
+        mbedtls_ssl_conf_authmode(&(ctx->pin_conf), MBEDTLS_SSL_VERIFY_NONE);
+    }
+#endif
+
+#ifdef NETTYPE_TLS_ECDHE_POOL
+    /* 密钥池只有 secp256r1，池运行时的连接使用把它放在曲线列表最前面的副本，默认顺序中 secp521r1 优先 */
+    ctx->pool_conf[0] = ctx->ssl_conf;
+    mbedtls_ssl_conf_curves(&(ctx->pool_conf[0]), nettype_tls_ecdhe_curves());
+#ifdef NETTYPE_TLS_PINNING
+    ctx->pool_conf[1] = ctx->pin_conf;
+    mbedtls_ssl_conf_curves(&(ctx->pool_conf[1]), nettype_tls_ecdhe_curves());
+#endif
+#endif
+
+    return ctx;
+
+exit:
+    nettype_tls_context_free(ctx);
+    return NULL;
+}
+
+void nettype_tls_context_hold(nettype_tls_context_t *ctx)
+{
+    platform_mutex_lock(&(ctx->lock));
+    ctx->refs++;
+    platform_mutex_unlock(&(ctx->lock));
+}
+
+/**
+ * @brief 释放一个引用，最后一个引用释放时销毁上下文
+ */
+void nettype_tls_context_put(nettype_tls_context_t *ctx)
+{
+    int refs;
+
+    if (NULL == ctx)
+        return;
+
+    platform_mutex_lock(&(ctx->lock));
+    refs = --ctx->refs;
+    platform_mutex_unlock(&(ctx->lock));
+
+    if (0 == refs)
+        nettype_tls_context_free(ctx);
+}
+
+/**
+ * @brief 取得本次连接使用的上下文。没有设置共享上下文时按 n->psk 或 n->ca_crt 创建一个，保存在 network_t 中供重连复用，
+ *        密钥或 CA 改变（例如切换到另一个端点）时重新创建
+ */
+static nettype_tls_context_t *nettype_tls_context_get(network_t* n)
+{
+    network_tls_credentials_t cred;
+    nettype_tls_context_t *ctx = (nettype_tls_context_t *) n->tls_context;
+
+    if ((NULL != ctx) && ((ctx->ca_src != (const unsigned char *)n->ca_crt) || (ctx->psk_src != n->psk))) {
+        nettype_tls_context_put(ctx);
+        n->tls_context = ctx = NULL;
+    }
+
+    if (NULL == ctx) {
+        memset(&cred, 0, sizeof(cred));
+        if (NULL != n->psk) {
+            cred.psk = n->psk;
+            cred.psk_len = n->psk_len;
+            cred.psk_identity = n->psk_identity;
+        } else {
+            cred.ca = (const unsigned char *)n->ca_crt;
+            cred.pinning = MQTT_TLS_PINNING;
+        }
+        n->tls_context = ctx = nettype_tls_context_create(&cred);
+    }
+
+    return ctx;
+}
+
+#ifdef NETTYPE_TLS_KTLS
+static void nettype_tls_ktls_keys_free(nettype_tls_params_t* nettype_tls_params)
+{
+    if (NULL == nettype_tls_params->ktls_keys)
+        return;
+
+    mbedtls_platform_zeroize(nettype_tls_params->ktls_keys, sizeof(nettype_tls_ktls_keys_t));
+    platform_memory_free(nettype_tls_params->ktls_keys);
+    nettype_tls_params->ktls_keys = NULL;
+}
+
+/**
+ * @brief 在握手中记下本连接的记录层密钥，只保留可以交给内核的 AEAD 套件（密钥块中没有 MAC 密钥）
+ */
+static int nettype_tls_ktls_export(void *p, const unsigned char *ms, const unsigned char *kb, size_t maclen, size_t keylen, size_t ivlen)
+{
+    nettype_tls_params_t *nettype_tls_params = (nettype_tls_params_t *) p;
+    nettype_tls_ktls_keys_t *keys = (nettype_tls_ktls_keys_t *) nettype_tls_params->ktls_keys;
+
+    (void) ms;
+
+    if ((0 != maclen) || (keylen > sizeof(keys->key[0])) || (ivlen > sizeof(keys->iv[0])))
+        return 0;
+
+    if (NULL == keys) {
+        keys = (nettype_tls_ktls_keys_t *) platform_memory_alloc(sizeof(nettype_tls_ktls_keys_t));
+        if (NULL == keys)
+            return 0;
+        nettype_tls_params->ktls_keys = keys;
+    }
+
+    /* 密钥块依次为两个方向的 MAC 密钥（AEAD 时为空）、加密密钥和隐式 IV */
+    memcpy(keys->key[0], kb, keylen);
+    memcpy(keys->key[1], kb + keylen, keylen);
+    memcpy(keys->iv[0], kb + 2 * keylen, ivlen);
+    memcpy(keys->iv[1], kb + 2 * keylen + ivlen, ivlen);
+
+    return 0;
+}
+
+/**
+ * @brief 握手完成后把 TLS 1.2 的 AEAD 记录层交给内核（TCP_ULP "tls"），之后直接在套接字上读写明文，
+ *        由内核加解密。内核没有 tls 模块、不支持该套件或者协商了 max_fragment_length 时仍由 mbedtls 处理
+ */
+static void nettype_tls_ktls_start(network_t* n, nettype_tls_params_t* nettype_tls_params)
+{
+    int cipher;
+    mbedtls_ssl_context *ssl = &(nettype_tls_params->ssl);
+    nettype_tls_ktls_keys_t *keys = (nettype_tls_ktls_keys_t *) nettype_tls_params->ktls_keys;
+    const mbedtls_ssl_ciphersuite_t *suite = mbedtls_ssl_ciphersuite_from_id(ssl->session->ciphersuite);
+
+    /* 内核从下一个记录开始接手，mbedtls 中不能还有没读完的记录 */
+    if ((NULL == keys) || (NULL == suite) || (MBEDTLS_SSL_MINOR_VERSION_3 != ssl->minor_ver) || mbedtls_ssl_check_pending(ssl))
+        goto exit;
+
+#if defined(MBEDTLS_SSL_MAX_FRAGMENT_LENGTH)
+    /* 内核按 16KB 组记录，不知道协商的记录上限 */
+    if (MBEDTLS_SSL_MAX_FRAG_LEN_NONE != ssl->session->mfl_code)
+        goto exit;
 #endif
 
-    mbedtls_ssl_conf_read_timeout(&(nettype_tls_params->ssl_conf), n->timeout_ms);
+    switch (suite->cipher) {
+        case MBEDTLS_CIPHER_AES_128_GCM:
+            cipher = PLATFORM_NET_KTLS_AES_128_GCM;
+            break;
+        case MBEDTLS_CIPHER_AES_256_GCM:
+            cipher = PLATFORM_NET_KTLS_AES_256_GCM;
+            break;
+        case MBEDTLS_CIPHER_AES_128_CCM:
+            /* 内核只支持 16 字节的认证标签，CCM-8 留给 mbedtls */
+            if (suite->flags & MBEDTLS_CIPHERSUITE_SHORT_TAG)
+                goto exit;
+            cipher = PLATFORM_NET_KTLS_AES_128_CCM;
+            break;
+        case MBEDTLS_CIPHER_CHACHA20_POLY1305:
+            cipher = PLATFORM_NET_KTLS_CHACHA20_POLY1305;
+            break;
+        default:
+            goto exit;
+    }
+
+    if ((0 != platform_net_socket_ktls_start(n->socket)) ||
+        (0 != platform_net_socket_ktls_set(n->socket, PLATFORM_NET_KTLS_TX, cipher, keys->key[0], keys->iv[0], ssl->cur_out_ctr))) {
+        MQTT_LOG_D("%s:%d %s()... kernel tls is not available, records stay in mbedtls", __FILE__, __LINE__, __FUNCTION__);
+        goto exit;
+    }
+    nettype_tls_params->ktls = PLATFORM_NET_KTLS_TX;
+
+    if (0 == platform_net_socket_ktls_set(n->socket, PLATFORM_NET_KTLS_RX, cipher, keys->key[1], keys->iv[1], ssl->in_ctr))
+        nettype_tls_params->ktls |= PLATFORM_NET_KTLS_RX;
 
-    if ((rc = mbedtls_ssl_setup(&(nettype_tls_params->ssl), &(nettype_tls_params->ssl_conf))) != 0) {
+    n->tls_stats.ktls++;
+
+exit:
+    nettype_tls_ktls_keys_free(nettype_tls_params);
+}
+#endif
+
+static int nettype_tls_init(network_t* n, nettype_tls_params_t* nettype_tls_params)
+{
+    int rc = MQTT_SUCCESS_ERROR;
+    mbedtls_ssl_config *conf;
+
+    mbedtls_net_init(&(nettype_tls_params->socket_fd));
+    mbedtls_ssl_init(&(nettype_tls_params->ssl));
+
+    nettype_tls_params->ctx = nettype_tls_context_get(n);
+    if (NULL == nettype_tls_params->ctx)
+        RETURN_ERROR(MQTT_SSL_CERT_ERROR);
+
+    /* 连接期间持有一个引用，共享上下文被销毁时不影响已建立的连接 */
+    nettype_tls_context_hold(nettype_tls_params->ctx);
+
+    conf = &(nettype_tls_params->ctx->ssl_conf);
+#ifdef NETTYPE_TLS_PINNING
+    /* 已经固定了该服务器的公钥：握手中不验证证书链，处理完服务器证书后只比较公钥和主机名 */
+    nettype_tls_params->pinned = nettype_tls_params->ctx->pinning &&
+                                 nettype_tls_pin_get(nettype_tls_params->ctx, nettype_tls_peer_hash(n), NULL);
+    if (nettype_tls_params->pinned)
+        conf = &(nettype_tls_params->ctx->pin_conf);
+#endif
+#ifdef NETTYPE_TLS_ECDHE_POOL
+    if (nettype_tls_ecdhe_pool_running())
+        conf = &(nettype_tls_params->ctx->pool_conf[nettype_tls_params->pinned ? 1 : 0]);
+#endif
+
+    if ((rc = mbedtls_ssl_setup(&(nettype_tls_params->ssl), conf)) != 0) {
         MQTT_LOG_E("mbedtls_ssl_setup failed returned 0x%04x", (rc < 0 )? -rc : rc);
         RETURN_ERROR(rc);
     }
 
+#ifdef NETTYPE_TLS_KTLS
+    mbedtls_ssl_set_export_keys_cb(&(nettype_tls_params->ssl), nettype_tls_ktls_export, nettype_tls_params);
+#endif
+
 #if defined(MBEDTLS_X509_CRT_PARSE_C)
     if ((rc = mbedtls_ssl_set_hostname(&(nettype_tls_params->ssl), n->host)) != 0) {
         MQTT_LOG_E("%s:%d %s()... mbedtls_ssl_set_hostname failed returned 0x%04x", __FILE__, __LINE__, __FUNCTION__, (rc < 0 )? -rc : rc);
@@ -124,76 +1087,337 @@ static int nettype_tls_init(network_t* n, nettype_tls_params_t* nettype_tls_para
     RETURN_ERROR(MQTT_SUCCESS_ERROR);
 }
 
+static void nettype_tls_free(nettype_tls_params_t* nettype_tls_params)
+{
+#ifdef NETTYPE_TLS_KTLS
+    nettype_tls_ktls_keys_free(nettype_tls_params);
+#endif
+    mbedtls_net_free(&(nettype_tls_params->socket_fd));
+    mbedtls_ssl_free(&(nettype_tls_params->ssl));
+    nettype_tls_context_put(nettype_tls_params->ctx);
+    nettype_tls_params->ctx = NULL;
+}
 
-int nettype_tls_connect(network_t* n)
+/**
+ * @brief 握手前设置上一次保存的会话，服务器接受时只进行简化握手，不再验证证书和交换密钥
+ *
+ * @param n 网络对象
+ * @param nettype_tls_params TLS 连接参数
+ */
+static void nettype_tls_session_set(network_t* n, nettype_tls_params_t* nettype_tls_params)
+{
+#if MQTT_TLS_SESSION_RESUMPTION
+    nettype_tls_session_t *s = (nettype_tls_session_t *) n->tls_session;
+
+    if ((NULL == s) || (s->peer != nettype_tls_peer_hash(n)))
+        return;
+
+    if (0 != mbedtls_ssl_set_session(&(nettype_tls_params->ssl), &(s->session)))
+        nettype_tls_session_free(n);
+#endif
+}
+
+/**
+ * @brief 握手成功后保存会话，供下一次重连恢复
+ *
+ * @param n 网络对象
+ * @param nettype_tls_params TLS 连接参数
+ */
+static void nettype_tls_session_save(network_t* n, nettype_tls_params_t* nettype_tls_params)
+{
+#if MQTT_TLS_SESSION_RESUMPTION
+    nettype_tls_session_t *s = (nettype_tls_session_t *) n->tls_session;
+
+    if (NULL == s) {
+        s = (nettype_tls_session_t *) platform_memory_alloc(sizeof(nettype_tls_session_t));
+        if (NULL == s)
+            return;
+        n->tls_session = s;
+    } else {
+        mbedtls_ssl_session_free(&(s->session));
+    }
+
+    mbedtls_ssl_session_init(&(s->session));
+    if (0 != mbedtls_ssl_get_session(&(nettype_tls_params->ssl), &(s->session))) {
+        nettype_tls_session_free(n);
+        return;
+    }
+    s->peer = nettype_tls_peer_hash(n);
+#endif
+}
+
+void nettype_tls_session_free(network_t* n)
+{
+    nettype_tls_session_t *s = (nettype_tls_session_t *) n->tls_session;
+
+    if (NULL == s)
+        return;
+
+    mbedtls_ssl_session_free(&(s->session));
+    platform_memory_free(s);
+    n->tls_session = NULL;
+}
+
+/*
+ * 异步握手期间的收发函数：套接字未就绪时返回 WANT_READ/WANT_WRITE，由调用者等待就绪后继续握手，
+ * 套接字本身保持阻塞模式，握手完成后换回 nettype_tls_init() 设置的阻塞收发函数
+ */
+static int nettype_tls_send_nb(void *ctx, const unsigned char *buf, size_t len)
+{
+    if (0 == platform_net_socket_wait(((mbedtls_net_context *)ctx)->fd, PLATFORM_NET_WAIT_WRITE, 0))
+        return MBEDTLS_ERR_SSL_WANT_WRITE;
+
+    return mbedtls_net_send(ctx, buf, len);
+}
+
+static int nettype_tls_recv_nb(void *ctx, unsigned char *buf, size_t len)
 {
     int rc;
+
+    if (0 == platform_net_socket_wait(((mbedtls_net_context *)ctx)->fd, PLATFORM_NET_WAIT_READ, 0))
+        return MBEDTLS_ERR_SSL_WANT_READ;
+
+    /* 可读却读不到数据说明对端已关闭连接 */
+    rc = mbedtls_net_recv(ctx, buf, len);
+    return (rc == MBEDTLS_ERR_SSL_WANT_READ) ? MBEDTLS_ERR_NET_CONN_RESET : rc;
+}
+
+/**
+ * @brief 异步连接失败，释放连接参数并累计失败次数
+ */
+static int nettype_tls_connect_fail(network_t* n, int rc)
+{
+    nettype_tls_params_t *nettype_tls_params = (nettype_tls_params_t *) n->nettype_tls_params;
+
+    n->tls_stats.failed++;
+    nettype_tls_free(nettype_tls_params);
+    platform_memory_free(nettype_tls_params);
+    n->nettype_tls_params = NULL;
+    n->socket = -1;
+    n->want = 0;
+    RETURN_ERROR(rc);
+}
+
+/**
+ * @brief 开始 TLS 连接，TCP 连接和握手都不等待对端，需要等待时返回 MQTT_WOULD_BLOCK_ERROR，
+ *        之后在 n->socket 上等到 n->want 中的事件再调用 nettype_tls_connect_continue()
+ *
+ * @param n 网络对象
+ * @return int MQTT_SUCCESS_ERROR 表示已连接，MQTT_WOULD_BLOCK_ERROR 表示仍在进行，其他为错误码
+ */
+int nettype_tls_connect_start(network_t* n)
+{
+    int rc;
+    nettype_tls_params_t *nettype_tls_params;
+
     if (NULL == n)
         RETURN_ERROR(MQTT_NULL_VALUE_ERROR);
     
-    nettype_tls_params_t *nettype_tls_params = (nettype_tls_params_t *) platform_memory_alloc(sizeof(nettype_tls_params_t));
+    nettype_tls_params = (nettype_tls_params_t *) platform_memory_alloc(sizeof(nettype_tls_params_t));
 
     if (NULL == nettype_tls_params)
         RETURN_ERROR(MQTT_MEM_NOT_ENOUGH_ERROR);
 
+    memset(nettype_tls_params, 0, sizeof(nettype_tls_params_t));
+    n->nettype_tls_params = nettype_tls_params;
 
     rc = nettype_tls_init(n, nettype_tls_params);
     if (MQTT_SUCCESS_ERROR != rc)
-        goto exit;
+        return nettype_tls_connect_fail(n, rc);
 
-    if (0 != (rc = mbedtls_net_connect(&(nettype_tls_params->socket_fd), n->host, n->port, MBEDTLS_NET_PROTO_TCP)))
-        goto exit;
+    mbedtls_ssl_set_bio(&(nettype_tls_params->ssl), &(nettype_tls_params->socket_fd), nettype_tls_send_nb, nettype_tls_recv_nb, NULL);
+
+    nettype_tls_params->socket_fd.fd = platform_net_socket_connect_start(n->host, n->port, PLATFORM_NET_PROTO_TCP);
+    if (nettype_tls_params->socket_fd.fd < 0)
+        return nettype_tls_connect_fail(n, nettype_tls_params->socket_fd.fd);
+
+    nettype_tls_session_set(n, nettype_tls_params);
+    nettype_tls_params->start = platform_timer_now();
+    nettype_tls_params->connecting = 1;
+    platform_timer_cutdown(&(nettype_tls_params->timer), n->timeout_ms);
+
+    n->socket = nettype_tls_params->socket_fd.fd;
+    n->want = NETWORK_WANT_WRITE;
+
+    return nettype_tls_connect_continue(n);
+}
+
+/**
+ * @brief 继续 TLS 连接，尽可能推进 TCP 连接和握手，直到需要等待对端或完成。
+ *        n->timeout_ms 内没有任何进展时连接失败；n->want 为 0 表示一段 ECC 运算刚结束，可以让出 CPU 后立即继续
+ *
+ * @param n 网络对象
+ * @return int MQTT_SUCCESS_ERROR 表示已连接，MQTT_WOULD_BLOCK_ERROR 表示仍在进行，其他为错误码
+ */
+int nettype_tls_connect_continue(network_t* n)
+{
+    int rc;
+    nettype_tls_params_t *nettype_tls_params;
+
+    if ((NULL == n) || (NULL == n->nettype_tls_params))
+        RETURN_ERROR(MQTT_NULL_VALUE_ERROR);
+
+    nettype_tls_params = (nettype_tls_params_t *) n->nettype_tls_params;
+
+    if (nettype_tls_params->connecting) {
+        rc = platform_net_socket_connect_result(nettype_tls_params->socket_fd.fd);
+        if (MQTT_WOULD_BLOCK_ERROR == rc) {
+            if (platform_timer_is_expired(&(nettype_tls_params->timer)))
+                return nettype_tls_connect_fail(n, MQTT_CONNECT_FAILED_ERROR);
+            RETURN_ERROR(MQTT_WOULD_BLOCK_ERROR);
+        }
+        if (0 != rc)
+            return nettype_tls_connect_fail(n, rc);
+
+        nettype_tls_params->connecting = 0;
+        platform_timer_cutdown(&(nettype_tls_params->timer), n->timeout_ms);
+    }
+
+    /* 逐步握手，在握手参数释放之前记录服务器是否接受了会话恢复 */
+    while (MBEDTLS_SSL_HANDSHAKE_OVER != nettype_tls_params->ssl.state) {
+        rc = mbedtls_ssl_handshake_step(&(nettype_tls_params->ssl));
+        if (NULL != nettype_tls_params->ssl.handshake)
+            nettype_tls_params->resumed = nettype_tls_params->ssl.handshake->resume;
+
+        if ((rc == MBEDTLS_ERR_SSL_WANT_READ) || (rc == MBEDTLS_ERR_SSL_WANT_WRITE)) {
+            if (platform_timer_is_expired(&(nettype_tls_params->timer))) {
+                MQTT_LOG_E("%s:%d %s()...mbedtls handshake timeout", __FILE__, __LINE__, __FUNCTION__);
+                nettype_tls_session_free(n);
+                return nettype_tls_connect_fail(n, MQTT_CONNECT_FAILED_ERROR);
+            }
+            n->want = (rc == MBEDTLS_ERR_SSL_WANT_READ) ? NETWORK_WANT_READ : NETWORK_WANT_WRITE;
+            RETURN_ERROR(MQTT_WOULD_BLOCK_ERROR);
+        }
 
-    while ((rc = mbedtls_ssl_handshake(&(nettype_tls_params->ssl))) != 0) {
-        if (rc != MBEDTLS_ERR_SSL_WANT_READ && rc != MBEDTLS_ERR_SSL_WANT_WRITE) {
+#if defined(MBEDTLS_ECP_RESTARTABLE)
+        /* ECC 运算只完成了一个分片，让出 CPU 后从中断处继续 */
+        if (rc == MBEDTLS_ERR_SSL_CRYPTO_IN_PROGRESS) {
+            platform_timer_cutdown(&(nettype_tls_params->timer), n->timeout_ms);
+            n->want = 0;
+            RETURN_ERROR(MQTT_WOULD_BLOCK_ERROR);
+        }
+#endif
+        if (0 != rc) {
             MQTT_LOG_E("%s:%d %s()...mbedtls handshake failed returned 0x%04x", __FILE__, __LINE__, __FUNCTION__, (rc < 0 )? -rc : rc);
 #if defined(MBEDTLS_X509_CRT_PARSE_C)
             if (rc == MBEDTLS_ERR_X509_CERT_VERIFY_FAILED) {
                 MQTT_LOG_E("%s:%d %s()...unable to verify the server's certificate", __FILE__, __LINE__, __FUNCTION__);
             }
 #endif
-            goto exit;
+            /* 服务器可能不再接受保存的会话，下次从完整握手开始 */
+            nettype_tls_session_free(n);
+            return nettype_tls_connect_fail(n, rc);
+        }
+
+#ifdef NETTYPE_TLS_PINNING
+        /* 在发送 ClientKeyExchange 之前检查服务器公钥，会话恢复没有服务器证书 */
+        if (nettype_tls_params->pinned && !nettype_tls_params->pin_checked && !nettype_tls_params->resumed &&
+            (nettype_tls_params->ssl.state > MBEDTLS_SSL_SERVER_CERTIFICATE)) {
+            if (MQTT_SUCCESS_ERROR != (rc = nettype_tls_pin_check(n, nettype_tls_params))) {
+                nettype_tls_session_free(n);
+                return nettype_tls_connect_fail(n, rc);
+            }
         }
+#endif
+
+        platform_timer_cutdown(&(nettype_tls_params->timer), n->timeout_ms);
     }
 
-    if ((rc = mbedtls_ssl_get_verify_result(&(nettype_tls_params->ssl))) != 0) {
+    /* 固定公钥的握手没有让 mbedtls 验证证书链，验证结果只有 MBEDTLS_X509_BADCERT_SKIP_VERIFY */
+    if (!nettype_tls_params->pinned && ((rc = mbedtls_ssl_get_verify_result(&(nettype_tls_params->ssl))) != 0)) {
         MQTT_LOG_E("%s:%d %s()...mbedtls_ssl_get_verify_result returned 0x%04x", __FILE__, __LINE__, __FUNCTION__, (rc < 0 )? -rc : rc);
-        goto exit;
+        return nettype_tls_connect_fail(n, rc);
     }
 
-    n->nettype_tls_params = nettype_tls_params;
+#ifdef NETTYPE_TLS_PINNING
+    if (nettype_tls_params->ctx->pinning && !nettype_tls_params->pinned && !nettype_tls_params->resumed) {
+        if (MQTT_SUCCESS_ERROR != (rc = nettype_tls_pin_learn(n, nettype_tls_params))) {
+            nettype_tls_session_free(n);
+            return nettype_tls_connect_fail(n, rc);
+        }
+    }
+#endif
+
+    if (nettype_tls_params->resumed)
+        n->tls_stats.resumed++;
+    else
+        n->tls_stats.full++;
+    n->tls_stats.last_ms = (unsigned int)(platform_timer_now() - nettype_tls_params->start);
+
+    nettype_tls_session_save(n, nettype_tls_params);
+
+#ifdef NETTYPE_TLS_KTLS
+    nettype_tls_ktls_start(n, nettype_tls_params);
+#endif
+
+    mbedtls_ssl_set_bio(&(nettype_tls_params->ssl), &(nettype_tls_params->socket_fd), mbedtls_net_send, mbedtls_net_recv, mbedtls_net_recv_timeout);
+    n->want = 0;
     RETURN_ERROR(MQTT_SUCCESS_ERROR)
+}
+
+int nettype_tls_connect(network_t* n)
+{
+    int rc;
+    nettype_tls_params_t *nettype_tls_params;
+
+    rc = nettype_tls_connect_start(n);
+
+    /* 阻塞连接只是在原地等待异步连接需要的事件 */
+    while (MQTT_WOULD_BLOCK_ERROR == rc) {
+        nettype_tls_params = (nettype_tls_params_t *) n->nettype_tls_params;
+        if (0 != n->want)
+            platform_net_socket_wait(n->socket, n->want, platform_timer_remain(&(nettype_tls_params->timer)));
+        else
+            platform_timer_usleep(MQTT_TLS_ECP_YIELD_MS * 1000);
+        rc = nettype_tls_connect_continue(n);
+    }
 
-exit:
-    platform_memory_free(nettype_tls_params);
     RETURN_ERROR(rc);
 }
 
+/**
+ * @brief 等待 TLS 数据可读，mbedtls 中已缓存的数据直接视为可读
+ *
+ * @param n 网络对象
+ * @param timeout 超时时间，单位为毫秒
+ * @return int 可读时返回正数，超时返回0，失败时返回负数
+ */
+int nettype_tls_wait(network_t* n, int timeout)
+{
+    nettype_tls_params_t *nettype_tls_params;
+
+    if ((NULL == n) || (NULL == n->nettype_tls_params))
+        RETURN_ERROR(MQTT_NULL_VALUE_ERROR);
+
+    nettype_tls_params = (nettype_tls_params_t *) n->nettype_tls_params;
+
+    if ((mbedtls_ssl_get_bytes_avail(&(nettype_tls_params->ssl)) > 0) || mbedtls_ssl_check_pending(&(nettype_tls_params->ssl)))
+        return 1;
+
+    return platform_net_socket_wait(n->socket, PLATFORM_NET_WAIT_READ, timeout);
+}
+
 
 void nettype_tls_disconnect(network_t* n) 
 {
     int rc = 0;
-    if (NULL == n)
+    if ((NULL == n) || (NULL == n->nettype_tls_params))
         return;
     
     nettype_tls_params_t *nettype_tls_params = (nettype_tls_params_t *) n->nettype_tls_params;
 
-    do {
-        rc = mbedtls_ssl_close_notify(&(nettype_tls_params->ssl));
-    } while (rc == MBEDTLS_ERR_SSL_WANT_READ || rc == MBEDTLS_ERR_SSL_WANT_WRITE);
-
-    mbedtls_net_free(&(nettype_tls_params->socket_fd));
-#if defined(MBEDTLS_X509_CRT_PARSE_C)
-    mbedtls_x509_crt_free(&(nettype_tls_params->client_cert));
-    mbedtls_x509_crt_free(&(nettype_tls_params->ca_cert));
-    mbedtls_pk_free(&(nettype_tls_params->private_key));
-#endif
-    mbedtls_ssl_free(&(nettype_tls_params->ssl));
-    mbedtls_ssl_config_free(&(nettype_tls_params->ssl_conf));
-    mbedtls_ctr_drbg_free(&(nettype_tls_params->ctr_drbg));
-    mbedtls_entropy_free(&(nettype_tls_params->entropy));
+    /* 异步握手中途放弃时不发送 close_notify，未发出的握手数据也不再等待；
+       发送方向交给内核后 mbedtls 的记录序号已经过时，也不再由它发送 */
+    if ((MBEDTLS_SSL_HANDSHAKE_OVER == nettype_tls_params->ssl.state) && !nettype_tls_params->ktls) {
+        do {
+            rc = mbedtls_ssl_close_notify(&(nettype_tls_params->ssl));
+        } while (rc == MBEDTLS_ERR_SSL_WANT_READ || rc == MBEDTLS_ERR_SSL_WANT_WRITE);
+    }
 
+    nettype_tls_free(nettype_tls_params);
     platform_memory_free(nettype_tls_params);
+    n->nettype_tls_params = NULL;
+    n->socket = -1;
 }
 
 int nettype_tls_write(network_t *n, unsigned char *buf, int len, int timeout)
@@ -207,6 +1431,11 @@ int nettype_tls_write(network_t *n, unsigned char *buf, int len, int timeout)
     
     nettype_tls_params_t *nettype_tls_params = (nettype_tls_params_t *) n->nettype_tls_params;
 
+#ifdef NETTYPE_TLS_KTLS
+    if (nettype_tls_params->ktls & PLATFORM_NET_KTLS_TX)
+        return nettype_tcp_write(n, buf, len, timeout);
+#endif
+
     platform_timer_cutdown(&timer, timeout);
 
     do {
@@ -223,6 +1452,40 @@ int nettype_tls_write(network_t *n, unsigned char *buf, int len, int timeout)
     return write_len;
 }
 
+/**
+ * @brief 发送多段数据。记录层交给内核后一次 sendmsg 发出，内核直接从各段加密，不再复制到 mbedtls 的记录缓冲区；
+ *        内核 TLS 不接受 MSG_ZEROCOPY，所以不请求零拷贝。否则由 mbedtls 逐段加密发送
+ *
+ * @param n 网络对象
+ * @param iov 数据段数组
+ * @param iovcnt 数据段数量
+ * @param timeout 超时时间，单位为毫秒，所有数据段共用
+ * @return int 成功时返回写入的字节数，失败时返回错误码
+ */
+int nettype_tls_writev(network_t *n, const network_iovec_t *iov, int iovcnt, int timeout)
+{
+    int i, len, sent = 0;
+
+    if ((NULL == n) || (NULL == n->nettype_tls_params))
+        RETURN_ERROR(MQTT_NULL_VALUE_ERROR);
+
+#ifdef NETTYPE_TLS_KTLS
+    if (((nettype_tls_params_t *) n->nettype_tls_params)->ktls & PLATFORM_NET_KTLS_TX)
+        return platform_net_socket_writev(n->socket, iov, iovcnt, 0, timeout);
+#endif
+
+    for (i = 0; i < iovcnt; i++) {
+        len = nettype_tls_write(n, (unsigned char *)iov[i].iov_base, (int)iov[i].iov_len, timeout);
+        if (len < 0)
+            return (sent > 0) ? sent : len;
+        sent += len;
+        if (len != (int)iov[i].iov_len)
+            break;
+    }
+
+    return sent;
+}
+
 int nettype_tls_read(network_t *n, unsigned char *buf, int len, int timeout)
 {
     int rc = 0;
@@ -234,6 +1497,11 @@ int nettype_tls_read(network_t *n, unsigned char *buf, int len, int timeout)
     
     nettype_tls_params_t *nettype_tls_params = (nettype_tls_params_t *) n->nettype_tls_params;
 
+#ifdef NETTYPE_TLS_KTLS
+    if (nettype_tls_params->ktls & PLATFORM_NET_KTLS_RX)
+        return nettype_tcp_read(n, buf, len, timeout);
+#endif
+
     platform_timer_cutdown(&timer, timeout);
     
     do {
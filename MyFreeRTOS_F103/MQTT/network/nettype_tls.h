@@ -13,6 +13,8 @@
 #include "network.h"
 #include "mqtt_error.h"
 #include "mqtt_log.h"
+#include "platform_mutex.h"
+#include "platform_timer.h"
 
 #ifndef MQTT_NETWORK_TYPE_NO_TLS
 
@@ -20,23 +22,81 @@
 extern "C" {
 #endif
 
-typedef struct nettype_tls_params {
-    mbedtls_net_context         socket_fd;        /**< mbed TLS network context. */
+#if defined(MBEDTLS_ECDH_PRECOMPUTED) && defined(MBEDTLS_ECP_DP_SECP256R1_ENABLED) && (MQTT_TLS_ECDHE_POOL_SIZE > 0)
+#define NETTYPE_TLS_ECDHE_POOL
+#endif
+
+/* 完整验证通过的服务器公钥，peer 为 host:port 的哈希，每个服务器单独固定 */
+typedef struct nettype_tls_pin {
+    uint32_t                    peer;
+    int                         set;
+    unsigned char               hash[32];         /**< SHA-256 of the server SubjectPublicKeyInfo. */
+} nettype_tls_pin_t;
+
+/* 可共享的 TLS 上下文，创建后只读，DRBG 和固定的公钥由 lock 保护，refs 为持有者数量 */
+struct nettype_tls_context {
     mbedtls_entropy_context     entropy;          /**< mbed TLS entropy. */
     mbedtls_ctr_drbg_context    ctr_drbg;         /**< mbed TLS ctr_drbg. */
-    mbedtls_ssl_context         ssl;              /**< mbed TLS control context. */
     mbedtls_ssl_config          ssl_conf;         /**< mbed TLS configuration context. */
+    mbedtls_ssl_config          pin_conf;         /**< shallow copy of ssl_conf without chain verification, used once a pin is known. */
+#ifdef NETTYPE_TLS_ECDHE_POOL
+    mbedtls_ssl_config          pool_conf[2];     /**< ssl_conf and pin_conf with secp256r1 first, used while the ECDHE pool runs. */
+#endif
 #if defined(MBEDTLS_X509_CRT_PARSE_C)
     mbedtls_x509_crt            ca_cert;          /**< mbed TLS CA certification. */
     mbedtls_x509_crt            client_cert;      /**< mbed TLS Client certification. */
 #endif
     mbedtls_pk_context          private_key;      /**< mbed TLS Client key. */
+    platform_mutex_t            lock;
+    int                         refs;
+    const unsigned char         *ca_src;          /**< CA data the context was built from. */
+    const unsigned char         *psk_src;         /**< pre-shared key the context was built from. */
+    int                         pinning;          /**< pin the server public key. */
+    int                         pin_fixed;        /**< pin holds a key configured by the application, every server key must match it. */
+    unsigned char               pin[32];          /**< configured SHA-256 of the server SubjectPublicKeyInfo. */
+    nettype_tls_pin_t           pins[MQTT_ENDPOINT_NUM_MAX]; /**< keys learned from fully verified handshakes, one per host:port. */
+    unsigned int                pin_next;         /**< slot replaced when every slot holds another server. */
+};
+
+typedef struct nettype_tls_context nettype_tls_context_t;
+
+typedef struct nettype_tls_params {
+    mbedtls_net_context         socket_fd;        /**< mbed TLS network context. */
+    mbedtls_ssl_context         ssl;              /**< mbed TLS control context. */
+    nettype_tls_context_t       *ctx;             /**< shared configuration, one reference held per connection. */
+    platform_timer_t            timer;            /**< connect fails when nothing progresses before it expires. */
+    unsigned long               start;            /**< connect start time, for tls_stats.last_ms. */
+    int                         connecting;       /**< tcp connection still in progress. */
+    int                         resumed;          /**< the server accepted the saved session. */
+    int                         pinned;           /**< set up with pin_conf, the server key is compared with the pin instead. */
+    int                         pin_checked;      /**< the server key of a pinned handshake has been checked. */
+    int                         ktls;             /**< record directions handled by the kernel, PLATFORM_NET_KTLS_TX/_RX. */
+    void                        *ktls_keys;       /**< record keys exported by the handshake until they are handed to the kernel. */
 } nettype_tls_params_t;
 
+/* 保存在 network_t 中的会话，peer 为 host:port 的哈希，只向同一服务器恢复 */
+typedef struct nettype_tls_session {
+    mbedtls_ssl_session         session;
+    uint32_t                    peer;
+} nettype_tls_session_t;
+
 int nettype_tls_read(network_t *n, unsigned char *buf, int len, int timeout);
 int nettype_tls_write(network_t *n, unsigned char *buf, int len, int timeout);
+int nettype_tls_writev(network_t *n, const network_iovec_t *iov, int iovcnt, int timeout);
+int nettype_tls_wait(network_t* n, int timeout);
 int nettype_tls_connect(network_t* n);
+int nettype_tls_connect_start(network_t* n);
+int nettype_tls_connect_continue(network_t* n);
 void nettype_tls_disconnect(network_t* n);
+void nettype_tls_session_free(network_t* n);
+nettype_tls_context_t *nettype_tls_context_create(const network_tls_credentials_t *cred);
+void nettype_tls_context_hold(nettype_tls_context_t *ctx);
+void nettype_tls_context_put(nettype_tls_context_t *ctx);
+void nettype_tls_memory_get(network_tls_memory_t *mem);
+void nettype_tls_memory_reset_peak(void);
+int nettype_tls_ecdhe_pool_start(nettype_tls_context_t *ctx);
+void nettype_tls_ecdhe_pool_stop(void);
+void nettype_tls_ecdhe_pool_get(network_tls_ecdhe_pool_t *pool);
 
 #endif /* MQTT_NETWORK_TYPE_NO_TLS */
 
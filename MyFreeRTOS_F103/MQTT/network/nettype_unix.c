@@ -0,0 +1,91 @@
+/*
+ * @Date: 2026-10-19
+ * @Description: AF_UNIX stream socket transport for a broker or bridge on the same host.
+ */
+#include "mqtt_log.h"
+#include "nettype_unix.h"
+
+#ifdef PLATFORM_NET_PROTO_UNIX
+
+/**
+ * @brief 读取AF_UNIX套接字数据。
+ *
+ * @param n 指向网络对象的指针。
+ * @param read_buf 存储读取数据的缓冲区。
+ * @param len 要读取的数据长度。
+ * @param timeout 超时时间，单位为毫秒。
+ * @return int 成功时返回读取的字节数，失败时返回错误码。
+ */
+int nettype_unix_read(network_t *n, unsigned char *read_buf, int len, int timeout)
+{
+    return platform_net_socket_recv_timeout(n->socket, read_buf, len, timeout);
+}
+
+/**
+ * @brief 等待AF_UNIX套接字数据可读。
+ *
+ * @param n 指向网络对象的指针。
+ * @param timeout 超时时间，单位为毫秒。
+ * @return int 可读时返回正数，超时返回0，失败时返回负数。
+ */
+int nettype_unix_wait(network_t *n, int timeout)
+{
+    return platform_net_socket_wait(n->socket, PLATFORM_NET_WAIT_READ, timeout);
+}
+
+/**
+ * @brief 写入AF_UNIX套接字数据。
+ *
+ * @param n 指向网络对象的指针。
+ * @param write_buf 要写入的数据缓冲区。
+ * @param len 要写入的数据长度。
+ * @param timeout 超时时间，单位为毫秒。
+ * @return int 成功时返回写入的字节数，失败时返回错误码。
+ */
+int nettype_unix_write(network_t *n, unsigned char *write_buf, int len, int timeout)
+{
+    return platform_net_socket_write_timeout(n->socket, write_buf, len, timeout);
+}
+
+/**
+ * @brief 将多段数据一次写入AF_UNIX套接字，本机套接字不支持零拷贝，始终按拷贝方式发送。
+ *
+ * @param n 指向网络对象的指针。
+ * @param iov 数据段数组。
+ * @param iovcnt 数据段数量。
+ * @param timeout 超时时间，单位为毫秒。
+ * @return int 成功时返回写入的字节数，失败时返回错误码。
+ */
+int nettype_unix_writev(network_t *n, const network_iovec_t *iov, int iovcnt, int timeout)
+{
+    return platform_net_socket_writev(n->socket, iov, iovcnt, 0, timeout);
+}
+
+/**
+ * @brief 连接到本机AF_UNIX套接字，路径保存在 n->host 中。
+ *
+ * @param n 指向网络对象的指针。
+ * @return int 成功时返回MQTT_SUCCESS_ERROR，失败时返回错误码。
+ */
+int nettype_unix_connect(network_t *n)
+{
+    n->socket = platform_net_socket_connect(n->host, NULL, PLATFORM_NET_PROTO_UNIX);
+    if (n->socket < 0)
+        RETURN_ERROR(n->socket);
+
+    RETURN_ERROR(MQTT_SUCCESS_ERROR);
+}
+
+/**
+ * @brief 断开AF_UNIX套接字连接。
+ *
+ * @param n 指向网络对象的指针。
+ */
+void nettype_unix_disconnect(network_t *n)
+{
+    if (NULL != n)
+        platform_net_socket_close(n->socket);
+    n->socket = -1;
+}
+
+#endif /* PLATFORM_NET_PROTO_UNIX */
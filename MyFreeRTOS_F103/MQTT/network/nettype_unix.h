@@ -0,0 +1,32 @@
+/*
+ * @Date: 2026-10-19
+ * @Description: AF_UNIX stream socket transport for a broker or bridge on the same host.
+ */
+#ifndef _NETTYPE_UNIX_H_
+#define _NETTYPE_UNIX_H_
+
+#include "platform_net_socket.h"
+#include "network.h"
+#include "mqtt_error.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* 只有提供了 PLATFORM_NET_PROTO_UNIX 的平台才支持 AF_UNIX 通道 */
+#ifdef PLATFORM_NET_PROTO_UNIX
+
+int nettype_unix_read(network_t *n, unsigned char *buf, int len, int timeout);
+int nettype_unix_wait(network_t *n, int timeout);
+int nettype_unix_write(network_t *n, unsigned char *buf, int len, int timeout);
+int nettype_unix_writev(network_t *n, const network_iovec_t *iov, int iovcnt, int timeout);
+int nettype_unix_connect(network_t* n);
+void nettype_unix_disconnect(network_t* n);
+
+#endif /* PLATFORM_NET_PROTO_UNIX */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
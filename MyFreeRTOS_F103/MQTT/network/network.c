@@ -8,6 +8,8 @@
 #include "platform_timer.h"
 #include "platform_memory.h"
 #include "nettype_tcp.h"
+#include "nettype_unix.h"
+#include "nettype_shm.h"
 
 #ifndef MQTT_NETWORK_TYPE_NO_TLS
 #include "nettype_tls.h"
@@ -25,12 +27,44 @@
 int network_read(network_t *n, unsigned char *buf, int len, int timeout)
 {
 #ifndef MQTT_NETWORK_TYPE_NO_TLS
-    if (n->channel)
+    if (NETWORK_CHANNEL_TLS == n->channel)
         return nettype_tls_read(n, buf, len, timeout);
+#endif
+#ifdef PLATFORM_NET_PROTO_UNIX
+    if (NETWORK_CHANNEL_UNIX == n->channel)
+        return nettype_unix_read(n, buf, len, timeout);
+#endif
+#ifdef PLATFORM_NET_PROTO_SHM
+    if (NETWORK_CHANNEL_SHM == n->channel)
+        return nettype_shm_read(n, buf, len, timeout);
 #endif
     return nettype_tcp_read(n, buf, len, timeout);
 }
 
+/**
+ * @brief 等待网络数据可读。
+ *
+ * @param n 指向网络对象的指针。
+ * @param timeout 超时时间，单位为毫秒。
+ * @return int 可读时返回正数，超时返回0，失败时返回负数。
+ */
+int network_wait(network_t *n, int timeout)
+{
+#ifndef MQTT_NETWORK_TYPE_NO_TLS
+    if (NETWORK_CHANNEL_TLS == n->channel)
+        return nettype_tls_wait(n, timeout);
+#endif
+#ifdef PLATFORM_NET_PROTO_UNIX
+    if (NETWORK_CHANNEL_UNIX == n->channel)
+        return nettype_unix_wait(n, timeout);
+#endif
+#ifdef PLATFORM_NET_PROTO_SHM
+    if (NETWORK_CHANNEL_SHM == n->channel)
+        return nettype_shm_wait(n, timeout);
+#endif
+    return nettype_tcp_wait(n, timeout);
+}
+
 /**
  * @brief 向网络写入数据。
  *
@@ -43,12 +77,47 @@ int network_read(network_t *n, unsigned char *buf, int len, int timeout)
 int network_write(network_t *n, unsigned char *buf, int len, int timeout)
 {
 #ifndef MQTT_NETWORK_TYPE_NO_TLS
-    if (n->channel)
+    if (NETWORK_CHANNEL_TLS == n->channel)
         return nettype_tls_write(n, buf, len, timeout);
+#endif
+#ifdef PLATFORM_NET_PROTO_UNIX
+    if (NETWORK_CHANNEL_UNIX == n->channel)
+        return nettype_unix_write(n, buf, len, timeout);
+#endif
+#ifdef PLATFORM_NET_PROTO_SHM
+    if (NETWORK_CHANNEL_SHM == n->channel)
+        return nettype_shm_write(n, buf, len, timeout);
 #endif
     return nettype_tcp_write(n, buf, len, timeout);
 }
 
+/**
+ * @brief 将多段数据作为一次写入发送到网络，调用者无需先把数据拼接到一个缓冲区中。
+ *
+ * @param n 指向网络对象的指针。
+ * @param iov 数据段数组。
+ * @param iovcnt 数据段数量。
+ * @param flags NETWORK_WRITE_ZEROCOPY 或 0，只有 TCP 通道使用。
+ * @param timeout 超时时间，单位为毫秒，所有数据段共用。
+ * @return int 成功时返回写入的字节数，失败时返回错误码。
+ */
+int network_writev(network_t *n, const network_iovec_t *iov, int iovcnt, int flags, int timeout)
+{
+#ifndef MQTT_NETWORK_TYPE_NO_TLS
+    if (NETWORK_CHANNEL_TLS == n->channel)
+        return nettype_tls_writev(n, iov, iovcnt, timeout);
+#endif
+#ifdef PLATFORM_NET_PROTO_UNIX
+    if (NETWORK_CHANNEL_UNIX == n->channel)
+        return nettype_unix_writev(n, iov, iovcnt, timeout);
+#endif
+#ifdef PLATFORM_NET_PROTO_SHM
+    if (NETWORK_CHANNEL_SHM == n->channel)
+        return nettype_shm_writev(n, iov, iovcnt, timeout);
+#endif
+    return nettype_tcp_writev(n, iov, iovcnt, flags, timeout);
+}
+
 /**
  * @brief 连接到服务器。
  *
@@ -58,12 +127,69 @@ int network_write(network_t *n, unsigned char *buf, int len, int timeout)
 int network_connect(network_t *n)
 {
 #ifndef MQTT_NETWORK_TYPE_NO_TLS
-    if (n->channel)
+    if (NETWORK_CHANNEL_TLS == n->channel)
         return nettype_tls_connect(n);
+#endif
+#ifdef PLATFORM_NET_PROTO_UNIX
+    if (NETWORK_CHANNEL_UNIX == n->channel)
+        return nettype_unix_connect(n);
+#endif
+#ifdef PLATFORM_NET_PROTO_SHM
+    if (NETWORK_CHANNEL_SHM == n->channel)
+        return nettype_shm_connect(n);
 #endif
     return nettype_tcp_connect(n);
 }
 
+/**
+ * @brief 开始连接服务器，不等待 TCP 连接和 TLS 握手完成，一个线程可以同时推进多个连接。
+ *        返回 MQTT_WOULD_BLOCK_ERROR 时在 n->socket 上等待 network_connect_want() 的事件，
+ *        再调用 network_connect_continue()；放弃连接时调用 network_release()。
+ *        本机 AF_UNIX 和共享内存通道直接完成连接，域名解析仍然是阻塞的。
+ *
+ * @param n 指向网络对象的指针。
+ * @return int 已连接返回MQTT_SUCCESS_ERROR，仍在进行中返回MQTT_WOULD_BLOCK_ERROR，失败时返回错误码。
+ */
+int network_connect_start(network_t *n)
+{
+    n->want = 0;
+#ifndef MQTT_NETWORK_TYPE_NO_TLS
+    if (NETWORK_CHANNEL_TLS == n->channel)
+        return nettype_tls_connect_start(n);
+#endif
+    if (NETWORK_CHANNEL_TCP == n->channel)
+        return nettype_tcp_connect_start(n);
+    return network_connect(n);
+}
+
+/**
+ * @brief 在套接字就绪后继续 network_connect_start() 开始的连接。
+ *
+ * @param n 指向网络对象的指针。
+ * @return int 已连接返回MQTT_SUCCESS_ERROR，仍在进行中返回MQTT_WOULD_BLOCK_ERROR，失败时返回错误码，此时连接已关闭。
+ */
+int network_connect_continue(network_t *n)
+{
+#ifndef MQTT_NETWORK_TYPE_NO_TLS
+    if (NETWORK_CHANNEL_TLS == n->channel)
+        return nettype_tls_connect_continue(n);
+#endif
+    if ((NETWORK_CHANNEL_TCP == n->channel) && (0 != n->want))
+        return nettype_tcp_connect_continue(n);
+    RETURN_ERROR((n->socket >= 0) ? MQTT_SUCCESS_ERROR : MQTT_NOT_CONNECT_ERROR);
+}
+
+/**
+ * @brief 获取异步连接等待的事件。
+ *
+ * @param n 指向网络对象的指针。
+ * @return int NETWORK_WANT_READ 和/或 NETWORK_WANT_WRITE，0 表示无需等待套接字，让出 CPU 后即可继续。
+ */
+int network_connect_want(network_t *n)
+{
+    return n->want;
+}
+
 /**
  * @brief 断开与服务器的连接。
  *
@@ -72,9 +198,19 @@ int network_connect(network_t *n)
 void network_disconnect(network_t *n)
 {
 #ifndef MQTT_NETWORK_TYPE_NO_TLS
-    if (n->channel)
+    if (NETWORK_CHANNEL_TLS == n->channel)
         nettype_tls_disconnect(n);
     else
+#endif
+#ifdef PLATFORM_NET_PROTO_UNIX
+    if (NETWORK_CHANNEL_UNIX == n->channel)
+        nettype_unix_disconnect(n);
+    else
+#endif
+#ifdef PLATFORM_NET_PROTO_SHM
+    if (NETWORK_CHANNEL_SHM == n->channel)
+        nettype_shm_disconnect(n);
+    else
 #endif
         nettype_tcp_disconnect(n);
 }
@@ -83,8 +219,8 @@ void network_disconnect(network_t *n)
  * @brief 初始化网络对象。
  *
  * @param n 指向网络对象的指针。
- * @param host 主机地址。
- * @param port 端口号。
+ * @param host 主机地址，以 '/' 或 '@' 开头时视为本机 AF_UNIX 套接字路径，以 "shm:" 开头时视为共享内存段名。
+ * @param port 端口号，AF_UNIX 通道忽略该参数。
  * @param ca 证书信息（如果使用TLS）。
  * @return int 成功时返回MQTT_SUCCESS_ERROR，失败时返回错误码。
  */
@@ -94,12 +230,21 @@ int network_init(network_t *n, const char *host, const char *port, const char *c
         RETURN_ERROR(MQTT_NULL_VALUE_ERROR);
 
     n->socket = -1;
+    n->want = 0;
     n->host = host;
     n->port = port;
+    n->channel = NETWORK_CHANNEL_TCP;
 
-#ifndef MQTT_NETWORK_TYPE_NO_TLS
-    n->channel = 0;
+#ifdef PLATFORM_NET_PROTO_SHM
+    if ((NULL != host) && (0 == strncmp(host, NETWORK_SHM_PREFIX, sizeof(NETWORK_SHM_PREFIX) - 1)))
+        n->channel = NETWORK_CHANNEL_SHM;
+#endif
+#ifdef PLATFORM_NET_PROTO_UNIX
+    if ((NULL != host) && (('/' == host[0]) || ('@' == host[0])))
+        n->channel = NETWORK_CHANNEL_UNIX;
+#endif
 
+#ifndef MQTT_NETWORK_TYPE_NO_TLS
     if (NULL != ca)
     {
         network_set_ca(n, ca);
@@ -115,23 +260,227 @@ int network_init(network_t *n, const char *host, const char *port, const char *c
  */
 void network_release(network_t *n)
 {
+#ifndef MQTT_NETWORK_TYPE_NO_TLS
+    void *tls_session;
+    network_tls_context_t *tls_context;
+    network_tls_stats_t tls_stats;
+#endif
+
     if (n->socket >= 0)
         network_disconnect(n);
 
+#ifndef MQTT_NETWORK_TYPE_NO_TLS
+    /* 保存的会话和 TLS 上下文用于下一次重连，不随连接一起释放 */
+    tls_session = n->tls_session;
+    tls_context = n->tls_context;
+    tls_stats = n->tls_stats;
     memset(n, 0, sizeof(network_t));
+    n->tls_session = tls_session;
+    n->tls_context = tls_context;
+    n->tls_stats = tls_stats;
+#else
+    memset(n, 0, sizeof(network_t));
+#endif
 }
 
 /**
- * @brief 设置网络通道（是否使用TLS）。
+ * @brief 获取 TLS 握手统计，可以用来确认重连是否走了会话恢复。
  *
  * @param n 指向网络对象的指针。
- * @param channel 通道类型。
+ * @param stats 输出握手统计，未启用 TLS 时全部为 0。
+ * @return int 成功时返回MQTT_SUCCESS_ERROR，失败时返回错误码。
  */
-void network_set_channel(network_t *n, int channel)
+int network_get_tls_stats(network_t *n, network_tls_stats_t *stats)
 {
+    if ((NULL == n) || (NULL == stats))
+        RETURN_ERROR(MQTT_NULL_VALUE_ERROR);
+
 #ifndef MQTT_NETWORK_TYPE_NO_TLS
-    n->channel = channel;
+    *stats = n->tls_stats;
+#else
+    memset(stats, 0, sizeof(network_tls_stats_t));
+#endif
+    RETURN_ERROR(MQTT_SUCCESS_ERROR);
+}
+
+/**
+ * @brief 获取内核仍在读取的零拷贝发送数量，为 0 之前以零拷贝发送的数据不能被修改。
+ *
+ * @param n 指向网络对象的指针。
+ * @return int 未完成的零拷贝发送数量，未启用零拷贝时为 0。
+ */
+int network_zerocopy_pending(network_t *n)
+{
+#ifdef PLATFORM_NET_ZEROCOPY
+    if ((NETWORK_CHANNEL_TCP == n->channel) && (n->socket >= 0))
+        return platform_net_socket_zerocopy_pending(n->socket);
+#endif
+    (void)n;
+    return 0;
+}
+
+/**
+ * @brief 获取 mbedtls 当前和峰值内存占用，用来确定一个安全连接实际需要多少 RAM。
+ *
+ * @param mem 输出内存统计，未启用 TLS 时全部为 0。
+ * @return int 成功时返回MQTT_SUCCESS_ERROR，失败时返回错误码。
+ */
+int network_get_tls_memory(network_tls_memory_t *mem)
+{
+    if (NULL == mem)
+        RETURN_ERROR(MQTT_NULL_VALUE_ERROR);
+
+#ifndef MQTT_NETWORK_TYPE_NO_TLS
+    nettype_tls_memory_get(mem);
+#else
+    memset(mem, 0, sizeof(network_tls_memory_t));
 #endif
+    RETURN_ERROR(MQTT_SUCCESS_ERROR);
+}
+
+/**
+ * @brief 把峰值重置为当前占用，之后的峰值只反映接下来的连接。
+ */
+void network_reset_tls_memory_peak(void)
+{
+#ifndef MQTT_NETWORK_TYPE_NO_TLS
+    nettype_tls_memory_reset_peak();
+#endif
+}
+
+/**
+ * @brief 启动 ECDHE 预计算密钥池：由一个低优先级线程在空闲时生成 secp256r1 密钥对，最多保存 MQTT_TLS_ECDHE_POOL_SIZE 个，
+ *        之后的 ECDHE 握手直接取用，省去关键路径上的一次密钥生成。池中的曲线参数表和密钥对从 mbedtls 的内存中分配。
+ *        默认不编译，需要定义 MBEDTLS_ECDH_PRECOMPUTED 并把 MQTT_TLS_ECDHE_POOL_SIZE 设为大于 0。
+ *
+ * @param ctx 密钥对使用该上下文的 DRBG 生成，池持有一个引用直到停止后线程退出
+ * @return int 成功或已经启动时返回MQTT_SUCCESS_ERROR，未启用 TLS 或密钥池时返回MQTT_FAILED_ERROR。
+ */
+int network_tls_ecdhe_pool_start(network_tls_context_t *ctx)
+{
+#ifndef MQTT_NETWORK_TYPE_NO_TLS
+    return nettype_tls_ecdhe_pool_start(ctx);
+#else
+    RETURN_ERROR(MQTT_FAILED_ERROR);
+#endif
+}
+
+/**
+ * @brief 停止密钥池，线程在当前密钥对生成完后退出并释放池中的密钥对，之后的握手恢复现算。
+ */
+void network_tls_ecdhe_pool_stop(void)
+{
+#ifndef MQTT_NETWORK_TYPE_NO_TLS
+    nettype_tls_ecdhe_pool_stop();
+#endif
+}
+
+/**
+ * @brief 获取密钥池的状态。
+ *
+ * @param pool 输出密钥池状态，未启用时全部为 0。
+ * @return int 成功时返回MQTT_SUCCESS_ERROR，失败时返回错误码。
+ */
+int network_get_tls_ecdhe_pool(network_tls_ecdhe_pool_t *pool)
+{
+    if (NULL == pool)
+        RETURN_ERROR(MQTT_NULL_VALUE_ERROR);
+
+#ifndef MQTT_NETWORK_TYPE_NO_TLS
+    nettype_tls_ecdhe_pool_get(pool);
+#else
+    memset(pool, 0, sizeof(network_tls_ecdhe_pool_t));
+#endif
+    RETURN_ERROR(MQTT_SUCCESS_ERROR);
+}
+
+/**
+ * @brief 创建可共享的 TLS 上下文，证书只解析一次、DRBG 只播种一次，之后的每次连接只创建 mbedtls_ssl_context。
+ *
+ * @param cred 证书信息，数据在上下文销毁前必须保持有效。
+ * @return network_tls_context_t* 成功返回上下文，失败或未启用 TLS 时返回 NULL。
+ */
+network_tls_context_t *network_tls_context_create(const network_tls_credentials_t *cred)
+{
+#ifndef MQTT_NETWORK_TYPE_NO_TLS
+    return nettype_tls_context_create(cred);
+#else
+    (void)cred;
+    return NULL;
+#endif
+}
+
+/**
+ * @brief 销毁共享的 TLS 上下文。仍被网络对象引用时，在最后一个引用释放后才真正销毁。
+ *
+ * @param ctx 由 network_tls_context_create() 创建的上下文。
+ */
+void network_tls_context_destroy(network_tls_context_t *ctx)
+{
+#ifndef MQTT_NETWORK_TYPE_NO_TLS
+    nettype_tls_context_put(ctx);
+#else
+    (void)ctx;
+#endif
+}
+
+/**
+ * @brief 为网络对象设置共享的 TLS 上下文，同时将通道设为 TLS。ctx 为 NULL 时释放网络对象持有的上下文。
+ *
+ * @param n 指向网络对象的指针。
+ * @param ctx TLS 上下文。
+ * @return int 成功时返回MQTT_SUCCESS_ERROR，失败时返回错误码。
+ */
+int network_set_tls_context(network_t *n, network_tls_context_t *ctx)
+{
+    if (NULL == n)
+        RETURN_ERROR(MQTT_NULL_VALUE_ERROR);
+
+#ifndef MQTT_NETWORK_TYPE_NO_TLS
+    if (ctx != n->tls_context) {
+        nettype_tls_context_put(n->tls_context);
+        n->tls_context = ctx;
+        if (NULL != ctx)
+            nettype_tls_context_hold(ctx);
+    }
+
+    if (NULL != ctx) {
+        n->ca_crt = (const char *)ctx->ca_src;
+        n->psk = ctx->psk_src;
+        n->channel = NETWORK_CHANNEL_TLS;
+        n->timeout_ms = MQTT_TLS_HANDSHAKE_TIMEOUT;
+    }
+    RETURN_ERROR(MQTT_SUCCESS_ERROR);
+#else
+    (void)ctx;
+    RETURN_ERROR(MQTT_FAILED_ERROR);
+#endif
+}
+
+/**
+ * @brief 释放保存的 TLS 会话，下一次连接将进行完整握手。网络对象不再使用时必须调用。
+ *
+ * @param n 指向网络对象的指针。
+ */
+void network_clear_tls_session(network_t *n)
+{
+#ifndef MQTT_NETWORK_TYPE_NO_TLS
+    if (NULL != n)
+        nettype_tls_session_free(n);
+#else
+    (void)n;
+#endif
+}
+
+/**
+ * @brief 设置网络通道（TCP、TLS、AF_UNIX 或共享内存）。
+ *
+ * @param n 指向网络对象的指针。
+ * @param channel 通道类型，NETWORK_CHANNEL_TCP、NETWORK_CHANNEL_TLS、NETWORK_CHANNEL_UNIX 或 NETWORK_CHANNEL_SHM。
+ */
+void network_set_channel(network_t *n, int channel)
+{
+    n->channel = channel;
 }
 
 /**
@@ -155,6 +504,33 @@ int network_set_ca(network_t *n, const char *ca)
     RETURN_ERROR(MQTT_SUCCESS_ERROR);
 }
 
+/**
+ * @brief 设置预共享密钥，使用 MQTT_TLS_PSK_CIPHERSUITE 套件握手，不需要证书，握手只有对称运算。
+ *
+ * @param n 指向网络对象的指针。
+ * @param identity 密钥标识，以 '\0' 结尾。
+ * @param psk 密钥，数据在网络对象不再使用前必须保持有效。
+ * @param psk_len 密钥长度，不超过 MBEDTLS_PSK_MAX_LEN。
+ * @return int 成功时返回MQTT_SUCCESS_ERROR，失败时返回错误码。
+ */
+int network_set_psk(network_t *n, const char *identity, const unsigned char *psk, unsigned int psk_len)
+{
+#ifndef MQTT_NETWORK_TYPE_NO_TLS
+    if ((NULL == n) || (NULL == identity) || (NULL == psk) || (0 == psk_len))
+        RETURN_ERROR(MQTT_NULL_VALUE_ERROR);
+
+    n->psk = psk;
+    n->psk_len = psk_len;
+    n->psk_identity = identity;
+    n->channel = NETWORK_CHANNEL_TLS;
+    n->timeout_ms = MQTT_TLS_HANDSHAKE_TIMEOUT;
+    RETURN_ERROR(MQTT_SUCCESS_ERROR);
+#else
+    (void)n; (void)identity; (void)psk; (void)psk_len;
+    RETURN_ERROR(MQTT_FAILED_ERROR);
+#endif
+}
+
 /**
  * @brief 设置主机和端口信息。
  *
@@ -8,6 +8,7 @@
 #ifndef _NETWORK_H_
 #define _NETWORK_H_
 
+#include <stddef.h>
 #include "mqtt_defconfig.h"
 
 #ifdef __cplusplus
@@ -16,29 +17,112 @@ extern "C" {
 
 #define     NETWORK_CHANNEL_TCP     0
 #define     NETWORK_CHANNEL_TLS     1
+#define     NETWORK_CHANNEL_UNIX    2       /* 本机 AF_UNIX 流套接字，host 为套接字路径，'@' 开头表示抽象命名空间 */
+#define     NETWORK_CHANNEL_SHM     3       /* 本机共享内存环形缓冲区，host 为 "shm:<name>" */
+
+#define     NETWORK_SHM_PREFIX      "shm:"
+
+/* 异步连接等待的套接字事件，与 PLATFORM_NET_WAIT_READ/PLATFORM_NET_WAIT_WRITE 取值相同 */
+#define     NETWORK_WANT_READ       1
+#define     NETWORK_WANT_WRITE      2
+
+/* network_writev() 的标志：第一段之后的数据可以零拷贝发送，调用者保证内核读完之前不修改它们 */
+#define     NETWORK_WRITE_ZEROCOPY  1
+
+/* 与 POSIX struct iovec 的成员顺序一致，平台层可以直接转换 */
+typedef struct network_iovec {
+    void                        *iov_base;
+    size_t                      iov_len;
+} network_iovec_t;
+
+/* TLS 证书或预共享密钥，证书长度为 0 表示以 '\0' 结尾的 PEM 字符串，否则按 DER 解析（CA 可以是多个 DER 证书首尾相接） */
+typedef struct network_tls_credentials {
+    const unsigned char         *ca;
+    size_t                      ca_len;
+    const unsigned char         *client_crt;    /* 可选的客户端证书和私钥 */
+    size_t                      client_crt_len;
+    const unsigned char         *client_key;
+    size_t                      client_key_len;
+    const unsigned char         *psk;           /* 设置后使用预共享密钥套件，不再使用证书 */
+    size_t                      psk_len;
+    const char                  *psk_identity;
+    int                         pinning;        /* 非 0 时按 host:port 固定第一次完整验证通过的服务器公钥，之后公钥不变的握手跳过证书链验证，仍检查主机名 */
+    const unsigned char         *pin;           /* 可选的服务器证书 SubjectPublicKeyInfo 的 SHA-256（32 字节），设置后公钥必须与它一致，第一次连接仍完整验证证书链 */
+} network_tls_credentials_t;
+
+/* 可在多个连接、多个客户端之间共享的 TLS 上下文（ssl_config、CA 证书链、DRBG、客户端证书） */
+typedef struct nettype_tls_context network_tls_context_t;
+
+/* TLS 握手统计，断开重连后继续累计 */
+typedef struct network_tls_stats {
+    unsigned int                full;           /* 完整握手次数 */
+    unsigned int                resumed;        /* 会话恢复（简化握手）次数 */
+    unsigned int                failed;         /* 握手失败次数 */
+    unsigned int                pinned;         /* 公钥与固定值一致、跳过证书链验证的完整握手次数 */
+    unsigned int                ktls;           /* 记录层交给内核 TLS 加解密的连接次数 */
+    unsigned int                last_ms;        /* 最近一次成功握手的耗时，单位毫秒 */
+} network_tls_stats_t;
+
+/* mbedtls 使用的内存，所有 TLS 连接和上下文合计，单位字节 */
+typedef struct network_tls_memory {
+    size_t                      current;
+    size_t                      peak;
+    size_t                      arena;          /* 静态内存池大小，0 表示从 platform_memory 分配 */
+} network_tls_memory_t;
+
+/* ECDHE 预计算密钥池，hits 为握手直接取用密钥对的次数，misses 为池空时在握手中现算的次数 */
+typedef struct network_tls_ecdhe_pool {
+    unsigned int                ready;          /* 已备好的密钥对数量 */
+    unsigned int                hits;
+    unsigned int                misses;
+} network_tls_ecdhe_pool_t;
 
 typedef struct network {
     const char                  *host;
     const char                  *port;
     int                         socket;
+    int                         channel;        /* tcp, tls or unix */
+    int                         want;           /* 异步连接未完成时等待的事件，0 表示让出 CPU 后即可继续 */
 #ifndef MQTT_NETWORK_TYPE_NO_TLS
-    int                         channel;        /* tcp or tls */
     const char                  *ca_crt;
     unsigned int                ca_crt_len;
     unsigned int                timeout_ms;            // SSL handshake timeout in millisecond
     void                        *nettype_tls_params;
+    const unsigned char         *psk;                  // pre-shared key mode, see network_set_psk()
+    unsigned int                psk_len;
+    const char                  *psk_identity;
+    void                        *tls_session;          // saved session for resumption, kept across network_release()
+    network_tls_context_t       *tls_context;          // shared or per-network configuration, kept across network_release()
+    network_tls_stats_t         tls_stats;
 #endif
 } network_t;
 
 int network_init(network_t *n, const char *host, const char *port, const char *ca);
 int network_set_ca(network_t *n, const char *ca);
+int network_set_psk(network_t *n, const char *identity, const unsigned char *psk, unsigned int psk_len);
 void network_set_channel(network_t *n, int channel);
 int network_set_host_port(network_t* n, char *host, char *port);
 int network_read(network_t* n, unsigned char* buf, int len, int timeout);
+int network_wait(network_t* n, int timeout);
 int network_write(network_t* n, unsigned char* buf, int len, int timeout);
+int network_writev(network_t* n, const network_iovec_t* iov, int iovcnt, int flags, int timeout);
 int network_connect(network_t* n);
+int network_connect_start(network_t* n);
+int network_connect_continue(network_t* n);
+int network_connect_want(network_t* n);
 void network_disconnect(network_t *n);
 void network_release(network_t* n);
+int network_get_tls_stats(network_t* n, network_tls_stats_t* stats);
+int network_zerocopy_pending(network_t* n);
+int network_get_tls_memory(network_tls_memory_t *mem);
+void network_reset_tls_memory_peak(void);
+int network_tls_ecdhe_pool_start(network_tls_context_t *ctx);
+void network_tls_ecdhe_pool_stop(void);
+int network_get_tls_ecdhe_pool(network_tls_ecdhe_pool_t *pool);
+void network_clear_tls_session(network_t* n);
+network_tls_context_t *network_tls_context_create(const network_tls_credentials_t* cred);
+void network_tls_context_destroy(network_tls_context_t* ctx);
+int network_set_tls_context(network_t* n, network_tls_context_t* ctx);
 
 #ifdef __cplusplus
 }
@@ -19,6 +19,23 @@ int platform_mutex_init(platform_mutex_t *m)
     return 0;
 }
 
+/**
+ * @brief 在互斥锁对象自身的存储空间上初始化互斥锁，不使用堆内存。
+ *
+ * @param m 指向平台互斥锁对象的指针。
+ * @return int 成功时返回0，失败或未开启 configSUPPORT_STATIC_ALLOCATION 时返回非0。
+ */
+int platform_mutex_init_static(platform_mutex_t *m)
+{
+#if (configSUPPORT_STATIC_ALLOCATION == 1)
+    m->mutex = xSemaphoreCreateMutexStatic(&m->storage);
+    return (NULL != m->mutex) ? 0 : -1;
+#else
+    m->mutex = NULL;
+    return -1;
+#endif
+}
+
 /**
  * @brief 加锁互斥锁。如果互斥锁已被占用，调用者将阻塞直到互斥锁可用。
  *
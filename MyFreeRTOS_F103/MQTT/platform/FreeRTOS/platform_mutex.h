@@ -13,9 +13,13 @@
 
 typedef struct platform_mutex {
     SemaphoreHandle_t mutex;
+#if (configSUPPORT_STATIC_ALLOCATION == 1)
+    StaticSemaphore_t storage;
+#endif
 } platform_mutex_t;
 
 int platform_mutex_init(platform_mutex_t* m);
+int platform_mutex_init_static(platform_mutex_t* m);
 int platform_mutex_lock(platform_mutex_t* m);
 int platform_mutex_trylock(platform_mutex_t* m);
 int platform_mutex_unlock(platform_mutex_t* m);
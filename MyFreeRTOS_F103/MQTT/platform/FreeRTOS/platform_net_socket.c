@@ -21,6 +21,30 @@ int platform_net_socket_connect(const char *host, const char *port, int proto)
     return 0;
 }
 
+/**
+ * @brief 开始连接网络主机，不等待连接完成。
+ *
+ * @param host 要连接的主机地址。
+ * @param port 要连接的端口号。
+ * @param proto 使用的协议（例如TCP或UDP）。
+ * @return int 成功时返回套接字，连接可能仍在进行中，失败时返回负数。未接入协议栈时按阻塞方式连接。
+ */
+int platform_net_socket_connect_start(const char *host, const char *port, int proto)
+{
+    return platform_net_socket_connect(host, port, proto);
+}
+
+/**
+ * @brief 查询 platform_net_socket_connect_start() 开始的连接是否完成。
+ *
+ * @param fd 套接字的文件描述符。
+ * @return int 已连接返回0，仍在进行中返回 MQTT_WOULD_BLOCK_ERROR，失败返回其他负数。
+ */
+int platform_net_socket_connect_result(int fd)
+{
+    return 0;
+}
+
 /**
  * @brief 从套接字接收数据。
  *
@@ -35,6 +59,19 @@ int platform_net_socket_recv(int fd, void *buf, size_t len, int flags)
     return 0;
 }
 
+/**
+ * @brief 等待套接字可读或可写。
+ *
+ * @param fd 套接字的文件描述符。
+ * @param events 等待的事件，PLATFORM_NET_WAIT_READ 和/或 PLATFORM_NET_WAIT_WRITE。
+ * @param timeout 超时时间。
+ * @return int 返回就绪的事件，超时返回0，失败返回负数。未接入协议栈时直接返回就绪，由读写函数处理超时。
+ */
+int platform_net_socket_wait(int fd, int events, int timeout)
+{
+    return events;
+}
+
 /**
  * @brief 在指定的超时时间内从套接字接收数据。
  *
@@ -76,6 +113,34 @@ int platform_net_socket_write_timeout(int fd, unsigned char *buf, int len, int t
     return 0;
 }
 
+/**
+ * @brief 将多段数据依次写入套接字。
+ *
+ * @param fd 套接字的文件描述符。
+ * @param iov 数据段数组。
+ * @param iovcnt 数据段数量。
+ * @param flags 发送标志，协议栈不支持时忽略。
+ * @param timeout 超时时间。
+ * @return int 返回写入的字节数，失败时返回负数。
+ */
+int platform_net_socket_writev(int fd, const network_iovec_t *iov, int iovcnt, int flags, int timeout)
+{
+    int i, len, sent = 0;
+
+    (void)flags;
+
+    for (i = 0; i < iovcnt; i++) {
+        len = platform_net_socket_write_timeout(fd, (unsigned char *)iov[i].iov_base, (int)iov[i].iov_len, timeout);
+        if (len < 0)
+            return (sent > 0) ? sent : len;
+        sent += len;
+        if (len != (int)iov[i].iov_len)
+            break;
+    }
+
+    return sent;
+}
+
 /**
  * @brief 关闭指定的套接字。
  *
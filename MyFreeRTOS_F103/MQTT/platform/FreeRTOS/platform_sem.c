@@ -0,0 +1,57 @@
+/*
+ * @Date: 2026-10-19
+ * @Description: binary semaphore, one thread waits for an event signalled by another.
+ */
+#include "platform_sem.h"
+
+/**
+ * @brief 初始化信号量，初始状态为无信号。开启 configSUPPORT_STATIC_ALLOCATION 时使用对象自身的存储空间，不使用堆内存。
+ *
+ * @param s 指向平台信号量对象的指针。
+ * @return int 成功时返回0，失败时返回非0。
+ */
+int platform_sem_init(platform_sem_t *s)
+{
+#if (configSUPPORT_STATIC_ALLOCATION == 1)
+    s->sem = xSemaphoreCreateBinaryStatic(&s->storage);
+#else
+    s->sem = xSemaphoreCreateBinary();
+#endif
+    return (NULL != s->sem) ? 0 : -1;
+}
+
+/**
+ * @brief 等待信号量，收到信号或超时后返回。
+ *
+ * @param s 指向平台信号量对象的指针。
+ * @param timeout 超时时间，单位毫秒。
+ * @return int 收到信号时返回0，超时返回非0。
+ */
+int platform_sem_wait(platform_sem_t *s, unsigned int timeout)
+{
+    return (pdTRUE == xSemaphoreTake(s->sem, pdMS_TO_TICKS(timeout))) ? 0 : -1;
+}
+
+/**
+ * @brief 发送信号，唤醒等待的任务。已有信号时不会累加。
+ *
+ * @param s 指向平台信号量对象的指针。
+ * @return int 成功时返回0。
+ */
+int platform_sem_post(platform_sem_t *s)
+{
+    xSemaphoreGive(s->sem);
+    return 0;
+}
+
+/**
+ * @brief 销毁信号量。
+ *
+ * @param s 指向平台信号量对象的指针。
+ * @return int 成功时返回0。
+ */
+int platform_sem_destroy(platform_sem_t *s)
+{
+    vSemaphoreDelete(s->sem);
+    return 0;
+}
@@ -0,0 +1,23 @@
+/*
+ * @Date: 2026-10-19
+ * @Description: binary semaphore, one thread waits for an event signalled by another.
+ */
+#ifndef _PLATFORM_SEM_H_
+#define _PLATFORM_SEM_H_
+
+#include "FreeRTOS.h"
+#include "semphr.h"
+
+typedef struct platform_sem {
+    SemaphoreHandle_t sem;
+#if (configSUPPORT_STATIC_ALLOCATION == 1)
+    StaticSemaphore_t storage;
+#endif
+} platform_sem_t;
+
+int platform_sem_init(platform_sem_t* s);
+int platform_sem_wait(platform_sem_t* s, unsigned int timeout);
+int platform_sem_post(platform_sem_t* s);
+int platform_sem_destroy(platform_sem_t* s);
+
+#endif
@@ -47,6 +47,43 @@ platform_thread_t *platform_thread_init(const char *name,
     return thread;
 }
 
+/**
+ * @brief 在调用者提供的存储空间上创建一个线程，不使用堆内存。
+ *
+ * @param storage 线程对象及任务控制块的存储空间。
+ * @param name 线程名称。
+ * @param entry 线程入口函数。
+ * @param param 传递给线程入口函数的参数。
+ * @param stack 线程栈的存储空间。
+ * @param stack_size 线程栈的大小（字节）。
+ * @param priority 线程的优先级。
+ * @param tick 线程的时间片大小（未使用）。
+ * @return platform_thread_t* 指向创建的线程对象的指针，失败时返回NULL。
+ */
+platform_thread_t *platform_thread_init_static(platform_thread_static_t *storage,
+                                               const char *name,
+                                               void (*entry)(void *),
+                                               void *const param,
+                                               void *stack,
+                                               unsigned int stack_size,
+                                               unsigned int priority,
+                                               unsigned int tick)
+{
+#if (configSUPPORT_STATIC_ALLOCATION == 1)
+    (void)tick; // 未使用的参数
+
+    if ((NULL == storage) || (NULL == stack))
+        return NULL;
+
+    storage->thread.thread = xTaskCreateStatic(entry, name, stack_size / sizeof(StackType_t), param, priority,
+                                               (StackType_t *)stack, &storage->tcb);
+
+    return (NULL != storage->thread.thread) ? &storage->thread : NULL;
+#else
+    return NULL;
+#endif
+}
+
 /**
  * @brief 启动线程。
  *
@@ -90,3 +127,14 @@ void platform_thread_destroy(platform_thread_t *thread)
     // 释放线程对象的内存
     platform_memory_free(thread);
 }
+
+/**
+ * @brief 销毁静态创建的线程，线程对象的存储空间由调用者管理。
+ *
+ * @param thread 指向要销毁的线程对象的指针。
+ */
+void platform_thread_destroy_static(platform_thread_t *thread)
+{
+    if (NULL != thread)
+        vTaskDelete(thread->thread);
+}
@@ -15,15 +15,31 @@ typedef struct platform_thread {
     TaskHandle_t thread;
 } platform_thread_t;
 
+typedef struct platform_thread_static {
+    platform_thread_t thread;
+#if (configSUPPORT_STATIC_ALLOCATION == 1)
+    StaticTask_t tcb;
+#endif
+} platform_thread_static_t;
+
 platform_thread_t *platform_thread_init( const char *name,
                                         void (*entry)(void *),
                                         void * const param,
                                         unsigned int stack_size,
                                         unsigned int priority,
                                         unsigned int tick);
+platform_thread_t *platform_thread_init_static(platform_thread_static_t *storage,
+                                        const char *name,
+                                        void (*entry)(void *),
+                                        void * const param,
+                                        void *stack,
+                                        unsigned int stack_size,
+                                        unsigned int priority,
+                                        unsigned int tick);
 void platform_thread_startup(platform_thread_t* thread);
 void platform_thread_stop(platform_thread_t* thread);
 void platform_thread_start(platform_thread_t* thread);
 void platform_thread_destroy(platform_thread_t* thread);
+void platform_thread_destroy_static(platform_thread_t* thread);
 
 #endif
@@ -98,11 +98,11 @@ unsigned long platform_timer_now(void)
  */
 void platform_timer_usleep(unsigned long usec)
 {
-    TickType_t tick;
+    TickType_t tick = 0;    // 0 时 vTaskDelay 只让出 CPU
 
     if (usec != 0)
     {
-        tick = usec / portTICK_PERIOD_MS;
+        tick = (usec / 1000) / portTICK_PERIOD_MS;
 
         if (tick == 0)
             tick = 1;
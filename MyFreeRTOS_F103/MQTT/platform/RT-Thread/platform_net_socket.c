@@ -42,11 +42,51 @@ int platform_net_socket_connect(const char *host, const char *port, int proto)
     return ret;
 }
 
+/* the connection is completed by the blocking connect, the first readiness check reports it */
+int platform_net_socket_connect_start(const char *host, const char *port, int proto)
+{
+    return platform_net_socket_connect(host, port, proto);
+}
+
+int platform_net_socket_connect_result(int fd)
+{
+    return (fd < 0) ? MQTT_CONNECT_FAILED_ERROR : 0;
+}
+
 int platform_net_socket_recv(int fd, void *buf, size_t len, int flags)
 {
     return recv(fd, buf, len, flags);
 }
 
+int platform_net_socket_wait(int fd, int events, int timeout)
+{
+    int rc;
+    fd_set rset, wset;
+    struct timeval tv;
+
+    tv.tv_sec = (timeout > 0) ? timeout / 1000 : 0;
+    tv.tv_usec = (timeout > 0) ? (timeout % 1000) * 1000 : 0;
+
+    FD_ZERO(&rset);
+    FD_ZERO(&wset);
+    if (events & PLATFORM_NET_WAIT_READ)
+        FD_SET(fd, &rset);
+    if (events & PLATFORM_NET_WAIT_WRITE)
+        FD_SET(fd, &wset);
+
+    rc = select(fd + 1, &rset, &wset, NULL, &tv);
+    if (rc <= 0)
+        return rc;
+
+    rc = 0;
+    if (FD_ISSET(fd, &rset))
+        rc |= PLATFORM_NET_WAIT_READ;
+    if (FD_ISSET(fd, &wset))
+        rc |= PLATFORM_NET_WAIT_WRITE;
+
+    return rc;
+}
+
 int platform_net_socket_recv_timeout(int fd, unsigned char *buf, int len, int timeout)
 {
     int nread;
@@ -102,6 +142,25 @@ int platform_net_socket_write_timeout(int fd, unsigned char *buf, int len, int t
 	return send(fd, buf, len, 0);
 }
 
+int platform_net_socket_writev(int fd, const network_iovec_t *iov, int iovcnt, int flags, int timeout)
+{
+    int i, len, sent = 0;
+
+    (void)flags;
+
+    /* no vectored send in the stack, write the segments one by one */
+    for (i = 0; i < iovcnt; i++) {
+        len = platform_net_socket_write_timeout(fd, (unsigned char *)iov[i].iov_base, (int)iov[i].iov_len, timeout);
+        if (len < 0)
+            return (sent > 0) ? sent : len;
+        sent += len;
+        if (len != (int)iov[i].iov_len)
+            break;
+    }
+
+    return sent;
+}
+
 int platform_net_socket_close(int fd)
 {
     return closesocket(fd);
@@ -33,11 +33,21 @@
 #define PLATFORM_NET_PROTO_TCP  0 /**< The TCP transport protocol */
 #define PLATFORM_NET_PROTO_UDP  1 /**< The UDP transport protocol */
 
+#define PLATFORM_NET_WAIT_READ  1 /**< Wait until the socket is readable */
+#define PLATFORM_NET_WAIT_WRITE 2 /**< Wait until the socket is writable */
+
+#define PLATFORM_NET_SEND_ZEROCOPY  1 /**< Send without copying the data where supported */
+#define PLATFORM_NET_SEND_MORE      2 /**< More data follows, hold back a partial segment */
+
 int platform_net_socket_connect(const char *host, const char *port, int proto);
+int platform_net_socket_connect_start(const char *host, const char *port, int proto);
+int platform_net_socket_connect_result(int fd);
 int platform_net_socket_recv(int fd, void *buf, size_t len, int flags);
+int platform_net_socket_wait(int fd, int events, int timeout);
 int platform_net_socket_recv_timeout(int fd, unsigned char *buf, int len, int timeout);
 int platform_net_socket_write(int fd, void *buf, size_t len);
 int platform_net_socket_write_timeout(int fd, unsigned char *buf, int len, int timeout);
+int platform_net_socket_writev(int fd, const network_iovec_t *iov, int iovcnt, int flags, int timeout);
 int platform_net_socket_close(int fd);
 int platform_net_socket_set_block(int fd);
 int platform_net_socket_set_nonblock(int fd);
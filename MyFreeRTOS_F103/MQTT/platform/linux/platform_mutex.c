@@ -12,6 +12,12 @@ int platform_mutex_init(platform_mutex_t* m)
     return pthread_mutex_init(&(m->mutex), NULL);
 }
 
+/* pthread mutexes never allocate, same as platform_mutex_init */
+int platform_mutex_init_static(platform_mutex_t* m)
+{
+    return pthread_mutex_init(&(m->mutex), NULL);
+}
+
 int platform_mutex_lock(platform_mutex_t* m)
 {
     return pthread_mutex_lock(&(m->mutex));
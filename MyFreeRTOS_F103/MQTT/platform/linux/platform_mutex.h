@@ -18,6 +18,7 @@ typedef struct platform_mutex {
 } platform_mutex_t;
 
 int platform_mutex_init(platform_mutex_t* m);
+int platform_mutex_init_static(platform_mutex_t* m);
 int platform_mutex_lock(platform_mutex_t* m);
 int platform_mutex_trylock(platform_mutex_t* m);
 int platform_mutex_unlock(platform_mutex_t* m);
@@ -6,12 +6,112 @@
  * @Description: the code belongs to jiejie, please keep the author information and source code according to the license.
  */
 #include "platform_net_socket.h"
+#include <linux/errqueue.h>
+#ifdef PLATFORM_NET_KTLS
+#include <linux/tls.h>
+#endif
 
-int platform_net_socket_connect(const char *host, const char *port, int proto)
+#define PLATFORM_NET_IOV_MAX    8
+
+#ifdef PLATFORM_NET_ZEROCOPY
+/* zerocopy sends issued and completed on each socket. The kernel keeps referencing the
+ * pages of a send until its completion arrives on the error queue; completions are reaped
+ * without blocking whenever the socket is written or waited on */
+static struct platform_net_zerocopy {
+    uint32_t sent;
+    uint32_t done;
+} platform_net_zerocopy[PLATFORM_NET_ZEROCOPY_FD_MAX];
+
+static void platform_net_socket_zerocopy_reset(int fd)
+{
+    if ((fd >= 0) && (fd < PLATFORM_NET_ZEROCOPY_FD_MAX)) {
+        __atomic_store_n(&platform_net_zerocopy[fd].sent, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&platform_net_zerocopy[fd].done, 0, __ATOMIC_RELAXED);
+    }
+}
+
+/* drains the completions that have arrived, returns how many error queue entries were read */
+static int platform_net_socket_zerocopy_reap(int fd)
+{
+    int num = 0;
+    char control[128];
+    struct msghdr msg;
+    struct cmsghdr *cm;
+    struct sock_extended_err *serr;
+
+    if ((fd < 0) || (fd >= PLATFORM_NET_ZEROCOPY_FD_MAX) ||
+        (__atomic_load_n(&platform_net_zerocopy[fd].sent, __ATOMIC_ACQUIRE) ==
+         __atomic_load_n(&platform_net_zerocopy[fd].done, __ATOMIC_ACQUIRE)))
+        return 0;
+
+    for (;;) {
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+
+        if (recvmsg(fd, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) < 0) {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+        num++;
+
+        for (cm = CMSG_FIRSTHDR(&msg); cm != NULL; cm = CMSG_NXTHDR(&msg, cm)) {
+            serr = (struct sock_extended_err *)CMSG_DATA(cm);
+            if ((serr->ee_errno != 0) || (serr->ee_origin != SO_EE_ORIGIN_ZEROCOPY))
+                continue;
+
+            /* ee_info .. ee_data is the range of completed sends */
+            __atomic_add_fetch(&platform_net_zerocopy[fd].done, serr->ee_data - serr->ee_info + 1, __ATOMIC_RELEASE);
+        }
+    }
+
+    return num;
+}
+#endif
+
+static int platform_net_socket_connect_unix(const char *path)
+{
+    int fd;
+    size_t len;
+    socklen_t addrlen;
+    struct sockaddr_un addr;
+
+    len = strlen(path);
+    if ((len == 0) || (len >= sizeof(addr.sun_path)))
+        return MQTT_SOCKET_UNKNOWN_HOST_ERROR;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    memcpy(addr.sun_path, path, len);
+    addrlen = offsetof(struct sockaddr_un, sun_path) + len;
+
+    /* a leading '@' names a socket in the abstract namespace */
+    if (path[0] == '@')
+        addr.sun_path[0] = '\0';
+    else
+        addrlen += 1;
+
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0)
+        return MQTT_SOCKET_FAILED_ERROR;
+
+    if (connect(fd, (struct sockaddr *)&addr, addrlen) != 0) {
+        close(fd);
+        return MQTT_CONNECT_FAILED_ERROR;
+    }
+
+    return fd;
+}
+
+static int platform_net_socket_open(const char *host, const char *port, int proto, int nonblock)
 {
     int fd, ret = MQTT_SOCKET_UNKNOWN_HOST_ERROR;
     struct addrinfo hints, *addr_list, *cur;
     
+    if (proto == PLATFORM_NET_PROTO_UNIX)
+        return platform_net_socket_connect_unix(host);
+
     /* Do name resolution with both IPv6 and IPv4 */
     memset(&hints, 0, sizeof(hints));
     hints.ai_family = AF_UNSPEC;
@@ -29,8 +129,22 @@ int platform_net_socket_connect(const char *host, const char *port, int proto)
             continue;
         }
 
-        if (connect(fd, cur->ai_addr, cur->ai_addrlen) == 0) {
+        if (nonblock)
+            platform_net_socket_set_nonblock(fd);
+
+        /* a non-blocking connect keeps the first address that accepts the attempt */
+        if ((connect(fd, cur->ai_addr, cur->ai_addrlen) == 0) || (nonblock && (errno == EINPROGRESS))) {
             ret = fd;
+            if (proto == PLATFORM_NET_PROTO_TCP) {
+                platform_net_socket_set_nodelay(fd, MQTT_NETWORK_TCP_NODELAY);
+#ifdef PLATFORM_NET_ZEROCOPY
+                {
+                    int one = 1;
+                    setsockopt(fd, SOL_SOCKET, SO_ZEROCOPY, &one, sizeof(one));
+                    platform_net_socket_zerocopy_reset(fd);
+                }
+#endif
+            }
             break;
         }
 
@@ -42,41 +156,113 @@ int platform_net_socket_connect(const char *host, const char *port, int proto)
     return ret;
 }
 
+int platform_net_socket_connect(const char *host, const char *port, int proto)
+{
+    return platform_net_socket_open(host, port, proto, 0);
+}
+
+/* only the tcp handshake runs in the background, name resolution still blocks */
+int platform_net_socket_connect_start(const char *host, const char *port, int proto)
+{
+    return platform_net_socket_open(host, port, proto, 1);
+}
+
+int platform_net_socket_connect_result(int fd)
+{
+    int rc, err = 0;
+    socklen_t len = sizeof(err);
+
+    rc = platform_net_socket_wait(fd, PLATFORM_NET_WAIT_WRITE, 0);
+    if (rc == 0)
+        return MQTT_WOULD_BLOCK_ERROR;
+
+    if ((rc < 0) || (getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &len) != 0) || (err != 0))
+        return MQTT_CONNECT_FAILED_ERROR;
+
+    /* the read and write paths expect a blocking socket */
+    platform_net_socket_set_block(fd);
+    return 0;
+}
+
 int platform_net_socket_recv(int fd, void *buf, size_t len, int flags)
 {
     return recv(fd, buf, len, flags);
 }
 
+int platform_net_socket_wait(int fd, int events, int timeout)
+{
+    int rc;
+    struct pollfd pfd;
+    platform_timer_t deadline;
+
+    pfd.fd = fd;
+    pfd.events = 0;
+    if (events & PLATFORM_NET_WAIT_READ)
+        pfd.events |= POLLIN;
+    if (events & PLATFORM_NET_WAIT_WRITE)
+        pfd.events |= POLLOUT;
+
+    platform_timer_cutdown(&deadline, (timeout > 0) ? timeout : 0);
+
+    for (;;) {
+        pfd.revents = 0;
+        do {
+            rc = poll(&pfd, 1, platform_timer_remain(&deadline));
+        } while ((rc < 0) && (errno == EINTR));
+
+        if (rc <= 0)
+            return rc;
+
+#ifdef PLATFORM_NET_ZEROCOPY
+        /* zerocopy completions on the error queue also raise POLLERR, they are not a socket error */
+        if (((pfd.revents & (POLLERR | POLLIN | POLLOUT | POLLHUP)) == POLLERR) &&
+            (platform_net_socket_zerocopy_reap(fd) > 0))
+            continue;
+#endif
+        break;
+    }
+
+    rc = 0;
+    /* a hang up or an error is reported as readable, the following recv returns it */
+    if (pfd.revents & (POLLIN | POLLHUP | POLLERR))
+        rc |= PLATFORM_NET_WAIT_READ;
+    if (pfd.revents & (POLLOUT | POLLHUP | POLLERR))
+        rc |= PLATFORM_NET_WAIT_WRITE;
+
+    return rc & events;
+}
+
 int platform_net_socket_recv_timeout(int fd, unsigned char *buf, int len, int timeout)
 {
     int nread;
     int nleft = len;
-    unsigned char *ptr; 
-    ptr = buf;
-
-    struct timeval tv = {
-        timeout / 1000, 
-        (timeout % 1000) * 1000
-    };
-    
-    if (tv.tv_sec < 0 || (tv.tv_sec == 0 && tv.tv_usec <= 0)) {
-        tv.tv_sec = 0;
-        tv.tv_usec = 100;
-    }
+    unsigned char *ptr = buf;
+    platform_timer_t deadline;
 
-    platform_net_socket_setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, (char *)&tv, sizeof(struct timeval));
+    /* the whole read shares one absolute deadline, partial reads do not restart the timeout */
+    platform_timer_cutdown(&deadline, (timeout > 0) ? timeout : 0);
 
     while (nleft > 0) {
-        nread = platform_net_socket_recv(fd, ptr, nleft, 0);
-        if (nread < 0) {
-            return -1;
-        } else if (nread == 0) {
-            break;
+        nread = recv(fd, ptr, nleft, MSG_DONTWAIT);
+        if (nread > 0) {
+            nleft -= nread;
+            ptr += nread;
+            continue;
         }
 
-        nleft -= nread;
-        ptr += nread;
+        if (nread == 0) {
+            /* peer closed the connection */
+            return (nleft == len) ? -1 : len - nleft;
+        }
+
+        if ((errno != EAGAIN) && (errno != EWOULDBLOCK) && (errno != EINTR))
+            return -1;
+
+        if ((platform_timer_is_expired(&deadline)) ||
+            (platform_net_socket_wait(fd, PLATFORM_NET_WAIT_READ, platform_timer_remain(&deadline)) < 0))
+            break;
     }
+
     return len - nleft;
 }
 
@@ -87,23 +273,127 @@ int platform_net_socket_write(int fd, void *buf, size_t len)
 
 int platform_net_socket_write_timeout(int fd, unsigned char *buf, int len, int timeout)
 {
-    struct timeval tv = {
-        timeout / 1000, 
-        (timeout % 1000) * 1000
-    };
-    
-    if (tv.tv_sec < 0 || (tv.tv_sec == 0 && tv.tv_usec <= 0)) {
-        tv.tv_sec = 0;
-        tv.tv_usec = 100;
+    int nwrite;
+    int nleft = len;
+    unsigned char *ptr = buf;
+    platform_timer_t deadline;
+
+    platform_timer_cutdown(&deadline, (timeout > 0) ? timeout : 0);
+
+    while (nleft > 0) {
+        nwrite = send(fd, ptr, nleft, MSG_DONTWAIT | MSG_NOSIGNAL);
+        if (nwrite > 0) {
+            nleft -= nwrite;
+            ptr += nwrite;
+            continue;
+        }
+
+        if ((nwrite < 0) && (errno != EAGAIN) && (errno != EWOULDBLOCK) && (errno != EINTR))
+            return (nleft == len) ? -1 : len - nleft;
+
+        if ((platform_timer_is_expired(&deadline)) ||
+            (platform_net_socket_wait(fd, PLATFORM_NET_WAIT_WRITE, platform_timer_remain(&deadline)) < 0))
+            break;
     }
 
-    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, (char *)&tv,sizeof(struct timeval));
-    
-    return write(fd, buf, len);
+    return len - nleft;
+}
+
+int platform_net_socket_writev(int fd, const network_iovec_t *iov, int iovcnt, int flags, int timeout)
+{
+    int i, idx = 0, nwrite, sent = 0, total = 0;
+    int send_flags = MSG_DONTWAIT | MSG_NOSIGNAL;
+    struct iovec vec[PLATFORM_NET_IOV_MAX];
+    struct msghdr msg;
+    platform_timer_t deadline;
+
+    if ((iovcnt <= 0) || (iovcnt > PLATFORM_NET_IOV_MAX))
+        return -1;
+
+    for (i = 0; i < iovcnt; i++) {
+        vec[i].iov_base = iov[i].iov_base;
+        vec[i].iov_len = iov[i].iov_len;
+        total += (int)iov[i].iov_len;
+    }
+
+#ifdef PLATFORM_NET_ZEROCOPY
+    /* the completions of earlier sends are collected here, writev never waits for them */
+    platform_net_socket_zerocopy_reap(fd);
+    if ((flags & PLATFORM_NET_SEND_ZEROCOPY) && (fd < PLATFORM_NET_ZEROCOPY_FD_MAX))
+        send_flags |= MSG_ZEROCOPY;
+#endif
+    if (flags & PLATFORM_NET_SEND_MORE)
+        send_flags |= MSG_MORE;
+
+    platform_timer_cutdown(&deadline, (timeout > 0) ? timeout : 0);
+
+    while (sent < total) {
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = &vec[idx];
+        msg.msg_iovlen = iovcnt - idx;
+
+        nwrite = sendmsg(fd, &msg, send_flags);
+        if (nwrite > 0) {
+            sent += nwrite;
+#ifdef PLATFORM_NET_ZEROCOPY
+            if (send_flags & MSG_ZEROCOPY)
+                __atomic_add_fetch(&platform_net_zerocopy[fd].sent, 1, __ATOMIC_RELEASE);
+#endif
+            /* skip the segments that were sent completely, trim the partial one */
+            while ((idx < iovcnt) && ((size_t)nwrite >= vec[idx].iov_len)) {
+                nwrite -= (int)vec[idx].iov_len;
+                idx++;
+            }
+            if (idx < iovcnt) {
+                vec[idx].iov_base = (char *)vec[idx].iov_base + nwrite;
+                vec[idx].iov_len -= nwrite;
+            }
+            continue;
+        }
+
+#ifdef PLATFORM_NET_ZEROCOPY
+        /* out of optmem for pinned pages, fall back to a copying send */
+        if ((nwrite < 0) && (errno == ENOBUFS) && (send_flags & MSG_ZEROCOPY)) {
+            send_flags &= ~MSG_ZEROCOPY;
+            continue;
+        }
+#endif
+
+        if ((nwrite < 0) && (errno != EAGAIN) && (errno != EWOULDBLOCK) && (errno != EINTR)) {
+            if (sent == 0)
+                return -1;
+            break;
+        }
+
+        if ((platform_timer_is_expired(&deadline)) ||
+            (platform_net_socket_wait(fd, PLATFORM_NET_WAIT_WRITE, platform_timer_remain(&deadline)) < 0))
+            break;
+    }
+
+    return sent;
+}
+
+/* zerocopy sends whose buffers the kernel may still read, their data must stay unchanged */
+int platform_net_socket_zerocopy_pending(int fd)
+{
+#ifdef PLATFORM_NET_ZEROCOPY
+    if ((fd < 0) || (fd >= PLATFORM_NET_ZEROCOPY_FD_MAX))
+        return 0;
+
+    platform_net_socket_zerocopy_reap(fd);
+    return (int)(__atomic_load_n(&platform_net_zerocopy[fd].sent, __ATOMIC_ACQUIRE) -
+                 __atomic_load_n(&platform_net_zerocopy[fd].done, __ATOMIC_ACQUIRE));
+#else
+    (void)fd;
+    return 0;
+#endif
 }
 
 int platform_net_socket_close(int fd)
 {
+#ifdef PLATFORM_NET_ZEROCOPY
+    platform_net_socket_zerocopy_reset(fd);
+#endif
     return close(fd);
 }
 
@@ -122,3 +412,107 @@ int platform_net_socket_setsockopt(int fd, int level, int optname, const void *o
     return setsockopt(fd, level, optname, optval, optlen);
 }
 
+int platform_net_socket_set_nodelay(int fd, int on)
+{
+    return setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+}
+
+int platform_net_socket_set_cork(int fd, int on)
+{
+    /* clearing the cork pushes out the queued partial segment */
+    return setsockopt(fd, IPPROTO_TCP, TCP_CORK, &on, sizeof(on));
+}
+
+#ifdef PLATFORM_NET_KTLS
+#ifndef SOL_TLS
+#define SOL_TLS                 282
+#endif
+
+int platform_net_socket_ktls_start(int fd)
+{
+    /* fails with ENOENT when the tls module is not available */
+    return setsockopt(fd, IPPROTO_TCP, TCP_ULP, "tls", sizeof("tls"));
+}
+
+/*
+ * key, iv and seq are the TLS 1.2 write key, the implicit iv (4 bytes for
+ * GCM/CCM, 12 for ChaCha20-Poly1305) and the next record sequence number.
+ * The explicit nonce continues from the sequence number, as mbedtls does.
+ */
+int platform_net_socket_ktls_set(int fd, int dir, int cipher, const unsigned char *key, const unsigned char *iv, const unsigned char *seq)
+{
+    int rc;
+    socklen_t len;
+    volatile unsigned char *p;
+    union {
+        struct tls_crypto_info info;
+#ifdef TLS_CIPHER_AES_GCM_128
+        struct tls12_crypto_info_aes_gcm_128 gcm128;
+#endif
+#ifdef TLS_CIPHER_AES_GCM_256
+        struct tls12_crypto_info_aes_gcm_256 gcm256;
+#endif
+#ifdef TLS_CIPHER_AES_CCM_128
+        struct tls12_crypto_info_aes_ccm_128 ccm128;
+#endif
+#ifdef TLS_CIPHER_CHACHA20_POLY1305
+        struct tls12_crypto_info_chacha20_poly1305 chacha;
+#endif
+    } crypto;
+
+    memset(&crypto, 0, sizeof(crypto));
+    crypto.info.version = TLS_1_2_VERSION;
+
+    switch (cipher) {
+#ifdef TLS_CIPHER_AES_GCM_128
+    case PLATFORM_NET_KTLS_AES_128_GCM:
+        crypto.info.cipher_type = TLS_CIPHER_AES_GCM_128;
+        memcpy(crypto.gcm128.key, key, TLS_CIPHER_AES_GCM_128_KEY_SIZE);
+        memcpy(crypto.gcm128.salt, iv, TLS_CIPHER_AES_GCM_128_SALT_SIZE);
+        memcpy(crypto.gcm128.iv, seq, TLS_CIPHER_AES_GCM_128_IV_SIZE);
+        memcpy(crypto.gcm128.rec_seq, seq, TLS_CIPHER_AES_GCM_128_REC_SEQ_SIZE);
+        len = sizeof(crypto.gcm128);
+        break;
+#endif
+#ifdef TLS_CIPHER_AES_GCM_256
+    case PLATFORM_NET_KTLS_AES_256_GCM:
+        crypto.info.cipher_type = TLS_CIPHER_AES_GCM_256;
+        memcpy(crypto.gcm256.key, key, TLS_CIPHER_AES_GCM_256_KEY_SIZE);
+        memcpy(crypto.gcm256.salt, iv, TLS_CIPHER_AES_GCM_256_SALT_SIZE);
+        memcpy(crypto.gcm256.iv, seq, TLS_CIPHER_AES_GCM_256_IV_SIZE);
+        memcpy(crypto.gcm256.rec_seq, seq, TLS_CIPHER_AES_GCM_256_REC_SEQ_SIZE);
+        len = sizeof(crypto.gcm256);
+        break;
+#endif
+#ifdef TLS_CIPHER_AES_CCM_128
+    case PLATFORM_NET_KTLS_AES_128_CCM:
+        crypto.info.cipher_type = TLS_CIPHER_AES_CCM_128;
+        memcpy(crypto.ccm128.key, key, TLS_CIPHER_AES_CCM_128_KEY_SIZE);
+        memcpy(crypto.ccm128.salt, iv, TLS_CIPHER_AES_CCM_128_SALT_SIZE);
+        memcpy(crypto.ccm128.iv, seq, TLS_CIPHER_AES_CCM_128_IV_SIZE);
+        memcpy(crypto.ccm128.rec_seq, seq, TLS_CIPHER_AES_CCM_128_REC_SEQ_SIZE);
+        len = sizeof(crypto.ccm128);
+        break;
+#endif
+#ifdef TLS_CIPHER_CHACHA20_POLY1305
+    case PLATFORM_NET_KTLS_CHACHA20_POLY1305:
+        crypto.info.cipher_type = TLS_CIPHER_CHACHA20_POLY1305;
+        memcpy(crypto.chacha.key, key, TLS_CIPHER_CHACHA20_POLY1305_KEY_SIZE);
+        memcpy(crypto.chacha.iv, iv, TLS_CIPHER_CHACHA20_POLY1305_IV_SIZE);
+        memcpy(crypto.chacha.rec_seq, seq, TLS_CIPHER_CHACHA20_POLY1305_REC_SEQ_SIZE);
+        len = sizeof(crypto.chacha);
+        break;
+#endif
+    default:
+        return -1;
+    }
+
+    rc = setsockopt(fd, SOL_TLS, (dir == PLATFORM_NET_KTLS_RX) ? TLS_RX : TLS_TX, &crypto, len);
+
+    /* the kernel keeps its own copy of the key */
+    for (p = (volatile unsigned char *)&crypto; p < (volatile unsigned char *)(&crypto + 1); p++)
+        *p = 0;
+
+    return rc;
+}
+#endif
@@ -12,6 +12,8 @@
 #include <sys/param.h>
 #include <sys/time.h>
 #include <sys/select.h>
+#include <poll.h>
+#include <sys/un.h>
 #include <netinet/in.h>
 #include <netinet/tcp.h>
 #include <arpa/inet.h>
@@ -27,6 +29,7 @@
 
 #include "network.h"
 #include "mqtt_error.h"
+#include "platform_timer.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -34,16 +37,52 @@ extern "C" {
 
 #define PLATFORM_NET_PROTO_TCP  0 /**< The TCP transport protocol */
 #define PLATFORM_NET_PROTO_UDP  1 /**< The UDP transport protocol */
+#define PLATFORM_NET_PROTO_UNIX 2 /**< AF_UNIX stream socket, host is the socket path */
+#define PLATFORM_NET_PROTO_SHM  3 /**< Shared-memory ring pair, see platform_shm_ring.h */
+
+#define PLATFORM_NET_WAIT_READ  1 /**< Wait until the socket is readable */
+#define PLATFORM_NET_WAIT_WRITE 2 /**< Wait until the socket is writable */
+
+#define PLATFORM_NET_SEND_ZEROCOPY  1 /**< Send without copying the data where supported */
+#define PLATFORM_NET_SEND_MORE      2 /**< More data follows, hold back a partial segment */
+
+#if (MQTT_NETWORK_ZEROCOPY_MIN > 0) && defined(MSG_ZEROCOPY) && defined(SO_ZEROCOPY)
+#define PLATFORM_NET_ZEROCOPY       1 /**< Zerocopy sends are tracked per socket */
+#define PLATFORM_NET_ZEROCOPY_FD_MAX    1024 /**< Sockets with a higher descriptor send by copying */
+#endif
+
+#if MQTT_TLS_KTLS && defined(TCP_ULP)
+#define PLATFORM_NET_KTLS           1 /**< The kernel can take over the TLS 1.2 record layer */
+#endif
+
+#define PLATFORM_NET_KTLS_TX        1 /**< Kernel encrypts the records sent on the socket */
+#define PLATFORM_NET_KTLS_RX        2 /**< Kernel decrypts the records received on the socket */
+
+#define PLATFORM_NET_KTLS_AES_128_GCM       1
+#define PLATFORM_NET_KTLS_AES_256_GCM       2
+#define PLATFORM_NET_KTLS_AES_128_CCM       3
+#define PLATFORM_NET_KTLS_CHACHA20_POLY1305 4
 
 int platform_net_socket_connect(const char *host, const char *port, int proto);
+int platform_net_socket_connect_start(const char *host, const char *port, int proto);
+int platform_net_socket_connect_result(int fd);
 int platform_net_socket_recv(int fd, void *buf, size_t len, int flags);
+int platform_net_socket_wait(int fd, int events, int timeout);
 int platform_net_socket_recv_timeout(int fd, unsigned char *buf, int len, int timeout);
 int platform_net_socket_write(int fd, void *buf, size_t len);
 int platform_net_socket_write_timeout(int fd, unsigned char *buf, int len, int timeout);
+int platform_net_socket_writev(int fd, const network_iovec_t *iov, int iovcnt, int flags, int timeout);
+int platform_net_socket_zerocopy_pending(int fd);
 int platform_net_socket_close(int fd);
 int platform_net_socket_set_block(int fd);
 int platform_net_socket_set_nonblock(int fd);
 int platform_net_socket_setsockopt(int fd, int level, int optname, const void *optval, socklen_t optlen);
+int platform_net_socket_set_nodelay(int fd, int on);
+int platform_net_socket_set_cork(int fd, int on);
+#ifdef PLATFORM_NET_KTLS
+int platform_net_socket_ktls_start(int fd);
+int platform_net_socket_ktls_set(int fd, int dir, int cipher, const unsigned char *key, const unsigned char *iv, const unsigned char *seq);
+#endif
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,72 @@
+/*
+ * @Date: 2026-10-19
+ * @Description: binary semaphore, one thread waits for an event signalled by another.
+ */
+#include <time.h>
+#include <errno.h>
+#include "platform_sem.h"
+
+/* the condition waits on CLOCK_MONOTONIC so wall-clock changes do not stretch the timeout */
+int platform_sem_init(platform_sem_t* s)
+{
+    pthread_condattr_t attr;
+    int rc;
+
+    s->signalled = 0;
+
+    if (0 != (rc = pthread_mutex_init(&(s->mutex), NULL)))
+        return rc;
+
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    rc = pthread_cond_init(&(s->cond), &attr);
+    pthread_condattr_destroy(&attr);
+
+    if (0 != rc)
+        pthread_mutex_destroy(&(s->mutex));
+
+    return rc;
+}
+
+/* returns 0 when signalled, ETIMEDOUT when the timeout expires first */
+int platform_sem_wait(platform_sem_t* s, unsigned int timeout)
+{
+    struct timespec ts;
+    int rc = 0;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    ts.tv_sec += timeout / 1000;
+    ts.tv_nsec += (timeout % 1000) * 1000000;
+    if (ts.tv_nsec >= 1000000000) {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000;
+    }
+
+    pthread_mutex_lock(&(s->mutex));
+    while ((!s->signalled) && (0 == rc))
+        rc = pthread_cond_timedwait(&(s->cond), &(s->mutex), &ts);
+    if (s->signalled) {
+        s->signalled = 0;
+        rc = 0;
+    }
+    pthread_mutex_unlock(&(s->mutex));
+
+    return rc;
+}
+
+/* a pending signal is not counted twice */
+int platform_sem_post(platform_sem_t* s)
+{
+    pthread_mutex_lock(&(s->mutex));
+    s->signalled = 1;
+    pthread_cond_signal(&(s->cond));
+    pthread_mutex_unlock(&(s->mutex));
+
+    return 0;
+}
+
+int platform_sem_destroy(platform_sem_t* s)
+{
+    pthread_cond_destroy(&(s->cond));
+    return pthread_mutex_destroy(&(s->mutex));
+}
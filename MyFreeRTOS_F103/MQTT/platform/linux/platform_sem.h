@@ -0,0 +1,28 @@
+/*
+ * @Date: 2026-10-19
+ * @Description: binary semaphore, one thread waits for an event signalled by another.
+ */
+#ifndef _PLATFORM_SEM_H_
+#define _PLATFORM_SEM_H_
+#include <pthread.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct platform_sem {
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    int signalled;
+} platform_sem_t;
+
+int platform_sem_init(platform_sem_t* s);
+int platform_sem_wait(platform_sem_t* s, unsigned int timeout);
+int platform_sem_post(platform_sem_t* s);
+int platform_sem_destroy(platform_sem_t* s);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,566 @@
+/*
+ * @Date: 2026-10-19
+ * @Description: pair of single-producer/single-consumer byte rings in a shared-memory segment.
+ */
+#include "platform_shm_ring.h"
+#include <stdio.h>
+#include <string.h>
+#include <limits.h>
+#include <errno.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+#define PLATFORM_SHM_MAGIC              0x4d534852      /* "MSHR" */
+#define PLATFORM_SHM_CACHE_LINE         64
+#define PLATFORM_SHM_NAME_MAX           64
+
+#define PLATFORM_SHM_STATE_CLOSED       0
+#define PLATFORM_SHM_STATE_LISTEN       1
+#define PLATFORM_SHM_STATE_CONNECTED    2
+
+#if defined(__x86_64__) || defined(__i386__)
+    #define platform_shm_cpu_relax()    __builtin_ia32_pause()
+#elif defined(__aarch64__) || defined(__arm__)
+    #define platform_shm_cpu_relax()    __asm__ __volatile__("yield" ::: "memory")
+#else
+    #define platform_shm_cpu_relax()    __asm__ __volatile__("" ::: "memory")
+#endif
+
+/* the producer and the consumer of a ring only write to their own cache line */
+typedef struct platform_shm_ring {
+    uint32_t                    head;               /* producer: bytes written, free running */
+    uint32_t                    writer_waiting;     /* producer: sleeping on a full ring */
+    uint8_t                     pad0[PLATFORM_SHM_CACHE_LINE - 8];
+    uint32_t                    tail;               /* consumer: bytes read, free running */
+    uint32_t                    reader_waiting;     /* consumer: sleeping on an empty ring */
+    uint8_t                     pad1[PLATFORM_SHM_CACHE_LINE - 8];
+} platform_shm_ring_t;
+
+/* segment layout: this header, then the data of ring 0 and of ring 1 */
+typedef struct platform_shm_segment {
+    uint32_t                    magic;
+    uint32_t                    size;               /* bytes per ring, power of two */
+    uint32_t                    state;              /* futex word, PLATFORM_SHM_STATE_* */
+    uint32_t                    pid[2];             /* 0: client, 1: server */
+    uint8_t                     pad[PLATFORM_SHM_CACHE_LINE - 20];
+    platform_shm_ring_t         ring[2];            /* 0: client to server, 1: server to client */
+} platform_shm_segment_t;
+
+typedef struct platform_shm_handle {
+    platform_shm_segment_t      *seg;
+    size_t                      map_len;
+    platform_shm_ring_t         *tx;
+    platform_shm_ring_t         *rx;
+    unsigned char               *tx_data;
+    unsigned char               *rx_data;
+    uint32_t                    mask;
+    uint32_t                    users;              /* calls in progress on this handle */
+    uint32_t                    closing;
+    int                         server;
+    char                        name[PLATFORM_SHM_NAME_MAX];
+} platform_shm_handle_t;
+
+static platform_shm_handle_t platform_shm_handles[MQTT_NETWORK_SHM_NUM_MAX];
+static pthread_mutex_t platform_shm_lock = PTHREAD_MUTEX_INITIALIZER;
+static int platform_shm_spin = -1;
+
+/* spinning only pays off while the peer runs on another cpu, on a single cpu it just delays the peer */
+static int platform_shm_spin_limit(void)
+{
+    if (platform_shm_spin < 0)
+        platform_shm_spin = (sysconf(_SC_NPROCESSORS_ONLN) > 1) ? MQTT_NETWORK_SHM_SPIN : 0;
+    return platform_shm_spin;
+}
+
+static void platform_shm_futex_wait(uint32_t *addr, uint32_t val, int timeout)
+{
+    struct timespec ts;
+
+    if (timeout <= 0)
+        timeout = 1;
+    ts.tv_sec = timeout / 1000;
+    ts.tv_nsec = (timeout % 1000) * 1000000L;
+
+    /* not FUTEX_PRIVATE, the word is shared with the other process */
+    syscall(SYS_futex, addr, FUTEX_WAIT, val, &ts, NULL, 0);
+}
+
+static void platform_shm_futex_wake(uint32_t *addr)
+{
+    syscall(SYS_futex, addr, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+}
+
+/* only called when the waiter has announced itself, so a hand-off without a sleeper costs no syscall */
+static void platform_shm_wake_if_waiting(uint32_t *waiting)
+{
+    if (__atomic_load_n(waiting, __ATOMIC_SEQ_CST)) {
+        __atomic_store_n(waiting, 0, __ATOMIC_RELAXED);
+        platform_shm_futex_wake(waiting);
+    }
+}
+
+static int platform_shm_path(char *path, const char *name)
+{
+    int len;
+
+    if ((NULL == name) || ('\0' == name[0]))
+        return -1;
+
+    /* shm_open() names start with a single '/' */
+    len = snprintf(path, PLATFORM_SHM_NAME_MAX, "%s%s", ('/' == name[0]) ? "" : "/", name);
+    return ((len <= 0) || (len >= PLATFORM_SHM_NAME_MAX)) ? -1 : 0;
+}
+
+static int platform_shm_alloc(platform_shm_segment_t *seg, size_t map_len, int server, const char *path)
+{
+    int i;
+    platform_shm_handle_t *h;
+    unsigned char *data = (unsigned char *)(seg + 1);
+
+    pthread_mutex_lock(&platform_shm_lock);
+    for (i = 0; i < MQTT_NETWORK_SHM_NUM_MAX; i++) {
+        h = &platform_shm_handles[i];
+        if ((NULL != h->seg) || (0 != __atomic_load_n(&h->users, __ATOMIC_SEQ_CST)))
+            continue;
+
+        h->map_len = map_len;
+        h->mask = seg->size - 1;
+        h->server = server;
+        h->tx = &seg->ring[server ? 1 : 0];
+        h->rx = &seg->ring[server ? 0 : 1];
+        h->tx_data = data + (server ? seg->size : 0);
+        h->rx_data = data + (server ? 0 : seg->size);
+        strcpy(h->name, path);
+        __atomic_store_n(&h->closing, 0, __ATOMIC_SEQ_CST);
+        __atomic_store_n(&h->seg, seg, __ATOMIC_RELEASE);
+        pthread_mutex_unlock(&platform_shm_lock);
+        return i;
+    }
+    pthread_mutex_unlock(&platform_shm_lock);
+
+    return MQTT_SOCKET_FAILED_ERROR;
+}
+
+static void platform_shm_release(platform_shm_handle_t *h)
+{
+    size_t map_len = h->map_len;
+    platform_shm_segment_t *seg;
+
+    /* the slot may be reused as soon as seg is cleared, exactly one caller gets to unmap */
+    seg = __atomic_exchange_n(&h->seg, NULL, __ATOMIC_ACQ_REL);
+    if (NULL != seg)
+        munmap(seg, map_len);
+}
+
+static void platform_shm_put(platform_shm_handle_t *h)
+{
+    if ((0 == __atomic_sub_fetch(&h->users, 1, __ATOMIC_SEQ_CST)) && __atomic_load_n(&h->closing, __ATOMIC_SEQ_CST))
+        platform_shm_release(h);
+}
+
+/* the mapping stays valid until put, a close from another thread (the mqttclient drops the
+ * network while the yield thread is reading) only unmaps once the last call has returned */
+static platform_shm_handle_t *platform_shm_hold(int handle)
+{
+    platform_shm_handle_t *h;
+
+    if ((handle < 0) || (handle >= MQTT_NETWORK_SHM_NUM_MAX))
+        return NULL;
+
+    h = &platform_shm_handles[handle];
+    __atomic_add_fetch(&h->users, 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&h->closing, __ATOMIC_SEQ_CST) || (NULL == __atomic_load_n(&h->seg, __ATOMIC_ACQUIRE))) {
+        platform_shm_put(h);
+        return NULL;
+    }
+
+    return h;
+}
+
+static int platform_shm_is_connected(platform_shm_handle_t *h)
+{
+    return PLATFORM_SHM_STATE_CONNECTED == __atomic_load_n(&h->seg->state, __ATOMIC_ACQUIRE);
+}
+
+/* a peer that exits without closing leaves the segment connected, there is no kernel object to
+ * report it like a socket would, so a waiter that had to sleep checks whether the peer still exists */
+static void platform_shm_check_peer(platform_shm_handle_t *h)
+{
+    uint32_t expected = PLATFORM_SHM_STATE_CONNECTED;
+    pid_t pid = (pid_t)__atomic_load_n(&h->seg->pid[h->server ? 0 : 1], __ATOMIC_ACQUIRE);
+
+    if ((pid > 0) && (kill(pid, 0) != 0) && (ESRCH == errno))
+        __atomic_compare_exchange_n(&h->seg->state, &expected, PLATFORM_SHM_STATE_CLOSED, 0,
+                                    __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
+
+/* the peer left the indices of a ring more than a ring apart, nothing in it can be trusted any more */
+static int platform_shm_corrupt(platform_shm_handle_t *h)
+{
+    __atomic_store_n(&h->seg->state, PLATFORM_SHM_STATE_CLOSED, __ATOMIC_SEQ_CST);
+    platform_shm_futex_wake(&h->seg->state);
+    return -1;
+}
+
+/* returns the bytes available, 0 on timeout, -1 once the peer closed and the ring is drained */
+static int platform_shm_wait_readable(platform_shm_handle_t *h, platform_timer_t *deadline)
+{
+    int spin;
+    uint32_t avail;
+    platform_shm_ring_t *r = h->rx;
+
+    for (spin = 0; ; spin++) {
+        avail = __atomic_load_n(&r->head, __ATOMIC_ACQUIRE) - r->tail;
+        if (avail > h->mask + 1)
+            return platform_shm_corrupt(h);
+        if (avail)
+            return (int)avail;
+        if (!platform_shm_is_connected(h))
+            return -1;
+        if (platform_timer_is_expired(deadline))
+            return 0;
+        if (spin < platform_shm_spin_limit()) {
+            platform_shm_cpu_relax();
+            continue;
+        }
+
+        /* announce the sleep, then check again so a concurrent write cannot be missed */
+        __atomic_store_n(&r->reader_waiting, 1, __ATOMIC_SEQ_CST);
+        if ((__atomic_load_n(&r->head, __ATOMIC_SEQ_CST) == r->tail) && platform_shm_is_connected(h))
+            platform_shm_futex_wait(&r->reader_waiting, 1, platform_timer_remain(deadline));
+        __atomic_store_n(&r->reader_waiting, 0, __ATOMIC_RELAXED);
+        platform_shm_check_peer(h);
+    }
+}
+
+/* returns the free space, 0 on timeout, -1 once the peer closed */
+static int platform_shm_wait_writable(platform_shm_handle_t *h, platform_timer_t *deadline)
+{
+    int spin;
+    uint32_t used, room;
+    platform_shm_ring_t *r = h->tx;
+
+    for (spin = 0; ; spin++) {
+        if (!platform_shm_is_connected(h))
+            return -1;
+        used = r->head - __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE);
+        if (used > h->mask + 1)
+            return platform_shm_corrupt(h);
+        room = h->mask + 1 - used;
+        if (room)
+            return (int)room;
+        if (platform_timer_is_expired(deadline))
+            return 0;
+        if (spin < platform_shm_spin_limit()) {
+            platform_shm_cpu_relax();
+            continue;
+        }
+
+        __atomic_store_n(&r->writer_waiting, 1, __ATOMIC_SEQ_CST);
+        if ((r->head - __atomic_load_n(&r->tail, __ATOMIC_SEQ_CST) == h->mask + 1) && platform_shm_is_connected(h))
+            platform_shm_futex_wait(&r->writer_waiting, 1, platform_timer_remain(deadline));
+        __atomic_store_n(&r->writer_waiting, 0, __ATOMIC_RELAXED);
+        platform_shm_check_peer(h);
+    }
+}
+
+int platform_shm_ring_create(const char *name, unsigned int size)
+{
+    int fd, handle;
+    size_t map_len;
+    char path[PLATFORM_SHM_NAME_MAX];
+    platform_shm_segment_t *seg;
+
+    if (0 == size)
+        size = MQTT_NETWORK_SHM_RING_SIZE;
+    if ((size & (size - 1)) || (platform_shm_path(path, name) != 0))
+        return MQTT_SOCKET_UNKNOWN_HOST_ERROR;
+
+    map_len = sizeof(platform_shm_segment_t) + 2 * (size_t)size;
+
+    /* a segment left behind by a server that died is replaced, connected clients keep the old mapping */
+    shm_unlink(path);
+    fd = shm_open(path, O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0)
+        return MQTT_SOCKET_FAILED_ERROR;
+
+    if (ftruncate(fd, map_len) != 0) {
+        close(fd);
+        shm_unlink(path);
+        return MQTT_SOCKET_FAILED_ERROR;
+    }
+
+    seg = mmap(NULL, map_len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (MAP_FAILED == seg) {
+        shm_unlink(path);
+        return MQTT_SOCKET_FAILED_ERROR;
+    }
+
+    /* ftruncate() zero fills, both rings start empty and the segment closed until accept */
+    seg->size = size;
+    seg->pid[1] = (uint32_t)getpid();
+    __atomic_store_n(&seg->magic, PLATFORM_SHM_MAGIC, __ATOMIC_RELEASE);
+
+    handle = platform_shm_alloc(seg, map_len, 1, path);
+    if (handle < 0) {
+        munmap(seg, map_len);
+        shm_unlink(path);
+    }
+
+    return handle;
+}
+
+int platform_shm_ring_accept(int handle, int timeout)
+{
+    int i;
+    uint32_t state;
+    int rc;
+    platform_timer_t deadline;
+    platform_shm_handle_t *h = platform_shm_hold(handle);
+
+    if (NULL == h)
+        return -1;
+    if (!h->server) {
+        platform_shm_put(h);
+        return -1;
+    }
+
+    platform_timer_cutdown(&deadline, (timeout > 0) ? timeout : 0);
+
+    /* the previous client is gone, discard what it left and take a new one */
+    if (PLATFORM_SHM_STATE_CLOSED == __atomic_load_n(&h->seg->state, __ATOMIC_ACQUIRE)) {
+        for (i = 0; i < 2; i++) {
+            h->seg->ring[i].head = 0;
+            h->seg->ring[i].tail = 0;
+            h->seg->ring[i].reader_waiting = 0;
+            h->seg->ring[i].writer_waiting = 0;
+        }
+        h->seg->pid[0] = 0;
+        __atomic_store_n(&h->seg->state, PLATFORM_SHM_STATE_LISTEN, __ATOMIC_SEQ_CST);
+    }
+
+    for (;;) {
+        state = __atomic_load_n(&h->seg->state, __ATOMIC_ACQUIRE);
+        if (PLATFORM_SHM_STATE_CONNECTED == state) {
+            rc = 1;
+            break;
+        }
+        if ((PLATFORM_SHM_STATE_LISTEN != state) || platform_timer_is_expired(&deadline)) {
+            rc = 0;
+            break;
+        }
+        platform_shm_futex_wait(&h->seg->state, state, platform_timer_remain(&deadline));
+    }
+
+    platform_shm_put(h);
+    return rc;
+}
+
+int platform_shm_ring_connect(const char *name)
+{
+    int fd, handle;
+    struct stat st;
+    uint32_t expected = PLATFORM_SHM_STATE_LISTEN;
+    char path[PLATFORM_SHM_NAME_MAX];
+    platform_shm_segment_t *seg;
+
+    if (platform_shm_path(path, name) != 0)
+        return MQTT_SOCKET_UNKNOWN_HOST_ERROR;
+
+    fd = shm_open(path, O_RDWR, 0);
+    if (fd < 0)
+        return MQTT_CONNECT_FAILED_ERROR;
+
+    if ((fstat(fd, &st) != 0) || (st.st_size < (off_t)sizeof(platform_shm_segment_t))) {
+        close(fd);
+        return MQTT_CONNECT_FAILED_ERROR;
+    }
+
+    seg = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (MAP_FAILED == seg)
+        return MQTT_SOCKET_FAILED_ERROR;
+
+    if ((PLATFORM_SHM_MAGIC != __atomic_load_n(&seg->magic, __ATOMIC_ACQUIRE)) ||
+        (0 == seg->size) || (seg->size & (seg->size - 1)) ||
+        ((size_t)st.st_size < sizeof(platform_shm_segment_t) + 2 * (size_t)seg->size)) {
+        munmap(seg, st.st_size);
+        return MQTT_CONNECT_FAILED_ERROR;
+    }
+
+    /* one client per segment, the server must be waiting in accept */
+    if (!__atomic_compare_exchange_n(&seg->state, &expected, PLATFORM_SHM_STATE_CONNECTED, 0,
+                                     __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        munmap(seg, st.st_size);
+        return MQTT_CONNECT_FAILED_ERROR;
+    }
+    __atomic_store_n(&seg->pid[0], (uint32_t)getpid(), __ATOMIC_RELEASE);
+    platform_shm_futex_wake(&seg->state);
+
+    handle = platform_shm_alloc(seg, st.st_size, 0, path);
+    if (handle < 0) {
+        __atomic_store_n(&seg->state, PLATFORM_SHM_STATE_CLOSED, __ATOMIC_SEQ_CST);
+        platform_shm_futex_wake(&seg->state);
+        munmap(seg, st.st_size);
+    }
+
+    return handle;
+}
+
+int platform_shm_ring_wait(int handle, int timeout)
+{
+    int rc;
+    platform_timer_t deadline;
+    platform_shm_handle_t *h = platform_shm_hold(handle);
+
+    if (NULL == h)
+        return -1;
+
+    platform_timer_cutdown(&deadline, (timeout > 0) ? timeout : 0);
+    rc = platform_shm_wait_readable(h, &deadline);
+    platform_shm_put(h);
+
+    return (rc > 0) ? 1 : rc;
+}
+
+int platform_shm_ring_read(int handle, unsigned char *buf, int len, int timeout)
+{
+    int avail;
+    int nleft = len;
+    uint32_t tail, n, off, first;
+    platform_timer_t deadline;
+    platform_shm_handle_t *h = platform_shm_hold(handle);
+
+    if (NULL == h)
+        return -1;
+
+    platform_timer_cutdown(&deadline, (timeout > 0) ? timeout : 0);
+
+    while (nleft > 0) {
+        avail = platform_shm_wait_readable(h, &deadline);
+        if (avail < 0) {
+            platform_shm_put(h);
+            return (nleft == len) ? -1 : len - nleft;
+        }
+        if (avail == 0)
+            break;
+
+        tail = h->rx->tail;
+        n = ((uint32_t)avail < (uint32_t)nleft) ? (uint32_t)avail : (uint32_t)nleft;
+        off = tail & h->mask;
+        first = (n < h->mask + 1 - off) ? n : h->mask + 1 - off;
+        memcpy(buf, h->rx_data + off, first);
+        memcpy(buf + first, h->rx_data, n - first);
+
+        __atomic_store_n(&h->rx->tail, tail + n, __ATOMIC_SEQ_CST);
+        platform_shm_wake_if_waiting(&h->rx->writer_waiting);
+
+        buf += n;
+        nleft -= n;
+    }
+
+    platform_shm_put(h);
+    return len - nleft;
+}
+
+int platform_shm_ring_writev(int handle, const network_iovec_t *iov, int iovcnt, int timeout)
+{
+    int i = 0, room, sent = 0;
+    size_t done = 0;
+    uint32_t head, copied, n, off, first;
+    const unsigned char *src;
+    platform_timer_t deadline;
+    platform_shm_handle_t *h = platform_shm_hold(handle);
+
+    if (NULL == h)
+        return -1;
+
+    platform_timer_cutdown(&deadline, (timeout > 0) ? timeout : 0);
+
+    while (i < iovcnt) {
+        room = platform_shm_wait_writable(h, &deadline);
+        if (room < 0) {
+            platform_shm_put(h);
+            return (sent > 0) ? sent : -1;
+        }
+        if (room == 0)
+            break;
+
+        /* copy every segment that fits, then publish them with one head update */
+        head = h->tx->head;
+        copied = 0;
+        while ((i < iovcnt) && (copied < (uint32_t)room)) {
+            src = (const unsigned char *)iov[i].iov_base + done;
+            n = ((iov[i].iov_len - done) < (uint32_t)room - copied) ? (uint32_t)(iov[i].iov_len - done) : (uint32_t)room - copied;
+            off = (head + copied) & h->mask;
+            first = (n < h->mask + 1 - off) ? n : h->mask + 1 - off;
+            memcpy(h->tx_data + off, src, first);
+            memcpy(h->tx_data, src + first, n - first);
+
+            copied += n;
+            done += n;
+            if (done == iov[i].iov_len) {
+                i++;
+                done = 0;
+            }
+        }
+
+        __atomic_store_n(&h->tx->head, head + copied, __ATOMIC_SEQ_CST);
+        platform_shm_wake_if_waiting(&h->tx->reader_waiting);
+        sent += copied;
+    }
+
+    platform_shm_put(h);
+    return sent;
+}
+
+int platform_shm_ring_write(int handle, const unsigned char *buf, int len, int timeout)
+{
+    network_iovec_t iov;
+
+    iov.iov_base = (void *)buf;
+    iov.iov_len = len;
+
+    return platform_shm_ring_writev(handle, &iov, 1, timeout);
+}
+
+int platform_shm_ring_close(int handle)
+{
+    int i;
+    platform_shm_segment_t *seg;
+    platform_shm_handle_t *h = platform_shm_hold(handle);
+
+    if (NULL == h)
+        return -1;
+
+    if (__atomic_exchange_n(&h->closing, 1, __ATOMIC_SEQ_CST)) {
+        platform_shm_put(h);
+        return -1;
+    }
+
+    seg = h->seg;
+
+    /* clearing the waiting words makes a peer that is about to sleep return at once */
+    __atomic_store_n(&seg->state, PLATFORM_SHM_STATE_CLOSED, __ATOMIC_SEQ_CST);
+    platform_shm_futex_wake(&seg->state);
+    for (i = 0; i < 2; i++) {
+        __atomic_store_n(&seg->ring[i].reader_waiting, 0, __ATOMIC_SEQ_CST);
+        __atomic_store_n(&seg->ring[i].writer_waiting, 0, __ATOMIC_SEQ_CST);
+        platform_shm_futex_wake(&seg->ring[i].reader_waiting);
+        platform_shm_futex_wake(&seg->ring[i].writer_waiting);
+    }
+
+    /* the name goes away at once, the mapping here or with the last call still running on the handle */
+    if (h->server)
+        shm_unlink(h->name);
+    platform_shm_put(h);
+
+    return 0;
+}
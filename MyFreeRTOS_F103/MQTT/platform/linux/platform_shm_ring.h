@@ -0,0 +1,32 @@
+/*
+ * @Date: 2026-10-19
+ * @Description: pair of single-producer/single-consumer byte rings in a shared-memory segment.
+ */
+#ifndef _PLATFORM_SHM_RING_H_
+#define _PLATFORM_SHM_RING_H_
+
+#include <stdint.h>
+
+#include "network.h"
+#include "mqtt_error.h"
+#include "platform_timer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* the side that creates the segment is the server (broker or bridge), the client connects by name */
+int platform_shm_ring_create(const char *name, unsigned int size);
+int platform_shm_ring_accept(int handle, int timeout);
+int platform_shm_ring_connect(const char *name);
+int platform_shm_ring_wait(int handle, int timeout);
+int platform_shm_ring_read(int handle, unsigned char *buf, int len, int timeout);
+int platform_shm_ring_write(int handle, const unsigned char *buf, int len, int timeout);
+int platform_shm_ring_writev(int handle, const network_iovec_t *iov, int iovcnt, int timeout);
+int platform_shm_ring_close(int handle);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _PLATFORM_SHM_RING_H_ */
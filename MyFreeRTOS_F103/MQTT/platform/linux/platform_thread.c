@@ -5,6 +5,7 @@
  * @LastEditTime: 2020-02-23 16:19:07
  * @Description: the code belongs to jiejie, please keep the author information and source code according to the license.
  */
+#include <limits.h>
 #include "platform_thread.h"
 #include "platform_memory.h"
 
@@ -33,6 +34,40 @@ platform_thread_t *platform_thread_init( const char *name,
     return thread;
 }
 
+platform_thread_t *platform_thread_init_static(platform_thread_static_t *storage,
+                                        const char *name,
+                                        void (*entry)(void *),
+                                        void * const param,
+                                        void *stack,
+                                        unsigned int stack_size,
+                                        unsigned int priority,
+                                        unsigned int tick)
+{
+    int res;
+    pthread_attr_t attr;
+    platform_thread_t *thread;
+    void *(*thread_entry) (void *);
+
+    if (NULL == storage)
+        return NULL;
+
+    thread_entry = (void *(*)(void*))entry;
+    thread = &storage->thread;
+
+    thread->mutex = (pthread_mutex_t)PTHREAD_MUTEX_INITIALIZER;
+    thread->cond = (pthread_cond_t)PTHREAD_COND_INITIALIZER;
+
+    pthread_attr_init(&attr);
+    /* a stack smaller than PTHREAD_STACK_MIN is rejected, use the default one */
+    if ((NULL != stack) && (stack_size >= PTHREAD_STACK_MIN))
+        pthread_attr_setstack(&attr, stack, stack_size);
+
+    res = pthread_create(&thread->thread, &attr, thread_entry, param);
+    pthread_attr_destroy(&attr);
+
+    return (0 == res) ? thread : NULL;
+}
+
 void platform_thread_startup(platform_thread_t* thread)
 {
     (void) thread;
@@ -58,4 +93,8 @@ void platform_thread_destroy(platform_thread_t* thread)
         pthread_detach(thread->thread);
 }
 
-
+void platform_thread_destroy_static(platform_thread_t* thread)
+{
+    if (NULL != thread)
+        pthread_detach(thread->thread);
+}
@@ -39,7 +39,9 @@ int platform_timer_remain(platform_timer_t* timer)
 
 unsigned long platform_timer_now(void)
 {
-    return (unsigned long) time(NULL);
+    struct timeval now;
+    gettimeofday(&now, NULL);
+    return (unsigned long) (now.tv_sec * 1000 + now.tv_usec / 1000);
 }
 
 void platform_timer_usleep(unsigned long usec)
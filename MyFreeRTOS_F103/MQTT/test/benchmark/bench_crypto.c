@@ -0,0 +1,700 @@
+/*
+ * @Date: 2026-10-19
+ * @Description: cost of the bundled mbedtls primitives and tls handshakes on the host.
+ *
+ * usage: bench_crypto [seconds_per_primitive]
+ *   primitives: symmetric ciphers and hashes are timed on 64-byte messages (a typical MQTT
+ *   publish) and on 1 KiB blocks; public-key operations are timed per operation.
+ *   handshakes: client and server run in one thread over an in-memory pipe, the client time is
+ *   split by handshake state and each side's heap peak is tracked by a counting allocator.
+ *   "worst" is the longest single client handshake step (averaged over the rounds, the host
+ *   scheduler makes a plain maximum noisy), i.e. how long the calling task holds the CPU without
+ *   a chance to yield; with MBEDTLS_ECP_RESTARTABLE the ECDHE-ECDSA handshake is
+ *   repeated for several mbedtls_ecp_set_max_ops() budgets (MQTT_TLS_ECP_MAX_OPS).
+ *   The test server certificates are secp256r1 (ECDSA) and RSA-2048, the EC test CA is
+ *   secp384r1, ECDHE is restricted to secp256r1.
+ *   "pinned" rows skip the chain verification and compare the SHA-256 of the server public key
+ *   with a pin instead, the way nettype_tls does once a key is pinned (the pin check is client time).
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if !defined(MBEDTLS_CONFIG_FILE)
+#include "mbedtls/config.h"
+#else
+#include MBEDTLS_CONFIG_FILE
+#endif
+
+#include "mbedtls/platform.h"
+#include "mbedtls/ssl.h"
+#include "mbedtls/ssl_cache.h"
+#include "mbedtls/entropy.h"
+#include "mbedtls/ctr_drbg.h"
+#include "mbedtls/certs.h"
+#include "mbedtls/x509_crt.h"
+#include "mbedtls/pk.h"
+#include "mbedtls/ccm.h"
+#include "mbedtls/gcm.h"
+#include "mbedtls/chachapoly.h"
+#include "mbedtls/sha1.h"
+#include "mbedtls/sha256.h"
+#include "mbedtls/md.h"
+#include "mbedtls/ecdh.h"
+#include "mbedtls/ecdsa.h"
+#include "mbedtls/asn1.h"
+
+#define BENCH_SMALL             64
+#define BENCH_LARGE             1024
+#define BENCH_PIPE_SIZE         (MBEDTLS_SSL_OUT_CONTENT_LEN + 2048)
+
+#define BENCH_CLIENT            0
+#define BENCH_SERVER            1
+
+/* client time per handshake phase */
+#define BENCH_PHASE_HELLO       0       /* ClientHello, ServerHello, ServerHelloDone */
+#define BENCH_PHASE_CERT        1       /* server certificate parsing and chain verification */
+#define BENCH_PHASE_SKX         2       /* ServerKeyExchange: signature verification, peer ECDHE share */
+#define BENCH_PHASE_CKX         3       /* ClientKeyExchange: own ECDHE share and premaster */
+#define BENCH_PHASE_FINISH      4       /* key derivation, ChangeCipherSpec and Finished */
+#define BENCH_PHASES            5
+
+typedef struct bench_heap {
+    long current;
+    long peak;
+} bench_heap_t;
+
+typedef struct bench_pipe {
+    size_t len;
+    unsigned char buf[BENCH_PIPE_SIZE];
+} bench_pipe_t;
+
+typedef struct bench_end {
+    bench_pipe_t *tx;
+    bench_pipe_t *rx;
+} bench_end_t;
+
+typedef struct bench_handshake {
+    const char *name;
+    int suite;
+    int rounds;
+    int resume;                 /* resume the first session on every following handshake */
+    const char *ca;             /* NULL for psk */
+    const size_t *ca_len;
+    const char *crt;
+    const size_t *crt_len;
+    const char *key;
+    const size_t *key_len;
+    int pinned;                 /* compare the server public key with a pin instead of verifying the chain */
+} bench_handshake_t;
+
+typedef int (*bench_op_t)(size_t len);
+
+static double bench_seconds = 0.3;
+static int bench_side;
+static bench_heap_t bench_heap[2];
+static long bench_wire;
+
+static mbedtls_entropy_context bench_entropy;
+static mbedtls_ctr_drbg_context bench_drbg;
+static unsigned char bench_in[BENCH_LARGE], bench_out[BENCH_LARGE + 16], bench_tag[16];
+static const unsigned char bench_key[32] = { 0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6, 0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c };
+static const unsigned char bench_iv[12] = { 0xca, 0xfe, 0xba, 0xbe, 0xfa, 0xce, 0xdb, 0xad, 0xde, 0xca, 0xf8, 0x88 };
+static const unsigned char bench_psk[16] = { 0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff };
+static const char bench_psk_identity[] = "node01";
+
+static mbedtls_ccm_context bench_ccm;
+static mbedtls_gcm_context bench_gcm;
+#if defined(MBEDTLS_CHACHAPOLY_C)
+static mbedtls_chachapoly_context bench_chachapoly;
+#endif
+static mbedtls_ecp_group bench_grp;
+static mbedtls_mpi bench_d, bench_z;
+static mbedtls_ecp_point bench_q, bench_peer;
+static mbedtls_ecdsa_context bench_ecdsa;
+static mbedtls_pk_context bench_rsa;
+static unsigned char bench_hash[32], bench_sig[MBEDTLS_MPI_MAX_SIZE];
+static size_t bench_sig_len;
+
+static double bench_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* the size and side live in front of each block so frees are charged to the side that allocated */
+static void *bench_calloc(size_t n, size_t size)
+{
+    size_t *p, total = n * size;
+
+    if (NULL == (p = calloc(1, total + 2 * sizeof(size_t))))
+        return NULL;
+
+    p[0] = total;
+    p[1] = bench_side;
+    bench_heap[bench_side].current += total;
+    if (bench_heap[bench_side].current > bench_heap[bench_side].peak)
+        bench_heap[bench_side].peak = bench_heap[bench_side].current;
+
+    return p + 2;
+}
+
+static void bench_free(void *ptr)
+{
+    size_t *p;
+
+    if (NULL == ptr)
+        return;
+
+    p = (size_t *)ptr - 2;
+    bench_heap[p[1]].current -= p[0];
+    free(p);
+}
+
+/* deterministic entropy is fine for timing, the platform entropy is disabled in this tree */
+static int bench_entropy_source(void *data, unsigned char *output, size_t len, size_t *olen)
+{
+    size_t i;
+
+    (void)data;
+    for (i = 0; i < len; i++)
+        output[i] = (unsigned char)rand();
+    *olen = len;
+    return 0;
+}
+
+/* runs op until the time budget is spent, returns seconds per call */
+static double bench_time(bench_op_t op, size_t len)
+{
+    long n = 0;
+    double start = bench_now(), now;
+
+    do {
+        if (op(len) != 0)
+            return -1;
+        n++;
+    } while ((now = bench_now()) - start < bench_seconds);
+
+    return (now - start) / n;
+}
+
+static void bench_symmetric(const char *name, bench_op_t op)
+{
+    double small = bench_time(op, BENCH_SMALL);
+    double large = bench_time(op, BENCH_LARGE);
+
+    if ((small < 0) || (large < 0)) {
+        printf("%-28s failed\n", name);
+        return;
+    }
+    printf("%-28s %10.2f %10.2f %10.1f\n", name, small * 1e6, large * 1e6, BENCH_LARGE / large / (1024 * 1024));
+}
+
+static void bench_public(const char *name, bench_op_t op)
+{
+    double t = bench_time(op, 0);
+
+    if (t < 0) {
+        printf("%-28s failed\n", name);
+        return;
+    }
+    printf("%-28s %10.3f %10.1f\n", name, t * 1e3, 1 / t);
+}
+
+static int bench_ccm8(size_t len)
+{
+    return mbedtls_ccm_encrypt_and_tag(&bench_ccm, len, bench_iv, 12, NULL, 0, bench_in, bench_out, bench_tag, 8);
+}
+
+static int bench_ccm16(size_t len)
+{
+    return mbedtls_ccm_encrypt_and_tag(&bench_ccm, len, bench_iv, 12, NULL, 0, bench_in, bench_out, bench_tag, 16);
+}
+
+static int bench_gcm128(size_t len)
+{
+    return mbedtls_gcm_crypt_and_tag(&bench_gcm, MBEDTLS_GCM_ENCRYPT, len, bench_iv, 12, NULL, 0, bench_in, bench_out, 16, bench_tag);
+}
+
+#if defined(MBEDTLS_CHACHAPOLY_C)
+static int bench_chacha(size_t len)
+{
+    return mbedtls_chachapoly_encrypt_and_tag(&bench_chachapoly, len, bench_iv, NULL, 0, bench_in, bench_out, bench_tag);
+}
+#endif
+
+static int bench_sha1(size_t len)
+{
+    return mbedtls_sha1_ret(bench_in, len, bench_out);
+}
+
+static int bench_sha256(size_t len)
+{
+    return mbedtls_sha256_ret(bench_in, len, bench_out, 0);
+}
+
+static int bench_hmac_sha256(size_t len)
+{
+    return mbedtls_md_hmac(mbedtls_md_info_from_type(MBEDTLS_MD_SHA256), bench_key, 32, bench_in, len, bench_out);
+}
+
+static int bench_ecdhe_keygen(size_t len)
+{
+    (void)len;
+    return mbedtls_ecdh_gen_public(&bench_grp, &bench_d, &bench_q, mbedtls_ctr_drbg_random, &bench_drbg);
+}
+
+static int bench_ecdhe_shared(size_t len)
+{
+    (void)len;
+    return mbedtls_ecdh_compute_shared(&bench_grp, &bench_z, &bench_peer, &bench_d, mbedtls_ctr_drbg_random, &bench_drbg);
+}
+
+static int bench_ecdsa_sign(size_t len)
+{
+    (void)len;
+    return mbedtls_ecdsa_write_signature(&bench_ecdsa, MBEDTLS_MD_SHA256, bench_hash, 32, bench_sig, &bench_sig_len,
+                                         mbedtls_ctr_drbg_random, &bench_drbg);
+}
+
+static int bench_ecdsa_verify(size_t len)
+{
+    (void)len;
+    return mbedtls_ecdsa_read_signature(&bench_ecdsa, bench_hash, 32, bench_sig, bench_sig_len);
+}
+
+static int bench_rsa_sign(size_t len)
+{
+    (void)len;
+    return mbedtls_pk_sign(&bench_rsa, MBEDTLS_MD_SHA256, bench_hash, 32, bench_sig, &bench_sig_len,
+                           mbedtls_ctr_drbg_random, &bench_drbg);
+}
+
+static int bench_rsa_verify(size_t len)
+{
+    (void)len;
+    return mbedtls_pk_verify(&bench_rsa, MBEDTLS_MD_SHA256, bench_hash, 32, bench_sig, bench_sig_len);
+}
+
+static void bench_primitives(void)
+{
+    memset(bench_in, 0xa5, sizeof(bench_in));
+
+    printf("%-28s %10s %10s %10s\n", "symmetric", "us/64B", "us/1KiB", "MiB/s");
+
+    mbedtls_ccm_init(&bench_ccm);
+    mbedtls_ccm_setkey(&bench_ccm, MBEDTLS_CIPHER_ID_AES, bench_key, 128);
+    bench_symmetric("AES-128-CCM-8", bench_ccm8);
+    bench_symmetric("AES-128-CCM", bench_ccm16);
+    mbedtls_ccm_free(&bench_ccm);
+
+    mbedtls_gcm_init(&bench_gcm);
+    mbedtls_gcm_setkey(&bench_gcm, MBEDTLS_CIPHER_ID_AES, bench_key, 128);
+    bench_symmetric("AES-128-GCM", bench_gcm128);
+    mbedtls_gcm_free(&bench_gcm);
+
+#if defined(MBEDTLS_CHACHAPOLY_C)
+    mbedtls_chachapoly_init(&bench_chachapoly);
+    mbedtls_chachapoly_setkey(&bench_chachapoly, bench_key);
+    bench_symmetric("ChaCha20-Poly1305", bench_chacha);
+    mbedtls_chachapoly_free(&bench_chachapoly);
+#endif
+
+    bench_symmetric("SHA-1", bench_sha1);
+    bench_symmetric("SHA-256", bench_sha256);
+    bench_symmetric("HMAC-SHA-256", bench_hmac_sha256);
+
+    printf("\n%-28s %10s %10s\n", "public key", "ms/op", "op/s");
+
+    mbedtls_sha256_ret((const unsigned char *)"mqtt", 4, bench_hash, 0);
+
+    mbedtls_ecp_group_init(&bench_grp);
+    mbedtls_mpi_init(&bench_d);
+    mbedtls_mpi_init(&bench_z);
+    mbedtls_ecp_point_init(&bench_q);
+    mbedtls_ecp_point_init(&bench_peer);
+    mbedtls_ecp_group_load(&bench_grp, MBEDTLS_ECP_DP_SECP256R1);
+    mbedtls_ecdh_gen_public(&bench_grp, &bench_d, &bench_peer, mbedtls_ctr_drbg_random, &bench_drbg);
+    bench_public("ECDHE secp256r1 keygen", bench_ecdhe_keygen);
+    bench_public("ECDHE secp256r1 shared", bench_ecdhe_shared);
+    mbedtls_ecp_point_free(&bench_peer);
+    mbedtls_ecp_point_free(&bench_q);
+    mbedtls_mpi_free(&bench_z);
+    mbedtls_mpi_free(&bench_d);
+    mbedtls_ecp_group_free(&bench_grp);
+
+    mbedtls_ecdsa_init(&bench_ecdsa);
+    mbedtls_ecdsa_genkey(&bench_ecdsa, MBEDTLS_ECP_DP_SECP256R1, mbedtls_ctr_drbg_random, &bench_drbg);
+    bench_public("ECDSA secp256r1 sign", bench_ecdsa_sign);
+    bench_public("ECDSA secp256r1 verify", bench_ecdsa_verify);
+    mbedtls_ecdsa_free(&bench_ecdsa);
+
+#if defined(MBEDTLS_CERTS_C)
+    mbedtls_pk_init(&bench_rsa);
+    if (0 == mbedtls_pk_parse_key(&bench_rsa, (const unsigned char *)mbedtls_test_srv_key_rsa_pem,
+                                  mbedtls_test_srv_key_rsa_pem_len, NULL, 0)) {
+        bench_public("RSA-2048 sign", bench_rsa_sign);
+        bench_public("RSA-2048 verify", bench_rsa_verify);
+    }
+    mbedtls_pk_free(&bench_rsa);
+#endif
+}
+
+static int bench_send(void *ctx, const unsigned char *buf, size_t len)
+{
+    bench_pipe_t *pipe = ((bench_end_t *)ctx)->tx;
+
+    if (len > BENCH_PIPE_SIZE - pipe->len)
+        len = BENCH_PIPE_SIZE - pipe->len;
+    if (0 == len)
+        return MBEDTLS_ERR_SSL_WANT_WRITE;
+
+    memcpy(pipe->buf + pipe->len, buf, len);
+    pipe->len += len;
+    bench_wire += len;
+    return (int)len;
+}
+
+static int bench_recv(void *ctx, unsigned char *buf, size_t len)
+{
+    bench_pipe_t *pipe = ((bench_end_t *)ctx)->rx;
+
+    if (0 == pipe->len)
+        return MBEDTLS_ERR_SSL_WANT_READ;
+
+    if (len > pipe->len)
+        len = pipe->len;
+
+    memcpy(buf, pipe->buf, len);
+    memmove(pipe->buf, pipe->buf + len, pipe->len - len);
+    pipe->len -= len;
+    return (int)len;
+}
+
+static int bench_phase(int state)
+{
+    switch (state) {
+        case MBEDTLS_SSL_SERVER_CERTIFICATE:
+            return BENCH_PHASE_CERT;
+        case MBEDTLS_SSL_SERVER_KEY_EXCHANGE:
+            return BENCH_PHASE_SKX;
+        case MBEDTLS_SSL_CLIENT_CERTIFICATE:
+        case MBEDTLS_SSL_CLIENT_KEY_EXCHANGE:
+        case MBEDTLS_SSL_CERTIFICATE_VERIFY:
+            return BENCH_PHASE_CKX;
+        case MBEDTLS_SSL_HELLO_REQUEST:
+        case MBEDTLS_SSL_CLIENT_HELLO:
+        case MBEDTLS_SSL_SERVER_HELLO:
+        case MBEDTLS_SSL_CERTIFICATE_REQUEST:
+        case MBEDTLS_SSL_SERVER_HELLO_DONE:
+            return BENCH_PHASE_HELLO;
+        default:
+            return BENCH_PHASE_FINISH;
+    }
+}
+
+#if defined(MBEDTLS_X509_CRT_PARSE_C)
+/* SHA-256 of the SubjectPublicKeyInfo, which follows the subject in the tbsCertificate */
+static int bench_pin_hash(const mbedtls_x509_crt *crt, unsigned char *hash)
+{
+    int rc;
+    size_t len;
+    unsigned char *start = crt->subject_raw.p + crt->subject_raw.len;
+    unsigned char *p = start;
+
+    if ((rc = mbedtls_asn1_get_tag(&p, crt->tbs.p + crt->tbs.len, &len, MBEDTLS_ASN1_CONSTRUCTED | MBEDTLS_ASN1_SEQUENCE)) != 0)
+        return rc;
+    return mbedtls_sha256_ret(start, (p + len) - start, hash, 0);
+}
+
+static int bench_pin_check(const mbedtls_ssl_context *ssl, const unsigned char *pin)
+{
+    unsigned char hash[32];
+
+    if ((NULL == ssl->session_negotiate->peer_cert) || (bench_pin_hash(ssl->session_negotiate->peer_cert, hash) != 0) ||
+        (memcmp(hash, pin, sizeof(hash)) != 0))
+        return MBEDTLS_ERR_X509_CERT_VERIFY_FAILED;
+    return 0;
+}
+#endif
+
+static int bench_handshake_run(const bench_handshake_t *h)
+{
+    int i, p, rc = 0, state, suites[2] = { 0, 0 };
+    long base[2], peak[2] = { 0, 0 }, wire = 0;
+    double t, step, worst = 0, phase[BENCH_PHASES] = { 0 }, spent[2] = { 0, 0 };
+    bench_pipe_t *c2s, *s2c;
+    bench_end_t ends[2];
+    mbedtls_ssl_config conf[2];
+    mbedtls_ssl_context ssl[2];
+    mbedtls_ssl_session session;
+#if defined(MBEDTLS_SSL_CACHE_C)
+    mbedtls_ssl_cache_context cache;
+#endif
+#if defined(MBEDTLS_X509_CRT_PARSE_C)
+    mbedtls_x509_crt ca, crt;
+    mbedtls_pk_context key;
+    unsigned char pin[32];
+#endif
+#if defined(MBEDTLS_ECP_C)
+    static const mbedtls_ecp_group_id curves[] = { MBEDTLS_ECP_DP_SECP256R1, MBEDTLS_ECP_DP_NONE };
+#endif
+
+    suites[0] = h->suite;
+    c2s = calloc(1, sizeof(bench_pipe_t));
+    s2c = calloc(1, sizeof(bench_pipe_t));
+    ends[BENCH_CLIENT].tx = c2s; ends[BENCH_CLIENT].rx = s2c;
+    ends[BENCH_SERVER].tx = s2c; ends[BENCH_SERVER].rx = c2s;
+
+    mbedtls_ssl_session_init(&session);
+#if defined(MBEDTLS_X509_CRT_PARSE_C)
+    mbedtls_x509_crt_init(&ca);
+    mbedtls_x509_crt_init(&crt);
+    mbedtls_pk_init(&key);
+#endif
+
+    /* client configured the way nettype_tls_context_create() does it */
+    bench_side = BENCH_CLIENT;
+    mbedtls_ssl_config_init(&conf[BENCH_CLIENT]);
+    mbedtls_ssl_config_defaults(&conf[BENCH_CLIENT], MBEDTLS_SSL_IS_CLIENT, MBEDTLS_SSL_TRANSPORT_STREAM, MBEDTLS_SSL_PRESET_DEFAULT);
+    mbedtls_ssl_conf_rng(&conf[BENCH_CLIENT], mbedtls_ctr_drbg_random, &bench_drbg);
+    mbedtls_ssl_conf_ciphersuites(&conf[BENCH_CLIENT], suites);
+#if defined(MBEDTLS_ECP_C)
+    mbedtls_ssl_conf_curves(&conf[BENCH_CLIENT], curves);
+#endif
+
+    bench_side = BENCH_SERVER;
+    mbedtls_ssl_config_init(&conf[BENCH_SERVER]);
+    mbedtls_ssl_config_defaults(&conf[BENCH_SERVER], MBEDTLS_SSL_IS_SERVER, MBEDTLS_SSL_TRANSPORT_STREAM, MBEDTLS_SSL_PRESET_DEFAULT);
+    mbedtls_ssl_conf_rng(&conf[BENCH_SERVER], mbedtls_ctr_drbg_random, &bench_drbg);
+    mbedtls_ssl_conf_ciphersuites(&conf[BENCH_SERVER], suites);
+#if defined(MBEDTLS_SSL_CACHE_C)
+    mbedtls_ssl_cache_init(&cache);
+    mbedtls_ssl_conf_session_cache(&conf[BENCH_SERVER], &cache, mbedtls_ssl_cache_get, mbedtls_ssl_cache_set);
+#endif
+
+    if (NULL == h->ca) {
+#if defined(MBEDTLS_KEY_EXCHANGE_PSK_ENABLED)
+        bench_side = BENCH_CLIENT;
+        mbedtls_ssl_conf_psk(&conf[BENCH_CLIENT], bench_psk, sizeof(bench_psk),
+                             (const unsigned char *)bench_psk_identity, strlen(bench_psk_identity));
+        bench_side = BENCH_SERVER;
+        mbedtls_ssl_conf_psk(&conf[BENCH_SERVER], bench_psk, sizeof(bench_psk),
+                             (const unsigned char *)bench_psk_identity, strlen(bench_psk_identity));
+#endif
+    }
+#if defined(MBEDTLS_X509_CRT_PARSE_C)
+    else {
+        bench_side = BENCH_CLIENT;
+        if ((rc = mbedtls_x509_crt_parse(&ca, (const unsigned char *)h->ca, *h->ca_len)) != 0)
+            goto exit;
+        mbedtls_ssl_conf_ca_chain(&conf[BENCH_CLIENT], &ca, NULL);
+        mbedtls_ssl_conf_authmode(&conf[BENCH_CLIENT], h->pinned ? MBEDTLS_SSL_VERIFY_NONE : MBEDTLS_SSL_VERIFY_REQUIRED);
+
+        bench_side = BENCH_SERVER;
+        if (((rc = mbedtls_x509_crt_parse(&crt, (const unsigned char *)h->crt, *h->crt_len)) != 0) ||
+            ((rc = mbedtls_pk_parse_key(&key, (const unsigned char *)h->key, *h->key_len, NULL, 0)) != 0) ||
+            ((rc = mbedtls_ssl_conf_own_cert(&conf[BENCH_SERVER], &crt, &key)) != 0) ||
+            ((rc = bench_pin_hash(&crt, pin)) != 0))
+            goto exit;
+    }
+#endif
+
+    for (i = 0; i < h->rounds + h->resume; i++) {
+        c2s->len = s2c->len = 0;
+        bench_wire = 0;
+        step = 0;
+        base[BENCH_CLIENT] = bench_heap[BENCH_CLIENT].peak = bench_heap[BENCH_CLIENT].current;
+        base[BENCH_SERVER] = bench_heap[BENCH_SERVER].peak = bench_heap[BENCH_SERVER].current;
+
+        for (bench_side = BENCH_CLIENT; bench_side <= BENCH_SERVER; bench_side++) {
+            mbedtls_ssl_init(&ssl[bench_side]);
+            if ((rc = mbedtls_ssl_setup(&ssl[bench_side], &conf[bench_side])) != 0)
+                goto exit;
+            mbedtls_ssl_set_bio(&ssl[bench_side], &ends[bench_side], bench_send, bench_recv, NULL);
+        }
+#if defined(MBEDTLS_X509_CRT_PARSE_C)
+        bench_side = BENCH_CLIENT;
+        mbedtls_ssl_set_hostname(&ssl[BENCH_CLIENT], "localhost");
+#endif
+        if (h->resume && (i > 0))
+            mbedtls_ssl_set_session(&ssl[BENCH_CLIENT], &session);
+
+        while ((ssl[BENCH_CLIENT].state != MBEDTLS_SSL_HANDSHAKE_OVER) ||
+               (ssl[BENCH_SERVER].state != MBEDTLS_SSL_HANDSHAKE_OVER)) {
+            for (bench_side = BENCH_CLIENT; bench_side <= BENCH_SERVER; bench_side++) {
+                if ((state = ssl[bench_side].state) == MBEDTLS_SSL_HANDSHAKE_OVER)
+                    continue;
+
+                t = bench_now();
+                rc = mbedtls_ssl_handshake_step(&ssl[bench_side]);
+#if defined(MBEDTLS_X509_CRT_PARSE_C)
+                if (h->pinned && (0 == rc) && (BENCH_CLIENT == bench_side) && (MBEDTLS_SSL_SERVER_CERTIFICATE == state))
+                    rc = bench_pin_check(&ssl[BENCH_CLIENT], pin);
+#endif
+                t = bench_now() - t;
+
+                /* the priming handshake of a resumption run is not counted */
+                if (!h->resume || (i > 0)) {
+                    spent[bench_side] += t;
+                    if (BENCH_CLIENT == bench_side) {
+                        phase[bench_phase(state)] += t;
+                        if (t > step)
+                            step = t;
+                    }
+                }
+
+#if defined(MBEDTLS_ECP_RESTARTABLE)
+                if (rc == MBEDTLS_ERR_SSL_CRYPTO_IN_PROGRESS)
+                    continue;
+#endif
+                if ((rc != 0) && (rc != MBEDTLS_ERR_SSL_WANT_READ) && (rc != MBEDTLS_ERR_SSL_WANT_WRITE)) {
+                    printf("%-32s %s handshake failed -0x%04x\n", h->name, bench_side ? "server" : "client", -rc);
+                    goto exit;
+                }
+            }
+        }
+        rc = 0;
+
+        if (h->resume && (0 == i)) {
+            bench_side = BENCH_CLIENT;
+            mbedtls_ssl_get_session(&ssl[BENCH_CLIENT], &session);
+        }
+
+        for (bench_side = BENCH_CLIENT; bench_side <= BENCH_SERVER; bench_side++) {
+            if ((!h->resume || (i > 0)) && (bench_heap[bench_side].peak - base[bench_side] > peak[bench_side]))
+                peak[bench_side] = bench_heap[bench_side].peak - base[bench_side];
+            mbedtls_ssl_free(&ssl[bench_side]);
+        }
+        if (!h->resume || (i > 0))
+            worst += step;
+        wire = bench_wire;
+    }
+
+    printf("%-32s %8.3f", h->name, spent[BENCH_CLIENT] * 1e3 / h->rounds);
+    for (p = 0; p < BENCH_PHASES; p++)
+        printf(" %7.3f", phase[p] * 1e3 / h->rounds);
+    printf(" %7.3f %8.3f %8ld %8ld %6ld\n", worst * 1e3 / h->rounds, spent[BENCH_SERVER] * 1e3 / h->rounds, peak[BENCH_CLIENT], peak[BENCH_SERVER], wire);
+
+exit:
+    if (rc != 0)
+        printf("%-32s setup failed -0x%04x\n", h->name, (rc < 0) ? -rc : rc);
+
+    bench_side = BENCH_CLIENT;
+    mbedtls_ssl_session_free(&session);
+    mbedtls_ssl_config_free(&conf[BENCH_CLIENT]);
+#if defined(MBEDTLS_X509_CRT_PARSE_C)
+    mbedtls_x509_crt_free(&ca);
+#endif
+    bench_side = BENCH_SERVER;
+    mbedtls_ssl_config_free(&conf[BENCH_SERVER]);
+#if defined(MBEDTLS_SSL_CACHE_C)
+    mbedtls_ssl_cache_free(&cache);
+#endif
+#if defined(MBEDTLS_X509_CRT_PARSE_C)
+    mbedtls_x509_crt_free(&crt);
+    mbedtls_pk_free(&key);
+#endif
+    free(c2s);
+    free(s2c);
+    return rc;
+}
+
+#if defined(MBEDTLS_CERTS_C)
+#define BENCH_EC_CERTS      mbedtls_test_ca_crt_ec_pem, &mbedtls_test_ca_crt_ec_pem_len, \
+                            mbedtls_test_srv_crt_ec_pem, &mbedtls_test_srv_crt_ec_pem_len, \
+                            mbedtls_test_srv_key_ec_pem, &mbedtls_test_srv_key_ec_pem_len
+#define BENCH_RSA_CERTS     mbedtls_test_ca_crt_rsa_sha256_pem, &mbedtls_test_ca_crt_rsa_sha256_pem_len, \
+                            mbedtls_test_srv_crt_rsa_sha256_pem, &mbedtls_test_srv_crt_rsa_sha256_pem_len, \
+                            mbedtls_test_srv_key_rsa_pem, &mbedtls_test_srv_key_rsa_pem_len
+#endif
+
+static const bench_handshake_t bench_handshakes[] = {
+#if defined(MBEDTLS_CERTS_C) && defined(MBEDTLS_KEY_EXCHANGE_ECDHE_ECDSA_ENABLED)
+#if defined(MBEDTLS_CCM_C)
+    { "ECDHE-ECDSA-AES128-CCM-8", MBEDTLS_TLS_ECDHE_ECDSA_WITH_AES_128_CCM_8, 20, 0, BENCH_EC_CERTS },
+#endif
+#if defined(MBEDTLS_GCM_C)
+    { "ECDHE-ECDSA-AES128-GCM-SHA256", MBEDTLS_TLS_ECDHE_ECDSA_WITH_AES_128_GCM_SHA256, 20, 0, BENCH_EC_CERTS },
+#endif
+#if defined(MBEDTLS_CHACHAPOLY_C)
+    { "ECDHE-ECDSA-CHACHA20-POLY1305", MBEDTLS_TLS_ECDHE_ECDSA_WITH_CHACHA20_POLY1305_SHA256, 20, 0, BENCH_EC_CERTS },
+#endif
+#if defined(MBEDTLS_GCM_C) && defined(MBEDTLS_SSL_CACHE_C)
+    { "ECDHE-ECDSA-AES128-GCM resumed", MBEDTLS_TLS_ECDHE_ECDSA_WITH_AES_128_GCM_SHA256, 200, 1, BENCH_EC_CERTS },
+#endif
+#if defined(MBEDTLS_GCM_C) && defined(MBEDTLS_SHA256_C)
+    { "ECDHE-ECDSA-AES128-GCM pinned", MBEDTLS_TLS_ECDHE_ECDSA_WITH_AES_128_GCM_SHA256, 20, 0, BENCH_EC_CERTS, 1 },
+#endif
+#endif
+#if defined(MBEDTLS_CERTS_C) && defined(MBEDTLS_KEY_EXCHANGE_ECDHE_RSA_ENABLED) && defined(MBEDTLS_GCM_C)
+    { "ECDHE-RSA-AES128-GCM-SHA256", MBEDTLS_TLS_ECDHE_RSA_WITH_AES_128_GCM_SHA256, 20, 0, BENCH_RSA_CERTS },
+#if defined(MBEDTLS_SHA256_C)
+    { "ECDHE-RSA-AES128-GCM pinned", MBEDTLS_TLS_ECDHE_RSA_WITH_AES_128_GCM_SHA256, 20, 0, BENCH_RSA_CERTS, 1 },
+#endif
+#endif
+#if defined(MBEDTLS_KEY_EXCHANGE_PSK_ENABLED) && defined(MBEDTLS_CCM_C)
+    { "PSK-AES128-CCM-8", MBEDTLS_TLS_PSK_WITH_AES_128_CCM_8, 200, 0 },
+#endif
+};
+
+#if defined(MBEDTLS_ECP_RESTARTABLE) && defined(MBEDTLS_CERTS_C) && \
+    defined(MBEDTLS_KEY_EXCHANGE_ECDHE_ECDSA_ENABLED) && defined(MBEDTLS_CCM_C)
+/* 0 runs every ECC operation in one go, a P-256 multiplication is about 3300 ops */
+static const unsigned bench_max_ops[] = { 0, 4000, 2000, 1000, 500, 250 };
+
+static void bench_restartable(void)
+{
+    size_t i;
+    char name[32];
+    bench_handshake_t h = { NULL, MBEDTLS_TLS_ECDHE_ECDSA_WITH_AES_128_CCM_8, 20, 0, BENCH_EC_CERTS };
+
+    printf("\nrestartable ECC, ECDHE-ECDSA-AES128-CCM-8 by mbedtls_ecp_set_max_ops()\n");
+    for (i = 0; i < sizeof(bench_max_ops) / sizeof(bench_max_ops[0]); i++) {
+        snprintf(name, sizeof(name), "max_ops %u", bench_max_ops[i]);
+        h.name = name;
+        mbedtls_ecp_set_max_ops(bench_max_ops[i]);
+        bench_handshake_run(&h);
+    }
+    mbedtls_ecp_set_max_ops(0);
+}
+#endif
+
+int main(int argc, char *argv[])
+{
+    size_t i;
+
+    if (argc > 1)
+        bench_seconds = atof(argv[1]);
+
+    mbedtls_platform_set_calloc_free(bench_calloc, bench_free);
+
+    mbedtls_entropy_init(&bench_entropy);
+    mbedtls_entropy_add_source(&bench_entropy, bench_entropy_source, NULL, MBEDTLS_ENTROPY_MAX_GATHER, MBEDTLS_ENTROPY_SOURCE_STRONG);
+    mbedtls_ctr_drbg_init(&bench_drbg);
+    mbedtls_ctr_drbg_seed(&bench_drbg, mbedtls_entropy_func, &bench_entropy, NULL, 0);
+
+    bench_primitives();
+
+#if defined(MBEDTLS_SSL_SRV_C) && defined(MBEDTLS_SSL_CLI_C)
+    printf("\nhandshake, ms per connection, heap in bytes, records up to %d bytes\n", MBEDTLS_SSL_IN_CONTENT_LEN);
+    printf("%-32s %8s %7s %7s %7s %7s %7s %7s %8s %8s %8s %6s\n", "suite", "client", "hello", "cert", "skx", "ckx", "finish",
+           "worst", "server", "cli peak", "srv peak", "wire");
+    for (i = 0; i < sizeof(bench_handshakes) / sizeof(bench_handshakes[0]); i++)
+        bench_handshake_run(&bench_handshakes[i]);
+#if defined(MBEDTLS_ECP_RESTARTABLE) && defined(MBEDTLS_CERTS_C) && \
+    defined(MBEDTLS_KEY_EXCHANGE_ECDHE_ECDSA_ENABLED) && defined(MBEDTLS_CCM_C)
+    bench_restartable();
+#endif
+#else
+    (void)i;
+    printf("\nhandshakes need MBEDTLS_SSL_SRV_C and MBEDTLS_SSL_CLI_C\n");
+#endif
+
+    mbedtls_ctr_drbg_free(&bench_drbg);
+    mbedtls_entropy_free(&bench_entropy);
+    return 0;
+}
@@ -0,0 +1,16 @@
+/*
+ * @Date: 2026-10-19
+ * @Description: mbedtls configuration of the TLS benchmarks, the device configuration plus the
+ *   server side they run in-process, the precomputed ECDH key pairs of the opt-in ECDHE pool and
+ *   the restartable ECC the max_ops sweep of bench_crypto needs. Built with -DMBEDTLS_CONFIG_FILE='"bench_mbedtls_config.h"'.
+ */
+#ifndef _BENCH_MBEDTLS_CONFIG_H_
+#define _BENCH_MBEDTLS_CONFIG_H_
+
+#include "mbedtls/config.h"
+
+#define MBEDTLS_SSL_SRV_C
+#define MBEDTLS_ECDH_PRECOMPUTED
+#define MBEDTLS_ECP_RESTARTABLE
+
+#endif /* _BENCH_MBEDTLS_CONFIG_H_ */
@@ -0,0 +1,312 @@
+/*
+ * @Date: 2026-10-19
+ * @Description: bytes per sensor reading, MQTT-SN over UDP against MQTT over TCP.
+ *
+ * usage: bench_mqttsn
+ *   both peers run in-process and count every byte they send and receive. On-wire cost adds
+ *   28 bytes of IPv4/UDP header per datagram and 40 bytes of IPv4/TCP header per segment;
+ *   each MQTT packet is one segment, a packet the peer does not answer costs one pure ACK,
+ *   and every TCP connection costs 3 handshake and 4 teardown segments.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include "mqtt_config.h"
+#include "mqtt_log.h"
+#include "mqttclient.h"
+#include "mqtt_sn.h"
+
+#define BENCH_TCP_PORT          "18831"
+#define BENCH_UDP_PORT          "18832"
+#define BENCH_READINGS          100
+#define BENCH_TOPIC             "sensors/node01/temperature"
+#define BENCH_SHORT_TOPIC       "t1"
+#define BENCH_PAYLOAD           "23.5"
+#define BENCH_UDP_OVERHEAD      28
+#define BENCH_TCP_OVERHEAD      40
+
+typedef struct bench_count {
+    long bytes;                 /* mqtt / mqtt-sn bytes, both directions */
+    long packets;               /* datagrams or data segments, both directions */
+    long acks;                  /* pure tcp ACKs */
+    long connections;
+} bench_count_t;
+
+static bench_count_t bench_tcp, bench_udp;
+static sem_t bench_tcp_closed;
+
+static int bench_read_full(int fd, unsigned char *buf, int len)
+{
+    int n, got = 0;
+
+    while (got < len) {
+        if ((n = read(fd, buf + got, len - got)) <= 0)
+            return -1;
+        got += n;
+    }
+    return got;
+}
+
+static void bench_tcp_reply(int fd, unsigned char *buf, int len)
+{
+    if (write(fd, buf, len) == len) {
+        bench_tcp.bytes += len;
+        bench_tcp.packets++;
+    }
+}
+
+/* minimal broker: CONNACK for CONNECT, PINGRESP for PINGREQ, everything else is swallowed */
+static void *bench_tcp_broker(void *arg)
+{
+    int lfd = (int)(long)arg, fd, len, shift, hdr;
+    unsigned char buf[1024], connack[4] = { 0x20, 0x02, 0x00, 0x00 }, pingresp[2] = { 0xd0, 0x00 };
+
+    while ((fd = accept(lfd, NULL, NULL)) >= 0) {
+        bench_tcp.connections++;
+
+        for (;;) {
+            if (bench_read_full(fd, buf, 1) < 0)
+                break;
+
+            len = 0;
+            shift = 0;
+            hdr = 1;
+            do {
+                if (bench_read_full(fd, buf + hdr, 1) < 0)
+                    goto closed;
+                len |= (buf[hdr] & 0x7f) << shift;
+                shift += 7;
+            } while (buf[hdr++] & 0x80);
+
+            if ((len > (int)sizeof(buf) - hdr) || ((len > 0) && (bench_read_full(fd, buf + hdr, len) < 0)))
+                break;
+
+            bench_tcp.bytes += hdr + len;
+            bench_tcp.packets++;
+
+            switch (buf[0] & 0xf0) {
+                case 0x10:
+                    bench_tcp_reply(fd, connack, sizeof(connack));
+                    break;
+                case 0xc0:
+                    bench_tcp_reply(fd, pingresp, sizeof(pingresp));
+                    break;
+                case 0xe0:
+                    goto closed;    /* DISCONNECT rides on the FIN */
+                default:
+                    bench_tcp.acks++;
+                    break;
+            }
+        }
+closed:
+        close(fd);
+        sem_post(&bench_tcp_closed);
+    }
+    return NULL;
+}
+
+static void bench_udp_reply(int fd, struct sockaddr_in *from, unsigned char *buf, int len)
+{
+    if (sendto(fd, buf, len, 0, (struct sockaddr *)from, sizeof(*from)) == len) {
+        bench_udp.bytes += len;
+        bench_udp.packets++;
+    }
+}
+
+/* minimal gateway: hands out topic ids in order and acknowledges whatever needs it */
+static void *bench_udp_gateway(void *arg)
+{
+    int fd = (int)(long)arg, len;
+    uint16_t next_id = 1;
+    unsigned char buf[512], rsp[8];
+    struct sockaddr_in from;
+    socklen_t from_len;
+
+    for (;;) {
+        from_len = sizeof(from);
+        if ((len = recvfrom(fd, buf, sizeof(buf), 0, (struct sockaddr *)&from, &from_len)) < 2)
+            continue;
+
+        bench_udp.bytes += len;
+        bench_udp.packets++;
+
+        switch (buf[1]) {
+            case 0x04:      /* CONNECT */
+                rsp[0] = 3; rsp[1] = 0x05; rsp[2] = 0;
+                bench_udp_reply(fd, &from, rsp, 3);
+                break;
+            case 0x0a:      /* REGISTER */
+                rsp[0] = 7; rsp[1] = 0x0b;
+                rsp[2] = next_id >> 8; rsp[3] = next_id & 0xff;
+                rsp[4] = buf[4]; rsp[5] = buf[5]; rsp[6] = 0;
+                next_id++;
+                bench_udp_reply(fd, &from, rsp, 7);
+                break;
+            case 0x0c:      /* PUBLISH, QoS1 is acknowledged */
+                if (((buf[2] >> 5) & 0x03) == 1) {
+                    rsp[0] = 7; rsp[1] = 0x0d;
+                    memcpy(rsp + 2, buf + 3, 4);
+                    rsp[6] = 0;
+                    bench_udp_reply(fd, &from, rsp, 7);
+                }
+                break;
+            case 0x16:      /* PINGREQ */
+                rsp[0] = 2; rsp[1] = 0x17;
+                bench_udp_reply(fd, &from, rsp, 2);
+                break;
+            case 0x18:      /* DISCONNECT, also the answer to a sleep request */
+                rsp[0] = 2; rsp[1] = 0x18;
+                bench_udp_reply(fd, &from, rsp, 2);
+                break;
+            default:
+                break;
+        }
+    }
+    return NULL;
+}
+
+static int bench_start_peers(void)
+{
+    int tfd, ufd, one = 1;
+    pthread_t t;
+    struct sockaddr_in in;
+
+    memset(&in, 0, sizeof(in));
+    in.sin_family = AF_INET;
+    in.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    tfd = socket(AF_INET, SOCK_STREAM, 0);
+    setsockopt(tfd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    in.sin_port = htons(atoi(BENCH_TCP_PORT));
+    if ((bind(tfd, (struct sockaddr *)&in, sizeof(in)) != 0) || (listen(tfd, 8) != 0))
+        return -1;
+
+    ufd = socket(AF_INET, SOCK_DGRAM, 0);
+    in.sin_port = htons(atoi(BENCH_UDP_PORT));
+    if (bind(ufd, (struct sockaddr *)&in, sizeof(in)) != 0)
+        return -1;
+
+    sem_init(&bench_tcp_closed, 0, 0);
+    pthread_create(&t, NULL, bench_tcp_broker, (void *)(long)tfd);
+    pthread_detach(t);
+    pthread_create(&t, NULL, bench_udp_gateway, (void *)(long)ufd);
+    pthread_detach(t);
+    return 0;
+}
+
+static void bench_report(const char *name, bench_count_t *c, int overhead)
+{
+    long segments = c->packets + c->acks + c->connections * 7;
+    long wire = c->bytes + (long)overhead * segments;
+
+    printf("%-28s %8.1f %10.2f %10.1f\n", name,
+           (double)c->bytes / BENCH_READINGS, (double)segments / BENCH_READINGS, (double)wire / BENCH_READINGS);
+}
+
+static void bench_message(mqtt_message_t *msg, mqtt_qos_t qos)
+{
+    memset(msg, 0, sizeof(mqtt_message_t));
+    msg->qos = qos;
+    msg->payload = BENCH_PAYLOAD;
+    msg->payloadlen = strlen(BENCH_PAYLOAD);
+}
+
+static void bench_mqtt_tcp(mqtt_client_t *client, int reconnect)
+{
+    int i;
+    mqtt_message_t msg;
+
+    memset(&bench_tcp, 0, sizeof(bench_tcp));
+
+    for (i = 0; i < BENCH_READINGS; i++) {
+        if (((0 == i) || reconnect) && (mqtt_connect(client) != MQTT_SUCCESS_ERROR)) {
+            printf("mqtt connect failed\n");
+            return;
+        }
+
+        bench_message(&msg, QOS0);
+        mqtt_publish(client, BENCH_TOPIC, &msg);
+
+        if (reconnect || (BENCH_READINGS - 1 == i)) {
+            mqtt_disconnect(client);
+            sem_wait(&bench_tcp_closed);
+            usleep(50 * 1000);      /* the yield thread cleans the session asynchronously */
+        }
+    }
+
+    bench_report(reconnect ? "mqtt/tcp reconnect" : "mqtt/tcp persistent", &bench_tcp, BENCH_TCP_OVERHEAD);
+}
+
+static void bench_mqtt_sn(const char *name, mqtt_qos_t qos, const char *topic, int sleep_cycle)
+{
+    int i;
+    mqtt_message_t msg;
+    mqtt_sn_client_t c;
+
+    mqtt_sn_init(&c, "127.0.0.1", BENCH_UDP_PORT, "node01");
+    mqtt_sn_set_clean_session(&c, sleep_cycle ? 0 : 1);
+    memset(&bench_udp, 0, sizeof(bench_udp));
+
+    if ((MQTT_SN_QOS_NEG1 != qos) && (mqtt_sn_connect(&c) != MQTT_SUCCESS_ERROR)) {
+        printf("mqtt-sn connect failed\n");
+        return;
+    }
+
+    for (i = 0; i < BENCH_READINGS; i++) {
+        /* a sleeping node reconnects, publishes and goes back to sleep for every reading */
+        if (sleep_cycle && (i > 0) && (mqtt_sn_connect(&c) != MQTT_SUCCESS_ERROR))
+            break;
+
+        bench_message(&msg, qos);
+        if (mqtt_sn_publish(&c, topic, &msg) != MQTT_SUCCESS_ERROR)
+            break;
+
+        if (sleep_cycle && (mqtt_sn_sleep(&c, 600) != MQTT_SUCCESS_ERROR))
+            break;
+    }
+
+    /* let the gateway drain the last datagrams */
+    usleep(100 * 1000);
+    if (i != BENCH_READINGS)
+        printf("%s stopped after %d readings\n", name, i);
+
+    bench_report(name, &bench_udp, BENCH_UDP_OVERHEAD);
+    mqtt_sn_release(&c);
+}
+
+int main(void)
+{
+    mqtt_client_t *client;
+
+    mqtt_log_init();
+
+    if (bench_start_peers() != 0) {
+        printf("bench_mqttsn: cannot listen on %s/%s\n", BENCH_TCP_PORT, BENCH_UDP_PORT);
+        return 1;
+    }
+
+    client = mqtt_lease();
+    mqtt_set_host(client, "127.0.0.1");
+    mqtt_set_port(client, BENCH_TCP_PORT);
+    mqtt_set_client_id(client, "node01");
+    mqtt_set_clean_session(client, 1);
+
+    printf("%d readings, topic \"%s\", payload \"%s\"\n", BENCH_READINGS, BENCH_TOPIC, BENCH_PAYLOAD);
+    printf("%-28s %8s %10s %10s\n", "per reading", "app B", "packets", "wire B");
+
+    bench_mqtt_tcp(client, 0);
+    bench_mqtt_tcp(client, 1);
+    bench_mqtt_sn("mqtt-sn qos0 registered", QOS0, BENCH_TOPIC, 0);
+    bench_mqtt_sn("mqtt-sn qos1 registered", QOS1, BENCH_TOPIC, 0);
+    bench_mqtt_sn("mqtt-sn qos-1 short topic", MQTT_SN_QOS_NEG1, BENCH_SHORT_TOPIC, 0);
+    bench_mqtt_sn("mqtt-sn qos0 sleep cycle", QOS0, BENCH_TOPIC, 1);
+
+    return 0;
+}
@@ -0,0 +1,270 @@
+/*
+ * @Date: 2026-10-19
+ * @Description: connect-to-CONNACK latency over TLS with and without the ECDHE key pair pool.
+ *
+ * usage: bench_tls_ecdhe_pool [rounds [max_ops]]
+ *   a built-in broker on loopback answers every CONNECT with a CONNACK over TLS (ECDHE-ECDSA on
+ *   secp256r1, mbedtls test certificates, no session cache so every connect is a full handshake).
+ *   Each round leases a client, times mqtt_connect() and disconnects it again.
+ *   - off:   no pool, the client generates its ECDHE key pair during the handshake
+ *   - idle:  pool started, the next connect waits until the pool is full
+ *   - burst: pool started, back-to-back connects, the pool only refills between them
+ *   max_ops overrides MQTT_TLS_ECP_MAX_OPS, 0 runs every ECC operation in one go.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+#include "mqtt_config.h"
+#include "mqtt_log.h"
+#include "mqttclient.h"
+#include "network.h"
+
+#ifndef MQTT_NETWORK_TYPE_NO_TLS
+
+#include "mbedtls/ssl.h"
+#include "mbedtls/entropy.h"
+#include "mbedtls/ctr_drbg.h"
+#include "mbedtls/certs.h"
+#include "mbedtls/x509_crt.h"
+#include "mbedtls/pk.h"
+#include "mbedtls/ecp.h"
+
+#define BENCH_PORT              "18831"
+#define BENCH_ROUNDS            50
+
+static mbedtls_ssl_config bench_conf;
+static mbedtls_entropy_context bench_entropy;
+static mbedtls_ctr_drbg_context bench_drbg;
+static mbedtls_x509_crt bench_crt;
+static mbedtls_pk_context bench_key;
+static network_tls_context_t *bench_ctx;
+static const mbedtls_ecp_group_id bench_curves[] = { MBEDTLS_ECP_DP_SECP256R1, MBEDTLS_ECP_DP_NONE };
+
+static double bench_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* deterministic entropy is fine for timing, the platform entropy is disabled in this tree */
+static int bench_entropy_source(void *data, unsigned char *output, size_t len, size_t *olen)
+{
+    size_t i;
+
+    (void)data;
+    for (i = 0; i < len; i++)
+        output[i] = (unsigned char)rand();
+    *olen = len;
+    return 0;
+}
+
+static int bench_send(void *ctx, const unsigned char *buf, size_t len)
+{
+    ssize_t n = send((int)(long)ctx, buf, len, MSG_NOSIGNAL);
+    return (n < 0) ? MBEDTLS_ERR_NET_SEND_FAILED : (int)n;
+}
+
+static int bench_recv(void *ctx, unsigned char *buf, size_t len)
+{
+    ssize_t n = recv((int)(long)ctx, buf, len, 0);
+    return (n < 0) ? MBEDTLS_ERR_NET_RECV_FAILED : (n == 0) ? MBEDTLS_ERR_SSL_PEER_CLOSE_NOTIFY : (int)n;
+}
+
+/* broker side of one connection: handshake, CONNACK for the CONNECT, then drain until the client leaves */
+static void *bench_peer(void *arg)
+{
+    int fd = (int)(long)arg;
+    unsigned char buf[256];
+    static const unsigned char connack[] = { 0x20, 0x02, 0x00, 0x00 };
+    mbedtls_ssl_context ssl;
+
+    mbedtls_ssl_init(&ssl);
+    if (mbedtls_ssl_setup(&ssl, &bench_conf) != 0)
+        goto out;
+    mbedtls_ssl_set_bio(&ssl, (void *)(long)fd, bench_send, bench_recv, NULL);
+
+    if ((mbedtls_ssl_handshake(&ssl) != 0) ||
+        (mbedtls_ssl_read(&ssl, buf, sizeof(buf)) <= 0) ||
+        (mbedtls_ssl_write(&ssl, connack, sizeof(connack)) != sizeof(connack)))
+        goto out;
+
+    while (mbedtls_ssl_read(&ssl, buf, sizeof(buf)) > 0)
+        ;
+
+out:
+    mbedtls_ssl_free(&ssl);
+    close(fd);
+    return NULL;
+}
+
+static void *bench_listener(void *arg)
+{
+    int lfd = (int)(long)arg, fd, one = 1;
+    pthread_t t;
+
+    while ((fd = accept(lfd, NULL, NULL)) >= 0) {
+        /* the handshake flight is written record by record, Nagle would hold it back for the delayed ack */
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        pthread_create(&t, NULL, bench_peer, (void *)(long)fd);
+        pthread_detach(t);
+    }
+    return NULL;
+}
+
+static int bench_listen(void)
+{
+    int fd, one = 1;
+    pthread_t t;
+    struct sockaddr_in in;
+
+    mbedtls_ssl_config_init(&bench_conf);
+    mbedtls_ctr_drbg_init(&bench_drbg);
+    mbedtls_entropy_init(&bench_entropy);
+    mbedtls_x509_crt_init(&bench_crt);
+    mbedtls_pk_init(&bench_key);
+    mbedtls_entropy_add_source(&bench_entropy, bench_entropy_source, NULL, MBEDTLS_ENTROPY_MAX_GATHER, MBEDTLS_ENTROPY_SOURCE_STRONG);
+
+    if ((mbedtls_ctr_drbg_seed(&bench_drbg, mbedtls_entropy_func, &bench_entropy, NULL, 0) != 0) ||
+        (mbedtls_x509_crt_parse(&bench_crt, (const unsigned char *)mbedtls_test_srv_crt_ec_pem, mbedtls_test_srv_crt_ec_pem_len) != 0) ||
+        (mbedtls_pk_parse_key(&bench_key, (const unsigned char *)mbedtls_test_srv_key_ec_pem, mbedtls_test_srv_key_ec_pem_len, NULL, 0) != 0) ||
+        (mbedtls_ssl_config_defaults(&bench_conf, MBEDTLS_SSL_IS_SERVER, MBEDTLS_SSL_TRANSPORT_STREAM, MBEDTLS_SSL_PRESET_DEFAULT) != 0) ||
+        (mbedtls_ssl_conf_own_cert(&bench_conf, &bench_crt, &bench_key) != 0))
+        return -1;
+    /* one broker connection at a time, the shared DRBG needs no lock */
+    mbedtls_ssl_conf_rng(&bench_conf, mbedtls_ctr_drbg_random, &bench_drbg);
+    mbedtls_ssl_conf_curves(&bench_conf, bench_curves);
+
+    fd = socket(AF_INET, SOCK_STREAM, 0);
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    memset(&in, 0, sizeof(in));
+    in.sin_family = AF_INET;
+    in.sin_port = htons(atoi(BENCH_PORT));
+    in.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if ((bind(fd, (struct sockaddr *)&in, sizeof(in)) != 0) || (listen(fd, 8) != 0))
+        return -1;
+
+    pthread_create(&t, NULL, bench_listener, (void *)(long)fd);
+    pthread_detach(t);
+    return 0;
+}
+
+static void bench_pool_wait(void)
+{
+    int i;
+    network_tls_ecdhe_pool_t pool;
+
+    for (i = 0; i < 5000; i++) {
+        network_get_tls_ecdhe_pool(&pool);
+        if (pool.ready >= MQTT_TLS_ECDHE_POOL_SIZE)
+            return;
+        usleep(1000);
+    }
+}
+
+static double bench_run(const char *name, int rounds, int idle)
+{
+    int i;
+    double t, sum = 0, min = 1e9, max = 0;
+    network_tls_ecdhe_pool_t before, after;
+    mqtt_client_t *client;
+
+    network_get_tls_ecdhe_pool(&before);
+    for (i = 0; i < rounds; i++) {
+        if (idle)
+            bench_pool_wait();
+
+        client = mqtt_lease();
+        mqtt_set_host(client, "localhost");
+        mqtt_set_port(client, BENCH_PORT);
+        mqtt_set_client_id(client, "bench_ecdhe");
+        mqtt_set_clean_session(client, 1);
+        mqtt_set_tls_context(client, bench_ctx);
+
+        t = bench_now();
+        if (mqtt_connect(client) != MQTT_SUCCESS_ERROR) {
+            printf("%-6s connect failed\n", name);
+            return 0;
+        }
+        t = (bench_now() - t) * 1e3;
+
+        sum += t;
+        if (t < min)
+            min = t;
+        if (t > max)
+            max = t;
+
+        /* each round keeps its own leased client until the program exits */
+        mqtt_disconnect(client);
+    }
+    network_get_tls_ecdhe_pool(&after);
+
+    printf("%-6s connect to CONNACK: %8.2f ms avg, %8.2f min, %8.2f max (%d rounds, %u pooled, %u computed)\n",
+           name, sum / rounds, min, max, rounds, after.hits - before.hits, after.misses - before.misses);
+    return sum / rounds;
+}
+
+int main(int argc, char *argv[])
+{
+    int rounds = BENCH_ROUNDS;
+    double off, idle;
+    network_tls_credentials_t cred;
+
+    if (argc > 1)
+        rounds = atoi(argv[1]);
+
+    mqtt_log_init();
+
+    if (bench_listen() != 0) {
+        printf("bench_tls_ecdhe_pool: cannot set up the broker on %s\n", BENCH_PORT);
+        return 1;
+    }
+
+    memset(&cred, 0, sizeof(cred));
+    cred.ca = (const unsigned char *)mbedtls_test_ca_crt_ec_pem;
+    bench_ctx = network_tls_context_create(&cred);
+    if (NULL == bench_ctx) {
+        printf("bench_tls_ecdhe_pool: cannot create the tls context\n");
+        return 1;
+    }
+
+#if defined(MBEDTLS_ECP_RESTARTABLE)
+    /* after the context, which applies MQTT_TLS_ECP_MAX_OPS */
+    if (argc > 2)
+        mbedtls_ecp_set_max_ops(atoi(argv[2]));
+#endif
+
+    off = bench_run("off", rounds, 0);
+
+    if (network_tls_ecdhe_pool_start(bench_ctx) != MQTT_SUCCESS_ERROR) {
+        printf("bench_tls_ecdhe_pool: the pool needs MBEDTLS_ECDH_PRECOMPUTED and MQTT_TLS_ECDHE_POOL_SIZE > 0\n");
+        return 1;
+    }
+    idle = bench_run("idle", rounds, 1);
+    bench_run("burst", rounds, 0);
+    network_tls_ecdhe_pool_stop();
+
+    if ((off > 0) && (idle > 0))
+        printf("pooled key pair saves %.2f ms per connect (%.1f%%)\n", off - idle, (off - idle) * 100 / off);
+
+    network_tls_context_destroy(bench_ctx);
+    return 0;
+}
+
+#else
+
+int main(void)
+{
+    printf("bench_tls_ecdhe_pool: skipped, built with MQTT_NETWORK_TYPE_NO_TLS\n");
+    return 0;
+}
+
+#endif /* MQTT_NETWORK_TYPE_NO_TLS */
@@ -0,0 +1,349 @@
+/*
+ * @Date: 2026-10-19
+ * @Description: tls handshake cost, PSK-AES-128-CCM-8 against the certificate suites.
+ *
+ * usage: bench_tls_psk
+ *   client and server run in one thread over an in-memory pipe, each side is stepped in turn and
+ *   timed separately. Every mbedtls allocation goes through a counting allocator tagged with the
+ *   side that made it, so the peak covers the ssl context, record buffers and handshake state.
+ *   The client is configured the way nettype_tls configures it.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if !defined(MBEDTLS_CONFIG_FILE)
+#include "mbedtls/config.h"
+#else
+#include MBEDTLS_CONFIG_FILE
+#endif
+
+#include "mbedtls/platform.h"
+#include "mbedtls/ssl.h"
+#include "mbedtls/entropy.h"
+#include "mbedtls/ctr_drbg.h"
+#include "mbedtls/certs.h"
+#include "mbedtls/x509_crt.h"
+#include "mbedtls/pk.h"
+
+#define BENCH_PSK_ROUNDS        200
+#define BENCH_CERT_ROUNDS       20
+#define BENCH_PIPE_SIZE         (MBEDTLS_SSL_MAX_CONTENT_LEN + 1024)
+
+#define BENCH_CLIENT            0
+#define BENCH_SERVER            1
+
+typedef struct bench_heap {
+    long current;
+    long peak;
+    long allocs;
+} bench_heap_t;
+
+typedef struct bench_pipe {
+    size_t len;
+    unsigned char buf[BENCH_PIPE_SIZE];
+} bench_pipe_t;
+
+typedef struct bench_end {
+    bench_pipe_t *tx;
+    bench_pipe_t *rx;
+} bench_end_t;
+
+typedef struct bench_suite {
+    const char *name;
+    int suite;
+    int rounds;
+    const char *ca;             /* NULL for psk */
+    size_t ca_len;
+    const char *crt;
+    size_t crt_len;
+    const char *key;
+    size_t key_len;
+} bench_suite_t;
+
+static int bench_side;
+static bench_heap_t bench_heap[2];
+static long bench_wire;
+
+static const unsigned char bench_psk[16] = {
+    0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff
+};
+static const char bench_psk_identity[] = "node01";
+
+/* the size and side live in front of each block so frees are charged to the side that allocated */
+static void *bench_calloc(size_t n, size_t size)
+{
+    size_t *p, total = n * size;
+
+    if ((NULL == (p = calloc(1, total + 2 * sizeof(size_t)))))
+        return NULL;
+
+    p[0] = total;
+    p[1] = bench_side;
+    bench_heap[bench_side].allocs++;
+    bench_heap[bench_side].current += total;
+    if (bench_heap[bench_side].current > bench_heap[bench_side].peak)
+        bench_heap[bench_side].peak = bench_heap[bench_side].current;
+
+    return p + 2;
+}
+
+static void bench_free(void *ptr)
+{
+    size_t *p;
+
+    if (NULL == ptr)
+        return;
+
+    p = (size_t *)ptr - 2;
+    bench_heap[p[1]].current -= p[0];
+    free(p);
+}
+
+static int bench_send(void *ctx, const unsigned char *buf, size_t len)
+{
+    bench_pipe_t *pipe = ((bench_end_t *)ctx)->tx;
+
+    if (len > BENCH_PIPE_SIZE - pipe->len)
+        len = BENCH_PIPE_SIZE - pipe->len;
+    if (0 == len)
+        return MBEDTLS_ERR_SSL_WANT_WRITE;
+
+    memcpy(pipe->buf + pipe->len, buf, len);
+    pipe->len += len;
+    bench_wire += len;
+    return (int)len;
+}
+
+static int bench_recv(void *ctx, unsigned char *buf, size_t len)
+{
+    bench_pipe_t *pipe = ((bench_end_t *)ctx)->rx;
+
+    if (0 == pipe->len)
+        return MBEDTLS_ERR_SSL_WANT_READ;
+
+    if (len > pipe->len)
+        len = pipe->len;
+
+    memcpy(buf, pipe->buf, len);
+    memmove(pipe->buf, pipe->buf + len, pipe->len - len);
+    pipe->len -= len;
+    return (int)len;
+}
+
+/* deterministic entropy is fine for timing, the platform entropy is disabled in this tree */
+static int bench_entropy(void *data, unsigned char *output, size_t len, size_t *olen)
+{
+    size_t i;
+
+    (void)data;
+    for (i = 0; i < len; i++)
+        output[i] = (unsigned char)rand();
+    *olen = len;
+    return 0;
+}
+
+static double bench_now_ms(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+static void bench_heap_reset(int side)
+{
+    bench_heap[side].peak = bench_heap[side].current;
+    bench_heap[side].allocs = 0;
+}
+
+static int bench_run(const bench_suite_t *s)
+{
+    int i, rc = 0, suites[2] = { 0, 0 };
+    long static_heap[2], peak[2] = { 0, 0 }, allocs[2] = { 0, 0 }, wire = 0;
+    double t, spent[2] = { 0, 0 };
+    bench_pipe_t *c2s, *s2c;
+    bench_end_t cli_end, srv_end;
+    mbedtls_entropy_context entropy;
+    mbedtls_ctr_drbg_context drbg;
+    mbedtls_ssl_config conf[2];
+    mbedtls_ssl_context ssl[2];
+#if defined(MBEDTLS_X509_CRT_PARSE_C)
+    mbedtls_x509_crt ca, crt;
+    mbedtls_pk_context key;
+#endif
+
+    suites[0] = s->suite;
+    c2s = calloc(1, sizeof(bench_pipe_t));
+    s2c = calloc(1, sizeof(bench_pipe_t));
+    cli_end.tx = c2s; cli_end.rx = s2c;
+    srv_end.tx = s2c; srv_end.rx = c2s;
+
+    mbedtls_entropy_init(&entropy);
+    mbedtls_entropy_add_source(&entropy, bench_entropy, NULL, MBEDTLS_ENTROPY_MAX_GATHER, MBEDTLS_ENTROPY_SOURCE_STRONG);
+    mbedtls_ctr_drbg_init(&drbg);
+    mbedtls_ctr_drbg_seed(&drbg, mbedtls_entropy_func, &entropy, NULL, 0);
+#if defined(MBEDTLS_X509_CRT_PARSE_C)
+    mbedtls_x509_crt_init(&ca);
+    mbedtls_x509_crt_init(&crt);
+    mbedtls_pk_init(&key);
+#endif
+
+    /* client configuration, as built by nettype_tls_context_create() */
+    bench_side = BENCH_CLIENT;
+    mbedtls_ssl_config_init(&conf[BENCH_CLIENT]);
+    mbedtls_ssl_config_defaults(&conf[BENCH_CLIENT], MBEDTLS_SSL_IS_CLIENT, MBEDTLS_SSL_TRANSPORT_STREAM, MBEDTLS_SSL_PRESET_DEFAULT);
+    mbedtls_ssl_conf_rng(&conf[BENCH_CLIENT], mbedtls_ctr_drbg_random, &drbg);
+    mbedtls_ssl_conf_ciphersuites(&conf[BENCH_CLIENT], suites);
+    if (NULL == s->ca) {
+        mbedtls_ssl_conf_psk(&conf[BENCH_CLIENT], bench_psk, sizeof(bench_psk),
+                             (const unsigned char *)bench_psk_identity, strlen(bench_psk_identity));
+    }
+#if defined(MBEDTLS_X509_CRT_PARSE_C)
+    else {
+        if ((rc = mbedtls_x509_crt_parse(&ca, (const unsigned char *)s->ca, s->ca_len)) != 0)
+            goto exit;
+        mbedtls_ssl_conf_ca_chain(&conf[BENCH_CLIENT], &ca, NULL);
+        mbedtls_ssl_conf_authmode(&conf[BENCH_CLIENT], MBEDTLS_SSL_VERIFY_REQUIRED);
+    }
+#endif
+
+    bench_side = BENCH_SERVER;
+    mbedtls_ssl_config_init(&conf[BENCH_SERVER]);
+    mbedtls_ssl_config_defaults(&conf[BENCH_SERVER], MBEDTLS_SSL_IS_SERVER, MBEDTLS_SSL_TRANSPORT_STREAM, MBEDTLS_SSL_PRESET_DEFAULT);
+    mbedtls_ssl_conf_rng(&conf[BENCH_SERVER], mbedtls_ctr_drbg_random, &drbg);
+    mbedtls_ssl_conf_ciphersuites(&conf[BENCH_SERVER], suites);
+    if (NULL == s->ca) {
+        mbedtls_ssl_conf_psk(&conf[BENCH_SERVER], bench_psk, sizeof(bench_psk),
+                             (const unsigned char *)bench_psk_identity, strlen(bench_psk_identity));
+    }
+#if defined(MBEDTLS_X509_CRT_PARSE_C)
+    else {
+        if (((rc = mbedtls_x509_crt_parse(&crt, (const unsigned char *)s->crt, s->crt_len)) != 0) ||
+            ((rc = mbedtls_pk_parse_key(&key, (const unsigned char *)s->key, s->key_len, NULL, 0)) != 0) ||
+            ((rc = mbedtls_ssl_conf_own_cert(&conf[BENCH_SERVER], &crt, &key)) != 0))
+            goto exit;
+    }
+#endif
+
+    static_heap[BENCH_CLIENT] = bench_heap[BENCH_CLIENT].current;
+    static_heap[BENCH_SERVER] = bench_heap[BENCH_SERVER].current;
+
+    for (i = 0; i < s->rounds; i++) {
+        c2s->len = s2c->len = 0;
+        bench_wire = 0;
+        bench_heap_reset(BENCH_CLIENT);
+        bench_heap_reset(BENCH_SERVER);
+
+        bench_side = BENCH_CLIENT;
+        t = bench_now_ms();
+        mbedtls_ssl_init(&ssl[BENCH_CLIENT]);
+        if ((rc = mbedtls_ssl_setup(&ssl[BENCH_CLIENT], &conf[BENCH_CLIENT])) != 0)
+            goto exit;
+#if defined(MBEDTLS_X509_CRT_PARSE_C)
+        mbedtls_ssl_set_hostname(&ssl[BENCH_CLIENT], "localhost");
+#endif
+        mbedtls_ssl_set_bio(&ssl[BENCH_CLIENT], &cli_end, bench_send, bench_recv, NULL);
+        spent[BENCH_CLIENT] += bench_now_ms() - t;
+
+        bench_side = BENCH_SERVER;
+        t = bench_now_ms();
+        mbedtls_ssl_init(&ssl[BENCH_SERVER]);
+        if ((rc = mbedtls_ssl_setup(&ssl[BENCH_SERVER], &conf[BENCH_SERVER])) != 0)
+            goto exit;
+        mbedtls_ssl_set_bio(&ssl[BENCH_SERVER], &srv_end, bench_send, bench_recv, NULL);
+        spent[BENCH_SERVER] += bench_now_ms() - t;
+
+        while ((ssl[BENCH_CLIENT].state != MBEDTLS_SSL_HANDSHAKE_OVER) ||
+               (ssl[BENCH_SERVER].state != MBEDTLS_SSL_HANDSHAKE_OVER)) {
+            for (bench_side = BENCH_CLIENT; bench_side <= BENCH_SERVER; bench_side++) {
+                if (ssl[bench_side].state == MBEDTLS_SSL_HANDSHAKE_OVER)
+                    continue;
+
+                t = bench_now_ms();
+                rc = mbedtls_ssl_handshake_step(&ssl[bench_side]);
+                spent[bench_side] += bench_now_ms() - t;
+
+                if ((rc != 0) && (rc != MBEDTLS_ERR_SSL_WANT_READ) && (rc != MBEDTLS_ERR_SSL_WANT_WRITE)) {
+                    printf("%s: %s handshake failed -0x%04x\n", s->name, bench_side ? "server" : "client", -rc);
+                    goto exit;
+                }
+            }
+        }
+        rc = 0;
+
+        for (bench_side = BENCH_CLIENT; bench_side <= BENCH_SERVER; bench_side++) {
+            if (bench_heap[bench_side].peak - static_heap[bench_side] > peak[bench_side])
+                peak[bench_side] = bench_heap[bench_side].peak - static_heap[bench_side];
+            allocs[bench_side] += bench_heap[bench_side].allocs;
+            mbedtls_ssl_free(&ssl[bench_side]);
+        }
+        wire = bench_wire;
+    }
+
+    printf("%-36s %9.3f %9.3f %8ld %9ld %9ld %8ld %6ld\n", s->name,
+           spent[BENCH_CLIENT] / s->rounds, spent[BENCH_SERVER] / s->rounds,
+           static_heap[BENCH_CLIENT], peak[BENCH_CLIENT], peak[BENCH_SERVER],
+           allocs[BENCH_CLIENT] / s->rounds, wire);
+
+exit:
+    if (rc != 0)
+        printf("%s: setup failed -0x%04x\n", s->name, (rc < 0) ? -rc : rc);
+
+    mbedtls_ssl_config_free(&conf[BENCH_CLIENT]);
+    mbedtls_ssl_config_free(&conf[BENCH_SERVER]);
+#if defined(MBEDTLS_X509_CRT_PARSE_C)
+    mbedtls_x509_crt_free(&ca);
+    mbedtls_x509_crt_free(&crt);
+    mbedtls_pk_free(&key);
+#endif
+    mbedtls_ctr_drbg_free(&drbg);
+    mbedtls_entropy_free(&entropy);
+    free(c2s);
+    free(s2c);
+    return rc;
+}
+
+int main(void)
+{
+    size_t i;
+    const bench_suite_t suites[] = {
+#if defined(MBEDTLS_KEY_EXCHANGE_PSK_ENABLED) && defined(MBEDTLS_CCM_C)
+        { "PSK-AES128-CCM-8", MBEDTLS_TLS_PSK_WITH_AES_128_CCM_8, BENCH_PSK_ROUNDS },
+#endif
+#if defined(MBEDTLS_KEY_EXCHANGE_ECDHE_ECDSA_ENABLED) && defined(MBEDTLS_CCM_C) && defined(MBEDTLS_CERTS_C)
+        { "ECDHE-ECDSA-AES128-CCM-8", MBEDTLS_TLS_ECDHE_ECDSA_WITH_AES_128_CCM_8, BENCH_CERT_ROUNDS,
+          mbedtls_test_ca_crt_ec_pem, mbedtls_test_ca_crt_ec_pem_len,
+          mbedtls_test_srv_crt_ec_pem, mbedtls_test_srv_crt_ec_pem_len,
+          mbedtls_test_srv_key_ec_pem, mbedtls_test_srv_key_ec_pem_len },
+#endif
+#if defined(MBEDTLS_KEY_EXCHANGE_ECDHE_ECDSA_ENABLED) && defined(MBEDTLS_GCM_C) && defined(MBEDTLS_CERTS_C)
+        { "ECDHE-ECDSA-AES128-GCM-SHA256", MBEDTLS_TLS_ECDHE_ECDSA_WITH_AES_128_GCM_SHA256, BENCH_CERT_ROUNDS,
+          mbedtls_test_ca_crt_ec_pem, mbedtls_test_ca_crt_ec_pem_len,
+          mbedtls_test_srv_crt_ec_pem, mbedtls_test_srv_crt_ec_pem_len,
+          mbedtls_test_srv_key_ec_pem, mbedtls_test_srv_key_ec_pem_len },
+#endif
+#if defined(MBEDTLS_KEY_EXCHANGE_ECDHE_RSA_ENABLED) && defined(MBEDTLS_GCM_C) && defined(MBEDTLS_CERTS_C)
+        { "ECDHE-RSA-AES128-GCM-SHA256", MBEDTLS_TLS_ECDHE_RSA_WITH_AES_128_GCM_SHA256, BENCH_CERT_ROUNDS,
+          mbedtls_test_ca_crt_rsa_sha256_pem, mbedtls_test_ca_crt_rsa_sha256_pem_len,
+          mbedtls_test_srv_crt_rsa_sha256_pem, mbedtls_test_srv_crt_rsa_sha256_pem_len,
+          mbedtls_test_srv_key_rsa_pem, mbedtls_test_srv_key_rsa_pem_len },
+#endif
+    };
+
+#if !defined(MBEDTLS_SSL_SRV_C) || !defined(MBEDTLS_SSL_CLI_C)
+    printf("bench_tls_psk: needs MBEDTLS_SSL_SRV_C and MBEDTLS_SSL_CLI_C\n");
+    return 1;
+#endif
+
+    mbedtls_platform_set_calloc_free(bench_calloc, bench_free);
+
+    printf("handshake cost per connection, heap in bytes, max content length %d\n", MBEDTLS_SSL_MAX_CONTENT_LEN);
+    printf("%-36s %9s %9s %8s %9s %9s %8s %6s\n", "suite", "cli ms", "srv ms", "cli conf", "cli peak", "srv peak", "allocs", "wire");
+
+    for (i = 0; i < sizeof(suites) / sizeof(suites[0]); i++)
+        bench_run(&suites[i]);
+
+    return 0;
+}
@@ -0,0 +1,296 @@
+/*
+ * @Date: 2026-10-19
+ * @Description: compare loopback TCP with the AF_UNIX and shared-memory transports for same-host links.
+ *
+ * usage: bench_transport [tcp_host tcp_port unix_path]
+ *   without arguments the network layer is measured against built-in echo peers;
+ *   with a local broker listening on both endpoints an MQTT QoS0 round trip is measured too.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include "mqtt_config.h"
+#include "mqtt_log.h"
+#include "mqttclient.h"
+#include "network.h"
+#include "platform_shm_ring.h"
+
+#define BENCH_TCP_PORT          "18830"
+#define BENCH_UNIX_PATH         "/tmp/mqttclient_bench.sock"
+#define BENCH_SHM_NAME          "mqttclient_bench"
+#define BENCH_PINGPONG_COUNT    20000
+#define BENCH_PINGPONG_SIZE     64
+#define BENCH_STREAM_CHUNK      (64 * 1024)
+#define BENCH_STREAM_TOTAL      (256 * 1024 * 1024)
+#define BENCH_MQTT_COUNT        5000
+#define BENCH_MQTT_SIZE         64
+
+static char bench_buf[BENCH_STREAM_CHUNK];
+static int bench_shm_handle = -1;
+
+static double bench_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* echo peer: the first byte selects echo (ping-pong) or sink (stream, acked by one byte at the end) */
+static void *bench_peer(void *arg)
+{
+    int fd = (int)(long)arg;
+    char mode, buf[BENCH_STREAM_CHUNK];
+    long total = 0;
+    ssize_t n;
+
+    if (read(fd, &mode, 1) != 1)
+        goto out;
+
+    while ((n = read(fd, buf, sizeof(buf))) > 0) {
+        if (mode == 'e') {
+            if (write(fd, buf, n) != n)
+                break;
+        } else {
+            total += n;
+            if (total >= BENCH_STREAM_TOTAL) {
+                (void)write(fd, &mode, 1);
+                total = 0;
+            }
+        }
+    }
+
+out:
+    close(fd);
+    return NULL;
+}
+
+static void *bench_listener(void *arg)
+{
+    int lfd = (int)(long)arg, fd;
+    pthread_t t;
+
+    while ((fd = accept(lfd, NULL, NULL)) >= 0) {
+        pthread_create(&t, NULL, bench_peer, (void *)(long)fd);
+        pthread_detach(t);
+    }
+    return NULL;
+}
+
+static int bench_listen(int unix_socket)
+{
+    int fd, one = 1;
+    pthread_t t;
+    struct sockaddr_in in;
+    struct sockaddr_un un;
+
+    if (unix_socket) {
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        memset(&un, 0, sizeof(un));
+        un.sun_family = AF_UNIX;
+        strncpy(un.sun_path, BENCH_UNIX_PATH, sizeof(un.sun_path) - 1);
+        unlink(BENCH_UNIX_PATH);
+        if (bind(fd, (struct sockaddr *)&un, sizeof(un)) != 0)
+            return -1;
+    } else {
+        fd = socket(AF_INET, SOCK_STREAM, 0);
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        memset(&in, 0, sizeof(in));
+        in.sin_family = AF_INET;
+        in.sin_port = htons(atoi(BENCH_TCP_PORT));
+        in.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (bind(fd, (struct sockaddr *)&in, sizeof(in)) != 0)
+            return -1;
+    }
+
+    if (listen(fd, 8) != 0)
+        return -1;
+
+    pthread_create(&t, NULL, bench_listener, (void *)(long)fd);
+    pthread_detach(t);
+    return 0;
+}
+
+/* the shared-memory peer serves one client at a time, like the rings themselves */
+static void *bench_shm_peer(void *arg)
+{
+    int handle = (int)(long)arg;
+    int n;
+    long total;
+    unsigned char mode, buf[BENCH_STREAM_CHUNK];
+
+    for (;;) {
+        if (platform_shm_ring_accept(handle, 1000) <= 0)
+            continue;
+        if (platform_shm_ring_read(handle, &mode, 1, 1000) != 1)
+            continue;
+
+        total = 0;
+        while ((n = platform_shm_ring_read(handle, buf, (mode == 'e') ? BENCH_PINGPONG_SIZE : sizeof(buf), 1000)) >= 0) {
+            if (mode == 'e') {
+                if ((n > 0) && (platform_shm_ring_write(handle, buf, n, 1000) != n))
+                    break;
+            } else {
+                total += n;
+                if (total >= BENCH_STREAM_TOTAL) {
+                    platform_shm_ring_write(handle, &mode, 1, 1000);
+                    total = 0;
+                }
+            }
+        }
+    }
+    return NULL;
+}
+
+static int bench_shm_listen(void)
+{
+    pthread_t t;
+
+    bench_shm_handle = platform_shm_ring_create(BENCH_SHM_NAME, 0);
+    if (bench_shm_handle < 0)
+        return -1;
+
+    pthread_create(&t, NULL, bench_shm_peer, (void *)(long)bench_shm_handle);
+    pthread_detach(t);
+    return 0;
+}
+
+static int bench_open(network_t *n, const char *host, const char *port, char mode)
+{
+    unsigned char m = (unsigned char)mode;
+
+    network_init(n, host, port, NULL);
+    if (network_connect(n) != MQTT_SUCCESS_ERROR)
+        return -1;
+    return (network_write(n, &m, 1, 1000) == 1) ? 0 : -1;
+}
+
+static void bench_network(const char *name, const char *host, const char *port)
+{
+    int i;
+    long sent;
+    double t0, t1;
+    network_t n;
+
+    if (bench_open(&n, host, port, 'e') != 0) {
+        printf("%-6s connect failed\n", name);
+        return;
+    }
+
+    t0 = bench_now();
+    for (i = 0; i < BENCH_PINGPONG_COUNT; i++) {
+        if ((network_write(&n, (unsigned char *)bench_buf, BENCH_PINGPONG_SIZE, 1000) != BENCH_PINGPONG_SIZE) ||
+            (network_read(&n, (unsigned char *)bench_buf, BENCH_PINGPONG_SIZE, 1000) != BENCH_PINGPONG_SIZE))
+            break;
+    }
+    t1 = bench_now();
+    network_release(&n);
+    printf("%-6s ping-pong %dB: %8.2f us/round trip (%d rounds)\n",
+           name, BENCH_PINGPONG_SIZE, (t1 - t0) * 1e6 / i, i);
+
+    if (bench_open(&n, host, port, 's') != 0)
+        return;
+
+    t0 = bench_now();
+    for (sent = 0; sent < BENCH_STREAM_TOTAL; sent += BENCH_STREAM_CHUNK) {
+        if (network_write(&n, (unsigned char *)bench_buf, BENCH_STREAM_CHUNK, 1000) != BENCH_STREAM_CHUNK)
+            break;
+    }
+    network_read(&n, (unsigned char *)bench_buf, 1, 5000);
+    t1 = bench_now();
+    network_release(&n);
+    printf("%-6s stream %dKB writes: %8.1f MB/s\n",
+           name, BENCH_STREAM_CHUNK / 1024, sent / (t1 - t0) / (1024 * 1024));
+}
+
+static pthread_mutex_t bench_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t bench_cond = PTHREAD_COND_INITIALIZER;
+static int bench_received;
+
+static void bench_handler(void *client, message_data_t *msg)
+{
+    (void)client;
+    (void)msg;
+    pthread_mutex_lock(&bench_mutex);
+    bench_received++;
+    pthread_cond_signal(&bench_cond);
+    pthread_mutex_unlock(&bench_mutex);
+}
+
+static void bench_mqtt(const char *name, char *host, char *port)
+{
+    int i, rc;
+    double t0, t1;
+    struct timespec ts;
+    mqtt_message_t msg;
+    mqtt_client_t *client = mqtt_lease();
+
+    mqtt_set_host(client, host);
+    mqtt_set_port(client, port);
+    mqtt_set_client_id(client, random_string(10));
+    mqtt_set_clean_session(client, 1);
+
+    if ((mqtt_connect(client) != MQTT_SUCCESS_ERROR) ||
+        (mqtt_subscribe(client, "bench/rtt", QOS0, bench_handler) != MQTT_SUCCESS_ERROR)) {
+        printf("%-6s mqtt connect failed\n", name);
+        return;
+    }
+
+    memset(&msg, 0, sizeof(msg));
+    msg.qos = QOS0;
+    msg.payload = bench_buf;
+    bench_received = 0;
+
+    t0 = bench_now();
+    for (i = 0; i < BENCH_MQTT_COUNT; i++) {
+        msg.payloadlen = BENCH_MQTT_SIZE;       /* mqtt_publish() clears it */
+        mqtt_publish(client, "bench/rtt", &msg);
+
+        clock_gettime(CLOCK_REALTIME, &ts);
+        ts.tv_sec += 1;
+        rc = 0;
+        pthread_mutex_lock(&bench_mutex);
+        while ((bench_received <= i) && (rc == 0))
+            rc = pthread_cond_timedwait(&bench_cond, &bench_mutex, &ts);
+        pthread_mutex_unlock(&bench_mutex);
+        if (rc != 0)
+            break;
+    }
+    t1 = bench_now();
+    printf("%-6s mqtt qos0 %dB: %8.2f us/round trip (%d rounds)\n",
+           name, BENCH_MQTT_SIZE, (t1 - t0) * 1e6 / i, i);
+
+    /* each run keeps its own leased client until the program exits */
+    mqtt_disconnect(client);
+}
+
+int main(int argc, char *argv[])
+{
+    mqtt_log_init();
+    memset(bench_buf, 'm', sizeof(bench_buf));
+
+    if ((bench_listen(0) != 0) || (bench_listen(1) != 0) || (bench_shm_listen() != 0)) {
+        printf("bench_transport: cannot listen on %s, %s or %s\n", BENCH_TCP_PORT, BENCH_UNIX_PATH, BENCH_SHM_NAME);
+        return 1;
+    }
+
+    bench_network("tcp", "127.0.0.1", BENCH_TCP_PORT);
+    bench_network("unix", BENCH_UNIX_PATH, NULL);
+    bench_network("shm", NETWORK_SHM_PREFIX BENCH_SHM_NAME, NULL);
+
+    if (argc >= 4) {
+        bench_mqtt("tcp", argv[1], argv[2]);
+        bench_mqtt("unix", argv[3], "0");
+    }
+
+    unlink(BENCH_UNIX_PATH);
+    platform_shm_ring_close(bench_shm_handle);
+    return 0;
+}
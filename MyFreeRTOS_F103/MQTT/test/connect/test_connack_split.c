@@ -0,0 +1,169 @@
+/*
+ * @Date: 2026-10-19
+ * @Description: connect against a loopback broker that writes its CONNACK in two parts.
+ *
+ * usage: test_connack_split
+ *   the broker sends the first 1, 2 or 3 bytes of the CONNACK, waits, then sends the rest.
+ *   mqtt_connect_start()/mqtt_connect_continue() must keep the bytes read so far and finish the
+ *   connect, without any call blocking for the gap; the blocking mqtt_connect() must finish too.
+ *   exits with 0 when every case passes.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+#include "mqtt_config.h"
+#include "mqtt_log.h"
+#include "mqttclient.h"
+
+#define TEST_PORT               "18832"
+#define TEST_GAP_MS             100
+#define TEST_CALL_MAX_MS        20
+
+static volatile int test_split;
+
+static double test_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+/* broker side of one connection: read the CONNECT, send the CONNACK in two writes, drain */
+static void *test_peer(void *arg)
+{
+    int fd = (int)(long)arg, split = test_split;
+    unsigned char buf[256];
+    static const unsigned char connack[] = { 0x20, 0x02, 0x00, 0x00 };
+
+    if (read(fd, buf, sizeof(buf)) > 0) {
+        if (write(fd, connack, split) == split) {
+            usleep(TEST_GAP_MS * 1000);
+            if (write(fd, connack + split, sizeof(connack) - split) == (ssize_t)(sizeof(connack) - split)) {
+                while (read(fd, buf, sizeof(buf)) > 0)
+                    ;
+            }
+        }
+    }
+
+    close(fd);
+    return NULL;
+}
+
+static void *test_listener(void *arg)
+{
+    int lfd = (int)(long)arg, fd, one = 1;
+    pthread_t t;
+
+    while ((fd = accept(lfd, NULL, NULL)) >= 0) {
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        pthread_create(&t, NULL, test_peer, (void *)(long)fd);
+        pthread_detach(t);
+    }
+    return NULL;
+}
+
+static int test_listen(void)
+{
+    int fd, one = 1;
+    pthread_t t;
+    struct sockaddr_in in;
+
+    fd = socket(AF_INET, SOCK_STREAM, 0);
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    memset(&in, 0, sizeof(in));
+    in.sin_family = AF_INET;
+    in.sin_port = htons(atoi(TEST_PORT));
+    in.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if ((bind(fd, (struct sockaddr *)&in, sizeof(in)) != 0) || (listen(fd, 8) != 0))
+        return -1;
+
+    pthread_create(&t, NULL, test_listener, (void *)(long)fd);
+    pthread_detach(t);
+    return 0;
+}
+
+static mqtt_client_t *test_client(void)
+{
+    mqtt_client_t *client = mqtt_lease();
+
+    mqtt_set_host(client, "127.0.0.1");
+    mqtt_set_port(client, TEST_PORT);
+    mqtt_set_client_id(client, "test_connack_split");
+    mqtt_set_clean_session(client, 1);
+    return client;
+}
+
+static int test_async(int split)
+{
+    int rc, fd, want;
+    double t, worst = 0;
+    struct pollfd p;
+    mqtt_client_t *client = test_client();
+
+    test_split = split;
+    t = test_now();
+    rc = mqtt_connect_start(client);
+    worst = test_now() - t;
+
+    while (MQTT_WOULD_BLOCK_ERROR == rc) {
+        want = mqtt_connect_want(client, &fd);
+        p.fd = fd;
+        p.events = ((want & NETWORK_WANT_READ) ? POLLIN : 0) | ((want & NETWORK_WANT_WRITE) ? POLLOUT : 0);
+        poll(&p, 1, want ? 10 : 0);
+
+        t = test_now();
+        rc = mqtt_connect_continue(client);
+        t = test_now() - t;
+        if (t > worst)
+            worst = t;
+    }
+
+    printf("async    split %d: rc %d, longest call %.2f ms\n", split, rc, worst);
+    if (MQTT_SUCCESS_ERROR == rc)
+        mqtt_disconnect(client);
+
+    return ((MQTT_SUCCESS_ERROR == rc) && (worst < TEST_CALL_MAX_MS)) ? 0 : 1;
+}
+
+static int test_blocking(int split)
+{
+    int rc;
+    mqtt_client_t *client = test_client();
+
+    test_split = split;
+    rc = mqtt_connect(client);
+    printf("blocking split %d: rc %d\n", split, rc);
+    if (MQTT_SUCCESS_ERROR == rc)
+        mqtt_disconnect(client);
+
+    return (MQTT_SUCCESS_ERROR == rc) ? 0 : 1;
+}
+
+int main(void)
+{
+    int split, failed = 0;
+
+    mqtt_log_init();
+
+    if (test_listen() != 0) {
+        printf("test_connack_split: cannot set up the broker on %s\n", TEST_PORT);
+        return 1;
+    }
+
+    for (split = 1; split < 4; split++) {
+        failed += test_async(split);
+        failed += test_blocking(split);
+    }
+
+    printf("%s\n", failed ? "FAILED" : "passed");
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,243 @@
+/*
+ * @Date: 2026-10-19
+ * @Description: connect over TLS against a loopback broker, with and without public key pinning.
+ *
+ * usage: test_tls_connect
+ *   a built-in broker answers every CONNECT with a CONNACK over TLS (mbedtls test certificates,
+ *   CN=localhost). Checks that the chain is verified, that a pin is only trusted after a fully
+ *   verified handshake and that a configured pin is enforced. exits with 0 when every case passes.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+#include "mqtt_config.h"
+#include "mqtt_log.h"
+#include "mqttclient.h"
+#include "network.h"
+
+#ifndef MQTT_NETWORK_TYPE_NO_TLS
+
+#include "mbedtls/ssl.h"
+#include "mbedtls/entropy.h"
+#include "mbedtls/ctr_drbg.h"
+#include "mbedtls/certs.h"
+#include "mbedtls/x509_crt.h"
+#include "mbedtls/pk.h"
+#include "mbedtls/sha256.h"
+
+#define TEST_PORT               "18833"
+
+static mbedtls_ssl_config test_conf;
+static mbedtls_entropy_context test_entropy;
+static mbedtls_ctr_drbg_context test_drbg;
+static mbedtls_x509_crt test_crt;
+static mbedtls_pk_context test_key;
+
+/* deterministic entropy is fine for a test, the platform entropy is disabled in this tree */
+static int test_entropy_source(void *data, unsigned char *output, size_t len, size_t *olen)
+{
+    size_t i;
+
+    (void)data;
+    for (i = 0; i < len; i++)
+        output[i] = (unsigned char)rand();
+    *olen = len;
+    return 0;
+}
+
+static int test_send(void *ctx, const unsigned char *buf, size_t len)
+{
+    ssize_t n = send((int)(long)ctx, buf, len, MSG_NOSIGNAL);
+    return (n < 0) ? MBEDTLS_ERR_NET_SEND_FAILED : (int)n;
+}
+
+static int test_recv(void *ctx, unsigned char *buf, size_t len)
+{
+    ssize_t n = recv((int)(long)ctx, buf, len, 0);
+    return (n < 0) ? MBEDTLS_ERR_NET_RECV_FAILED : (n == 0) ? MBEDTLS_ERR_SSL_PEER_CLOSE_NOTIFY : (int)n;
+}
+
+/* broker side of one connection: handshake, CONNACK for the CONNECT, then drain until the client leaves */
+static void *test_peer(void *arg)
+{
+    int fd = (int)(long)arg;
+    unsigned char buf[256];
+    static const unsigned char connack[] = { 0x20, 0x02, 0x00, 0x00 };
+    mbedtls_ssl_context ssl;
+
+    mbedtls_ssl_init(&ssl);
+    if (mbedtls_ssl_setup(&ssl, &test_conf) != 0)
+        goto out;
+    mbedtls_ssl_set_bio(&ssl, (void *)(long)fd, test_send, test_recv, NULL);
+
+    if ((mbedtls_ssl_handshake(&ssl) != 0) ||
+        (mbedtls_ssl_read(&ssl, buf, sizeof(buf)) <= 0) ||
+        (mbedtls_ssl_write(&ssl, connack, sizeof(connack)) != sizeof(connack)))
+        goto out;
+
+    while (mbedtls_ssl_read(&ssl, buf, sizeof(buf)) > 0)
+        ;
+
+out:
+    mbedtls_ssl_free(&ssl);
+    close(fd);
+    return NULL;
+}
+
+static void *test_listener(void *arg)
+{
+    int lfd = (int)(long)arg, fd, one = 1;
+    pthread_t t;
+
+    while ((fd = accept(lfd, NULL, NULL)) >= 0) {
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        pthread_create(&t, NULL, test_peer, (void *)(long)fd);
+        pthread_detach(t);
+    }
+    return NULL;
+}
+
+static int test_listen(void)
+{
+    int fd, one = 1;
+    pthread_t t;
+    struct sockaddr_in in;
+
+    mbedtls_ssl_config_init(&test_conf);
+    mbedtls_ctr_drbg_init(&test_drbg);
+    mbedtls_entropy_init(&test_entropy);
+    mbedtls_x509_crt_init(&test_crt);
+    mbedtls_pk_init(&test_key);
+    mbedtls_entropy_add_source(&test_entropy, test_entropy_source, NULL, MBEDTLS_ENTROPY_MAX_GATHER, MBEDTLS_ENTROPY_SOURCE_STRONG);
+
+    if ((mbedtls_ctr_drbg_seed(&test_drbg, mbedtls_entropy_func, &test_entropy, NULL, 0) != 0) ||
+        (mbedtls_x509_crt_parse(&test_crt, (const unsigned char *)mbedtls_test_srv_crt_ec_pem, mbedtls_test_srv_crt_ec_pem_len) != 0) ||
+        (mbedtls_pk_parse_key(&test_key, (const unsigned char *)mbedtls_test_srv_key_ec_pem, mbedtls_test_srv_key_ec_pem_len, NULL, 0) != 0) ||
+        (mbedtls_ssl_config_defaults(&test_conf, MBEDTLS_SSL_IS_SERVER, MBEDTLS_SSL_TRANSPORT_STREAM, MBEDTLS_SSL_PRESET_DEFAULT) != 0) ||
+        (mbedtls_ssl_conf_own_cert(&test_conf, &test_crt, &test_key) != 0))
+        return -1;
+    /* one broker connection at a time, the shared DRBG needs no lock */
+    mbedtls_ssl_conf_rng(&test_conf, mbedtls_ctr_drbg_random, &test_drbg);
+
+    fd = socket(AF_INET, SOCK_STREAM, 0);
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    memset(&in, 0, sizeof(in));
+    in.sin_family = AF_INET;
+    in.sin_port = htons(atoi(TEST_PORT));
+    in.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if ((bind(fd, (struct sockaddr *)&in, sizeof(in)) != 0) || (listen(fd, 8) != 0))
+        return -1;
+
+    pthread_create(&t, NULL, test_listener, (void *)(long)fd);
+    pthread_detach(t);
+    return 0;
+}
+
+/* SHA-256 of the server SubjectPublicKeyInfo, the value network_tls_credentials_t.pin takes */
+static int test_server_pin(unsigned char *pin)
+{
+    int len;
+    unsigned char der[512];
+
+    len = mbedtls_pk_write_pubkey_der(&test_key, der, sizeof(der));
+    if (len <= 0)
+        return -1;
+
+    return mbedtls_sha256_ret(der + sizeof(der) - len, len, pin, 0);
+}
+
+/* one connect with its own client, expect_ok says whether it has to succeed, pinned whether the
+ * server key has to be accepted through the pin instead of the chain */
+static int test_connect(const char *name, network_tls_context_t *ctx, int expect_ok, int pinned)
+{
+    int rc, failed;
+    network_tls_stats_t stats;
+    mqtt_client_t *client = mqtt_lease();
+
+    mqtt_set_host(client, "localhost");
+    mqtt_set_port(client, TEST_PORT);
+    mqtt_set_client_id(client, "test_tls_connect");
+    mqtt_set_clean_session(client, 1);
+    mqtt_set_tls_context(client, ctx);
+
+    rc = mqtt_connect(client);
+    memset(&stats, 0, sizeof(stats));
+    mqtt_get_tls_stats(client, &stats);
+    if (MQTT_SUCCESS_ERROR == rc)
+        mqtt_disconnect(client);
+
+    failed = expect_ok ? ((MQTT_SUCCESS_ERROR != rc) || (stats.pinned != (unsigned int)pinned))
+                       : (MQTT_SUCCESS_ERROR == rc);
+    printf("%-28s rc %d, pinned %u: %s\n", name, rc, stats.pinned, failed ? "FAILED" : "ok");
+
+    /* each case keeps its own leased client until the program exits */
+    return failed;
+}
+
+static int test_case(const char *name, const char *ca, int pinning, const unsigned char *pin,
+                     int first_ok, int second_ok)
+{
+    int failed;
+    network_tls_credentials_t cred;
+    network_tls_context_t *ctx;
+
+    memset(&cred, 0, sizeof(cred));
+    cred.ca = (const unsigned char *)ca;
+    cred.pinning = pinning;
+    cred.pin = pin;
+    ctx = network_tls_context_create(&cred);
+    if (NULL == ctx) {
+        printf("%s: cannot create the tls context\n", name);
+        return 1;
+    }
+
+    /* the first connect always verifies the chain, the second one may take the pin */
+    failed = test_connect(name, ctx, first_ok, 0);
+    if (first_ok)
+        failed += test_connect(name, ctx, second_ok, pinning ? 1 : 0);
+
+    network_tls_context_destroy(ctx);
+    return failed;
+}
+
+int main(void)
+{
+    int failed = 0;
+    unsigned char pin[32], bad[32];
+
+    mqtt_log_init();
+
+    if ((test_listen() != 0) || (test_server_pin(pin) != 0)) {
+        printf("test_tls_connect: cannot set up the broker on %s\n", TEST_PORT);
+        return 1;
+    }
+    memset(bad, 0x11, sizeof(bad));
+
+    failed += test_case("verified", mbedtls_test_ca_crt_ec_pem, 0, NULL, 1, 1);
+    failed += test_case("wrong ca", mbedtls_test_ca_crt_rsa_sha256_pem, 0, NULL, 0, 0);
+    failed += test_case("learned pin", mbedtls_test_ca_crt_ec_pem, 1, NULL, 1, 1);
+    failed += test_case("learned pin, wrong ca", mbedtls_test_ca_crt_rsa_sha256_pem, 1, NULL, 0, 0);
+    failed += test_case("configured pin", mbedtls_test_ca_crt_ec_pem, 1, pin, 1, 1);
+    failed += test_case("configured pin, wrong ca", mbedtls_test_ca_crt_rsa_sha256_pem, 1, pin, 0, 0);
+    failed += test_case("wrong configured pin", mbedtls_test_ca_crt_ec_pem, 1, bad, 0, 0);
+
+    printf("%s\n", failed ? "FAILED" : "passed");
+    return failed ? 1 : 0;
+}
+
+#else
+
+int main(void)
+{
+    printf("test_tls_connect: skipped, built with MQTT_NETWORK_TYPE_NO_TLS\n");
+    return 0;
+}
+
+#endif /* MQTT_NETWORK_TYPE_NO_TLS */